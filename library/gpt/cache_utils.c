@@ -0,0 +1,461 @@
+// 
+// Copyright 2010-2011 Herve BREDIN (bredin@limsi.fr)
+// Contact: http://pinocchio.niderb.fr/
+// 
+// This file is part of pinocchIO.
+//  
+//      pinocchIO is free software: you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation, either version 3 of the License, or
+//      (at your option) any later version.
+//  
+//      pinocchIO is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//  
+//      You should have received a copy of the GNU General Public License
+//      along with pinocchIO. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+#include "cache_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// Cache files are written in host byte order and are not meant to be shared between machines:
+// the cache key covers the layout of stored types, so that a foreign cache is simply ignored.
+//
+// header:  magic, version, key
+// labels:  for each file, timeline length, timeline, number of labels per timerange, labels
+// data:    datatype, then for each file, timeline length, timeline, number of entries,
+//          first/number of corresponding label timeranges and filter mask per timerange
+// trailer: magic
+
+#define CACHE_MAGIC "GPTCACHE"
+#define CACHE_MAGIC_SIZE 8
+#define CACHE_VERSION 2
+
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+// 64-bit FNV-1a
+static uint64_t hashBytes(uint64_t hash, const void* bytes, size_t size)
+{
+    const unsigned char* b = (const unsigned char*) bytes;
+    size_t i;
+    
+    for (i=0; i<size; i++)
+    {
+        hash ^= b[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+static uint64_t hashInt(uint64_t hash, int value)
+{
+    return hashBytes(hash, &value, sizeof(int));
+}
+
+static uint64_t hashString(uint64_t hash, const char* string)
+{
+    return hashBytes(hash, string, strlen(string)+1);
+}
+
+// hash path, identity, size and modification time of a file
+static int hashFile(uint64_t* hash, const char* path)
+{
+    struct stat st;
+    int64_t value;
+    
+    if (stat(path, &st) < 0) return -1;
+    
+    *hash = hashString(*hash, path);
+    value = (int64_t) st.st_dev;   *hash = hashBytes(*hash, &value, sizeof(int64_t));
+    value = (int64_t) st.st_ino;   *hash = hashBytes(*hash, &value, sizeof(int64_t));
+    value = (int64_t) st.st_size;  *hash = hashBytes(*hash, &value, sizeof(int64_t));
+    value = (int64_t) st.st_mtime; *hash = hashBytes(*hash, &value, sizeof(int64_t));
+#ifdef __APPLE__
+    value = (int64_t) st.st_mtimespec.tv_nsec;
+#else
+    value = (int64_t) st.st_mtim.tv_nsec;
+#endif
+    *hash = hashBytes(*hash, &value, sizeof(int64_t));
+    
+    return 1;
+}
+
+static uint64_t hashPredicate(uint64_t hash, const GPTLabelPredicate* predicate)
+{
+    int i;
+    
+    hash = hashInt(hash, (int) predicate->type);
+    hash = hashInt(hash, predicate->numberOfValues);
+    for (i=0; i<predicate->numberOfValues; i++) hash = hashInt(hash, predicate->values[i]);
+    hash = hashInt(hash, predicate->numberOfOperands);
+    for (i=0; i<predicate->numberOfOperands; i++) hash = hashPredicate(hash, &(predicate->operands[i]));
+    return hash;
+}
+
+int getServerCacheKey(GPTServer* server, const GPTLabelPredicate* labelPredicate,
+                      int maximumNumberOfSamplesPerLabel, uint64_t* key)
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+    int f;
+    
+    hash = hashInt(hash, CACHE_VERSION);
+    hash = hashInt(hash, (int) sizeof(PIOTimeRange));
+    hash = hashInt(hash, (int) sizeof(int));
+    
+    hash = hashInt(hash, LBL_AVAILABLE(*server));
+    if (LBL_AVAILABLE(*server))
+    {
+        hash = hashString(hash, LBL_DATASET(*server));
+        hash = hashInt(hash, LBL_NFILES(*server));
+        for (f=0; f<LBL_NFILES(*server); f++)
+            if (hashFile(&hash, LBL_PATH(*server, f)) < 0) return -1;
+    }
+    
+    hash = hashInt(hash, DAT_AVAILABLE(*server));
+    if (DAT_AVAILABLE(*server))
+    {
+        hash = hashString(hash, DAT_DATASET(*server));
+        hash = hashInt(hash, DAT_NFILES(*server));
+        for (f=0; f<DAT_NFILES(*server); f++)
+            if (hashFile(&hash, DAT_PATH(*server, f)) < 0) return -1;
+    }
+    
+    hash = hashPredicate(hash, labelPredicate);
+    hash = hashInt(hash, maximumNumberOfSamplesPerLabel);
+    
+    *key = hash;
+    return 1;
+}
+
+// ===================================
+// Loading
+// ===================================
+
+typedef struct {
+    const char* data;
+    size_t size;
+    size_t position;
+} cacheReader_t;
+
+static const void* take(cacheReader_t* reader, size_t size)
+{
+    const void* bytes;
+    
+    if (size > reader->size - reader->position) return NULL;
+    bytes = reader->data + reader->position;
+    reader->position += size;
+    return bytes;
+}
+
+static int takeInt(cacheReader_t* reader, int* value)
+{
+    const void* bytes = take(reader, sizeof(int));
+    if (!bytes) return -1;
+    memcpy(value, bytes, sizeof(int));
+    return 1;
+}
+
+// copy an array of number*size bytes into a new buffer
+static void* takeArray(cacheReader_t* reader, int number, size_t size)
+{
+    const void* bytes;
+    void* array;
+    
+    if (number < 0) return NULL;
+    if ((size_t)number > (reader->size - reader->position)/size) return NULL;
+    
+    bytes = take(reader, number*size);
+    array = malloc(number > 0 ? number*size : 1);
+    if (array) memcpy(array, bytes, number*size);
+    return array;
+}
+
+static void** newArrayOfArrays(int number)
+{
+    return (void**) calloc(number > 0 ? number : 1, sizeof(void*));
+}
+
+static void freeArrayOfArrays(void** arrays, int number)
+{
+    int f;
+    if (!arrays) return;
+    for (f=0; f<number; f++) free(arrays[f]);
+    free(arrays);
+}
+
+// release whatever loadServerCache() allocated so far
+static void discardCache(GPTServer* server)
+{
+    int nLabelFiles = LBL_AVAILABLE(*server) ? LBL_NFILES(*server) : 0;
+    int nDataFiles = DAT_AVAILABLE(*server) ? DAT_NFILES(*server) : 0;
+    
+    free(server->lengthOfLabelTimeline);
+    freeArrayOfArrays((void**) server->labelTimeline, nLabelFiles);
+    freeArrayOfArrays((void**) server->label, nLabelFiles);
+    freeArrayOfArrays((void**) server->numberOfLabelsPerFilePerTimerange, nLabelFiles);
+    freeArrayOfArrays((void**) server->indexOfFirstLabelPerFilePerTimerange, nLabelFiles);
+    server->lengthOfLabelTimeline = NULL;
+    server->labelTimeline = NULL;
+    server->label = NULL;
+    server->numberOfLabelsPerFilePerTimerange = NULL;
+    server->indexOfFirstLabelPerFilePerTimerange = NULL;
+    
+    free(server->lengthOfDataTimeline);
+    freeArrayOfArrays((void**) server->dataTimeline, nDataFiles);
+    freeArrayOfArrays((void**) server->numberOfEntriesPerTimerangePerFile, nDataFiles);
+    freeArrayOfArrays((void**) server->firstCorrespondingLabelTimerange, nDataFiles);
+    freeArrayOfArrays((void**) server->numberOfCorrespondingLabelTimerange, nDataFiles);
+    freeArrayOfArrays((void**) server->filtered, nDataFiles);
+    server->lengthOfDataTimeline = NULL;
+    server->dataTimeline = NULL;
+    server->numberOfEntriesPerTimerangePerFile = NULL;
+    server->firstCorrespondingLabelTimerange = NULL;
+    server->numberOfCorrespondingLabelTimerange = NULL;
+    server->filtered = NULL;
+}
+
+static int loadLabels(GPTServer* server, cacheReader_t* reader)
+{
+    int f, t, n, total;
+    
+    server->lengthOfLabelTimeline = (int*) calloc(LBL_NFILES(*server) > 0 ? LBL_NFILES(*server) : 1, sizeof(int));
+    server->labelTimeline = (PIOTimeRange**) newArrayOfArrays(LBL_NFILES(*server));
+    server->label = (int**) newArrayOfArrays(LBL_NFILES(*server));
+    server->numberOfLabelsPerFilePerTimerange = (int**) newArrayOfArrays(LBL_NFILES(*server));
+    server->indexOfFirstLabelPerFilePerTimerange = (int**) newArrayOfArrays(LBL_NFILES(*server));
+    
+    for (f=0; f<LBL_NFILES(*server); f++)
+    {
+        if (takeInt(reader, &n) < 0) return -1;
+        LBL_NTIMERANGES(*server, f) = n;
+        
+        LBL_TIMELINE(*server, f) = (PIOTimeRange*) takeArray(reader, n, sizeof(PIOTimeRange));
+        if (!LBL_TIMELINE(*server, f)) return -1;
+        
+        server->numberOfLabelsPerFilePerTimerange[f] = (int*) takeArray(reader, n, sizeof(int));
+        if (!server->numberOfLabelsPerFilePerTimerange[f]) return -1;
+        
+        // labels of tth timerange start where labels of (t-1)th timerange end
+        server->indexOfFirstLabelPerFilePerTimerange[f] = (int*) malloc(n > 0 ? n*sizeof(int) : 1);
+        total = 0;
+        for (t=0; t<n; t++)
+        {
+            if (LBL_NLABELS(*server, f, t) < 0) return -1;
+            server->indexOfFirstLabelPerFilePerTimerange[f][t] = total;
+            total += LBL_NLABELS(*server, f, t);
+        }
+        
+        if ((takeInt(reader, &n) < 0) || (n != total)) return -1;
+        server->label[f] = (int*) takeArray(reader, total, sizeof(int));
+        if (!server->label[f]) return -1;
+    }
+    
+    return 1;
+}
+
+static int loadData(GPTServer* server, cacheReader_t* reader, PIOBaseType* type, int* dimension)
+{
+    int f, n;
+    int baseType;
+    
+    if (takeInt(reader, &baseType) < 0) return -1;
+    if (takeInt(reader, dimension) < 0) return -1;
+    if (*dimension < 1) return -1;
+    *type = (PIOBaseType) baseType;
+    
+    server->lengthOfDataTimeline = (int*) calloc(DAT_NFILES(*server) > 0 ? DAT_NFILES(*server) : 1, sizeof(int));
+    server->dataTimeline = (PIOTimeRange**) newArrayOfArrays(DAT_NFILES(*server));
+    server->numberOfEntriesPerTimerangePerFile = (int**) newArrayOfArrays(DAT_NFILES(*server));
+    server->firstCorrespondingLabelTimerange = (int**) newArrayOfArrays(DAT_NFILES(*server));
+    server->numberOfCorrespondingLabelTimerange = (int**) newArrayOfArrays(DAT_NFILES(*server));
+    server->filtered = (int**) newArrayOfArrays(DAT_NFILES(*server));
+    
+    for (f=0; f<DAT_NFILES(*server); f++)
+    {
+        if (takeInt(reader, &n) < 0) return -1;
+        DAT_NTIMERANGES(*server, f) = n;
+        
+        if (!(DAT_TIMELINE(*server, f) = (PIOTimeRange*) takeArray(reader, n, sizeof(PIOTimeRange)))) return -1;
+        if (!(server->numberOfEntriesPerTimerangePerFile[f]  = (int*) takeArray(reader, n, sizeof(int)))) return -1;
+        if (!(server->firstCorrespondingLabelTimerange[f]    = (int*) takeArray(reader, n, sizeof(int)))) return -1;
+        if (!(server->numberOfCorrespondingLabelTimerange[f] = (int*) takeArray(reader, n, sizeof(int)))) return -1;
+        if (!(server->filtered[f]                            = (int*) takeArray(reader, n, sizeof(int)))) return -1;
+    }
+    
+    return 1;
+}
+
+int loadServerCache(GPTServer* server, const char* path, uint64_t key)
+{
+    FILE* file = NULL;
+    struct stat st;
+    char* buffer = NULL;
+    cacheReader_t reader;
+    const void* bytes;
+    uint64_t storedKey;
+    int version;
+    int status = 1;
+    PIOBaseType type = PINOCCHIO_TYPE_INT;
+    int dimension = -1;
+    
+    file = fopen(path, "rb");
+    if (!file) return 0;
+    
+    // read the whole cache at once
+    if ((fstat(fileno(file), &st) < 0) || (st.st_size < CACHE_MAGIC_SIZE))
+    {
+        fclose(file);
+        return 0;
+    }
+    buffer = (char*) malloc(st.st_size);
+    if (!buffer || (fread(buffer, 1, st.st_size, file) != (size_t) st.st_size))
+    {
+        free(buffer);
+        fclose(file);
+        return 0;
+    }
+    fclose(file);
+    
+    reader.data = buffer;
+    reader.size = st.st_size;
+    reader.position = 0;
+    
+    // check header
+    bytes = take(&reader, CACHE_MAGIC_SIZE);
+    if (memcmp(bytes, CACHE_MAGIC, CACHE_MAGIC_SIZE)) status = 0;
+    if ((status > 0) && ((takeInt(&reader, &version) < 0) || (version != CACHE_VERSION))) status = 0;
+    if ((status > 0) && !(bytes = take(&reader, sizeof(uint64_t)))) status = 0;
+    if (status > 0)
+    {
+        memcpy(&storedKey, bytes, sizeof(uint64_t));
+        if (storedKey != key) status = 0;
+    }
+    
+    // load arrays
+    if ((status > 0) && LBL_AVAILABLE(*server))
+        if (loadLabels(server, &reader) < 0) status = 0;
+    if ((status > 0) && DAT_AVAILABLE(*server))
+        if (loadData(server, &reader, &type, &dimension) < 0) status = 0;
+    
+    // check trailer
+    if (status > 0)
+    {
+        bytes = take(&reader, CACHE_MAGIC_SIZE);
+        if (!bytes || memcmp(bytes, CACHE_MAGIC, CACHE_MAGIC_SIZE) || (reader.position != reader.size))
+            status = 0;
+    }
+    
+    free(buffer);
+    
+    if (status <= 0)
+    {
+        discardCache(server);
+        return 0;
+    }
+    
+    if (LBL_AVAILABLE(*server)) server->labelDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    if (DAT_AVAILABLE(*server)) server->datatype = pioNewDatatype(type, dimension);
+    
+    return 1;
+}
+
+// ===================================
+// Saving
+// ===================================
+
+static int putInt(FILE* file, int value)
+{
+    return (fwrite(&value, sizeof(int), 1, file) == 1) ? 1 : -1;
+}
+
+static int putArray(FILE* file, const void* array, int number, size_t size)
+{
+    if (number == 0) return 1;
+    return (fwrite(array, size, number, file) == (size_t) number) ? 1 : -1;
+}
+
+static int saveLabels(GPTServer* server, FILE* file)
+{
+    int f, t, total;
+    
+    for (f=0; f<LBL_NFILES(*server); f++)
+    {
+        total = 0;
+        for (t=0; t<LBL_NTIMERANGES(*server, f); t++) total += LBL_NLABELS(*server, f, t);
+        
+        if (putInt(file, LBL_NTIMERANGES(*server, f)) < 0) return -1;
+        if (putArray(file, LBL_TIMELINE(*server, f), LBL_NTIMERANGES(*server, f), sizeof(PIOTimeRange)) < 0) return -1;
+        if (putArray(file, server->numberOfLabelsPerFilePerTimerange[f], LBL_NTIMERANGES(*server, f), sizeof(int)) < 0) return -1;
+        if (putInt(file, total) < 0) return -1;
+        if (putArray(file, server->label[f], total, sizeof(int)) < 0) return -1;
+    }
+    
+    return 1;
+}
+
+static int saveData(GPTServer* server, FILE* file)
+{
+    int f;
+    
+    if (putInt(file, (int) server->datatype.type) < 0) return -1;
+    if (putInt(file, server->datatype.dimension) < 0) return -1;
+    
+    for (f=0; f<DAT_NFILES(*server); f++)
+    {
+        if (putInt(file, DAT_NTIMERANGES(*server, f)) < 0) return -1;
+        if (putArray(file, DAT_TIMELINE(*server, f), DAT_NTIMERANGES(*server, f), sizeof(PIOTimeRange)) < 0) return -1;
+        if (putArray(file, server->numberOfEntriesPerTimerangePerFile[f],  DAT_NTIMERANGES(*server, f), sizeof(int)) < 0) return -1;
+        if (putArray(file, server->firstCorrespondingLabelTimerange[f],    DAT_NTIMERANGES(*server, f), sizeof(int)) < 0) return -1;
+        if (putArray(file, server->numberOfCorrespondingLabelTimerange[f], DAT_NTIMERANGES(*server, f), sizeof(int)) < 0) return -1;
+        if (putArray(file, server->filtered[f],                            DAT_NTIMERANGES(*server, f), sizeof(int)) < 0) return -1;
+    }
+    
+    return 1;
+}
+
+int saveServerCache(GPTServer* server, const char* path, uint64_t key)
+{
+    FILE* file = NULL;
+    char* temporary = NULL;
+    int version = CACHE_VERSION;
+    int status = 1;
+    
+    // write to a temporary file first so that concurrent servers never see a partial cache
+    temporary = (char*) malloc(strlen(path)+32);
+    sprintf(temporary, "%s.%ld.tmp", path, (long) getpid());
+    
+    file = fopen(temporary, "wb");
+    if (!file)
+    {
+        free(temporary);
+        return -1;
+    }
+    
+    if ((fwrite(CACHE_MAGIC, 1, CACHE_MAGIC_SIZE, file) != CACHE_MAGIC_SIZE) ||
+        (putInt(file, version) < 0) ||
+        (fwrite(&key, sizeof(uint64_t), 1, file) != 1))
+        status = -1;
+    
+    if ((status > 0) && LBL_AVAILABLE(*server)) status = saveLabels(server, file);
+    if ((status > 0) && DAT_AVAILABLE(*server)) status = saveData(server, file);
+    
+    if ((status > 0) && (fwrite(CACHE_MAGIC, 1, CACHE_MAGIC_SIZE, file) != CACHE_MAGIC_SIZE))
+        status = -1;
+    
+    if (fclose(file) != 0) status = -1;
+    
+    if ((status > 0) && (rename(temporary, path) < 0)) status = -1;
+    if (status < 0) remove(temporary);
+    
+    free(temporary);
+    return status;
+}
@@ -0,0 +1,217 @@
+// 
+// Copyright 2010-2011 Herve BREDIN (bredin@limsi.fr)
+// Contact: http://pinocchio.niderb.fr/
+// 
+// This file is part of pinocchIO.
+//  
+//      pinocchIO is free software: you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation, either version 3 of the License, or
+//      (at your option) any later version.
+//  
+//      pinocchIO is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//  
+//      You should have received a copy of the GNU General Public License
+//      along with pinocchIO. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+#include "filter_utils.h"
+#include "hash_utils.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+// Label predicates are compiled into a bitmap over label ranks
+// (position in the sorted list of distinct label values):
+// comparisons and ranges are contiguous runs of ranks, found by binary search,
+// and AND/OR/NOT are bitwise operations on whole words.
+
+#define WORD_BITS 64
+
+int checkLabelPredicate(const GPTLabelPredicate* predicate)
+{
+    int i;
+    
+    if (!predicate) return -1;
+    
+    switch (predicate->type)
+    {
+        case GEPETTO_LABEL_PREDICATE_ANY:
+            return 1;
+        case GEPETTO_LABEL_PREDICATE_EQUALS_TO:
+        case GEPETTO_LABEL_PREDICATE_DIFFERS_FROM:
+        case GEPETTO_LABEL_PREDICATE_GREATER_THAN:
+        case GEPETTO_LABEL_PREDICATE_SMALLER_THAN:
+            return ((predicate->numberOfValues == 1) && predicate->values) ? 1 : -1;
+        case GEPETTO_LABEL_PREDICATE_IN_SET:
+            return ((predicate->numberOfValues >= 0) && 
+                    (predicate->values || (predicate->numberOfValues == 0))) ? 1 : -1;
+        case GEPETTO_LABEL_PREDICATE_IN_RANGE:
+            return ((predicate->numberOfValues == 2) && predicate->values) ? 1 : -1;
+        case GEPETTO_LABEL_PREDICATE_AND:
+        case GEPETTO_LABEL_PREDICATE_OR:
+        case GEPETTO_LABEL_PREDICATE_NOT:
+            if ((predicate->numberOfOperands < 1) || !predicate->operands) return -1;
+            if ((predicate->type == GEPETTO_LABEL_PREDICATE_NOT) && (predicate->numberOfOperands != 1)) return -1;
+            for (i=0; i<predicate->numberOfOperands; i++)
+                if (checkLabelPredicate(&(predicate->operands[i])) < 0) return -1;
+            return 1;
+        default:
+            return -1;
+    }
+}
+
+// rank of first label value greater than or equal to value
+static int lowerBound(GPTServer* server, int value)
+{
+    int first = 0, count = LBL_NUMBER(*server), step;
+    
+    while (count > 0)
+    {
+        step = count/2;
+        if (LBL_VALUE(*server, first+step) < value)
+        {
+            first += step+1;
+            count -= step+1;
+        }
+        else count = step;
+    }
+    return first;
+}
+
+// rank of first label value strictly greater than value
+static int upperBound(GPTServer* server, int value)
+{
+    int first = 0, count = LBL_NUMBER(*server), step;
+    
+    while (count > 0)
+    {
+        step = count/2;
+        if (LBL_VALUE(*server, first+step) <= value)
+        {
+            first += step+1;
+            count -= step+1;
+        }
+        else count = step;
+    }
+    return first;
+}
+
+// set bits of ranks from (included) to (excluded)
+static void setRanks(uint64_t* bitmap, int from, int to)
+{
+    int r;
+    for (r=from; r<to; r++) bitmap[r/WORD_BITS] |= ((uint64_t)1) << (r%WORD_BITS);
+}
+
+static void setRank(GPTServer* server, uint64_t* bitmap, int value)
+{
+    int r = lowerBound(server, value);
+    if ((r < LBL_NUMBER(*server)) && (LBL_VALUE(*server, r) == value)) setRanks(bitmap, r, r+1);
+}
+
+static uint64_t* compileNode(GPTServer* server, const GPTLabelPredicate* predicate, int numberOfWords)
+{
+    uint64_t* bitmap = NULL;
+    uint64_t* operand = NULL;
+    int n = LBL_NUMBER(*server);
+    int i, w;
+    
+    bitmap = (uint64_t*) calloc(numberOfWords, sizeof(uint64_t));
+    
+    switch (predicate->type)
+    {
+        case GEPETTO_LABEL_PREDICATE_ANY:
+            setRanks(bitmap, 0, n);
+            break;
+        case GEPETTO_LABEL_PREDICATE_EQUALS_TO:
+            setRank(server, bitmap, predicate->values[0]);
+            break;
+        case GEPETTO_LABEL_PREDICATE_DIFFERS_FROM:
+            setRanks(bitmap, 0, lowerBound(server, predicate->values[0]));
+            setRanks(bitmap, upperBound(server, predicate->values[0]), n);
+            break;
+        case GEPETTO_LABEL_PREDICATE_GREATER_THAN:
+            setRanks(bitmap, upperBound(server, predicate->values[0]), n);
+            break;
+        case GEPETTO_LABEL_PREDICATE_SMALLER_THAN:
+            setRanks(bitmap, 0, lowerBound(server, predicate->values[0]));
+            break;
+        case GEPETTO_LABEL_PREDICATE_IN_SET:
+            for (i=0; i<predicate->numberOfValues; i++)
+                setRank(server, bitmap, predicate->values[i]);
+            break;
+        case GEPETTO_LABEL_PREDICATE_IN_RANGE:
+            if (predicate->values[0] <= predicate->values[1])
+                setRanks(bitmap, lowerBound(server, predicate->values[0]), upperBound(server, predicate->values[1]));
+            break;
+        case GEPETTO_LABEL_PREDICATE_AND:
+        case GEPETTO_LABEL_PREDICATE_OR:
+            if (predicate->type == GEPETTO_LABEL_PREDICATE_AND) setRanks(bitmap, 0, n);
+            for (i=0; i<predicate->numberOfOperands; i++)
+            {
+                operand = compileNode(server, &(predicate->operands[i]), numberOfWords);
+                if (predicate->type == GEPETTO_LABEL_PREDICATE_AND)
+                    for (w=0; w<numberOfWords; w++) bitmap[w] &= operand[w];
+                else
+                    for (w=0; w<numberOfWords; w++) bitmap[w] |= operand[w];
+                free(operand);
+            }
+            break;
+        case GEPETTO_LABEL_PREDICATE_NOT:
+            operand = compileNode(server, &(predicate->operands[0]), numberOfWords);
+            setRanks(bitmap, 0, n);
+            for (w=0; w<numberOfWords; w++) bitmap[w] &= ~operand[w];
+            free(operand);
+            break;
+        default:
+            break;
+    }
+    
+    return bitmap;
+}
+
+int compileLabelFilter(GPTServer* server, const GPTLabelPredicate* predicate)
+{
+    uint64_t* bitmap = NULL;
+    labelMap_t* rankOfLabel = NULL;
+    int numberOfWords;
+    int numberOfLabels;
+    int f, t, i, r;
+    
+    if (checkLabelPredicate(predicate) < 0) return -1;
+    
+    rankOfLabel = newLabelMap(LBL_NUMBER(*server));
+    if (!rankOfLabel) return -1;
+    for (r=0; r<LBL_NUMBER(*server); r++)
+        *labelMapInsert(rankOfLabel, LBL_VALUE(*server, r)) = r;
+    
+    numberOfWords = LBL_NUMBER(*server)/WORD_BITS + 1;
+    bitmap = compileNode(server, predicate, numberOfWords);
+    
+    if (!server->labelAccepted)
+        server->labelAccepted = (char**) calloc(LBL_NFILES(*server), sizeof(char*));
+    
+    // one pass over the labels of each file
+    for (f=0; f<LBL_NFILES(*server); f++)
+    {
+        t = LBL_NTIMERANGES(*server, f);
+        numberOfLabels = (t > 0) ? server->indexOfFirstLabelPerFilePerTimerange[f][t-1] + LBL_NLABELS(*server, f, t-1) : 0;
+        
+        free(server->labelAccepted[f]);
+        server->labelAccepted[f] = (char*) malloc(numberOfLabels+1);
+        for (i=0; i<numberOfLabels; i++)
+        {
+            r = labelMapFind(rankOfLabel, server->label[f][i], 0);
+            server->labelAccepted[f][i] = (char)((bitmap[r/WORD_BITS] >> (r%WORD_BITS)) & 1);
+        }
+    }
+    
+    free(bitmap);
+    destroyLabelMap(rankOfLabel);
+    return 1;
+}
@@ -54,6 +54,18 @@ filter = {
 	# smallerThan = 1;
  
     maximumNumberOfSamples = 2000;
+ 
+	# compound filter on label values (replaces the above)
+	# accept = { or = ( { in = [1, 12, 37]; },
+	#                   { and = ( { inRange = [100, 199]; }, { not = { equalsTo = 150; }; } ); } ); };
+};
+
+server = {
+	numberOfProcesses = 8; // scan files with 8 processes
+	prefetchDepth = 256; // read up to 256 timeranges ahead...
+	prefetchMemory = 64; // ... but no more than 64MB
+	openFiles = 32; // keep up to 32 files open between reads
+	cache = "/tmp/TRECVid2007_devel_1001.cache"; // skip file scan when nothing changed
 };
 \endverbatim
 
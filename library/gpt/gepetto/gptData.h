@@ -60,6 +60,14 @@ int gptGetServerDimension(GPTServer server);
  into another variable before calling gptReadNext() again.\n
  See pioRead() documentation for more information on how to use @a buffer.
  
+ @note
+ When the server was created with a positive @ref GPTServerOptions "prefetchDepth",
+ a background thread opens files and reads upcoming timeranges ahead of time
+ (within @ref GPTServerOptions "prefetchMemory" bytes) so that gptReadNext() 
+ seldom has to wait for the disk. This thread runs until the end of the server is reached,
+ or until gptCloseServer() is called: in the meantime, the application must not
+ call pinocchIO functions directly (Gepetto functions are fine).
+ 
  @param[in,out] server Gepetto server 
  @param[in] datatype Buffer datatype
  @param[out] buffer Data buffer
@@ -103,6 +111,293 @@ int gptReadNext(GPTServer* gptServer,
 #define gptReadNextData(server, datatype, buffer) gptReadNext((server), (datatype), (buffer), NULL, NULL)
 
 
+/**
+ @brief Read next data entries and their labels from server, by batch
+ 
+ Fill @a buffer with up to @a maxVectors next data entries available from the @a server,
+ from the current position of gptReadNext() (which is moved accordingly).
+ Consecutive timeranges are read at once, directly into @a buffer.
+ A timerange is never split between two batches: 
+ reading stops before the first timerange that does not fit.
+ 
+ For each entry v of the batch:
+ - labels[v] is the first label of its timerange matching the server label filter 
+ (or @ref GEPETTO_NO_LABEL if there is none, or if the server does not serve labels),
+ - fileIndices[v] is the index of the file it comes from,
+ - timeranges[v] is the index of its timerange in this file.
+ 
+ @param[in,out] server Gepetto server 
+ @param[in] datatype Buffer datatype
+ @param[in] maxVectors Maximum number of entries
+ @param[out] buffer Data buffer, large enough for @a maxVectors entries
+ @param[out] labels Entry labels (array of size @a maxVectors, or NULL)
+ @param[out] fileIndices Entry file indices (array of size @a maxVectors, or NULL)
+ @param[out] timeranges Entry timerange indices (array of size @a maxVectors, or NULL)
+ 
+ @returns
+ - number of entries in @a buffer when successful
+ - @ref GEPETTO_END_OF_SERVER (-1) when the end of the server is reached 
+ (server position is then reset to the beginning)
+ - @ref GEPETTO_BATCH_TOO_SMALL when next timerange alone contains more than @a maxVectors entries
+ (server position is left unchanged: call again with a larger batch to read it)
+ - @ref GEPETTO_READ_FAILURE when data cannot be read
+ (server position is left unchanged, at the timerange that failed)
+ 
+ @note
+ When a failure occurs after some entries were already read, they are returned
+ and the failure is reported by the next call.
+ 
+\par Example
+\verbatim
+ float buffer[1000*dimension];
+ int labels[1000];
+ while ((number = gptReadBatch(&server, datatype, 1000, buffer, labels, NULL, NULL)) >= 0)
+ {
+     // process number entries
+ }
+ if (number != GEPETTO_END_OF_SERVER)
+ {
+     // a timerange has more than 1000 entries, or data could not be read
+ }
+\endverbatim
+
+ @ingroup gptdata
+ */
+int gptReadBatch(GPTServer* server,
+                 PIODatatype datatype,
+                 int maxVectors,
+                 void* buffer,
+                 int* labels,
+                 int* fileIndices,
+                 int* timeranges);
+
+/**
+ @brief Change label filter of a server
+ 
+ Replace the label filter of the @a server by @a predicate, without scanning 
+ data and label files again: only served timeranges are updated
+ (and sampled again if the server has a maximum number of samples per label).
+ The position of gptReadNext() is reset to the beginning of the server.
+ 
+ @param[in,out] server Gepetto server
+ @param[in] predicate Label predicate (not kept by the server)
+ 
+ @returns
+ - 1 when successful
+ - -1 if the server does not serve labels, @a predicate is invalid, readers 
+ of the server are still open (see gptNewReader()) or the new served timeranges 
+ could not be computed. In this case, served timeranges and position of 
+ gptReadNext() are left unchanged.
+ 
+ @note
+ server.labelFilterType and server.labelFilterReference are left untouched.
+ 
+\par Example
+\verbatim
+ int concepts[3] = {12, 37, 41};
+ GPTLabelPredicate predicate = {GEPETTO_LABEL_PREDICATE_IN_SET, 3, concepts, 0, NULL};
+ gptSetLabelFilter(&server, &predicate);
+\endverbatim
+ 
+ @ingroup gptdata
+ */
+int gptSetLabelFilter(GPTServer* server,
+                      const GPTLabelPredicate* predicate);
+
+/**
+ @brief Change the order in which gptReadNext() and gptReadBatch() go through the server
+ 
+ Served timeranges are read in file order then chronological order by default
+ (@ref GEPETTO_ITERATION_MODE_SEQUENTIAL). Other modes precompute, at the beginning of
+ each epoch (i.e. each pass over the server), a permutation of served timeranges:
+ - @ref GEPETTO_ITERATION_MODE_SHUFFLE: random order
+ - @ref GEPETTO_ITERATION_MODE_ROUND_ROBIN: one timerange of each label value after the other,
+   until all of them are served
+ - @ref GEPETTO_ITERATION_MODE_STRATIFIED: timeranges of each label value are spread 
+   evenly over the epoch, so that every block of @a blockSize timeranges 
+   follows the distribution of label values of the whole server
+ 
+ In the last two modes, timeranges are grouped by their first label accepted by the label filter.
+ Within each label value (or the whole server, for @ref GEPETTO_ITERATION_MODE_SHUFFLE), 
+ the order is random, and changes at each epoch. The same @a seed always gives the same epochs.
+ 
+ In order to keep I/O efficient, the permutation is cut into blocks of @a blockSize 
+ timeranges (typically, the number of timeranges of a mini-batch), and timeranges are read file by file, 
+ chronologically, within each block. Recently used data files are kept open. 
+ Use a @a blockSize of 1 to read timeranges in permutation order exactly.
+ 
+ @param[in,out] server Gepetto server
+ @param[in] mode Iteration mode
+ @param[in] seed Random seed
+ @param[in] blockSize Number of timeranges per block 
+ (not vectors: a timerange may hold several vectors, see example below)
+ 
+ @returns
+ - 1 when successful
+ - -1 otherwise (round-robin and stratified modes require labels)
+ 
+ @note
+ The position of gptReadNext() is reset to the beginning of the server.\n
+ Read-ahead (@ref GPTServerOptions "prefetchDepth") only applies to the sequential mode.\n
+ gptDumpServer() always dumps the server in file order.
+ 
+\par Example
+\verbatim
+ // 10 epochs of stratified mini-batches of 256 vectors,
+ // from timeranges holding 4 vectors on average: blocks of 256/4 timeranges
+ gptSetIterationMode(&server, GEPETTO_ITERATION_MODE_STRATIFIED, 42, 256/4);
+ for (epoch=0; epoch<10; epoch++)
+    while ((n = gptReadBatch(&server, datatype, 256, buffer, labels, NULL, NULL)) > 0)
+        train(buffer, labels, n);
+\endverbatim
+ 
+ @ingroup gptdata
+ */
+int gptSetIterationMode(GPTServer* server,
+                        GPTIterationMode mode,
+                        unsigned int seed,
+                        int blockSize);
+
+/**
+ @brief Create new reader of a Gepetto server
+ 
+ Same as gptNewReaderWithSharding() with @ref GEPETTO_SHARDING_BY_ENTRIES.
+ 
+ @param[in] server Gepetto server
+ @param[in] shardIndex Index of the reader share, from 0 to @a numberOfShards-1
+ @param[in] numberOfShards Number of readers sharing the server
+ 
+ @returns
+ - new reader when successful
+ - NULL otherwise
+ 
+ @ingroup gptdata
+ */
+GPTReader* gptNewReader(GPTServer* server,
+                        int shardIndex,
+                        int numberOfShards);
+
+/**
+ @brief Create new reader of a share of a Gepetto server
+ 
+ gptReadNext() and gptReadBatch() keep their position inside the server:
+ a server can only be read by one consumer. Readers have their own position
+ (and their own data and label buffers) instead, so that several threads can
+ read the same server at once, each one with its own reader.
+ 
+ Served timeranges, in file order then chronological order, are split into
+ @a numberOfShards disjoint shares: the reader goes through share @a shardIndex only.
+ - @ref GEPETTO_SHARDING_BY_FILE: each share is made of consecutive files
+ - @ref GEPETTO_SHARDING_BY_ENTRIES: each share is made of consecutive timeranges
+ holding about the same number of served entries (timeranges are never split)
+ 
+ The same shares are obtained by processes creating the same server with the same arguments.
+ 
+ @param[in] server Gepetto server (must not be closed before the reader)
+ @param[in] shardIndex Index of the reader share, from 0 to @a numberOfShards-1
+ @param[in] numberOfShards Number of readers sharing the server
+ @param[in] mode How served timeranges are split between readers
+ 
+ @returns
+ - new reader when successful
+ - NULL otherwise
+ 
+ @note
+ Readers always go through their share sequentially (see gptSetIterationMode()).\n
+ Shares are computed when the reader is created: the server label filter cannot 
+ be changed (see gptSetLabelFilter()) until all its readers are closed.\n
+ Within a process, HDF5 calls of all readers (and of the server) are serialized: 
+ threads only overlap the work they do between two reads, not the reads themselves. 
+ To spread reading over several cores, run one process per share instead 
+ (each process creating its own server and its own reader).
+ 
+\par Example
+\verbatim
+ // in each one of numberOfThreads threads
+ GPTReader* reader = gptNewReader(&server, thread, numberOfThreads);
+ while ((n = gptReaderReadBatch(reader, datatype, 256, buffer, labels, NULL, NULL)) > 0)
+    process(buffer, labels, n);
+ gptCloseReader(&reader);
+\endverbatim
+ 
+ @ingroup gptdata
+ */
+GPTReader* gptNewReaderWithSharding(GPTServer* server,
+                                    int shardIndex,
+                                    int numberOfShards,
+                                    GPTShardingMode mode);
+
+/**
+ @brief Read next data and its label from reader share
+ 
+ Same as gptReadNext(), within the share of @a reader.
+ 
+ @note
+ @a buffer and @a labels point to reader internal buffers. <b>Do not free them!</b>\n
+ They are modified (and possibly moved) by each call to gptReaderReadNext().
+ 
+ @param[in,out] reader Gepetto server reader
+ @param[in] datatype Buffer datatype
+ @param[out] buffer Data buffer
+ @param[out] nLabels Number of data labels. Use NULL if you are not interested in the labels.
+ @param[out] labels Data labels. Use NULL if you are not interested in the labels.
+ 
+ @returns
+ - @a number of entries when successful
+ - -1 when the end of the share is reached (reader position is then reset to its beginning),
+ or in case of failure
+ 
+ @ingroup gptdata
+ */
+int gptReaderReadNext(GPTReader* reader,
+                      PIODatatype datatype,
+                      void** buffer,
+                      int* nLabels,
+                      int** labels);
+
+/**
+ @brief Read next data entries and their labels from reader share, by batch
+ 
+ Same as gptReadBatch(), within the share of @a reader.
+ 
+ @param[in,out] reader Gepetto server reader
+ @param[in] datatype Buffer datatype
+ @param[in] maxVectors Maximum number of entries
+ @param[out] buffer Data buffer, large enough for @a maxVectors entries
+ @param[out] labels Entry labels (array of size @a maxVectors, or NULL)
+ @param[out] fileIndices Entry file indices (array of size @a maxVectors, or NULL)
+ @param[out] timeranges Entry timerange indices (array of size @a maxVectors, or NULL)
+ 
+ @returns
+ - number of entries in @a buffer when successful
+ - @ref GEPETTO_END_OF_SERVER (-1) when the end of the share is reached 
+ (reader position is then reset to its beginning)
+ - @ref GEPETTO_BATCH_TOO_SMALL or @ref GEPETTO_READ_FAILURE, as gptReadBatch()
+ 
+ @ingroup gptdata
+ */
+int gptReaderReadBatch(GPTReader* reader,
+                       PIODatatype datatype,
+                       int maxVectors,
+                       void* buffer,
+                       int* labels,
+                       int* fileIndices,
+                       int* timeranges);
+
+/**
+ @brief Close Gepetto server reader
+ 
+ Upon success, @a reader is set to NULL.
+ 
+ @param[in,out] reader Gepetto server reader
+ @returns
+ - 1 when reader is successfully closed
+ - 0 otherwise
+ 
+ @ingroup gptdata
+ */
+int gptCloseReader(GPTReader** reader);
+
 /**
  @brief Dump whole server data into buffer
  
@@ -114,6 +409,11 @@ int gptReadNext(GPTServer* gptServer,
  
  Entries are stored in the buffer the one after the other,
  sorted in file index/time range ascending order.
+ They are read directly into @a buffer, by blocks of consecutive time ranges.
+ 
+ @note
+ gptDumpServer() dumps the whole server: it does not depend on 
+ (and does not modify) the current position of gptReadNext().
  
  @note
  Buffer @a datatype does not have to match @a server datatype exactly.\n 
@@ -137,15 +437,15 @@ int gptReadNext(GPTServer* gptServer,
  // Allocate buffer for data
  buffer = malloc(size);
  // Dump the whole server
- totalNumber = gptDumpDataset(server, datatype, buffer);
+ int64_t totalNumber = gptDumpServer(server, datatype, buffer);
 \endverbatim
  
  
  @ingroup gptdata
  */
-long gptDumpServer(GPTServer* server,
-                   PIODatatype datatype,
-                   void* buffer);
+int64_t gptDumpServer(GPTServer* server,
+                      PIODatatype datatype,
+                      void* buffer);
 
 
 
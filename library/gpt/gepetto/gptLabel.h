@@ -78,6 +78,28 @@ int gptGetListOfDistinctLabels(GPTServer server, int* list);
 int gptGetTimerangesForLabel(GPTServer server,
                              int labelValue,
                              GPTTimeRange* timeranges);
+
+/**
+ @brief Get list of timeranges with a specified label, without copy
+ 
+ Same as gptGetTimerangesForLabel(), except that @a timeranges points
+ directly into the label index built when the server was created.
+ 
+ @param[in] server Gepetto server
+ @param[in] labelValue Label value
+ @param[out] timeranges Pointer to first timerange with requested label (NULL if there is none)
+ @returns total number of timeranges with matching label
+ 
+ @note
+ @a timeranges is sorted by file, then chronologically.
+ It must not be modified nor freed, and is no longer valid once the server is closed.
+ 
+ @ingroup gptlabel
+ 
+ */
+int gptGetTimerangesForLabelNoCopy(GPTServer server,
+                                   int labelValue,
+                                   const GPTTimeRange** timeranges);
                              
 #endif
 
@@ -74,11 +74,65 @@
  @returns 
     - valid Gepetto server when successful
     - invalid Gepetto server (@ref GPTServerInvalid) otherwise
+ 
+ See gptNewServerWithOptions() for more control.
  */
 GPTServer gptNewServer(int numberOfDataFiles, char** pathToDataFile, const char* pathToDataDataset,
                        GPTLabelFilterType labelFilterType, int labelFilterReference, int maximumNumberOfSamplesPerLabel,
                        int numberOfLabelFiles, char** pathToLabelFile, const char* pathToLabelDataset);
 
+/**
+ @brief Create new Gepetto server with options
+ 
+ Same as gptNewServer() except that server creation is driven by @a options.
+ 
+ Creating a server reads the timeline, the number of entries per timerange
+ and the labels of every data and label file. With @a options.numberOfProcesses
+ greater than 1, files are shared between the calling process and 
+ @a options.numberOfProcesses - 1 forked worker processes. Each of them scans its 
+ share with its own copy of the HDF5 library, so that HDF5 calls are not serialized:
+ this helps a lot with many files on slow or remote storage.
+ Files of a worker process that fails are scanned by the calling process.
+ 
+ With a positive @a options.prefetchDepth, gptReadNext() reads upcoming timeranges
+ ahead of time, in a background thread.
+ 
+ Data and label files are opened through a pool of pinocchIO handles (see pioNewPool())
+ that keeps up to @a options.maximumNumberOfOpenFiles of them open between reads:
+ files scanned last are not opened again by the first reads, and going back and forth
+ between a few files (see gptSetIterationMode()) does not reopen them every time.
+
+ When @a options.cacheFile is set, everything computed from the files
+ (timelines, labels, label/data correspondence and filtering) is saved there,
+ and loaded back in one sequential read by subsequent servers with the same
+ arguments, as long as none of the files changed (size and modification time).
+ A missing, stale or corrupted cache file is silently rebuilt.
+
+ When @a options.labelPredicate is set, it replaces @a labelFilterType and
+ @a labelFilterReference: it is compiled into one bit per distinct label value
+ and a timerange is served as soon as one of its labels is accepted.
+ See gptSetLabelFilter() to change it afterwards.
+
+ @param[in] numberOfDataFiles Number of data pinocchIO files
+ @param[in] pathToDataFile List of paths to data pinocchIO files
+ @param[in] pathToDataDataset Path to pinocchIO dataset containing server data
+ @param[in] labelFilterType Type of label filter
+ @param[in] labelFilterReference Reference of label filter
+ @param[in] maximumNumberOfSamplesPerLabel Maximum number of samples per label served by the server
+ @param[in] numberOfLabelFiles Number of label pinocchIO files
+ @param[in] pathToLabelFile List of paths to label pinocchIO files
+ @param[in] pathToLabelDataset Path to pinocchIO dataset containing server labels
+ @param[in] options Server options (see @ref GPTServerOptionsDefault)
+ 
+ @returns 
+    - valid Gepetto server when successful
+    - invalid Gepetto server (@ref GPTServerInvalid) otherwise
+ */
+GPTServer gptNewServerWithOptions(int numberOfDataFiles, char** pathToDataFile, const char* pathToDataDataset,
+                                  GPTLabelFilterType labelFilterType, int labelFilterReference, int maximumNumberOfSamplesPerLabel,
+                                  int numberOfLabelFiles, char** pathToLabelFile, const char* pathToLabelDataset,
+                                  GPTServerOptions options);
+
 /**
  @brief Close Gepetto server
  
@@ -21,6 +21,7 @@
 #ifndef _GEPETTO_TYPES_H
 #define _GEPETTO_TYPES_H
 
+#include <limits.h>
 #include "pinocchIO/pinocchIO.h"
 
 /**
@@ -44,7 +45,192 @@ typedef enum {
 	GEPETTO_LABEL_FILTER_TYPE_SMALLER_THAN
 } GPTLabelFilterType;
 
+/**
+ @brief Order in which served timeranges are read
+ 
+ See gptSetIterationMode().
+ 
+ @ingroup server
+ */
+typedef enum {
+    /** File order, then chronological order (default) */
+    GEPETTO_ITERATION_MODE_SEQUENTIAL,
+    /** Random order, shuffled again at each epoch */
+    GEPETTO_ITERATION_MODE_SHUFFLE,
+    /** One timerange of each label value after the other, in random order within each label value */
+    GEPETTO_ITERATION_MODE_ROUND_ROBIN,
+    /** Label values spread over the epoch in proportion to their number of timeranges, 
+        so that each block of timeranges follows the overall label distribution */
+    GEPETTO_ITERATION_MODE_STRATIFIED
+} GPTIterationMode;
+
+/**
+ @brief Partition of served timeranges between readers
+ 
+ See gptNewReaderWithSharding().
+ 
+ @ingroup server
+ */
+typedef enum {
+    /** Each reader gets its own range of consecutive files */
+    GEPETTO_SHARDING_BY_FILE,
+    /** Each reader gets its own range of consecutive timeranges,
+        holding about the same number of served entries */
+    GEPETTO_SHARDING_BY_ENTRIES
+} GPTShardingMode;
+
+/**
+ @brief Gepetto server reader
+ 
+ Opaque structure holding the position of one of several consumers 
+ of a Gepetto server. See gptNewReader().
+ 
+ @ingroup server
+ */
+typedef struct GPTReader_s GPTReader;
+
+/**
+ @brief Type of label predicate
+ 
+ See @ref GPTLabelPredicate.
+ 
+ @ingroup server
+ */
+typedef enum {
+    /** Any label value */
+    GEPETTO_LABEL_PREDICATE_ANY,
+    /** Label value equals to values[0] */
+    GEPETTO_LABEL_PREDICATE_EQUALS_TO,
+    /** Label value differs from values[0] */
+    GEPETTO_LABEL_PREDICATE_DIFFERS_FROM,
+    /** Label value is greater than values[0] */
+    GEPETTO_LABEL_PREDICATE_GREATER_THAN,
+    /** Label value is smaller than values[0] */
+    GEPETTO_LABEL_PREDICATE_SMALLER_THAN,
+    /** Label value is one of values[0], ..., values[numberOfValues-1] */
+    GEPETTO_LABEL_PREDICATE_IN_SET,
+    /** Label value is between values[0] and values[1] (both included) */
+    GEPETTO_LABEL_PREDICATE_IN_RANGE,
+    /** All operands hold */
+    GEPETTO_LABEL_PREDICATE_AND,
+    /** At least one operand holds */
+    GEPETTO_LABEL_PREDICATE_OR,
+    /** Single operand does not hold */
+    GEPETTO_LABEL_PREDICATE_NOT
+} GPTLabelPredicateType;
+
+/**
+ @brief Label predicate
+ 
+ Compound label filter: tree of comparisons combined with AND, OR and NOT.
+ A data timerange is served when at least one of its labels satisfies the predicate.
+ 
+ For instance, labels 12 or 37, or between 100 and 199 except 150:
+\verbatim
+ int concepts[2] = {12, 37};
+ int range[2] = {100, 199};
+ int excluded = 150;
+ GPTLabelPredicate not150[1] = {{GEPETTO_LABEL_PREDICATE_EQUALS_TO, 1, &excluded, 0, NULL}};
+ GPTLabelPredicate inRange[2] = {{GEPETTO_LABEL_PREDICATE_IN_RANGE, 2, range, 0, NULL},
+                                 {GEPETTO_LABEL_PREDICATE_NOT, 0, NULL, 1, not150}};
+ GPTLabelPredicate either[2] = {{GEPETTO_LABEL_PREDICATE_IN_SET, 2, concepts, 0, NULL},
+                                {GEPETTO_LABEL_PREDICATE_AND, 0, NULL, 2, inRange}};
+ GPTLabelPredicate predicate = {GEPETTO_LABEL_PREDICATE_OR, 0, NULL, 2, either};
+\endverbatim
+ 
+ @ingroup server
+ */
+typedef struct GPTLabelPredicate_s {
+    /** type of predicate */
+    GPTLabelPredicateType type;
+    /** number of reference values */
+    int numberOfValues;
+    /** reference values (comparisons, set and range) */
+    int* values;
+    /** number of operands */
+    int numberOfOperands;
+    /** operands (AND, OR and NOT) */
+    struct GPTLabelPredicate_s* operands;
+} GPTLabelPredicate;
+
+/**
+ @brief Label of data entries that have none
+ 
+ See gptReadBatch().
+ 
+ @ingroup server
+ */
+#define GEPETTO_NO_LABEL INT_MIN
+
+/**
+ @brief gptReadBatch() return value when the end of the server is reached
+ 
+ @ingroup server
+ */
+#define GEPETTO_END_OF_SERVER -1
+
+/**
+ @brief gptReadBatch() return value when next timerange alone does not fit into the batch
+ 
+ @ingroup server
+ */
+#define GEPETTO_BATCH_TOO_SMALL -2
+
+/**
+ @brief gptReadBatch() return value when data cannot be read
+ 
+ @ingroup server
+ */
+#define GEPETTO_READ_FAILURE -3
+
+/**
+ @brief Gepetto server options
+ 
+ @ingroup server
+ */
+typedef struct {
+    /** number of processes scanning data and label files when the server is created (1 to scan them in the calling process) */
+    int numberOfProcesses;
+    /** number of upcoming timeranges read ahead by gptReadNext() in a background thread (0 to disable read-ahead) */
+    int prefetchDepth;
+    /** maximum amount of read-ahead data, in bytes */
+    size_t prefetchMemory;
+    /** path to index cache file (NULL to disable caching), only used while the server is created */
+    const char* cacheFile;
+    /** compound label filter, replacing label filter type and reference when not NULL (only used while the server is created) */
+    const GPTLabelPredicate* labelPredicate;
+    /** maximum number of data and label files kept open between reads */
+    int maximumNumberOfOpenFiles;
+} GPTServerOptions;
+
+/**
+ @brief Default Gepetto server options
+ 
+ Files scanned by the calling process only, no read-ahead, no index cache,
+ up to 16 open files.
+ 
+ @ingroup server
+ */
+#define GPTServerOptionsDefault ((GPTServerOptions) {1, 0, 67108864, NULL, NULL, 16})
+
 
+/**
+ @brief pinocchIO time range
+ 
+ A time range can be seen as a time segment, with a start \a time and a \a duration.
+ 
+ pinocchIO stores time ranges internally using three integer values: \a time, \a duration and \a scale.
+ 
+ See @ref PIOTime for more detail on how to efficiently choose the \a scale.
+ 
+ @ingroup time
+ */
+typedef struct {
+    /** pinocchIO timerange */
+    PIOTimeRange timerange;
+    /** file index */
+    int fileIndex;
+} GPTTimeRange;
 
 /**
  @brief Label/data server
@@ -125,6 +311,23 @@ typedef struct {
      */
     int** labelCountsPerFile;
     
+    /**
+     @brief Inverted index: position of first label timerange for each label value
+     
+     labelTimeranges[firstLabelTimerange[i]] to labelTimeranges[firstLabelTimerange[i+1]-1]
+     are the label timeranges with ith label value.\n
+     firstLabelTimerange has LBL_NUMBER(server)+1 elements.
+     */
+    int* firstLabelTimerange;
+    
+    /**
+     @brief Inverted index: label timeranges, grouped by label value
+     
+     Within each group, label timeranges are sorted by file, then chronologically.\n
+     Getter: gptGetTimerangesForLabelNoCopy()
+     */
+    GPTTimeRange* labelTimeranges;
+    
     // -------
     // storage
     // -------
@@ -307,18 +510,28 @@ typedef struct {
      */
     int** filtered; 
     
+    /**
+     @brief Indicates whether a label matches the label filter
+     
+     labelAccepted[f][i] is set to 1 if label[f][i] matches the label filter.\n
+     Getter: LBL_ACCEPTED(server, f, t, r) for the rth label of the tth timerange in the fth file.
+     */
+    char** labelAccepted;
+    
     // ===================================
     // Internals
     // ===================================    
     
+    GPTServerOptions options;
+    
+    PIOPool* pool;
+    
     PIODatatype datatype;
     PIODatatype labelDatatype;
     
     int         current_file_index;
-    PIOFile     current_file;
-    
     int         current_timerange_index;
-    PIODataset  current_dataset;
+    PIODataset* current_dataset;
     PIODatatype current_datatype;
     PIOTimeline current_timeline;   
     
@@ -327,6 +540,11 @@ typedef struct {
     int  current_data_labels_number;
     int* current_data_labels;
     
+    struct prefetcher_s* prefetcher;
+    
+    struct iterator_s* iterator;
+    
+    int numberOfReaders;
     
 } GPTServer;
 
@@ -344,6 +562,8 @@ typedef struct {
 /* listOfDistinctLabels */      NULL,               \
 /* labelCounts */               NULL,               \
 /* labelCountsPerFile */        NULL,               \
+/* firstLabelTimerange */       NULL,               \
+/* labelTimeranges */           NULL,               \
 /* lengthOfLabelTimeline */     NULL,               \
 /* labelTimeline */             NULL,               \
 /* label */                     NULL,               \
@@ -364,36 +584,24 @@ typedef struct {
 /* firstCorrespondingLabelTimerange */    NULL,     \
 /* numberOfCorrespondingLabelTimerange */ NULL,     \
 /* filtered */                  NULL,               \
+/* labelAccepted */             NULL,               \
+/* options */                   {1, 0, 67108864, NULL, NULL, 16}, \
+/* pool */                      NULL,               \
 /* datatype */                  PIODatatypeInvalid, \
 /* labelDatatype */             PIODatatypeInvalid, \
 /* current_file_index */        -1,                 \
-/* curent_file */               PIOFileInvalid,     \
 /* current_timerange_index */   -1,                 \
-/* current_dataset */           PIODatasetInvalid,  \
+/* current_dataset */           NULL,               \
 /* current_datatype */          PIODatatypeInvalid, \
 /* current_timeline */          PIOTimelineInvalid, \
 /* eof */                       -1,                 \
 /* current_data_labels_number */ -1,                \
-/* current_data_labels */       NULL                \
+/* current_data_labels */       NULL,               \
+/* prefetcher */                NULL,               \
+/* iterator */                  NULL,               \
+/* numberOfReaders */           0                   \
 })
 
-/**
- @brief pinocchIO time range
- 
- A time range can be seen as a time segment, with a start \a time and a \a duration.
- 
- pinocchIO stores time ranges internally using three integer values: \a time, \a duration and \a scale.
- 
- See @ref PIOTime for more detail on how to efficiently choose the \a scale.
- 
- @ingroup time
- */
-typedef struct {
-    /** pinocchIO timerange */
-    PIOTimeRange timerange;
-    /** file index */
-    int fileIndex;
-} GPTTimeRange;
 
 // Label-related getters
 
@@ -415,6 +623,7 @@ typedef struct {
 #define LBL_LABELS( server, f, t)           ((server).label[(f)]+(server).indexOfFirstLabelPerFilePerTimerange[(f)][(t)])
 #define LBL_NLABELS(server, f, t)           ((server).numberOfLabelsPerFilePerTimerange[(f)][(t)])
 #define LBL_LABEL(  server, f, t, r)        ((LBL_LABELS((server), (f), (t)))[(r)])
+#define LBL_ACCEPTED(server, f, t, r)       ((server).labelAccepted[(f)][(server).indexOfFirstLabelPerFilePerTimerange[(f)][(t)]+(r)])
 
 #define LBL_TIMELINES(server)               ((server).labelTimeline)
 #define LBL_TIMELINE(server, f)             ((LBL_TIMELINES((server)))[(f)])
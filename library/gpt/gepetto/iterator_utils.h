@@ -0,0 +1,65 @@
+// 
+// Copyright 2010-2011 Herve BREDIN (bredin@limsi.fr)
+// Contact: http://pinocchio.niderb.fr/
+// 
+// This file is part of pinocchIO.
+//  
+//      pinocchIO is free software: you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation, either version 3 of the License, or
+//      (at your option) any later version.
+//  
+//      pinocchIO is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//  
+//      You should have received a copy of the GNU General Public License
+//      along with pinocchIO. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+#ifndef _ITERATOR_UTILS_H
+#define _ITERATOR_UTILS_H
+
+#include <stdint.h>
+#include "gptTypes.h"
+
+typedef struct {
+    int fileIndex;
+    int timerangeIndex;
+} iteratorPosition_t;
+
+// served timeranges of one epoch, in iteration order
+struct iterator_s {
+    GPTIterationMode mode;
+    int blockSize;
+    uint64_t state;
+    
+    int numberOfPositions;
+    iteratorPosition_t* positions;
+    int position;
+    int valid;
+    
+    // data file being read (taken from server pool)
+    PIOPool* pool;
+    int fileIndex;
+    PIODataset* dataset;
+};
+
+typedef struct iterator_s iterator_t;
+
+iterator_t* newIterator           (GPTIterationMode mode, unsigned int seed, int blockSize);
+void        destroyIterator       (iterator_t* iterator);
+
+int         peekIteratorPosition  (iterator_t* iterator, GPTServer* server,
+                                   int* fileIndex, int* timerangeIndex);
+int         peekIteratorPositionAt(iterator_t* iterator, int offset,
+                                   int* fileIndex, int* timerangeIndex);
+void        advanceIterator       (iterator_t* iterator, int count);
+void        invalidateIterator    (iterator_t* iterator);
+
+PIODataset* getIteratorDataset    (iterator_t* iterator, GPTServer* server, int fileIndex);
+void        releaseIteratorDataset(iterator_t* iterator);
+
+#endif
@@ -0,0 +1,85 @@
+// 
+// Copyright 2010-2011 Herve BREDIN (bredin@limsi.fr)
+// Contact: http://pinocchio.niderb.fr/
+// 
+// This file is part of pinocchIO.
+//  
+//      pinocchIO is free software: you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation, either version 3 of the License, or
+//      (at your option) any later version.
+//  
+//      pinocchIO is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//  
+//      You should have received a copy of the GNU General Public License
+//      along with pinocchIO. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+#ifndef _PREFETCH_UTILS_H
+#define _PREFETCH_UTILS_H
+
+#include <pthread.h>
+#include "gptTypes.h"
+
+typedef struct {
+    int fileIndex;
+    int timerangeIndex;
+    int number;
+    size_t size;
+    size_t capacity;
+    void* data;
+} prefetchSlot_t;
+
+// ring buffer of filtered timeranges read ahead by a background thread
+struct prefetcher_s {
+    // server storage (owned by the server, read-only)
+    int numberOfFiles;
+    char** pathToFile;
+    char* pathToDataset;
+    PIOPool* pool; // only used with the HDF5 lock held
+    int* numberOfTimeranges;
+    int** numberOfEntries;
+    int** filtered;
+    
+    PIODatatype datatype;
+    size_t entrySize;
+    
+    // position of next timerange to read
+    int fileIndex;
+    int timerangeIndex;
+    
+    // ring buffer (the oldest slot is held by the consumer)
+    int numberOfSlots;
+    prefetchSlot_t* slots;
+    int first;
+    int count;
+    int held;
+    size_t used;
+    size_t memory;
+    
+    int done;
+    int stop;
+    
+    int started;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t notEmpty;
+    pthread_cond_t notFull;
+    int consumerWaiting;
+    int producerWaiting;
+};
+
+typedef struct prefetcher_s prefetcher_t;
+
+prefetcher_t* startPrefetcher (GPTServer server, PIODatatype datatype,
+                               int fileIndex, int timerangeIndex);
+int           nextPrefetched  (prefetcher_t* prefetcher,
+                               int* fileIndex, int* timerangeIndex,
+                               int* number, void** buffer);
+int           stopPrefetcher  (prefetcher_t* prefetcher);
+
+#endif
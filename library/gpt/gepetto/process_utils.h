@@ -0,0 +1,35 @@
+// 
+// Copyright 2010-2011 Herve BREDIN (bredin@limsi.fr)
+// Contact: http://pinocchio.niderb.fr/
+// 
+// This file is part of pinocchIO.
+//  
+//      pinocchIO is free software: you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation, either version 3 of the License, or
+//      (at your option) any later version.
+//  
+//      pinocchIO is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//  
+//      You should have received a copy of the GNU General Public License
+//      along with pinocchIO. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+#ifndef _PROCESS_UTILS_H
+#define _PROCESS_UTILS_H
+
+#include <stdio.h>
+
+// task run by runInProcesses(), with NULL results when run by the calling process.
+// Tasks run by worker processes write their results, read back by the collecting
+// task in the calling process. Returns -1 when results cannot be written (or read).
+typedef int (*processTask_t)(void* context, int index, FILE* results);
+
+int runInProcesses (int numberOfProcesses, int numberOfTasks, 
+                    processTask_t task, processTask_t collect, void* context);
+
+#endif
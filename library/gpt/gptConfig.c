@@ -40,6 +40,22 @@ char* fgetln(FILE *fp, size_t *lenp);
 
 #define GEPETTO_CONFIGURATION_FILE_FILTER_MAXIMUM_SAMPLES "maximumNumberOfSamples"
 
+#define GEPETTO_CONFIGURATION_FILE_FILTER_ACCEPT "accept"
+#define GEPETTO_CONFIGURATION_FILE_PREDICATE_ANY "any"
+#define GEPETTO_CONFIGURATION_FILE_PREDICATE_IN_SET "in"
+#define GEPETTO_CONFIGURATION_FILE_PREDICATE_IN_RANGE "inRange"
+#define GEPETTO_CONFIGURATION_FILE_PREDICATE_AND "and"
+#define GEPETTO_CONFIGURATION_FILE_PREDICATE_OR "or"
+#define GEPETTO_CONFIGURATION_FILE_PREDICATE_NOT "not"
+
+#define GEPETTO_CONFIGURATION_FILE_SECTION_TITLE_SERVER "server"
+
+#define GEPETTO_CONFIGURATION_FILE_SERVER_NUMBER_OF_PROCESSES "numberOfProcesses"
+#define GEPETTO_CONFIGURATION_FILE_SERVER_PREFETCH_DEPTH "prefetchDepth"
+#define GEPETTO_CONFIGURATION_FILE_SERVER_PREFETCH_MEMORY "prefetchMemory"
+#define GEPETTO_CONFIGURATION_FILE_SERVER_CACHE "cache"
+#define GEPETTO_CONFIGURATION_FILE_SERVER_OPEN_FILES "openFiles"
+
 #define GEPETTO_CONFIGURATION_FILE_SECTION_TITLE_DATA   "data"
 #define GEPETTO_CONFIGURATION_FILE_SECTION_TITLE_LABEL  "label"
 
@@ -177,6 +193,358 @@ int getFilterFromConfigurationFile(const char* filename, GPTLabelFilterType* lab
     return 1;
 }
 
+/**
+ @brief Free label predicate parsed from configuration file
+ 
+ @param[in,out] predicate Label predicate (its content only is freed)
+ */
+static void freeLabelPredicate(GPTLabelPredicate* predicate)
+{
+    int i;
+    
+    free(predicate->values);
+    predicate->values = NULL;
+    predicate->numberOfValues = 0;
+    
+    for (i=0; i<predicate->numberOfOperands; i++)
+        freeLabelPredicate(&(predicate->operands[i]));
+    free(predicate->operands);
+    predicate->operands = NULL;
+    predicate->numberOfOperands = 0;
+}
+
+/**
+ @brief Parse label predicate
+ 
+ @a setting is a group with exactly one of:
+ - any = 1;
+ - equalsTo, differsFrom, greaterThan or smallerThan = value;
+ - in = [value1, value2, ...];
+ - inRange = [minimum, maximum];
+ - and = ( {predicate}, {predicate}, ... );
+ - or = ( {predicate}, {predicate}, ... );
+ - not = {predicate};
+ 
+ @param[in] setting Predicate setting
+ @param[out] predicate Label predicate
+ 
+ @returns
+ - 1 if successful
+ - -1 in case of failure
+ */
+static int parseLabelPredicate(const config_setting_t* setting, GPTLabelPredicate* predicate)
+{
+    const config_setting_t* member = NULL;
+    const char* name = NULL;
+    int i, n;
+    
+    predicate->type = GEPETTO_LABEL_PREDICATE_ANY;
+    predicate->numberOfValues = 0;
+    predicate->values = NULL;
+    predicate->numberOfOperands = 0;
+    predicate->operands = NULL;
+    
+    if (!config_setting_is_group(setting) || (config_setting_length(setting) != 1))
+    {
+        fprintf(stderr, "Label predicate at line %d must have exactly one member.\n",
+                config_setting_source_line(setting));
+        return -1;
+    }
+    
+    member = config_setting_get_elem(setting, 0);
+    name = config_setting_name(member);
+    
+    if (!strcmp(name, GEPETTO_CONFIGURATION_FILE_PREDICATE_ANY)) return 1;
+    
+    // comparisons
+    if (!strcmp(name, GEPETTO_CONFIGURATION_FILE_FILTER_TYPE_EQUALS_TO))
+        predicate->type = GEPETTO_LABEL_PREDICATE_EQUALS_TO;
+    else if (!strcmp(name, GEPETTO_CONFIGURATION_FILE_FILTER_TYPE_DIFFERS_FROM))
+        predicate->type = GEPETTO_LABEL_PREDICATE_DIFFERS_FROM;
+    else if (!strcmp(name, GEPETTO_CONFIGURATION_FILE_FILTER_TYPE_GREATER_THAN))
+        predicate->type = GEPETTO_LABEL_PREDICATE_GREATER_THAN;
+    else if (!strcmp(name, GEPETTO_CONFIGURATION_FILE_FILTER_TYPE_SMALLER_THAN))
+        predicate->type = GEPETTO_LABEL_PREDICATE_SMALLER_THAN;
+    if (predicate->type != GEPETTO_LABEL_PREDICATE_ANY)
+    {
+        if (config_setting_type(member) != CONFIG_TYPE_INT)
+        {
+            fprintf(stderr, "Label predicate %s at line %d expects an integer.\n",
+                    name, config_setting_source_line(member));
+            return -1;
+        }
+        predicate->numberOfValues = 1;
+        predicate->values = (int*) malloc(sizeof(int));
+        predicate->values[0] = config_setting_get_int(member);
+        return 1;
+    }
+    
+    // set and range
+    if (!strcmp(name, GEPETTO_CONFIGURATION_FILE_PREDICATE_IN_SET) ||
+        !strcmp(name, GEPETTO_CONFIGURATION_FILE_PREDICATE_IN_RANGE))
+    {
+        if (!strcmp(name, GEPETTO_CONFIGURATION_FILE_PREDICATE_IN_SET))
+            predicate->type = GEPETTO_LABEL_PREDICATE_IN_SET;
+        else
+            predicate->type = GEPETTO_LABEL_PREDICATE_IN_RANGE;
+        
+        n = config_setting_is_aggregate(member) ? config_setting_length(member) : -1;
+        if ((n < 0) || ((predicate->type == GEPETTO_LABEL_PREDICATE_IN_RANGE) && (n != 2)))
+        {
+            fprintf(stderr, "Label predicate %s at line %d expects %s.\n",
+                    name, config_setting_source_line(member),
+                    (predicate->type == GEPETTO_LABEL_PREDICATE_IN_RANGE) ? "[minimum, maximum]" : "an array of integers");
+            return -1;
+        }
+        predicate->numberOfValues = n;
+        predicate->values = (int*) malloc((n+1)*sizeof(int));
+        for (i=0; i<n; i++)
+        {
+            if (config_setting_type(config_setting_get_elem(member, i)) != CONFIG_TYPE_INT)
+            {
+                fprintf(stderr, "Label predicate %s at line %d expects integers.\n",
+                        name, config_setting_source_line(member));
+                freeLabelPredicate(predicate);
+                return -1;
+            }
+            predicate->values[i] = config_setting_get_int_elem(member, i);
+        }
+        return 1;
+    }
+    
+    // composition
+    if (!strcmp(name, GEPETTO_CONFIGURATION_FILE_PREDICATE_NOT))
+    {
+        predicate->type = GEPETTO_LABEL_PREDICATE_NOT;
+        predicate->numberOfOperands = 1;
+        predicate->operands = (GPTLabelPredicate*) calloc(1, sizeof(GPTLabelPredicate));
+        if (parseLabelPredicate(member, predicate->operands) < 0)
+        {
+            freeLabelPredicate(predicate);
+            return -1;
+        }
+        return 1;
+    }
+    
+    if (!strcmp(name, GEPETTO_CONFIGURATION_FILE_PREDICATE_AND) ||
+        !strcmp(name, GEPETTO_CONFIGURATION_FILE_PREDICATE_OR))
+    {
+        if (!strcmp(name, GEPETTO_CONFIGURATION_FILE_PREDICATE_AND))
+            predicate->type = GEPETTO_LABEL_PREDICATE_AND;
+        else
+            predicate->type = GEPETTO_LABEL_PREDICATE_OR;
+        
+        n = config_setting_is_list(member) ? config_setting_length(member) : 0;
+        if (n < 1)
+        {
+            fprintf(stderr, "Label predicate %s at line %d expects a list of predicates.\n",
+                    name, config_setting_source_line(member));
+            return -1;
+        }
+        predicate->operands = (GPTLabelPredicate*) calloc(n, sizeof(GPTLabelPredicate));
+        for (i=0; i<n; i++)
+        {
+            if (parseLabelPredicate(config_setting_get_elem(member, i), &(predicate->operands[i])) < 0)
+            {
+                freeLabelPredicate(predicate);
+                return -1;
+            }
+            predicate->numberOfOperands++;
+        }
+        return 1;
+    }
+    
+    fprintf(stderr, "Unknown label predicate %s at line %d.\n", name, config_setting_source_line(member));
+    return -1;
+}
+
+/**
+ @brief Parse "accept" label predicate of section "filter"
+ 
+ @param[in] filename Path to configuration file
+ @param[out] labelPredicate Label predicate
+ 
+ @returns
+ - 0 if configuration file has no "filter/accept" setting
+ - 1 if successful
+ - -1 in case of failure
+ 
+ @note
+ When successful, @a labelPredicate is allocated and must be freed with freeLabelPredicate() then free().
+ */
+int getLabelPredicateFromConfigurationFile(const char* filename, GPTLabelPredicate** labelPredicate)
+{
+    config_t config;
+    const config_setting_t *accept_setting = NULL;
+    
+    *labelPredicate = NULL;
+    
+    config_init(&config);
+    
+    // read configuration file
+    if (config_read_file(&config, filename) == CONFIG_FALSE)
+    {
+        fprintf(stderr,
+                "Could not parse configuration file %s.\n",
+                filename);
+        fprintf(stderr, "%s at line %d\n", config_error_text(&config), config_error_line(&config));
+        fflush(stderr);
+        config_destroy(&config);
+        
+        return -1;
+    }
+    
+    accept_setting = config_lookup(&config, GEPETTO_CONFIGURATION_FILE_SECTION_TITLE_FILTER "." GEPETTO_CONFIGURATION_FILE_FILTER_ACCEPT);
+    if (!accept_setting)
+    {
+        config_destroy(&config);
+        return 0;
+    }
+    
+    *labelPredicate = (GPTLabelPredicate*) malloc(sizeof(GPTLabelPredicate));
+    if (parseLabelPredicate(accept_setting, *labelPredicate) < 0)
+    {
+        fprintf(stderr, "Invalid %s/%s in configuration file %s.\n",
+                GEPETTO_CONFIGURATION_FILE_SECTION_TITLE_FILTER,
+                GEPETTO_CONFIGURATION_FILE_FILTER_ACCEPT,
+                filename);
+        fflush(stderr);
+        free(*labelPredicate);
+        *labelPredicate = NULL;
+        config_destroy(&config);
+        
+        return -1;
+    }
+    
+    config_destroy(&config);
+    
+    return 1;
+}
+
+/**
+ @brief Parse section "server"
+ 
+ @param[in] filename Path to configuration file
+ @param[out] options Server options
+ 
+ @returns
+ - 0 if configuration file has no "server" section
+ - 1 if successful
+ - -1 in case of failure
+ 
+ @note
+ Options missing from the "server" section keep their default value.
+ When set, @a options->cacheFile is allocated and must be freed by the caller.
+ */
+int getServerOptionsFromConfigurationFile(const char* filename, GPTServerOptions* options)
+{
+    config_t config;
+    const config_setting_t *server_section = NULL;
+    int prefetchMemory = -1; // in megabytes
+    const char* cacheFile = NULL;
+    char* copy = NULL;
+    
+    config_init(&config);
+    
+    *options = GPTServerOptionsDefault;
+    
+    // read configuration file
+    if (config_read_file(&config, filename) == CONFIG_FALSE)
+    {
+        fprintf(stderr,
+                "Could not parse configuration file %s.\n",
+                filename);
+        fprintf(stderr, "%s at line %d\n", config_error_text(&config), config_error_line(&config));
+        fflush(stderr);
+        config_destroy(&config);
+        
+        return -1;
+    }
+    
+    server_section = config_lookup(&config, GEPETTO_CONFIGURATION_FILE_SECTION_TITLE_SERVER);
+    if (!server_section)
+    {
+        config_destroy(&config);
+        return 0;
+    }
+    
+    config_setting_lookup_int(server_section,
+                              GEPETTO_CONFIGURATION_FILE_SERVER_NUMBER_OF_PROCESSES,
+                              &(options->numberOfProcesses));
+    if (options->numberOfProcesses < 1)
+    {
+        fprintf(stderr, "%s/%s must be positive in configuration file %s.\n",
+                GEPETTO_CONFIGURATION_FILE_SECTION_TITLE_SERVER,
+                GEPETTO_CONFIGURATION_FILE_SERVER_NUMBER_OF_PROCESSES,
+                filename);
+        fflush(stderr);
+        config_destroy(&config);
+        
+        return -1;
+    }
+    
+    config_setting_lookup_int(server_section,
+                              GEPETTO_CONFIGURATION_FILE_SERVER_PREFETCH_DEPTH,
+                              &(options->prefetchDepth));
+    if (options->prefetchDepth < 0)
+    {
+        fprintf(stderr, "%s/%s must not be negative in configuration file %s.\n",
+                GEPETTO_CONFIGURATION_FILE_SECTION_TITLE_SERVER,
+                GEPETTO_CONFIGURATION_FILE_SERVER_PREFETCH_DEPTH,
+                filename);
+        fflush(stderr);
+        config_destroy(&config);
+        
+        return -1;
+    }
+    
+    if (config_setting_lookup_int(server_section,
+                                  GEPETTO_CONFIGURATION_FILE_SERVER_PREFETCH_MEMORY,
+                                  &prefetchMemory) == CONFIG_TRUE)
+    {
+        if (prefetchMemory <= 0)
+        {
+            fprintf(stderr, "%s/%s must be positive in configuration file %s.\n",
+                    GEPETTO_CONFIGURATION_FILE_SECTION_TITLE_SERVER,
+                    GEPETTO_CONFIGURATION_FILE_SERVER_PREFETCH_MEMORY,
+                    filename);
+            fflush(stderr);
+            config_destroy(&config);
+            
+            return -1;
+        }
+        options->prefetchMemory = (size_t)prefetchMemory*1048576;
+    }
+    
+    config_setting_lookup_int(server_section,
+                              GEPETTO_CONFIGURATION_FILE_SERVER_OPEN_FILES,
+                              &(options->maximumNumberOfOpenFiles));
+    if (options->maximumNumberOfOpenFiles < 1)
+    {
+        fprintf(stderr, "%s/%s must be positive in configuration file %s.\n",
+                GEPETTO_CONFIGURATION_FILE_SECTION_TITLE_SERVER,
+                GEPETTO_CONFIGURATION_FILE_SERVER_OPEN_FILES,
+                filename);
+        fflush(stderr);
+        config_destroy(&config);
+        
+        return -1;
+    }
+    
+    if (config_setting_lookup_string(server_section,
+                                     GEPETTO_CONFIGURATION_FILE_SERVER_CACHE,
+                                     &cacheFile) == CONFIG_TRUE)
+    {
+        copy = (char*) malloc((strlen(cacheFile)+1)*sizeof(char));
+        sprintf(copy, "%s", cacheFile);
+        options->cacheFile = copy;
+    }
+    
+    config_destroy(&config);
+    
+    return 1;
+}
+
 /**
  @brief Parse section "label" or "data"
  
@@ -396,6 +764,9 @@ GPTServer gptNewServerFromConfigurationFile(const char* filename)
     int labelFilterReference = -1;
     int maximumNumberOfSamplesPerLabel = -1;
     
+    GPTServerOptions options = GPTServerOptionsDefault;
+    GPTLabelPredicate* labelPredicate = NULL;
+    
     int f;
     
     // try and parse "data" section
@@ -429,10 +800,43 @@ GPTServer gptNewServerFromConfigurationFile(const char* filename)
         return GPTServerInvalid;
     }
     
+    // try and parse "filter/accept" predicate
+    if (getLabelPredicateFromConfigurationFile(filename, &labelPredicate) < 0)
+    {
+        // return invalid gepetto server if an error happened
+        for (f=0; f<numberOfDataFiles; f++) free(pathToDataFile[f]);
+        free(pathToDataFile); 
+        for (f=0; f<numberOfLabelFiles; f++) free(pathToLabelFile[f]);
+        free(pathToLabelFile); 
+        free(pathToDataDataset); 
+        free(pathToLabelDataset); 
+        
+        return GPTServerInvalid;
+    }
+    
+    // try and parse "server" section
+    if (getServerOptionsFromConfigurationFile(filename, &options) < 0)
+    {
+        if (labelPredicate) { freeLabelPredicate(labelPredicate); free(labelPredicate); }
+
+        // return invalid gepetto server if an error happened
+        for (f=0; f<numberOfDataFiles; f++) free(pathToDataFile[f]);
+        free(pathToDataFile); 
+        for (f=0; f<numberOfLabelFiles; f++) free(pathToLabelFile[f]);
+        free(pathToLabelFile); 
+        free(pathToDataDataset); 
+        free(pathToLabelDataset); 
+        
+        return GPTServerInvalid;
+    }
+    
+    options.labelPredicate = labelPredicate;
+    
     // initialize server
-    gptServer = gptNewServer(numberOfDataFiles, pathToDataFile, pathToDataDataset,
-                             labelFilterType, labelFilterReference, maximumNumberOfSamplesPerLabel,
-                             numberOfLabelFiles, pathToLabelFile, pathToLabelDataset);
+    gptServer = gptNewServerWithOptions(numberOfDataFiles, pathToDataFile, pathToDataDataset,
+                                        labelFilterType, labelFilterReference, maximumNumberOfSamplesPerLabel,
+                                        numberOfLabelFiles, pathToLabelFile, pathToLabelDataset,
+                                        options);
     
     // free what needs to be freed
     for (f=0; f<numberOfDataFiles; f++) free(pathToDataFile[f]); free(pathToDataFile);
@@ -441,5 +845,8 @@ GPTServer gptNewServerFromConfigurationFile(const char* filename)
     for (f=0; f<numberOfLabelFiles; f++) free(pathToLabelFile[f]); free(pathToLabelFile);
     free(pathToLabelDataset);
     
+    free((char*) options.cacheFile);
+    if (labelPredicate) { freeLabelPredicate(labelPredicate); free(labelPredicate); }
+    
     return gptServer;
 }
@@ -19,6 +19,12 @@
 // 
 
 #include "gptData.h"
+#include "prefetch_utils.h"
+#include "thread_utils.h"
+#include "filter_utils.h"
+#include "iterator_utils.h"
+#include "server_utils.h"
+#include "data_utils.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -31,173 +37,1062 @@ int gptGetServerDimension(GPTServer gptServer)
         return -1;
 }
 
-int gptReadNext(GPTServer* server, PIODatatype datatype, void** buffer, 
-                int* nLabels, int** labels)
+/**
+ @internal
+ @brief Get labels of a data timerange into a given buffer
+ 
+ @param[in] server Gepetto server
+ @param[in] f File index
+ @param[in] data_t Data timerange index
+ @param[out] nLabels Number of labels (or NULL)
+ @param[out] labels Labels, stored in @a storage (or NULL)
+ @param[in,out] storage Label buffer, reallocated if needed
+ @param[in,out] capacity Number of labels @a storage can hold
+ */
+static void collectLabels(GPTServer* server, int f, int data_t, 
+                          int* nLabels, int** labels, int** storage, int* capacity)
 {
-    int number = -1;
     int numberOfLabels = -1;
     int i, r;
     
-    if (!DAT_AVAILABLE(*server)) 
+    // get total number of corresponding labels
+    // (as the sum of number of labels for each corresponding timeranges)
+    if (nLabels || labels)
     {
-        server->eof = 1;
-        return -1;
+        if (LBL_AVAILABLE(*server))
+        {
+            numberOfLabels = 0;
+            for (i=0; i<server->numberOfCorrespondingLabelTimerange[f][data_t]; i++) 
+                numberOfLabels += LBL_NLABELS(*server, f, i+server->firstCorrespondingLabelTimerange[f][data_t]);
+        }
+    }
+    
+    if (nLabels)
+    {
+        if (LBL_AVAILABLE(*server)) *nLabels = numberOfLabels;
+        else *nLabels = 0;
+    }
+    
+    if (labels)
+    {
+        if (LBL_AVAILABLE(*server))
+        {
+            if (numberOfLabels > *capacity)
+            {
+                *capacity = numberOfLabels;
+                *storage = (int*) realloc(*storage, (*capacity)*sizeof(int));
+            }
+            
+            numberOfLabels = 0;
+            for (i=0; i<server->numberOfCorrespondingLabelTimerange[f][data_t]; i++) 
+            {
+                for (r=0; r<LBL_NLABELS(*server, f, i+server->firstCorrespondingLabelTimerange[f][data_t]); r++) 
+                {
+                    (*storage)[numberOfLabels] = LBL_LABEL(*server, f,
+                                                           i+server->firstCorrespondingLabelTimerange[f][data_t],
+                                                           r);
+                    numberOfLabels++;
+                }
+            }
+            
+            *labels = *storage;
+        }
+        else *labels = NULL;
     }
+}
+
+/**
+ @internal
+ @brief Get labels of a data timerange
+ 
+ @param[in,out] server Gepetto server
+ @param[in] f File index
+ @param[in] data_t Data timerange index
+ @param[out] nLabels Number of labels (or NULL)
+ @param[out] labels Labels, stored in server internal buffer (or NULL)
+ */
+static void getLabelsOfDataTimerange(GPTServer* server, int f, int data_t, 
+                                     int* nLabels, int** labels)
+{
+    collectLabels(server, f, data_t, nLabels, labels, 
+                  &(server->current_data_labels), &(server->current_data_labels_number));
+}
+
+/**
+ @internal
+ @brief Get label of a data timerange
+ 
+ @param[in] server Gepetto server
+ @param[in] f File index
+ @param[in] data_t Data timerange index
+ @returns
+ - first label of the timerange matching server label filter
+ - @ref GEPETTO_NO_LABEL if there is none
+ 
+ Also used by iterator_utils.c to group timeranges by label (see data_utils.h).
+ */
+int getLabelOfDataTimerange(GPTServer* server, int f, int data_t)
+{
+    int i, r, label_t;
+    
+    if (!LBL_AVAILABLE(*server)) return GEPETTO_NO_LABEL;
     
-    // if last timerange is processed, go to first timerange of next file
-    if (server->current_timerange_index == DAT_NTIMERANGES(*server, 
-                                                           server->current_file_index))
+    for (i=0; i<server->numberOfCorrespondingLabelTimerange[f][data_t]; i++)
     {
-        if (PIODatasetIsValid(server->current_dataset))
-            pioCloseDataset(&(server->current_dataset));
-        if (PIOFileIsValid(server->current_file))
-            pioCloseFile(&(server->current_file));
-        server->current_timerange_index = 0;
-        server->current_file_index++;
+        label_t = server->firstCorrespondingLabelTimerange[f][data_t]+i;
+        for (r=0; r<LBL_NLABELS(*server, f, label_t); r++)
+            if (LBL_ACCEPTED(*server, f, label_t, r))
+                return LBL_LABEL(*server, f, label_t, r);
+    }
+    
+    return GEPETTO_NO_LABEL;
+}
+
+/**
+ @internal
+ @brief Give data file/dataset being read back to the pool
+ 
+ Must be called with the HDF5 lock held.
+ 
+ @param[in,out] server Gepetto server
+ @param[in,out] dataset Pooled dataset (set to NULL)
+ */
+static void releaseDataset(GPTServer* server, PIODataset** dataset)
+{
+    if (!*dataset) return;
+    
+    pioPoolReleaseDataset(server->pool, *dataset);
+    *dataset = NULL;
+}
+
+/**
+ @internal
+ @brief Get data dataset of fth file from the pool, if not already done
+ 
+ Must be called with the HDF5 lock held.
+ 
+ @param[in,out] server Gepetto server
+ @param[in] f File index
+ @param[in,out] dataset Pooled dataset (NULL if it could not be opened)
+ */
+static void openDataset(GPTServer* server, int f, PIODataset** dataset)
+{
+    if (*dataset) return;
+    
+    *dataset = pioPoolOpenDataset(server->pool, DAT_PATH(*server, f), DAT_DATASET(*server),
+                                  PINOCCHIO_DATASET_PRELOAD_LINKS);
+}
+
+/**
+ @internal
+ @brief Move a position to next timerange matching label filter
+ 
+ Starting from position (@a f, @a t) (included), skip timeranges filtered out by the server 
+ and release @a dataset when moving to the next file.
+ 
+ @param[in] server Gepetto server
+ @param[in,out] f File index
+ @param[in,out] t Timerange index
+ @param[in] endFile File index of end position
+ @param[in] endTimerange Timerange index of end position (excluded)
+ @param[in,out] dataset Pooled dataset of fth file (or NULL)
+ @returns
+ - 1 if position is at a timerange matching label filter
+ - 0 if end position is reached
+ */
+static int seekFiltered(GPTServer* server, int* f, int* t, int endFile, int endTimerange,
+                        PIODataset** dataset)
+{
+    while (1)
+    {
+        // if end position is reached, stop
+        if ((*f > endFile) || ((*f == endFile) && (*t >= endTimerange))) return 0;
+        if (*f == DAT_NFILES(*server)) return 0;
+        
+        // if last timerange is processed, go to first timerange of next file
+        if (*t == DAT_NTIMERANGES(*server, *f))
+        {
+            lockHDF5();
+            releaseDataset(server, dataset);
+            unlockHDF5();
+            *t = 0;
+            (*f)++;
+            continue;
+        }
+        
+        if (DAT_FILTERED(*server, *f, *t)) return 1;
+        
+        (*t)++;
+    }
+}
+
+/**
+ @internal
+ @brief Count consecutive filtered timeranges fitting into a batch
+ 
+ A timerange is never split between two batches.
+ 
+ @param[in] server Gepetto server
+ @param[in] f File index
+ @param[in] data_t Index of first timerange (filtered)
+ @param[in] endTimerange Timerange index not to be reached in fth file
+ @param[in] room Number of vectors still fitting into the batch
+ @param[out] countVectors Number of vectors in these timeranges
+ @returns number of timeranges
+ */
+static int countBatchTimeranges(GPTServer* server, int f, int data_t, int endTimerange,
+                                int room, int* countVectors)
+{
+    int count = 0;
+    
+    *countVectors = 0;
+    while ((data_t+count < endTimerange) &&
+           DAT_FILTERED(*server, f, data_t+count) &&
+           (*countVectors+server->numberOfEntriesPerTimerangePerFile[f][data_t+count] <= room))
+    {
+        *countVectors += server->numberOfEntriesPerTimerangePerFile[f][data_t+count];
+        count++;
+    }
+    
+    return count;
+}
+
+/**
+ @internal
+ @brief Give current data file/dataset back to the pool
+ 
+ Must be called with the HDF5 lock held.
+ 
+ @param[in,out] server Gepetto server
+ */
+static void releaseCurrentFile(GPTServer* server)
+{
+    releaseDataset(server, &(server->current_dataset));
+}
+
+/**
+ @internal
+ @brief Move server to next timerange matching label filter
+ 
+ Starting from current position (included), skip timeranges filtered out by the server 
+ and close data file when moving to the next one.
+ 
+ @param[in,out] server Gepetto server
+ @returns
+ - 1 if server is positioned at a timerange matching label filter
+ - 0 if the end of the server is reached
+ */
+static int seekNextFiltered(GPTServer* server)
+{
+    return seekFiltered(server, &(server->current_file_index), &(server->current_timerange_index),
+                        DAT_NFILES(*server), 0, &(server->current_dataset));
+}
+
+/**
+ @internal
+ @brief Rewind server once its end is reached
+ @param[in,out] server Gepetto server
+ */
+static void rewindServer(GPTServer* server)
+{
+    server->current_file_index = 0;
+    server->current_timerange_index = 0;
+    server->eof = 1;
+}
+
+/**
+ @internal
+ @brief Stop gptReadNext() read-ahead, if any
+ 
+ Read-ahead thread works on a copy of the server: it must be stopped 
+ before served timeranges or reading position change.
+ 
+ @param[in,out] server Gepetto server
+ */
+static void stopReadAhead(GPTServer* server)
+{
+    if (!server->prefetcher) return;
+    stopPrefetcher(server->prefetcher);
+    server->prefetcher = NULL;
+}
+
+/**
+ @internal
+ @brief Go back to the first timerange of the server
+ 
+ Stop read-ahead, close current data file and clear end of server.
+ 
+ @param[in,out] server Gepetto server
+ */
+static void restartServer(GPTServer* server)
+{
+    stopReadAhead(server);
+    lockHDF5();
+    releaseCurrentFile(server);
+    unlockHDF5();
+    server->current_file_index = 0;
+    server->current_timerange_index = 0;
+    server->eof = 0;
+}
+
+/**
+ @internal
+ @brief Memory size of one entry of @a datatype
+ 
+ Same as pioGetSize(), with the HDF5 lock held: 
+ readers may be calling HDF5 from other threads.
+ 
+ @param[in] datatype Buffer datatype
+ @returns size of one entry, in bytes
+ */
+static size_t getEntrySize(PIODatatype datatype)
+{
+    size_t size;
+    
+    lockHDF5();
+    size = pioGetSize(datatype);
+    unlockHDF5();
+    return size;
+}
+
+/**
+ @internal
+ @brief Open current data file/dataset if necessary
+ 
+ Must be called with the HDF5 lock held.
+ 
+ @param[in,out] server Gepetto server
+ */
+static void openCurrentFile(GPTServer* server)
+{
+    openDataset(server, server->current_file_index, &(server->current_dataset));
+}
+
+/**
+ @internal
+ @brief Pop next data from the read-ahead queue
+ 
+ Same as gptReadNext(), when server.options.prefetchDepth > 0.
+ The read-ahead thread is started by the first call and stopped at the end of the server
+ (or when @a datatype changes).
+ */
+static int readNextPrefetched(GPTServer* server, PIODatatype datatype, void** buffer, 
+                              int* nLabels, int** labels)
+{
+    int f = -1;
+    int data_t = -1;
+    int number = -1;
+    
+    // restart read-ahead from current position if buffer datatype changed
+    if (server->prefetcher && 
+        ((server->prefetcher->datatype.type != datatype.type) ||
+         (server->prefetcher->datatype.dimension != datatype.dimension)))
+        stopReadAhead(server);
+    
+    if (!server->prefetcher)
+    {
+        server->prefetcher = startPrefetcher(*server, datatype, 
+                                             server->current_file_index, 
+                                             server->current_timerange_index);
+        if (!server->prefetcher) return -1;
     }
     
     // if last file is processed, stop
-    if (server->current_file_index == DAT_NFILES(*server))
+    if (!nextPrefetched(server->prefetcher, &f, &data_t, &number, buffer))
     {
-        server->current_file_index = 0;
-        server->current_timerange_index = 0;
-        server->eof = 1;
+        stopReadAhead(server);
+        rewindServer(server);
         return -1;
     }
     
-    // open next file/dataset if necessary
-    if (server->current_timerange_index == 0)
+    server->current_file_index = f;
+    server->current_timerange_index = data_t+1;
+    
+    getLabelsOfDataTimerange(server, f, data_t, nLabels, labels);
+    
+    return number;
+}
+
+/**
+ @internal
+ @brief Read next data in iteration order
+ 
+ Same as gptReadNext(), when server iteration mode is not sequential.
+ */
+static int readNextPermuted(GPTServer* server, PIODatatype datatype, void** buffer, 
+                            int* nLabels, int** labels)
+{
+    PIODataset* dataset = NULL;
+    int f = -1;
+    int data_t = -1;
+    int number = -1;
+    int found;
+    
+    found = peekIteratorPosition(server->iterator, server, &f, &data_t);
+    if (found < 0) return -1;
+    
+    // next call starts a new epoch
+    if (!found)
+    {
+        invalidateIterator(server->iterator);
+        rewindServer(server);
+        return -1;
+    }
+    
+    lockHDF5();
+    dataset = getIteratorDataset(server->iterator, server, f);
+    if (dataset) number = pioRead(dataset, data_t, datatype, buffer);
+    unlockHDF5();
+    
+    getLabelsOfDataTimerange(server, f, data_t, nLabels, labels);
+    
+    advanceIterator(server->iterator, 1);
+    server->current_file_index = f;
+    server->current_timerange_index = data_t+1;
+    
+    return number;
+}
+
+int gptReadNext(GPTServer* server, PIODatatype datatype, void** buffer, 
+                int* nLabels, int** labels)
+{
+    int number = -1;
+    
+    if (!DAT_AVAILABLE(*server)) 
     {
-        server->current_file = pioOpenFile(DAT_PATH(*server, server->current_file_index),
-                                           PINOCCHIO_READONLY);
-        server->current_dataset = pioOpenDataset(PIOMakeObject(server->current_file),
-                                                 DAT_DATASET(*server));
+        server->eof = 1;
+        return -1;
     }
     
-    // if not filtered, read next data
-    if (DAT_FILTERED(*server, server->current_file_index, server->current_timerange_index))
+    if (server->iterator)
+        return readNextPermuted(server, datatype, buffer, nLabels, labels);
+    
+    if (server->options.prefetchDepth > 0)
+        return readNextPrefetched(server, datatype, buffer, nLabels, labels);
+    
+    // skip timeranges filtered out by the server
+    if (!seekNextFiltered(server))
     {
-        number = pioRead(&(server->current_dataset), 
+        rewindServer(server);
+        return -1;
+    }
+    
+    // read next data
+    lockHDF5();
+    openCurrentFile(server);
+    if (server->current_dataset)
+        number = pioRead(server->current_dataset, 
                          server->current_timerange_index,
                          datatype, 
                          buffer);
-        
-        // get total number of corresponding labels
-        // (as the sum of number of labels for each corresponding timeranges)
-        if (nLabels || labels)
+    unlockHDF5();
+    
+    getLabelsOfDataTimerange(server, 
+                             server->current_file_index, 
+                             server->current_timerange_index, 
+                             nLabels, labels);
+    
+    server->current_timerange_index++;
+    
+    // return number of data
+    return number;
+}
+
+int gptSetLabelFilter(GPTServer* server, const GPTLabelPredicate* predicate)
+{
+    int numberOfReaders;
+    
+    // readers shares depend on served timeranges, 
+    // and reader threads may be reading the filter being replaced
+    lockHDF5();
+    numberOfReaders = server->numberOfReaders;
+    unlockHDF5();
+    if (numberOfReaders > 0) return -1;
+    
+    // read-ahead thread reads the filter being replaced
+    stopReadAhead(server);
+    
+    if (updateLabelFilter(server, predicate) < 0) return -1;
+    
+    // served timeranges changed
+    restartServer(server);
+    if (server->iterator) invalidateIterator(server->iterator);
+    
+    return 1;
+}
+
+int gptSetIterationMode(GPTServer* server, GPTIterationMode mode, unsigned int seed, int blockSize)
+{
+    iterator_t* iterator = NULL;
+    
+    if (!DAT_AVAILABLE(*server)) return -1;
+    
+    switch (mode)
+    {
+        case GEPETTO_ITERATION_MODE_SEQUENTIAL:
+        case GEPETTO_ITERATION_MODE_SHUFFLE:
+            break;
+        case GEPETTO_ITERATION_MODE_ROUND_ROBIN:
+        case GEPETTO_ITERATION_MODE_STRATIFIED:
+            if (!LBL_AVAILABLE(*server)) return -1;
+            break;
+        default:
+            return -1;
+    }
+    
+    if (mode != GEPETTO_ITERATION_MODE_SEQUENTIAL)
+    {
+        iterator = newIterator(mode, seed, blockSize);
+        if (!iterator) return -1;
+    }
+    
+    restartServer(server);
+    if (server->iterator)
+    {
+        lockHDF5();
+        destroyIterator(server->iterator);
+        unlockHDF5();
+    }
+    server->iterator = iterator;
+    
+    return 1;
+}
+
+/**
+ @internal
+ @brief Store label, file index and timerange index of entries read by gptReadBatch()
+ 
+ @param[in] server Gepetto server
+ @param[in] f File index
+ @param[in] data_t Index of first timerange
+ @param[in] count Number of consecutive timeranges
+ @param[in] offset Position of first entry in output arrays
+ @param[out] labels Labels (or NULL)
+ @param[out] fileIndices File indices (or NULL)
+ @param[out] timeranges Timerange indices (or NULL)
+ @returns number of entries
+ */
+static int storeBatchEntries(GPTServer* server, int f, int data_t, int count, int offset,
+                             int* labels, int* fileIndices, int* timeranges)
+{
+    int numberOfVectors = offset;
+    int label;
+    int tr, e;
+    
+    for (tr=data_t; tr<data_t+count; tr++)
+    {
+        label = (labels ? getLabelOfDataTimerange(server, f, tr) : GEPETTO_NO_LABEL);
+        for (e=0; e<server->numberOfEntriesPerTimerangePerFile[f][tr]; e++)
         {
-            if (LBL_AVAILABLE(*server))
+            if (labels)      labels[numberOfVectors]      = label;
+            if (fileIndices) fileIndices[numberOfVectors] = f;
+            if (timeranges)  timeranges[numberOfVectors]  = tr;
+            numberOfVectors++;
+        }
+    }
+    
+    return numberOfVectors-offset;
+}
+
+/**
+ @internal
+ @brief Read next batch in iteration order
+ 
+ Same as gptReadBatch(), when server iteration mode is not sequential.
+ */
+static int readBatchPermuted(GPTServer* server, PIODatatype datatype, int maxVectors, void* buffer,
+                             int* labels, int* fileIndices, int* timeranges)
+{
+    PIODataset* dataset = NULL;
+    int f, data_t;
+    int g, tr;
+    int count; // number of consecutive time ranges read at once
+    int countVectors; // number of vectors in these time ranges
+    int numberOfVectors = 0; // number of vectors in buffer so far
+    int64_t numberOfEntries;
+    size_t oneEntrySize;
+    int found;
+    
+    oneEntrySize = getEntrySize(datatype);
+    
+    while (numberOfVectors < maxVectors)
+    {
+        found = peekIteratorPosition(server->iterator, server, &f, &data_t);
+        if (found < 0) 
+        {
+            // failure is reported by the next call
+            // if buffer already contains some vectors
+            if (numberOfVectors == 0) return GEPETTO_READ_FAILURE;
+            break;
+        }
+        if (!found)
+        {
+            // end of server is reported by the next call
+            // if buffer already contains some vectors
+            if (numberOfVectors == 0)
             {
-                numberOfLabels = 0;
-                for (i=0; 
-                     i<server->numberOfCorrespondingLabelTimerange[server->current_file_index][server->current_timerange_index]; 
-                     i++) 
-                {
-                    numberOfLabels += LBL_NLABELS(*server, 
-                                                  server->current_file_index, 
-                                                  i+server->firstCorrespondingLabelTimerange[server->current_file_index][server->current_timerange_index]);
-                }
+                invalidateIterator(server->iterator);
+                rewindServer(server);
+                return GEPETTO_END_OF_SERVER;
             }
+            break;
         }
         
-        if (nLabels)
+        // upcoming timeranges that happen to be consecutive in the same file
+        count = 0;
+        countVectors = 0;
+        while (peekIteratorPositionAt(server->iterator, count, &g, &tr) &&
+               (g == f) && (tr == data_t+count) &&
+               (numberOfVectors+countVectors+server->numberOfEntriesPerTimerangePerFile[f][tr] <= maxVectors))
         {
-            if (LBL_AVAILABLE(*server)) *nLabels = numberOfLabels;
-            else *nLabels = 0;
+            countVectors += server->numberOfEntriesPerTimerangePerFile[f][tr];
+            count++;
         }
         
-        if (labels)
+        // next timerange does not fit
+        if (count == 0) break;
+        
+        lockHDF5();
+        dataset = getIteratorDataset(server->iterator, server, f);
+        numberOfEntries = -1;
+        if (dataset)
+            numberOfEntries = pioReadRangeInto(dataset, data_t, count, datatype,
+                                               buffer + numberOfVectors*oneEntrySize,
+                                               (maxVectors-numberOfVectors)*oneEntrySize,
+                                               NULL);
+        unlockHDF5();
+        
+        // failure is reported by the next call
+        // if buffer already contains some vectors
+        if (numberOfEntries != countVectors)
+        {
+            if (numberOfVectors == 0) return GEPETTO_READ_FAILURE;
+            break;
+        }
+        
+        numberOfVectors += storeBatchEntries(server, f, data_t, count, numberOfVectors,
+                                             labels, fileIndices, timeranges);
+        
+        advanceIterator(server->iterator, count);
+    }
+    
+    // next timerange does not fit into buffer
+    if (numberOfVectors == 0) return GEPETTO_BATCH_TOO_SMALL;
+    
+    return numberOfVectors;
+}
+
+int gptReadBatch(GPTServer* server, PIODatatype datatype, int maxVectors, void* buffer,
+                 int* labels, int* fileIndices, int* timeranges)
+{
+    int f, data_t;
+    int count; // number of consecutive time ranges read at once
+    int countVectors; // number of vectors in these time ranges
+    int numberOfVectors = 0; // number of vectors in buffer so far
+    int64_t numberOfEntries;
+    size_t oneEntrySize;
+    
+    if (!DAT_AVAILABLE(*server)) 
+    {
+        server->eof = 1;
+        return GEPETTO_END_OF_SERVER;
+    }
+    
+    if (server->iterator)
+        return readBatchPermuted(server, datatype, maxVectors, buffer, labels, fileIndices, timeranges);
+    
+    // stop gptReadNext() read-ahead, if any
+    // (it restarts from the position where gptReadBatch() stops)
+    stopReadAhead(server);
+    
+    oneEntrySize = getEntrySize(datatype);
+    
+    while (numberOfVectors < maxVectors)
+    {
+        // skip timeranges filtered out by the server
+        if (!seekNextFiltered(server))
         {
-            if (LBL_AVAILABLE(*server))
+            // end of server is reported by the next call
+            // if buffer already contains some vectors
+            if (numberOfVectors == 0)
             {
-                if (numberOfLabels > server->current_data_labels_number)
-                {
-                    server->current_data_labels_number = numberOfLabels;
-                    server->current_data_labels = (int*) realloc(server->current_data_labels,
-                                                                 server->current_data_labels_number*sizeof(int));
-                }
-                
-                numberOfLabels = 0;
-                for (i=0; 
-                     i<server->numberOfCorrespondingLabelTimerange[server->current_file_index][server->current_timerange_index]; 
-                     i++) 
-                {
-                    for (r=0; 
-                         r<LBL_NLABELS(*server, 
-                                       server->current_file_index, 
-                                       i+server->firstCorrespondingLabelTimerange[server->current_file_index][server->current_timerange_index]); 
-                         r++) 
-                    {
-                        server->current_data_labels[numberOfLabels] = LBL_LABEL(*server,
-                                                                                server->current_file_index,
-                                                                                i+server->firstCorrespondingLabelTimerange[server->current_file_index][server->current_timerange_index],
-                                                                                r);
-                        numberOfLabels++;
-                    }
-                }
-                
-                *labels = server->current_data_labels;
+                rewindServer(server);
+                return GEPETTO_END_OF_SERVER;
             }
-            else *labels = NULL;
+            break;
         }
         
-        server->current_timerange_index++;
+        f = server->current_file_index;
+        data_t = server->current_timerange_index;
+        
+        // consecutive filtered timeranges fitting into what is left of buffer
+        count = countBatchTimeranges(server, f, data_t, DAT_NTIMERANGES(*server, f),
+                                     maxVectors-numberOfVectors, &countVectors);
+        
+        // next timerange does not fit
+        if (count == 0) break;
+        
+        lockHDF5();
+        openCurrentFile(server);
+        numberOfEntries = -1;
+        if (server->current_dataset)
+            numberOfEntries = pioReadRangeInto(server->current_dataset, data_t, count, datatype,
+                                               buffer + numberOfVectors*oneEntrySize,
+                                               (maxVectors-numberOfVectors)*oneEntrySize,
+                                               NULL);
+        unlockHDF5();
+        
+        // failure is reported by the next call
+        // if buffer already contains some vectors
+        if (numberOfEntries != countVectors)
+        {
+            if (numberOfVectors == 0) return GEPETTO_READ_FAILURE;
+            break;
+        }
+        
+        numberOfVectors += storeBatchEntries(server, f, data_t, count, numberOfVectors,
+                                             labels, fileIndices, timeranges);
+        
+        server->current_timerange_index += count;
+    }
+    
+    // next timerange does not fit into buffer
+    if (numberOfVectors == 0) return GEPETTO_BATCH_TOO_SMALL;
+    
+    return numberOfVectors;
+}
+
+
+// position of one of several consumers of a server (see gptNewReader())
+struct GPTReader_s {
+    GPTServer* server;
+    
+    // share of served timeranges, from (firstFile, firstTimerange) included
+    // to (endFile, endTimerange) excluded
+    int firstFile;
+    int firstTimerange;
+    int endFile;
+    int endTimerange;
+    
+    // current position
+    int fileIndex;
+    int timerangeIndex;
+    PIODataset* dataset;
+    
+    // data and labels returned by gptReaderReadNext()
+    void* buffer;
+    size_t capacity;
+    int* labels;
+    int numberOfLabels;
+};
+
+/**
+ @internal
+ @brief Find first timerange preceded by a given number of served entries
+ 
+ @param[in] server Gepetto server
+ @param[in] target Number of served entries
+ @param[out] f File index
+ @param[out] t Timerange index
+ */
+static void findShareBoundary(GPTServer* server, int64_t target, int* f, int* t)
+{
+    int64_t count = 0;
+    
+    for (*f=0; *f<DAT_NFILES(*server); (*f)++)
+        for (*t=0; *t<DAT_NTIMERANGES(*server, *f); (*t)++)
+        {
+            if (count >= target) return;
+            if (DAT_FILTERED(*server, *f, *t)) 
+                count += server->numberOfEntriesPerTimerangePerFile[*f][*t];
+        }
+    
+    *f = DAT_NFILES(*server);
+    *t = 0;
+}
+
+/**
+ @internal
+ @brief Rewind reader once the end of its share is reached
+ @param[in,out] reader Gepetto server reader
+ */
+static void rewindReader(GPTReader* reader)
+{
+    lockHDF5();
+    releaseDataset(reader->server, &(reader->dataset));
+    unlockHDF5();
+    
+    reader->fileIndex = reader->firstFile;
+    reader->timerangeIndex = reader->firstTimerange;
+}
+
+GPTReader* gptNewReader(GPTServer* server, int shardIndex, int numberOfShards)
+{
+    return gptNewReaderWithSharding(server, shardIndex, numberOfShards, GEPETTO_SHARDING_BY_ENTRIES);
+}
+
+GPTReader* gptNewReaderWithSharding(GPTServer* server, int shardIndex, int numberOfShards,
+                                    GPTShardingMode mode)
+{
+    GPTReader* reader = NULL;
+    int64_t total = 0;
+    int f, t;
+    
+    if (!DAT_AVAILABLE(*server)) return NULL;
+    if ((numberOfShards < 1) || (shardIndex < 0) || (shardIndex >= numberOfShards)) return NULL;
+    
+    reader = (GPTReader*) malloc(sizeof(GPTReader));
+    if (!reader) return NULL;
+    
+    switch (mode)
+    {
+        case GEPETTO_SHARDING_BY_FILE:
+            reader->firstFile = (int)(((int64_t)shardIndex*DAT_NFILES(*server))/numberOfShards);
+            reader->firstTimerange = 0;
+            reader->endFile = (int)(((int64_t)(shardIndex+1)*DAT_NFILES(*server))/numberOfShards);
+            reader->endTimerange = 0;
+            break;
+            
+        case GEPETTO_SHARDING_BY_ENTRIES:
+            for (f=0; f<DAT_NFILES(*server); f++)
+                for (t=0; t<DAT_NTIMERANGES(*server, f); t++)
+                    if (DAT_FILTERED(*server, f, t)) 
+                        total += server->numberOfEntriesPerTimerangePerFile[f][t];
+            findShareBoundary(server, (total*shardIndex)/numberOfShards,
+                              &(reader->firstFile), &(reader->firstTimerange));
+            findShareBoundary(server, (total*(shardIndex+1))/numberOfShards,
+                              &(reader->endFile), &(reader->endTimerange));
+            break;
+            
+        default:
+            free(reader);
+            return NULL;
     }
-    // otherwise, go to next timerange
-    else 
+    
+    // last share goes until the end of the server
+    // (including timeranges with no entry)
+    if (shardIndex == numberOfShards-1)
     {
-        server->current_timerange_index++;
-        number = gptReadNext(server, datatype, buffer, nLabels, labels);
+        reader->endFile = DAT_NFILES(*server);
+        reader->endTimerange = 0;
     }
     
-    // return number of data
+    lockHDF5();
+    server->numberOfReaders++;
+    unlockHDF5();
+    
+    reader->server = server;
+    reader->fileIndex = reader->firstFile;
+    reader->timerangeIndex = reader->firstTimerange;
+    reader->dataset = NULL;
+    reader->buffer = NULL;
+    reader->capacity = 0;
+    reader->labels = NULL;
+    reader->numberOfLabels = 0;
+    
+    return reader;
+}
+
+int gptReaderReadNext(GPTReader* reader, PIODatatype datatype, void** buffer, 
+                      int* nLabels, int** labels)
+{
+    GPTServer* server = reader->server;
+    size_t size;
+    int number = -1;
+    int f, t;
+    
+    // skip timeranges filtered out by the server
+    if (!seekFiltered(server, &(reader->fileIndex), &(reader->timerangeIndex),
+                      reader->endFile, reader->endTimerange, &(reader->dataset)))
+    {
+        rewindReader(reader);
+        return -1;
+    }
+    
+    f = reader->fileIndex;
+    t = reader->timerangeIndex;
+    
+    // read into reader buffer: pooled dataset buffer is shared with other readers
+    lockHDF5();
+    size = server->numberOfEntriesPerTimerangePerFile[f][t]*pioGetSize(datatype);
+    if (size > reader->capacity)
+    {
+        reader->buffer = realloc(reader->buffer, size);
+        reader->capacity = reader->buffer ? size : 0;
+    }
+    openDataset(server, f, &(reader->dataset));
+    if (reader->dataset && (reader->capacity >= size))
+        number = pioReadInto(reader->dataset, t, datatype, reader->buffer, reader->capacity);
+    unlockHDF5();
+    
+    collectLabels(server, f, t, nLabels, labels, &(reader->labels), &(reader->numberOfLabels));
+    
+    reader->timerangeIndex++;
+    
+    *buffer = reader->buffer;
     return number;
 }
 
+int gptReaderReadBatch(GPTReader* reader, PIODatatype datatype, int maxVectors, void* buffer,
+                       int* labels, int* fileIndices, int* timeranges)
+{
+    GPTServer* server = reader->server;
+    int f, data_t;
+    int endTimerange;
+    int count; // number of consecutive time ranges read at once
+    int countVectors; // number of vectors in these time ranges
+    int numberOfVectors = 0; // number of vectors in buffer so far
+    int64_t numberOfEntries;
+    size_t oneEntrySize;
+    
+    oneEntrySize = getEntrySize(datatype);
+    
+    while (numberOfVectors < maxVectors)
+    {
+        // skip timeranges filtered out by the server
+        if (!seekFiltered(server, &(reader->fileIndex), &(reader->timerangeIndex),
+                          reader->endFile, reader->endTimerange, &(reader->dataset)))
+        {
+            // end of share is reported by the next call
+            // if buffer already contains some vectors
+            if (numberOfVectors == 0)
+            {
+                rewindReader(reader);
+                return GEPETTO_END_OF_SERVER;
+            }
+            break;
+        }
+        
+        f = reader->fileIndex;
+        data_t = reader->timerangeIndex;
+        
+        // consecutive filtered timeranges of the share fitting into what is left of buffer
+        endTimerange = (f == reader->endFile) ? reader->endTimerange : DAT_NTIMERANGES(*server, f);
+        count = countBatchTimeranges(server, f, data_t, endTimerange,
+                                     maxVectors-numberOfVectors, &countVectors);
+        
+        // next timerange does not fit
+        if (count == 0) break;
+        
+        lockHDF5();
+        openDataset(server, f, &(reader->dataset));
+        numberOfEntries = -1;
+        if (reader->dataset)
+            numberOfEntries = pioReadRangeInto(reader->dataset, data_t, count, datatype,
+                                               buffer + numberOfVectors*oneEntrySize,
+                                               (maxVectors-numberOfVectors)*oneEntrySize,
+                                               NULL);
+        unlockHDF5();
+        
+        // failure is reported by the next call
+        // if buffer already contains some vectors
+        if (numberOfEntries != countVectors)
+        {
+            if (numberOfVectors == 0) return GEPETTO_READ_FAILURE;
+            break;
+        }
+        
+        numberOfVectors += storeBatchEntries(server, f, data_t, count, numberOfVectors,
+                                             labels, fileIndices, timeranges);
+        
+        reader->timerangeIndex += count;
+    }
+    
+    // next timerange does not fit into buffer
+    if (numberOfVectors == 0) return GEPETTO_BATCH_TOO_SMALL;
+    
+    return numberOfVectors;
+}
+
+int gptCloseReader(GPTReader** reader)
+{
+    if (!*reader) return 0;
+    
+    lockHDF5();
+    releaseDataset((*reader)->server, &((*reader)->dataset));
+    (*reader)->server->numberOfReaders--;
+    unlockHDF5();
+    
+    free((*reader)->buffer);
+    free((*reader)->labels);
+    free(*reader);
+    *reader = NULL;
+    
+    return 1;
+}
 
-long gptDumpServer(GPTServer* server,
-                   PIODatatype datatype,
-                   void* buffer)
+int64_t gptDumpServer(GPTServer* server,
+                      PIODatatype datatype,
+                      void* buffer)
 {
     int f; // file index
     int tr; // time range index
-    long totalNumberOfEntries; // total number of served entries
-    long numberOfEntries;  // local number of entries
-    long oneEntrySize; // memory size of one entry
-    void* localBuffer = NULL;
+    int count; // number of consecutive time ranges
+    int64_t totalNumberOfEntries; // total number of served entries
+    int64_t expectedNumberOfEntries; // expected number of served entries
+    int64_t numberOfEntries;  // local number of entries
+    int64_t oneEntrySize; // memory size of one entry
+    PIODataset* pioDataset = NULL;
     
-    oneEntrySize = (long)pioGetSize(datatype);
-    totalNumberOfEntries = 0;
+    oneEntrySize = (int64_t)getEntrySize(datatype);
+    
+    expectedNumberOfEntries = 0;
+    for (f=0; f<DAT_NFILES(*server); f++)
+    {
+        for (tr=0; tr<DAT_NTIMERANGES(*server, f); tr++)
+        {
+            if (server->filtered[f][tr]) 
+                expectedNumberOfEntries += server->numberOfEntriesPerTimerangePerFile[f][tr];
+        }
+    }
     
     // if buffer == NULL, return expected size of buffer
-    if (!buffer)
+    if (!buffer) return  oneEntrySize * expectedNumberOfEntries;
+    
+    totalNumberOfEntries = 0;
+    for (f=0; f<DAT_NFILES(*server); f++)
     {
-
-        for (f=0; f<DAT_NFILES(*server); f++)
+        // gptReadNext() read-ahead thread may be running
+        lockHDF5();
+        
+        pioDataset = pioPoolOpenDataset(server->pool, DAT_PATH(*server, f), DAT_DATASET(*server),
+                                        PINOCCHIO_DATASET_PRELOAD_LINKS);
+        if (!pioDataset)
         {
-            for (tr=0; tr<DAT_NTIMERANGES(*server, f); tr++)
+            unlockHDF5();
+            return -1;
+        }
+        
+        tr = 0;
+        while (tr < DAT_NTIMERANGES(*server, f))
+        {
+            if (!server->filtered[f][tr]) { tr++; continue; }
+            
+            // read consecutive filtered time ranges at once,
+            // directly at their final position in buffer
+            count = 1;
+            while ((tr+count < DAT_NTIMERANGES(*server, f)) && (server->filtered[f][tr+count])) 
+                count++;
+            
+            numberOfEntries = pioReadRangeInto(pioDataset, tr, count, datatype,
+                                               buffer + totalNumberOfEntries*oneEntrySize, 
+                                               (expectedNumberOfEntries-totalNumberOfEntries)*oneEntrySize,
+                                               NULL);
+            if (numberOfEntries < 0)
             {
-                if (server->filtered[f][tr]) 
-                    totalNumberOfEntries += server->numberOfEntriesPerTimerangePerFile[f][tr];
+                pioPoolReleaseDataset(server->pool, pioDataset);
+                unlockHDF5();
+                return -1;
             }
+            
+            totalNumberOfEntries += numberOfEntries;
+            tr = tr + count;
         }
-        return  oneEntrySize * totalNumberOfEntries;
+        
+        pioPoolReleaseDataset(server->pool, pioDataset);
+        
+        unlockHDF5();
     }
-
-    while (server->eof == 0) 
-    {   
-        numberOfEntries = gptReadNextData(server, datatype, &localBuffer);
-        if (numberOfEntries > 0)
-        {
-            memcpy(buffer + totalNumberOfEntries*oneEntrySize, 
-                   localBuffer, 
-                   numberOfEntries*oneEntrySize);
-            totalNumberOfEntries += numberOfEntries;            
-        }
-    }    
+    
     return totalNumberOfEntries;
 }
-
-
-
-
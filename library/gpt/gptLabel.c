@@ -20,6 +20,7 @@
 
 #include "gptLabel.h"
 #include <stdlib.h>
+#include <string.h>
 
 int gptGetListOfDistinctLabels(GPTServer server, int* list)
 {
@@ -39,84 +40,63 @@ int gptGetListOfDistinctLabels(GPTServer server, int* list)
 
 /**
  @internal
-
- @brief Get list of label timeranges matching a specific label value
- @param[in] server Gepetto server
- @param[in] labelValue Label value looked for
- @param[in] f File index
- @param[out] timeranges Array of label timeranges
- @returns number of label timeranges
  
- @note
- Calling getTimerangesForLabelAndFile with NULL @a timeranges will
- return the number of label timeranges. It can be uses to preallocate
- @a timeranges with enough memory space to store the whole list of timeranges.
- 
- @ingroup gptlabel
+ @brief Compare two integer labels
+ */
+static int compareLabels(void const* a, void const* b)
+{
+    int const* pa = (int const*) a;
+    int const* pb = (int const*) b;
+    return (*pa > *pb) - (*pa < *pb);
+}
+
+/**
+ @internal
  
+ @brief Get rank of label value
+ @param[in] server Gepetto server
+ @param[in] labelValue Label value
+ @returns
+ - position of @a labelValue in sorted list of distinct labels
+ - -1 if server does not know this label value
  */
-static int getTimerangesForLabelAndFile(GPTServer server,
-                                        int labelValue,
-                                        int f,
-                                        PIOTimeRange* timeranges)
+static int getLabelRank(GPTServer server, int labelValue)
 {
-    int t, i;
+    int* found = NULL;
     
-    // Number of timeranges with matching label
-    int numberOfTimeranges = 0;
+    if (!LBL_AVAILABLE(server) || (LBL_NUMBER(server) == 0)) return -1;
     
-    for (t=0; t<LBL_NTIMERANGES(server, f); t++) 
-    {
-        for (i=0; i<LBL_NLABELS(server, f, t); i++) 
-        {
-            if (LBL_LABEL(server, f, t, i) == labelValue)
-            {
-                if (timeranges)
-                    timeranges[numberOfTimeranges] = LBL_TIMERANGE(server, f, t);
-                numberOfTimeranges++;
-                break; // in case of two identical labels in the same timerange
-            }
-        }
-    }
-    
-    return numberOfTimeranges;
+    found = (int*) bsearch(&labelValue, LBL_LIST(server), LBL_NUMBER(server), sizeof(int), compareLabels);
+    if (!found) return -1;
+    return (int)(found - LBL_LIST(server));
 }
 
-
 int gptGetTimerangesForLabel(GPTServer server,
                              int labelValue,
                              GPTTimeRange* timeranges)
 {
-    int f, i;
-    int localNumberOfTimeranges = -1;
-    PIOTimeRange* localTimeranges = NULL;
-    int totalNumberOfTimeranges = -1;
+    const GPTTimeRange* indexed = NULL;
+    int numberOfTimeranges;
     
-    if (timeranges)
-    {
-        totalNumberOfTimeranges = 0;
-        for (f=0; f<LBL_NFILES(server); f++) 
-        {
-            localNumberOfTimeranges = getTimerangesForLabelAndFile(server, labelValue, f, NULL);
-            localTimeranges = (PIOTimeRange*) malloc(localNumberOfTimeranges*sizeof(PIOTimeRange));
-            localNumberOfTimeranges = getTimerangesForLabelAndFile(server, labelValue, f, localTimeranges);
-            for (i=0; i<localNumberOfTimeranges; i++) 
-            {
-                timeranges[totalNumberOfTimeranges+i].fileIndex = f;
-                timeranges[totalNumberOfTimeranges+i].timerange = localTimeranges[i];
-            }
-            totalNumberOfTimeranges += localNumberOfTimeranges;
-            free(localTimeranges);
-        }
-    }
-    else 
+    numberOfTimeranges = gptGetTimerangesForLabelNoCopy(server, labelValue, &indexed);
+    if (timeranges && (numberOfTimeranges > 0))
+        memcpy(timeranges, indexed, numberOfTimeranges*sizeof(GPTTimeRange));
+    
+    return numberOfTimeranges;
+}
+
+int gptGetTimerangesForLabelNoCopy(GPTServer server,
+                                   int labelValue,
+                                   const GPTTimeRange** timeranges)
+{
+    int rank = getLabelRank(server, labelValue);
+    
+    if (rank < 0)
     {
-        totalNumberOfTimeranges = 0;
-        for (f=0; f<LBL_NFILES(server); f++) 
-            totalNumberOfTimeranges += getTimerangesForLabelAndFile(server, 
-                                                                    labelValue,
-                                                                    f, NULL);
+        if (timeranges) *timeranges = NULL;
+        return 0;
     }
     
-    return totalNumberOfTimeranges;
+    if (timeranges) *timeranges = server.labelTimeranges + server.firstLabelTimerange[rank];
+    return server.firstLabelTimerange[rank+1] - server.firstLabelTimerange[rank];
 }
@@ -22,7 +22,14 @@
 #include <string.h>
 
 #include "gptServer.h"
-#include "list_utils.h"
+#include "hash_utils.h"
+#include "thread_utils.h"
+#include "process_utils.h"
+#include "prefetch_utils.h"
+#include "iterator_utils.h"
+#include "cache_utils.h"
+#include "filter_utils.h"
+#include "server_utils.h"
 
 #ifndef MAX
 /**
@@ -39,69 +46,96 @@
 
 /**
  @internal
- @brief Apply filter on given label
- @param[in] label Input label
- @param[in] labelFilterType Label filter type
- @param[in] labelFilterReference Label filter reference value
+ @brief Apply server filter on given data timerange
+ 
+ Labels of consecutive label timeranges are stored contiguously:
+ the labels corresponding to a data timerange are a slice of server.labelAccepted.
+ 
+ @param[in] server Gepetto server
+ @param[in] f File index
+ @param[in] data_t Data timerange index
  @returns 
- - 1 if label value matches filter
- - 0 otherwise
+ - TRUE if data matches filter
+ - FALSE otherwise
  */
-static int applyFilter(int label,
-                       GPTLabelFilterType labelFilterType,
-                       int labelFilterReference)
+static int isFiltered(GPTServer* server,
+                      int f,
+                      int data_t)
 {
-    int result;
-    switch (labelFilterType)
+    char result = 0;
+    int first_t, last_t;
+    int first, last, i;
+    
+    if (server->numberOfCorrespondingLabelTimerange[f][data_t] == 0) return 0;
+    
+    first_t = server->firstCorrespondingLabelTimerange[f][data_t];
+    last_t = first_t + server->numberOfCorrespondingLabelTimerange[f][data_t] - 1;
+    first = server->indexOfFirstLabelPerFilePerTimerange[f][first_t];
+    last = server->indexOfFirstLabelPerFilePerTimerange[f][last_t] + LBL_NLABELS(*server, f, last_t);
+    
+    for (i=first; i<last; i++) result |= server->labelAccepted[f][i];
+    return result;
+}
+
+/**
+ @internal
+ @brief Set data filter according to compiled label filter
+ 
+ Allocate (if needed) and set server.filtered
+ 
+ @param[in, out] server Gepetto server
+ */
+static void filterData(GPTServer* server)
+{
+    int f;
+    int data_t;
+    
+    if (!server->filtered)
+        server->filtered = (int**) calloc(DAT_NFILES(*server), sizeof(int*));
+    
+    for (f=0; f<DAT_NFILES(*server); f++) 
+    {
+        if (!server->filtered[f])
+            server->filtered[f] = (int*) malloc(DAT_NTIMERANGES(*server, f)*sizeof(int));
+        
+        // without labels, keep everything
+        if (LBL_AVAILABLE(*server))
+            for (data_t=0; data_t<DAT_NTIMERANGES(*server, f); data_t++) 
+                server->filtered[f][data_t] = isFiltered(server, f, data_t);
+        else
+            for (data_t=0; data_t<DAT_NTIMERANGES(*server, f); data_t++) 
+                server->filtered[f][data_t] = 1;
+    }
+}
+
+/**
+ @internal
+ @brief Get label predicate equivalent to simple label filter
+ @param[in] type Type of label filter
+ @param[in] reference Label filter reference value (must outlive returned predicate)
+ @returns label predicate
+ */
+static GPTLabelPredicate getSimpleLabelPredicate(GPTLabelFilterType type, int* reference)
+{
+    GPTLabelPredicate predicate = {GEPETTO_LABEL_PREDICATE_ANY, 1, reference, 0, NULL};
+    switch (type)
     {
-        case GEPETTO_LABEL_FILTER_TYPE_NONE:
-            result = 1;
-            break;
         case GEPETTO_LABEL_FILTER_TYPE_EQUALS_TO:
-            result = (label == labelFilterReference);
+            predicate.type = GEPETTO_LABEL_PREDICATE_EQUALS_TO;
             break;
         case GEPETTO_LABEL_FILTER_TYPE_DIFFERS_FROM:
-            result = (label != labelFilterReference);
+            predicate.type = GEPETTO_LABEL_PREDICATE_DIFFERS_FROM;
             break;
         case GEPETTO_LABEL_FILTER_TYPE_GREATER_THAN:
-            result = (label > labelFilterReference);
+            predicate.type = GEPETTO_LABEL_PREDICATE_GREATER_THAN;
             break;
         case GEPETTO_LABEL_FILTER_TYPE_SMALLER_THAN:
-            result = (label < labelFilterReference);
+            predicate.type = GEPETTO_LABEL_PREDICATE_SMALLER_THAN;
             break;
         default:
             break;
-    }        
-    
-    return result;
-}
-
-/**
- @internal
- @brief Apply server filter on given 
- @param[in] server Gepetto server
- @param[in] f File index
- @param[in] data_t Data timerange index
- @returns 
- - TRUE if data matches filter
- - FALSE otherwise
- */
-static int isFiltered(GPTServer server,
-                      int f,
-                      int data_t)
-{
-    int result = 0;
-    int n, label_t, r;
-    
-    for (n=0; n<server.numberOfCorrespondingLabelTimerange[f][data_t]; n++) 
-    {
-        label_t = server.firstCorrespondingLabelTimerange[f][data_t] + n;
-        for (r=0; r<LBL_NLABELS(server, f, label_t); r++) 
-            result = result || applyFilter(LBL_LABEL(server, f, label_t, r), 
-                                           server.labelFilterType,
-                                           server.labelFilterReference); 
     }
-    return result;
+    return predicate;
 }
 
 /**
@@ -137,13 +171,15 @@ static int hasLabel(GPTServer server, int f, int data_t, int label)
  @param[in] b Second label value
  @returns 
  - positive value if @a a is greater than @a b
- - negative value otherwise
+ - negative value if @a a is less than @a b
+ - 0 otherwise
  */
 static int compareLabels (void const *a, void const *b)
 {
     int const *pa = a;
     int const *pb = b;
-    return *pa - *pb;
+    // no subtraction: it overflows for labels far apart (e.g. INT_MIN and INT_MAX)
+    return (*pa > *pb) - (*pa < *pb);
 }
 
 /**
@@ -191,6 +227,272 @@ static int initLabelConfiguration( GPTServer* server, int numberOfLabelFiles, ch
     return 1;
 }
 
+/**
+ @internal
+ @brief Outcome of the scan of a label or data file
+ */
+typedef enum {
+    SCAN_SUCCESS,
+    SCAN_CANNOT_OPEN_FILE,
+    SCAN_CANNOT_OPEN_DATASET,
+    SCAN_CANNOT_GET_DATATYPE,
+    SCAN_NOT_MONODIMENSIONAL,
+    SCAN_CANNOT_OPEN_TIMELINE,
+    SCAN_NO_LABEL,
+    SCAN_CANNOT_DUMP_LABELS,
+    SCAN_CANNOT_READ_NUMBERS
+} scanStatus_t;
+
+/**
+ @internal
+ @brief Print why scanning a label or data file failed
+ 
+ @param[in] status Scan outcome
+ @param[in] kind "label" or "data"
+ @param[in] path Path to file
+ @param[in] dataset Path to dataset
+ */
+static void reportScanError(scanStatus_t status, const char* kind, const char* path, const char* dataset)
+{
+    switch (status)
+    {
+        case SCAN_CANNOT_OPEN_FILE:
+            fprintf(stderr, "Geppeto cannot open %s file %s.\n", kind, path);
+            break;
+        case SCAN_CANNOT_OPEN_DATASET:
+            fprintf(stderr, "Gepetto cannot open %s dataset %s in file %s.\n", kind, dataset, path);
+            break;
+        case SCAN_CANNOT_GET_DATATYPE:
+            fprintf(stderr, "Gepetto cannot get datatype of %s dataset %s in file %s.\n", kind, dataset, path);
+            break;
+        case SCAN_NOT_MONODIMENSIONAL:
+            fprintf(stderr, 
+                    "Gepetto found that the datatype of %s dataset %s in file %s is not mono-dimensional.\n",
+                    kind, dataset, path);
+            break;
+        case SCAN_CANNOT_OPEN_TIMELINE:
+            fprintf(stderr, "Geppeto cannot open timeline of %s dataset %s in file %s.\n", kind, dataset, path);
+            break;
+        case SCAN_NO_LABEL:
+            fprintf(stderr, "Gepetto cannot find any label in dataset %s in file %s.\n", dataset, path);
+            break;
+        case SCAN_CANNOT_DUMP_LABELS:
+            fprintf(stderr, "Gepetto cannot dump label dataset %s in file %s.\n", dataset, path);
+            break;
+        case SCAN_CANNOT_READ_NUMBERS:
+            fprintf(stderr, "Geppeto cannot get number of entries from %s dataset %s in file %s.\n", kind, dataset, path);
+            break;
+        default:
+            break;
+    }
+    fflush(stderr);
+}
+
+/**
+ @internal
+ @brief State shared by file scanning tasks
+ 
+ Each task only writes into the per-file slots of the file it scans.
+ */
+typedef struct {
+    GPTServer* server;
+    scanStatus_t* status;
+    PIOBaseType* type;
+    int* dimension;
+} scanContext_t;
+
+/**
+ @internal
+ @brief Write integer into results of a worker process
+ @returns 1 when successful, -1 otherwise
+ */
+static int putInt(FILE* results, int value)
+{
+    return (fwrite(&value, sizeof(int), 1, results) == 1) ? 1 : -1;
+}
+
+/**
+ @internal
+ @brief Write array into results of a worker process
+ @returns 1 when successful, -1 otherwise
+ */
+static int putArray(FILE* results, const void* array, int number, size_t size)
+{
+    if (number == 0) return 1;
+    return (fwrite(array, size, number, results) == (size_t) number) ? 1 : -1;
+}
+
+/**
+ @internal
+ @brief Read integer from results of a worker process
+ @returns 1 when successful, -1 otherwise
+ */
+static int getInt(FILE* results, int* value)
+{
+    return (fread(value, sizeof(int), 1, results) == 1) ? 1 : -1;
+}
+
+/**
+ @internal
+ @brief Read array from results of a worker process
+ @returns newly allocated array, or NULL in case of failure
+ */
+static void* getArray(FILE* results, int number, size_t size)
+{
+    void* array = NULL;
+    
+    if (number < 0) return NULL;
+    array = malloc(number > 0 ? number*size : 1);
+    if (array && (number > 0) && (fread(array, size, number, results) != (size_t) number))
+    {
+        free(array);
+        array = NULL;
+    }
+    return array;
+}
+
+/**
+ @internal
+ @brief Load timeline and labels of fth label file
+ 
+ Must be called with the HDF5 lock held.
+ 
+ @param[in,out] server Gepetto server
+ @param[in] f File index
+ @returns scan outcome
+ */
+static scanStatus_t loadLabelFile(GPTServer* server, int f)
+{
+    PIOFile* file = NULL;
+    PIODataset* dataset = NULL;
+    PIODatatype datatype = PIODatatypeInvalid;
+    PIOTimeline timeline = PIOTimelineInvalid;
+    int64_t labelBufferSize = -1;
+    scanStatus_t status = SCAN_SUCCESS;
+    
+    // check if label file is readable
+    file = pioPoolOpenFile(server->pool, LBL_PATH(*server, f));
+    if (!file) return SCAN_CANNOT_OPEN_FILE;
+    pioPoolReleaseFile(server->pool, file);
+    
+    // check if label dataset is readable
+    // (file is kept open: data are often stored in the same file)
+    dataset = pioPoolOpenDataset(server->pool, LBL_PATH(*server, f), LBL_DATASET(*server), 
+                                 PINOCCHIO_DATASET_DEFAULT);
+    if (!dataset) return SCAN_CANNOT_OPEN_DATASET;
+    
+    // check if label datatype is mono-dimensional
+    datatype = pioGetDatatype(*dataset);
+    if (PIODatatypeIsInvalid(datatype)) status = SCAN_CANNOT_GET_DATATYPE;
+    else if (datatype.dimension != 1) status = SCAN_NOT_MONODIMENSIONAL;
+    
+    // load label timeline
+    if (status == SCAN_SUCCESS)
+    {
+        // time ranges are read straight into server
+        timeline = pioGetTimelineWithFlags(*dataset, PINOCCHIO_TIMELINE_LAZY);
+        if (PIOTimelineIsInvalid(timeline)) status = SCAN_CANNOT_OPEN_TIMELINE;
+    }
+    if (status == SCAN_SUCCESS)
+    {
+        LBL_NTIMERANGES(*server, f) = timeline.ntimeranges;
+        LBL_TIMELINE(*server, f) = (PIOTimeRange*) malloc(LBL_NTIMERANGES(*server, f)*sizeof(PIOTimeRange));
+        if (pioReadTimeRanges(timeline, 0, timeline.ntimeranges, LBL_TIMELINE(*server, f)) < 0)
+            status = SCAN_CANNOT_OPEN_TIMELINE;
+    }
+    
+    // load label data
+    if (status == SCAN_SUCCESS)
+    {
+        labelBufferSize = pioDumpDataset(dataset, server->labelDatatype, NULL, NULL);
+        if (labelBufferSize <= 0) status = SCAN_NO_LABEL;
+    }
+    if (status == SCAN_SUCCESS)
+    {
+        server->label[f] = (int*) malloc(labelBufferSize);
+        server->numberOfLabelsPerFilePerTimerange[f] = (int*) malloc(LBL_NTIMERANGES(*server, f)*sizeof(int));
+        if (pioDumpDataset(dataset, server->labelDatatype, server->label[f], server->numberOfLabelsPerFilePerTimerange[f]) < 0)
+            status = SCAN_CANNOT_DUMP_LABELS;
+    }
+    
+    if (PIOTimelineIsValid(timeline)) pioCloseTimeline(&timeline);
+    if (PIODatatypeIsValid(datatype)) pioCloseDatatype(&datatype);
+    pioPoolReleaseDataset(server->pool, dataset);
+    
+    return status;
+}
+
+/**
+ @internal
+ @brief Scan fth label file (see runInProcesses())
+ 
+ @param[in,out] context Scan context
+ @param[in] f File index
+ @param[in,out] results Results of worker process (NULL in calling process)
+ @returns 1 when successful, -1 if results cannot be written
+ */
+static int scanLabelFile(void* context, int f, FILE* results)
+{
+    scanContext_t* scan = (scanContext_t*) context;
+    GPTServer* server = scan->server;
+    int label_t;
+    int total = 0;
+    
+    lockHDF5();
+    scan->status[f] = loadLabelFile(server, f);
+    unlockHDF5();
+    
+    if (!results || (scan->status[f] != SCAN_SUCCESS)) 
+        return results ? putInt(results, scan->status[f]) : 1;
+    
+    for (label_t=0; label_t<LBL_NTIMERANGES(*server, f); label_t++) total += LBL_NLABELS(*server, f, label_t);
+    
+    if (putInt(results, scan->status[f]) < 0) return -1;
+    if (putInt(results, LBL_NTIMERANGES(*server, f)) < 0) return -1;
+    if (putArray(results, LBL_TIMELINE(*server, f), LBL_NTIMERANGES(*server, f), sizeof(PIOTimeRange)) < 0) return -1;
+    if (putArray(results, server->numberOfLabelsPerFilePerTimerange[f], LBL_NTIMERANGES(*server, f), sizeof(int)) < 0) return -1;
+    if (putInt(results, total) < 0) return -1;
+    return putArray(results, server->label[f], total, sizeof(int));
+}
+
+/**
+ @internal
+ @brief Collect scan of fth label file by a worker process (see runInProcesses())
+ 
+ @param[in,out] context Scan context
+ @param[in] f File index
+ @param[in,out] results Results of worker process
+ @returns 1 when successful, -1 otherwise (nothing is kept then)
+ */
+static int collectLabelFile(void* context, int f, FILE* results)
+{
+    scanContext_t* scan = (scanContext_t*) context;
+    GPTServer* server = scan->server;
+    int status, total;
+    
+    if (getInt(results, &status) < 0) return -1;
+    scan->status[f] = (scanStatus_t) status;
+    if (scan->status[f] != SCAN_SUCCESS) return 1;
+    
+    if (getInt(results, &(LBL_NTIMERANGES(*server, f))) < 0) return -1;
+    LBL_TIMELINE(*server, f) = (PIOTimeRange*) getArray(results, LBL_NTIMERANGES(*server, f), sizeof(PIOTimeRange));
+    server->numberOfLabelsPerFilePerTimerange[f] = (int*) getArray(results, LBL_NTIMERANGES(*server, f), sizeof(int));
+    if (getInt(results, &total) > 0) server->label[f] = (int*) getArray(results, total, sizeof(int));
+    
+    if (!LBL_TIMELINE(*server, f) || !server->numberOfLabelsPerFilePerTimerange[f] || !server->label[f])
+    {
+        free(LBL_TIMELINE(*server, f));
+        free(server->numberOfLabelsPerFilePerTimerange[f]);
+        free(server->label[f]);
+        LBL_TIMELINE(*server, f) = NULL;
+        server->numberOfLabelsPerFilePerTimerange[f] = NULL;
+        server->label[f] = NULL;
+        return -1;
+    }
+    
+    return 1;
+}
+
 /**
  @internal
  @brief Init label storage variables
@@ -203,6 +505,8 @@ static int initLabelConfiguration( GPTServer* server, int numberOfLabelFiles, ch
  - server.label
  - server.labelDatatype
  
+ Label files are shared between server.options.numberOfProcesses processes.
+ 
  @param[in, out] server Gepetto server
  @returns
  - 1 when successful
@@ -212,7 +516,7 @@ static int initLabelStorage(GPTServer* server)
 {
     int f;
     int label_t;
-    size_t labelBufferSize = -1;
+    scanContext_t scan;
     
     // label timelines
     LBL_TIMELINES(*server) = (PIOTimeRange**) malloc(LBL_NFILES(*server)*sizeof(PIOTimeRange*));
@@ -234,87 +538,21 @@ static int initLabelStorage(GPTServer* server)
     // labels are integers
     server->labelDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);        
     
+    // scan all label files
+    scan.server = server;
+    scan.status = (scanStatus_t*) malloc(LBL_NFILES(*server)*sizeof(scanStatus_t));
+    scan.type = NULL;
+    scan.dimension = NULL;
+    runInProcesses(server->options.numberOfProcesses, LBL_NFILES(*server), 
+                   scanLabelFile, collectLabelFile, &scan);
+    
     for (f=0; f<LBL_NFILES(*server); f++)
     {
-        // check if label file is readable
-        server->current_file = pioOpenFile(LBL_PATH(*server, f), PINOCCHIO_READONLY);
-        if (PIOFileIsInvalid(server->current_file)) 
+        // report first failure
+        if (scan.status[f] != SCAN_SUCCESS)
         {
-            fprintf(stderr, "Geppeto cannot open label file %s.\n", LBL_PATH(*server, f));
-            fflush(stderr);
-            gptCloseServer(server);
-            return -1;
-        }
-        
-        // check if label dataset is readable
-        server->current_dataset = pioOpenDataset(PIOMakeObject(server->current_file),
-                                                 LBL_DATASET(*server));
-        if (PIODatasetIsInvalid(server->current_dataset))
-        {
-            fprintf(stderr, "Gepetto cannot open label dataset %s in file %s.\n",
-                    LBL_DATASET(*server), LBL_PATH(*server, f));
-            fflush(stderr);
-            gptCloseServer(server);
-            return -1;
-        }
-        
-        // check if label datatype is mono-dimensional
-        server->current_datatype = pioGetDatatype(server->current_dataset);
-        if (PIODatatypeIsInvalid(server->current_datatype))
-        {
-            fprintf(stderr, "Gepetto cannot get datatype of label dataset %s in file %s.\n",
-                    LBL_DATASET(*server), LBL_PATH(*server, f));
-            fflush(stderr);
-            gptCloseServer(server);
-            return -1;            
-        }
-        if (server->current_datatype.dimension != 1)
-        {
-            fprintf(stderr, 
-                    "Gepetto found that the datatype of label dataset %s in file %s is not mono-dimensional.\n",
-                    LBL_DATASET(*server), LBL_PATH(*server, f));
-            fflush(stderr);                
-            gptCloseServer(server);
-            return -1;            
-        }
-        
-        // load label timeline
-        server->current_timeline = pioGetTimeline(server->current_dataset);
-        if (PIOTimelineIsInvalid(server->current_timeline))
-        {
-            fprintf(stderr, "Geppeto cannot open timeline of label dataset %s in file %s.\n",
-                    LBL_DATASET(*server), LBL_PATH(*server, f));
-            fflush(stderr);
-            gptCloseServer(server);
-            return -1;
-            
-        }
-        LBL_NTIMERANGES(*server, f) = server->current_timeline.ntimeranges;
-        LBL_TIMELINE(*server, f) = (PIOTimeRange*) malloc(LBL_NTIMERANGES(*server, f)*sizeof(PIOTimeRange));
-        for (label_t=0; label_t<LBL_NTIMERANGES(*server, f); label_t++) 
-            LBL_TIMERANGE(*server, f, label_t) = server->current_timeline.timeranges[label_t];
-        
-        // load label data
-        labelBufferSize = pioDumpDataset(&(server->current_dataset), server->labelDatatype, NULL, NULL);
-        if (labelBufferSize <= 0)
-        {
-            fprintf(stderr, 
-                    "Gepetto cannot find any label in dataset %s in file %s.\n",
-                    LBL_DATASET(*server), LBL_PATH(*server, f));
-            fflush(stderr);
-            gptCloseServer(server);
-            return -1;                
-        }
-        
-        server->label[f] = (int*) malloc(labelBufferSize);
-        server->numberOfLabelsPerFilePerTimerange[f] = (int*) malloc(LBL_NTIMERANGES(*server, f)*sizeof(int));
-        
-        if (pioDumpDataset(&(server->current_dataset), server->labelDatatype, server->label[f], server->numberOfLabelsPerFilePerTimerange[f]) < 0)
-        {
-            fprintf(stderr, 
-                    "Gepetto cannot dump label dataset %s in file %s.\n",
-                    LBL_DATASET(*server), LBL_PATH(*server, f));
-            fflush(stderr);
+            reportScanError(scan.status[f], "label", LBL_PATH(*server, f), LBL_DATASET(*server));
+            free(scan.status);
             gptCloseServer(server);
             return -1;
         }
@@ -323,78 +561,82 @@ static int initLabelStorage(GPTServer* server)
         server->indexOfFirstLabelPerFilePerTimerange[f][0] = 0;
         for (label_t=1; label_t<LBL_NTIMERANGES(*server, f); label_t++)
             server->indexOfFirstLabelPerFilePerTimerange[f][label_t] = server->indexOfFirstLabelPerFilePerTimerange[f][label_t-1] + LBL_NLABELS(*server, f, label_t-1);
-        
-        // prepare for next file
-        pioCloseTimeline(&(server->current_timeline));
-        pioCloseDatatype(&(server->current_datatype));
-        pioCloseDataset(&(server->current_dataset));
-        pioCloseFile(&(server->current_file));
-    }    
+    }
     
+    free(scan.status);
     return 1;
 }
 
 /**
  @internal
  @brief Get statistics on labels
+ 
+ Labels are counted in a hash map, then ranked by value:
+ per-file counts are dense arrays indexed by label rank.
+ 
  @param[in] server Gepetto server
  @param[out] labels List of distinct label values, sorted in ascending order
  @param[out] labelCounts Label counts for each label value
  @param[out] labelCountsPerFile Label counts for each label value, per file
- @returns number of distinct label values
+ @returns 
+ - number of distinct label values
+ - -1 in case of failure
+ 
+ @note
+ @a labels, @a labelCounts and @a labelCountsPerFile are allocated by this function.
  */
-static int getStatsOnLabels(GPTServer server, int* labels, int* labelCounts, int** labelCountsPerFile)
+static int getStatsOnLabels(GPTServer server, int** labels, int** labelCounts, int*** labelCountsPerFile)
 {
     int f, t, i;
     int count;
-    listOfLabels_t* list = NULL;
-    listOfLabels_t** listPerFile = NULL;
-    
-    listPerFile = (listOfLabels_t**) malloc(LBL_NFILES(server)*sizeof(listOfLabels_t*));
-    for (f=0; f<LBL_NFILES(server); f++) listPerFile[f] = NULL;
-    
+    int* value;
+    labelMap_t* map = NULL;
     
-    count = 0; // number of distinct labels so far
+    // count occurrences of each label value
+    map = newLabelMap(0);
+    if (!map) return -1;
     for(f=0; f<LBL_NFILES(server); f++)
     {
         for(t=0; t<LBL_NTIMERANGES(server, f); t++)
         {
             for(i=0; i<LBL_NLABELS(server, f, t); i++)
             {
-                if (!isLabelInList(list, LBL_LABEL(server, f, t, i)))
+                value = labelMapInsert(map, LBL_LABEL(server, f, t, i));
+                if (!value)
                 {
-                    if (labels) labels[count] = LBL_LABEL(server, f, t, i);
-                    count++;
+                    destroyLabelMap(map);
+                    return -1;
                 }
-                list           = updateLabelCount(list,           LBL_LABEL(server, f, t, i), 1);
-                listPerFile[f] = updateLabelCount(listPerFile[f], LBL_LABEL(server, f, t, i), 1);
-                
+                (*value)++;
             }
         }
     }
+    count = map->count; // number of distinct labels
     
-    if (labels)
+    // sort labels
+    *labels = (int*) malloc(count*sizeof(int));
+    labelMapKeys(map, *labels);
+    qsort(*labels, count, sizeof(int), compareLabels);
+    
+    // from now on, map label value to its rank
+    *labelCounts = (int*) malloc(count*sizeof(int));
+    for (i=0; i<count; i++)
     {
-        // sort labels
-        qsort(labels, count, sizeof(int), compareLabels);
-        if (labelCounts)
-        {
-            for (i=0; i<count; i++)
-                labelCounts[i] = getLabelCount(list, labels[i]);
-        }
-        
-        if (labelCountsPerFile)
-        {
-            for (f=0; f<LBL_NFILES(server); f++)
-                for (i=0; i<count; i++)
-                    labelCountsPerFile[f][i] = getLabelCount(listPerFile[f], labels[i]);
-        }
+        value = labelMapInsert(map, (*labels)[i]);
+        (*labelCounts)[i] = *value;
+        *value = i;
     }
     
-    destroyListOfLabels(list);
-    for (f=0; f<LBL_NFILES(server); f++) 
-        destroyListOfLabels(listPerFile[f]);
-    free(listPerFile);
+    *labelCountsPerFile = (int**) malloc(LBL_NFILES(server)*sizeof(int*));
+    for (f=0; f<LBL_NFILES(server); f++)
+    {
+        (*labelCountsPerFile)[f] = (int*) calloc(count, sizeof(int));
+        for(t=0; t<LBL_NTIMERANGES(server, f); t++)
+            for(i=0; i<LBL_NLABELS(server, f, t); i++)
+                (*labelCountsPerFile)[f][labelMapFind(map, LBL_LABEL(server, f, t, i), -1)]++;
+    }
+    
+    destroyLabelMap(map);
     
     return count;
 }
@@ -415,14 +657,94 @@ static int getStatsOnLabels(GPTServer server, int* labels, int* labelCounts, int
  */
 static int initLabelStatistics(GPTServer* server)
 {
-    int f;
-    LBL_NUMBER(*server) = getStatsOnLabels(*server, NULL, NULL, NULL);
-    LBL_LIST(*server) = (int*) malloc(LBL_NUMBER(*server)*sizeof(int));
-    server->labelCounts = (int*) malloc(LBL_NUMBER(*server)*sizeof(int));
-    server->labelCountsPerFile = (int**) malloc(LBL_NFILES(*server)*sizeof(int*));
-    for (f=0; f<LBL_NFILES(*server); f++)
-        server->labelCountsPerFile[f] = (int*) malloc(LBL_NUMBER(*server)*sizeof(int));
-    getStatsOnLabels(*server, LBL_LIST(*server), server->labelCounts, server->labelCountsPerFile);
+    LBL_NUMBER(*server) = getStatsOnLabels(*server, &LBL_LIST(*server), &(server->labelCounts), &(server->labelCountsPerFile));
+    if (LBL_NUMBER(*server) < 0)
+    {
+        LBL_NUMBER(*server) = 0;
+        fprintf(stderr, "Gepetto could not count labels.\n");
+        fflush(stderr);
+        gptCloseServer(server);
+        return -1;
+    }
+    return 1;
+}
+
+/**
+ @internal
+ @brief Init label inverted index
+ 
+ Allocate and set:
+ - server.firstLabelTimerange
+ - server.labelTimeranges
+ 
+ A label timerange appears once per distinct label value it holds.
+ 
+ @param server Gepetto server
+ @returns
+ - 1 when successful
+ - -1 otherwise
+ */
+static int initLabelIndex(GPTServer* server)
+{
+    int f, t, i, n;
+    int pass;
+    int stamp;
+    int* lastSeen = NULL;
+    int* position = NULL;
+    labelMap_t* rankOfLabel = NULL;
+    
+    rankOfLabel = newLabelMap(LBL_NUMBER(*server));
+    if (!rankOfLabel)
+    {
+        gptCloseServer(server);
+        return -1;
+    }
+    for (n=0; n<LBL_NUMBER(*server); n++)
+        *labelMapInsert(rankOfLabel, LBL_VALUE(*server, n)) = n;
+    
+    lastSeen = (int*) malloc(LBL_NUMBER(*server)*sizeof(int));
+    position = (int*) calloc(LBL_NUMBER(*server)+1, sizeof(int));
+    
+    // first pass counts label timeranges per label, second pass fills index
+    for (pass=0; pass<2; pass++)
+    {
+        for (n=0; n<LBL_NUMBER(*server); n++) lastSeen[n] = -1;
+        
+        stamp = 0;
+        for (f=0; f<LBL_NFILES(*server); f++)
+        {
+            for (t=0; t<LBL_NTIMERANGES(*server, f); t++, stamp++)
+            {
+                for (i=0; i<LBL_NLABELS(*server, f, t); i++)
+                {
+                    n = labelMapFind(rankOfLabel, LBL_LABEL(*server, f, t, i), -1);
+                    // in case of two identical labels in the same timerange
+                    if (lastSeen[n] == stamp) continue;
+                    lastSeen[n] = stamp;
+                    
+                    if (pass == 0) position[n+1]++;
+                    else
+                    {
+                        server->labelTimeranges[position[n]].fileIndex = f;
+                        server->labelTimeranges[position[n]].timerange = LBL_TIMERANGE(*server, f, t);
+                        position[n]++;
+                    }
+                }
+            }
+        }
+        
+        if (pass == 0)
+        {
+            for (n=0; n<LBL_NUMBER(*server); n++) position[n+1] += position[n];
+            server->firstLabelTimerange = (int*) malloc((LBL_NUMBER(*server)+1)*sizeof(int));
+            for (n=0; n<=LBL_NUMBER(*server); n++) server->firstLabelTimerange[n] = position[n];
+            server->labelTimeranges = (GPTTimeRange*) malloc((position[LBL_NUMBER(*server)]+1)*sizeof(GPTTimeRange));
+        }
+    }
+    
+    free(position);
+    free(lastSeen);
+    destroyLabelMap(rankOfLabel);
     return 1;
 }
 
@@ -467,6 +789,143 @@ static int initDataConfiguration( GPTServer* server, int numberOfDataFiles, char
     return 1;
 }
 
+/**
+ @internal
+ @brief Load timeline and number of entries per timerange of fth data file
+ 
+ Must be called with the HDF5 lock held.
+ 
+ @param[in,out] server Gepetto server
+ @param[in] f File index
+ @param[out] type Base type of data datatype
+ @param[out] dimension Dimension of data datatype
+ @returns scan outcome
+ */
+static scanStatus_t loadDataFile(GPTServer* server, int f, PIOBaseType* type, int* dimension)
+{
+    PIOFile* file = NULL;
+    PIODataset* dataset = NULL;
+    PIODatatype datatype = PIODatatypeInvalid;
+    PIOTimeline timeline = PIOTimelineInvalid;
+    scanStatus_t status = SCAN_SUCCESS;
+    
+    // test fth data file
+    file = pioPoolOpenFile(server->pool, DAT_PATH(*server, f));
+    if (!file) return SCAN_CANNOT_OPEN_FILE;
+    pioPoolReleaseFile(server->pool, file);
+    
+    // test fth data dataset
+    // (links are loaded once for both the scan and gptReadNext())
+    dataset = pioPoolOpenDataset(server->pool, DAT_PATH(*server, f), DAT_DATASET(*server),
+                                 PINOCCHIO_DATASET_PRELOAD_LINKS);
+    if (!dataset) return SCAN_CANNOT_OPEN_DATASET;
+    
+    // get fth data datatype (checked against the first one afterwards)
+    datatype = pioGetDatatype(*dataset);
+    if (PIODatatypeIsInvalid(datatype)) status = SCAN_CANNOT_GET_DATATYPE;
+    else
+    {
+        *type = datatype.type;
+        *dimension = datatype.dimension;
+    }
+    
+    // load data timeline
+    if (status == SCAN_SUCCESS)
+    {
+        // time ranges are read straight into server
+        timeline = pioGetTimelineWithFlags(*dataset, PINOCCHIO_TIMELINE_LAZY);
+        if (PIOTimelineIsInvalid(timeline)) status = SCAN_CANNOT_OPEN_TIMELINE;
+    }
+    if (status == SCAN_SUCCESS)
+    {
+        DAT_NTIMERANGES(*server, f) = timeline.ntimeranges;
+        DAT_TIMELINE(*server, f) = (PIOTimeRange*) malloc(DAT_NTIMERANGES(*server, f)*sizeof(PIOTimeRange));
+        if (pioReadTimeRanges(timeline, 0, timeline.ntimeranges, DAT_TIMELINE(*server, f)) < 0)
+            status = SCAN_CANNOT_OPEN_TIMELINE;
+    }
+    
+    // load number of entries per timerange
+    if (status == SCAN_SUCCESS)
+    {
+        server->numberOfEntriesPerTimerangePerFile[f] = (int*)malloc(sizeof(int)*DAT_NTIMERANGES(*server, f));
+        if (pioReadAllNumbers(*dataset, server->numberOfEntriesPerTimerangePerFile[f]) < 0)
+            status = SCAN_CANNOT_READ_NUMBERS;
+    }
+    
+    if (PIOTimelineIsValid(timeline)) pioCloseTimeline(&timeline);
+    if (PIODatatypeIsValid(datatype)) pioCloseDatatype(&datatype);
+    pioPoolReleaseDataset(server->pool, dataset);
+    
+    return status;
+}
+
+/**
+ @internal
+ @brief Scan fth data file (see runInProcesses())
+ 
+ @param[in,out] context Scan context
+ @param[in] f File index
+ @param[in,out] results Results of worker process (NULL in calling process)
+ @returns 1 when successful, -1 if results cannot be written
+ */
+static int scanDataFile(void* context, int f, FILE* results)
+{
+    scanContext_t* scan = (scanContext_t*) context;
+    GPTServer* server = scan->server;
+    
+    lockHDF5();
+    scan->status[f] = loadDataFile(server, f, &(scan->type[f]), &(scan->dimension[f]));
+    unlockHDF5();
+    
+    if (!results || (scan->status[f] != SCAN_SUCCESS)) 
+        return results ? putInt(results, scan->status[f]) : 1;
+    
+    if (putInt(results, scan->status[f]) < 0) return -1;
+    if (putInt(results, (int) scan->type[f]) < 0) return -1;
+    if (putInt(results, scan->dimension[f]) < 0) return -1;
+    if (putInt(results, DAT_NTIMERANGES(*server, f)) < 0) return -1;
+    if (putArray(results, DAT_TIMELINE(*server, f), DAT_NTIMERANGES(*server, f), sizeof(PIOTimeRange)) < 0) return -1;
+    return putArray(results, server->numberOfEntriesPerTimerangePerFile[f], DAT_NTIMERANGES(*server, f), sizeof(int));
+}
+
+/**
+ @internal
+ @brief Collect scan of fth data file by a worker process (see runInProcesses())
+ 
+ @param[in,out] context Scan context
+ @param[in] f File index
+ @param[in,out] results Results of worker process
+ @returns 1 when successful, -1 otherwise (nothing is kept then)
+ */
+static int collectDataFile(void* context, int f, FILE* results)
+{
+    scanContext_t* scan = (scanContext_t*) context;
+    GPTServer* server = scan->server;
+    int status, type;
+    
+    if (getInt(results, &status) < 0) return -1;
+    scan->status[f] = (scanStatus_t) status;
+    if (scan->status[f] != SCAN_SUCCESS) return 1;
+    
+    if (getInt(results, &type) < 0) return -1;
+    scan->type[f] = (PIOBaseType) type;
+    if (getInt(results, &(scan->dimension[f])) < 0) return -1;
+    if (getInt(results, &(DAT_NTIMERANGES(*server, f))) < 0) return -1;
+    DAT_TIMELINE(*server, f) = (PIOTimeRange*) getArray(results, DAT_NTIMERANGES(*server, f), sizeof(PIOTimeRange));
+    server->numberOfEntriesPerTimerangePerFile[f] = (int*) getArray(results, DAT_NTIMERANGES(*server, f), sizeof(int));
+    
+    if (!DAT_TIMELINE(*server, f) || !server->numberOfEntriesPerTimerangePerFile[f])
+    {
+        free(DAT_TIMELINE(*server, f));
+        free(server->numberOfEntriesPerTimerangePerFile[f]);
+        DAT_TIMELINE(*server, f) = NULL;
+        server->numberOfEntriesPerTimerangePerFile[f] = NULL;
+        return -1;
+    }
+    
+    return 1;
+}
+
 /**
  @internal
  @brief Init data storage variables
@@ -477,6 +936,8 @@ static int initDataConfiguration( GPTServer* server, int numberOfDataFiles, char
  - server.datatype
  - server.numberOfEntriesPerTimerangePerFile
  
+ Data files are shared between server.options.numberOfProcesses processes.
+ 
  @param[in, out] server Gepetto server
  @returns
  - 1 when successful
@@ -485,118 +946,67 @@ static int initDataConfiguration( GPTServer* server, int numberOfDataFiles, char
 static int initDataStorage(GPTServer* gptServer)
 {
     int f;
-    int data_t;
+    int failed = 0;
+    scanContext_t scan;
     
     gptServer->dataTimeline = (PIOTimeRange**) malloc(DAT_NFILES(*gptServer)*sizeof(PIOTimeRange*));
     for (f=0; f<DAT_NFILES(*gptServer); f++) DAT_TIMELINE(*gptServer, f) = NULL;
     
     gptServer->numberOfEntriesPerTimerangePerFile = (int**)malloc(sizeof(int*)*DAT_NFILES(*gptServer));
+    for (f=0; f<DAT_NFILES(*gptServer); f++) gptServer->numberOfEntriesPerTimerangePerFile[f] = NULL;
     
     gptServer->lengthOfDataTimeline = (int*) malloc(DAT_NFILES(*gptServer)*sizeof(int));
     
     // test, initialize and (partially, timeline only) load data
-    for (f=0; f<DAT_NFILES(*gptServer); f++)
-    {            
-        // test fth data file
-        gptServer->current_file = pioOpenFile(DAT_PATH(*gptServer, f), PINOCCHIO_READONLY);
-        if (PIOFileIsInvalid(gptServer->current_file)) 
-        {
-            fprintf(stderr, "Geppeto cannot open data file %s.\n", DAT_PATH(*gptServer, f));
-            fflush(stderr);
-            gptCloseServer(gptServer);
-            return -1;
-        }
-        
-        // test fth data dataset
-        gptServer->current_dataset = pioOpenDataset(PIOMakeObject(gptServer->current_file),
-                                                    DAT_DATASET(*gptServer));
-        if (PIODatasetIsInvalid(gptServer->current_dataset))
-        {
-            fprintf(stderr, "Gepetto cannot open data dataset %s in file %s.\n",
-                    DAT_DATASET(*gptServer), DAT_PATH(*gptServer, f));
-            fflush(stderr);
-            gptCloseServer(gptServer);
-            return -1;
-        }
-        
-        // test fth data datatype
-        gptServer->current_datatype = pioGetDatatype(gptServer->current_dataset);
-        if (PIODatatypeIsInvalid(gptServer->current_datatype))
+    scan.server = gptServer;
+    scan.status = (scanStatus_t*) malloc(DAT_NFILES(*gptServer)*sizeof(scanStatus_t));
+    scan.type = (PIOBaseType*) malloc(DAT_NFILES(*gptServer)*sizeof(PIOBaseType));
+    scan.dimension = (int*) malloc(DAT_NFILES(*gptServer)*sizeof(int));
+    runInProcesses(gptServer->options.numberOfProcesses, DAT_NFILES(*gptServer), 
+                   scanDataFile, collectDataFile, &scan);
+    
+    // report first failure and check that all datatypes match the first one
+    for (f=0; f<DAT_NFILES(*gptServer) && !failed; f++)
+    {
+        if (scan.status[f] != SCAN_SUCCESS)
         {
-            fprintf(stderr, "Gepetto cannot get datatype of data dataset %s in file %s.\n",
-                    DAT_DATASET(*gptServer), DAT_PATH(*gptServer, f));
-            fflush(stderr);
-            gptCloseServer(gptServer);
-            return -1;            
+            reportScanError(scan.status[f], "data", DAT_PATH(*gptServer, f), DAT_DATASET(*gptServer));
+            failed = 1;
         }
-        
-        if (f == 0)
+        else if (f == 0)
         {
             // initialize data datatype
-            gptServer->datatype = pioNewDatatype(gptServer->current_datatype.type,
-                                                 gptServer->current_datatype.dimension);
+            gptServer->datatype = pioNewDatatype(scan.type[f], scan.dimension[f]);
             if (PIODatatypeIsInvalid(gptServer->datatype))
             {
                 fprintf(stderr, "Gepetto found that datatype of dataset %s in first file %s is invalid.\n",
                         DAT_DATASET(*gptServer), DAT_PATH(*gptServer, f));
                 fflush(stderr);
-                
-                gptCloseServer(gptServer);
-                return -1;            
+                failed = 1;
             }
         }
-        else
-        {
-            // test fth data datatype
-            if ((gptServer->current_datatype.dimension != gptServer->datatype.dimension) ||
-                (gptServer->current_datatype.type      != gptServer->datatype.type))
-            {
-                fprintf(stderr, 
-                        "Gepetto found that the datatype of dataset %s in file %s does not match the one in first file %s.\n",
-                        DAT_DATASET(*gptServer), DAT_PATH(*gptServer, f), DAT_PATH(*gptServer, 0));
-                fflush(stderr);                
-                gptCloseServer(gptServer);
-                return -1;            
-            }
-        }
-        
-        // load data timeline
-        gptServer->current_timeline = pioGetTimeline(gptServer->current_dataset);
-        if (PIOTimelineIsInvalid(gptServer->current_timeline))
-        {
-            fprintf(stderr, "Geppeto cannot open timeline of data dataset %s in file %s.\n",
-                    DAT_DATASET(*gptServer), DAT_PATH(*gptServer, f));
-            fflush(stderr);
-            gptCloseServer(gptServer);
-            return -1;
-            
-        }
-        DAT_NTIMERANGES(*gptServer, f) = gptServer->current_timeline.ntimeranges;
-        DAT_TIMELINE(*gptServer, f) = (PIOTimeRange*) malloc(DAT_NTIMERANGES(*gptServer, f)*sizeof(PIOTimeRange));
-        for (data_t=0; data_t<DAT_NTIMERANGES(*gptServer, f); data_t++) 
-            DAT_TIMERANGE(*gptServer, f, data_t) = gptServer->current_timeline.timeranges[data_t];
-        
-        // load number of entries per timerange
-        gptServer->numberOfEntriesPerTimerangePerFile[f] = (int*)malloc(sizeof(int)*DAT_NTIMERANGES(*gptServer, f));
-        if (pioReadAllNumbers(gptServer->current_dataset, gptServer->numberOfEntriesPerTimerangePerFile[f]) < 0)
+        else if ((scan.dimension[f] != gptServer->datatype.dimension) ||
+                 (scan.type[f]      != gptServer->datatype.type))
         {
-            fprintf(stderr, "Geppeto cannot get number of entries from data dataset %s in file %s.\n",
-                    DAT_DATASET(*gptServer), DAT_PATH(*gptServer, f));
-            fflush(stderr);
-            gptCloseServer(gptServer);
-            return -1;
+            fprintf(stderr, 
+                    "Gepetto found that the datatype of dataset %s in file %s does not match the one in first file %s.\n",
+                    DAT_DATASET(*gptServer), DAT_PATH(*gptServer, f), DAT_PATH(*gptServer, 0));
+            fflush(stderr);                
+            failed = 1;
         }
-        
-        // prepare for next file
-        pioCloseTimeline(&(gptServer->current_timeline));
-        pioCloseDatatype(&(gptServer->current_datatype));
-        pioCloseDataset(&(gptServer->current_dataset));
-        pioCloseFile(&(gptServer->current_file));
     }
     
+    free(scan.status);
+    free(scan.type);
+    free(scan.dimension);
     
-    return 1;
+    if (failed)
+    {
+        gptCloseServer(gptServer);
+        return -1;
+    }
     
+    return 1;
 }
 
 /**
@@ -608,6 +1018,7 @@ static int initDataStorage(GPTServer* gptServer)
  - server.labelFilterReference
  - server.firstCorrespondingLabelTimerange
  - server.numberOfCorrespondingLabelTimerange
+ - server.filtered (label filter must be compiled already)
  
  @param[in, out] server Gepetto server
  @param[in] type Type of label filter
@@ -619,7 +1030,6 @@ static int initDataStorage(GPTServer* gptServer)
 static int initDataFiltering(GPTServer* server, GPTLabelFilterType type, int reference, int maximumNumberOfSamplesPerLabel)
 {
     int f;
-    int label_t;
     int data_t;
     
     server->labelFilterType = type;
@@ -642,60 +1052,16 @@ static int initDataFiltering(GPTServer* server, GPTLabelFilterType type, int ref
         
         if (LBL_AVAILABLE(*server))
         {
-            for (data_t=0; data_t<DAT_NTIMERANGES(*server, f); data_t++) 
-            {                    
-                // start looking at first matching timerange of previous data timerange
-                if (data_t == 0) label_t = 0;
-                else label_t = MAX(server->firstCorrespondingLabelTimerange[f][data_t-1], 0);
-                
-                // look for first matching timerange
-                while (// not yet reached the end of label timeline
-                       (label_t < LBL_NTIMERANGES(*server, f)) &&
-                       // label timerange still happens BEFORE data timerange
-                       (pioCompareTimeRanges(LBL_TIMERANGE(*server, f, label_t), 
-                                             DAT_TIMERANGE(*server, f, data_t)) != PINOCCHIO_TIMERANGE_COMPARISON_DESCENDING) &&
-                       // label timerange still DOES NOT intersect data timerange
-                       (!pioTimeRangeIntersectsTimeRange(LBL_TIMERANGE(*server, f, label_t), 
-                                                         DAT_TIMERANGE(*server, f, data_t))))
-                    label_t++;
-                
-                // if there is at least one matching timerange
-                if ((label_t < LBL_NTIMERANGES(*server, f)) &&
-                    (pioTimeRangeIntersectsTimeRange(LBL_TIMERANGE(*server, f, label_t), 
-                                                     DAT_TIMERANGE(*server, f, data_t))))
-                {
-                    // store first matching timerange
-                    server->firstCorrespondingLabelTimerange[f][data_t] = label_t;
-                    
-                    // count number of matching timeranges
-                    while (                           
-                           // not yet reached the end of label timeline
-                           (label_t < LBL_NTIMERANGES(*server, f))
-                           &&
-                           (pioTimeRangeIntersectsTimeRange(LBL_TIMERANGE(*server, f, label_t), 
-                                                            DAT_TIMERANGE(*server, f, data_t)))) 
-                    {
-                        server->numberOfCorrespondingLabelTimerange[f][data_t]++;    
-                        label_t++;
-                    }
-                }
-            }
+            // first matching label timerange and number of matching label timeranges
+            if (pioJoinTimeLines(DAT_TIMELINE(*server, f), DAT_NTIMERANGES(*server, f),
+                                 LBL_TIMELINE(*server, f), LBL_NTIMERANGES(*server, f),
+                                 server->firstCorrespondingLabelTimerange[f],
+                                 server->numberOfCorrespondingLabelTimerange[f]) < 0)
+                return -1;
         }
     }
     
-    server->filtered = (int**) malloc(DAT_NFILES(*server)*sizeof(int*));
-    for (f=0; f<DAT_NFILES(*server); f++) 
-    {
-        // initialize with "no filter" (i.e. keep everything)
-        server->filtered[f] = (int*) malloc(DAT_NTIMERANGES(*server, f)*sizeof(int));
-        for (data_t=0; data_t<DAT_NTIMERANGES(*server, f); data_t++) 
-            server->filtered[f][data_t] = 1;
-        
-        if (LBL_AVAILABLE(*server))
-            for (data_t=0; data_t<DAT_NTIMERANGES(*server, f); data_t++) 
-                server->filtered[f][data_t] = isFiltered(*server, f, data_t);
-        
-    }
+    filterData(server);
     
     return 1;
 }
@@ -887,54 +1253,91 @@ static int initDataStatistics(GPTServer* server)
     int i;
     int r;
     int n;
-    listOfLabels_t* localList;
-    
-    server->numberOfVectorsWithLabel = (int*) malloc(LBL_NUMBER(*server)*sizeof(int));
-    for (n=0; n<LBL_NUMBER(*server); n++) server->numberOfVectorsWithLabel[n] = 0;
+    int stamp;
+    int* lastSeen = NULL;
+    labelMap_t* rankOfLabel = NULL;
     
+    server->numberOfVectorsWithLabel = (int*) calloc(LBL_NUMBER(*server), sizeof(int));
     server->numberOfVectorsWithLabelPerFile = (int**) malloc(DAT_NFILES(*server)*sizeof(int*));
     for (f=0; f<DAT_NFILES(*server); f++)
+        server->numberOfVectorsWithLabelPerFile[f] = (int*) calloc(LBL_NUMBER(*server), sizeof(int));
+    
+    // label value to label rank
+    rankOfLabel = newLabelMap(LBL_NUMBER(*server));
+    if (!rankOfLabel)
     {
-        server->numberOfVectorsWithLabelPerFile[f] = (int*) malloc(LBL_NUMBER(*server)*sizeof(int));
-        for (n=0; n<LBL_NUMBER(*server); n++) 
-            server->numberOfVectorsWithLabelPerFile[f][n] = 0;        
+        gptCloseServer(server);
+        return -1;
     }
+    for (n=0; n<LBL_NUMBER(*server); n++)
+        *labelMapInsert(rankOfLabel, LBL_VALUE(*server, n)) = n;
+    
+    // lastSeen[n] is the stamp of the last data timerange counted for nth label
+    lastSeen = (int*) malloc(LBL_NUMBER(*server)*sizeof(int));
+    for (n=0; n<LBL_NUMBER(*server); n++) lastSeen[n] = -1;
     
+    stamp = 0;
     for (f=0; f<DAT_NFILES(*server); f++)
     {
-        for (data_t=0; data_t<DAT_NTIMERANGES(*server, f); data_t++) 
+        for (data_t=0; data_t<DAT_NTIMERANGES(*server, f); data_t++, stamp++) 
         {
-            localList = NULL;
-            
-            // get each data timerange label counts
+            // add +1 for each data timerange with at least one corresponding label
             for (i=0; i<server->numberOfCorrespondingLabelTimerange[f][data_t]; i++) 
             {
                 label_t = server->firstCorrespondingLabelTimerange[f][data_t]+i;
                 for (r=0; r<LBL_NLABELS(*server, f, label_t); r++) 
-                    localList = updateLabelCount(localList, LBL_LABEL(*server, f, label_t, r), 1);
-            }   
-            
-            // add +1 for each data timerange with at least one corresponding label
-            for (n=0; n<LBL_NUMBER(*server); n++) 
-            {
-                if (getLabelCount(localList, LBL_VALUE(*server, n)) > 0)
                 {
+                    n = labelMapFind(rankOfLabel, LBL_LABEL(*server, f, label_t, r), -1);
+                    if (lastSeen[n] == stamp) continue;
+                    lastSeen[n] = stamp;
                     server->numberOfVectorsWithLabel[n]           += server->numberOfEntriesPerTimerangePerFile[f][data_t];
                     server->numberOfVectorsWithLabelPerFile[f][n] += server->numberOfEntriesPerTimerangePerFile[f][data_t];
                 }
             }
-            
-            destroyListOfLabels(localList);
         }
     }
+    
+    free(lastSeen);
+    destroyLabelMap(rankOfLabel);
     return 1;
 }
 
 GPTServer gptNewServer(int numberOfDataFiles, char** pathToDataFile, const char* pathToDataDataset,
                        GPTLabelFilterType labelFilterType, int labelFilterReference, int maximumNumberOfSamplesPerLabel,
                        int numberOfLabelFiles, char** pathToLabelFile, const char* pathToLabelDataset)
+{
+    return gptNewServerWithOptions(numberOfDataFiles, pathToDataFile, pathToDataDataset,
+                                   labelFilterType, labelFilterReference, maximumNumberOfSamplesPerLabel,
+                                   numberOfLabelFiles, pathToLabelFile, pathToLabelDataset,
+                                   GPTServerOptionsDefault);
+}
+
+GPTServer gptNewServerWithOptions(int numberOfDataFiles, char** pathToDataFile, const char* pathToDataDataset,
+                                  GPTLabelFilterType labelFilterType, int labelFilterReference, int maximumNumberOfSamplesPerLabel,
+                                  int numberOfLabelFiles, char** pathToLabelFile, const char* pathToLabelDataset,
+                                  GPTServerOptions options)
 {        
     GPTServer gptServer = GPTServerInvalid;
+    uint64_t cacheKey = 0;
+    int hasCacheKey = 0;
+    int cached = 0;
+    GPTLabelPredicate simplePredicate;
+    const GPTLabelPredicate* labelPredicate = NULL;
+    
+    gptServer.options = options;
+    // path to cache file and label predicate are not kept by the server
+    gptServer.options.cacheFile = NULL;
+    gptServer.options.labelPredicate = NULL;
+    
+    // compound label filter takes precedence over simple one
+    simplePredicate = getSimpleLabelPredicate(labelFilterType, &labelFilterReference);
+    labelPredicate = options.labelPredicate ? options.labelPredicate : &simplePredicate;
+    if (checkLabelPredicate(labelPredicate) < 0)
+    {
+        fprintf(stderr, "Gepetto found that label filter is invalid.\n");
+        fflush(stderr);
+        return GPTServerInvalid;
+    }
     
     if (initLabelConfiguration(&gptServer, numberOfLabelFiles, pathToLabelFile, pathToLabelDataset) < 0)
         return GPTServerInvalid;
@@ -958,7 +1361,7 @@ GPTServer gptNewServer(int numberOfDataFiles, char** pathToDataFile, const char*
     
     // if server applies filters on labels
     // make sure server serves labels
-    if ((labelFilterType != GEPETTO_LABEL_FILTER_TYPE_NONE) && 
+    if (((labelFilterType != GEPETTO_LABEL_FILTER_TYPE_NONE) || options.labelPredicate) && 
         (!LBL_AVAILABLE(gptServer)))
     {
         fprintf(stderr, "Cannot apply filter if no label is available.\n");
@@ -967,45 +1370,95 @@ GPTServer gptNewServer(int numberOfDataFiles, char** pathToDataFile, const char*
         return GPTServerInvalid;
     }
     
+    // data and label files are opened through the pool from now on
+    gptServer.pool = pioNewPool(options.maximumNumberOfOpenFiles);
+    if (!gptServer.pool)
+    {
+        fprintf(stderr, "Gepetto could not create pool of %d open files.\n", options.maximumNumberOfOpenFiles);
+        fflush(stderr);
+        gptCloseServer(&gptServer);
+        return GPTServerInvalid;
+    }
+    
+    // try and load storage, correspondence and filtering from cache file
+    // (valid as long as configuration and pinocchIO files are unchanged)
+    if (options.cacheFile)
+    {
+        hasCacheKey = (getServerCacheKey(&gptServer, labelPredicate, 
+                                         maximumNumberOfSamplesPerLabel, &cacheKey) > 0);
+        if (hasCacheKey)
+            cached = loadServerCache(&gptServer, options.cacheFile, cacheKey);
+    }
+    
     // initialize server label stuff
     if (LBL_AVAILABLE(gptServer))
     {
-        if (initLabelStorage(&gptServer) < 0)
-            return GPTServerInvalid;
-        
+        if (!cached)
+            if (initLabelStorage(&gptServer) < 0)
+                return GPTServerInvalid;
         
         if (initLabelStatistics(&gptServer) < 0)
             return GPTServerInvalid;        
+        
+        if (initLabelIndex(&gptServer) < 0)
+            return GPTServerInvalid;
+        
+        if (compileLabelFilter(&gptServer, labelPredicate) < 0)
+        {
+            fprintf(stderr, "Gepetto could not compile label filter.\n");
+            fflush(stderr);
+            gptCloseServer(&gptServer);
+            return GPTServerInvalid;
+        }
     }
     
     if (DAT_AVAILABLE(gptServer))
     {        
-        if (initDataStorage(&gptServer) < 0)
-            return GPTServerInvalid;
-        
-        if (initDataFiltering(&gptServer, labelFilterType, labelFilterReference, maximumNumberOfSamplesPerLabel) < 0)
-            return GPTServerInvalid;
+        if (cached)
+        {
+            gptServer.labelFilterType = labelFilterType;
+            gptServer.labelFilterReference = labelFilterReference;
+            gptServer.maximumNumberOfSamplesPerLabel = maximumNumberOfSamplesPerLabel;
+        }
+        else
+        {
+            if (initDataStorage(&gptServer) < 0)
+                return GPTServerInvalid;
+            
+            if (initDataFiltering(&gptServer, labelFilterType, labelFilterReference, maximumNumberOfSamplesPerLabel) < 0)
+                return GPTServerInvalid;
+        }
         
         if (LBL_AVAILABLE(gptServer))
         {
             if (initDataStatistics(&gptServer) < 0)
                 return GPTServerInvalid;
             
-            if (gptServer.maximumNumberOfSamplesPerLabel > 0)
+            // cached filter mask is already sampled
+            if (!cached && (gptServer.maximumNumberOfSamplesPerLabel > 0))
                 if (performDataSamplingPerLabel(&gptServer) < 0)
                     return GPTServerInvalid;
         }
         else {
-            if (gptServer.maximumNumberOfSamplesPerLabel > 0)
+            if (!cached && (gptServer.maximumNumberOfSamplesPerLabel > 0))
                 if (performDataSampling(&gptServer) < 0)
                     return GPTServerInvalid;
         }
     }
     
+    // failing to write cache file is not fatal
+    if (hasCacheKey && !cached)
+    {
+        if (saveServerCache(&gptServer, options.cacheFile, cacheKey) < 0)
+        {
+            fprintf(stderr, "Gepetto could not write cache file %s.\n", options.cacheFile);
+            fflush(stderr);
+        }
+    }
+    
     gptServer.current_file_index = 0;
-    gptServer.current_file = PIOFileInvalid;
     gptServer.current_timerange_index = 0;
-    gptServer.current_dataset = PIODatasetInvalid;
+    gptServer.current_dataset = NULL;
     gptServer.current_timeline = PIOTimelineInvalid;
     
     gptServer.eof = 0;
@@ -1013,10 +1466,103 @@ GPTServer gptNewServer(int numberOfDataFiles, char** pathToDataFile, const char*
     return gptServer;
 }
 
+/**
+ @internal
+ @brief Free server.filtered
+ @param[in] filtered Served timeranges, per data file (or NULL)
+ @param[in] numberOfDataFiles Number of data files
+ */
+static void freeFiltered(int** filtered, int numberOfDataFiles)
+{
+    int f;
+    
+    if (!filtered) return;
+    for (f=0; f<numberOfDataFiles; f++) free(filtered[f]);
+    free(filtered);
+}
+
+/**
+ @internal
+ @brief Free server.labelAccepted
+ @param[in] labelAccepted Accepted labels, per label file (or NULL)
+ @param[in] numberOfLabelFiles Number of label files
+ */
+static void freeLabelAccepted(char** labelAccepted, int numberOfLabelFiles)
+{
+    int f;
+    
+    if (!labelAccepted) return;
+    for (f=0; f<numberOfLabelFiles; f++) free(labelAccepted[f]);
+    free(labelAccepted);
+}
+
+/**
+ @internal
+ @brief Replace label filter of a server
+ 
+ Compile @a predicate, then update (and sample) served data accordingly.
+ Used by gptSetLabelFilter().
+ 
+ The new filter is computed into new server.labelAccepted and server.filtered 
+ arrays, which only replace the current ones once everything succeeded.
+ 
+ @param[in,out] server Gepetto server
+ @param[in] predicate Label predicate
+ @returns
+ - 1 when successful
+ - -1 otherwise (server is left unchanged)
+ */
+int updateLabelFilter(GPTServer* server, const GPTLabelPredicate* predicate)
+{
+    char** labelAccepted = server->labelAccepted;
+    int** filtered = server->filtered;
+    int success = 1;
+    
+    if (!LBL_AVAILABLE(*server)) return -1;
+    if (checkLabelPredicate(predicate) < 0) return -1;
+    
+    server->labelAccepted = NULL;
+    if (DAT_AVAILABLE(*server)) server->filtered = NULL;
+    
+    if (compileLabelFilter(server, predicate) < 0) success = 0;
+    if (success && DAT_AVAILABLE(*server))
+    {
+        filterData(server);
+        if (server->maximumNumberOfSamplesPerLabel > 0)
+            if (performDataSamplingPerLabel(server) < 0)
+                success = 0;
+    }
+    
+    if (!success)
+    {
+        // restore previous filter
+        freeLabelAccepted(server->labelAccepted, LBL_NFILES(*server));
+        server->labelAccepted = labelAccepted;
+        if (DAT_AVAILABLE(*server))
+        {
+            freeFiltered(server->filtered, DAT_NFILES(*server));
+            server->filtered = filtered;
+        }
+        return -1;
+    }
+    
+    freeLabelAccepted(labelAccepted, LBL_NFILES(*server));
+    if (DAT_AVAILABLE(*server)) freeFiltered(filtered, DAT_NFILES(*server));
+    return 1;
+}
+
 int gptCloseServer(GPTServer* gptServer)
 {
     int f = 0;
     
+    // stop gptReadNext() read-ahead thread
+    if (gptServer->prefetcher) stopPrefetcher(gptServer->prefetcher);
+    gptServer->prefetcher = NULL;
+    
+    // give data file read by iteration order back to the pool
+    if (gptServer->iterator) destroyIterator(gptServer->iterator);
+    gptServer->iterator = NULL;
+    
     // free pathToDataFile
     if (gptServer->pathToDataFile)
     {
@@ -1062,12 +1608,19 @@ int gptCloseServer(GPTServer* gptServer)
     // free label counts
     free(gptServer->labelCounts);
     // free per file label counts
-    for (f=0; f<LBL_NFILES(*gptServer); f++)
+    if (gptServer->labelCountsPerFile)
     {
-        free(gptServer->labelCountsPerFile[f]);
-        gptServer->labelCountsPerFile[f] = NULL;
+        for (f=0; f<LBL_NFILES(*gptServer); f++)
+        {
+            free(gptServer->labelCountsPerFile[f]);
+            gptServer->labelCountsPerFile[f] = NULL;
+        }
+        free(gptServer->labelCountsPerFile); 
     }
-    free(gptServer->labelCountsPerFile); 
+    
+    // free label inverted index
+    free(gptServer->firstLabelTimerange);
+    free(gptServer->labelTimeranges);
     
     // free pathToLabelFile
     if (gptServer->pathToLabelFile)
@@ -1142,16 +1695,13 @@ int gptCloseServer(GPTServer* gptServer)
     gptServer->firstCorrespondingLabelTimerange = NULL;
     
     // free filtered
-    if (gptServer->filtered)
-    {
-        for (f=0; f<gptServer->numberOfDataFiles; f++) {
-            if (gptServer->filtered[f]) free(gptServer->filtered[f]); 
-            gptServer->filtered[f] = NULL;
-        }
-        free(gptServer->filtered);
-    }
+    freeFiltered(gptServer->filtered, gptServer->numberOfDataFiles);
     gptServer->filtered = NULL;
     
+    // free labelAccepted
+    freeLabelAccepted(gptServer->labelAccepted, gptServer->numberOfLabelFiles);
+    gptServer->labelAccepted = NULL;
+    
     // free datatype
     if (PIODatatypeIsValid(gptServer->datatype))
         pioCloseDatatype(&(gptServer->datatype));
@@ -1160,13 +1710,8 @@ int gptCloseServer(GPTServer* gptServer)
     if (PIODatatypeIsValid(gptServer->labelDatatype))
         pioCloseDatatype(&(gptServer->labelDatatype));
     
-    // free current_file
-    if (PIOFileIsValid(gptServer->current_file)) 
-        pioCloseFile(&(gptServer->current_file));
-    
-    // free current_dataset
-    if (PIODatasetIsValid(gptServer->current_dataset))
-        pioCloseDataset(&(gptServer->current_dataset));
+    // close files kept open by the pool (including current_dataset)
+    if (gptServer->pool) pioClosePool(&(gptServer->pool));
     
     // free current_datatype
     if (PIODatatypeIsValid(gptServer->current_datatype))
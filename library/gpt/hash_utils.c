@@ -0,0 +1,151 @@
+// 
+// Copyright 2010-2011 Herve BREDIN (bredin@limsi.fr)
+// Contact: http://pinocchio.niderb.fr/
+// 
+// This file is part of pinocchIO.
+//  
+//      pinocchIO is free software: you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation, either version 3 of the License, or
+//      (at your option) any later version.
+//  
+//      pinocchIO is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//  
+//      You should have received a copy of the GNU General Public License
+//      along with pinocchIO. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+#include "hash_utils.h"
+#include <stdlib.h>
+#include <stdint.h>
+
+#define LABEL_MAP_MINIMUM_CAPACITY 16
+
+// murmur3 finalizer: consecutive labels end up far apart
+static int slotOf(int capacity, int label)
+{
+    uint32_t h = (uint32_t) label;
+    h ^= h >> 16;
+    h *= 0x85ebca6bU;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35U;
+    h ^= h >> 16;
+    return (int)(h & (uint32_t)(capacity-1));
+}
+
+static int allocLabelMap(labelMap_t* map, int capacity)
+{
+    map->capacity = capacity;
+    map->count = 0;
+    map->keys = (int*) malloc(capacity*sizeof(int));
+    map->values = (int*) malloc(capacity*sizeof(int));
+    map->used = (char*) calloc(capacity, sizeof(char));
+    if (!map->keys || !map->values || !map->used)
+    {
+        free(map->keys); free(map->values); free(map->used);
+        return -1;
+    }
+    return 1;
+}
+
+labelMap_t* newLabelMap(int expectedNumberOfLabels)
+{
+    labelMap_t* map = NULL;
+    int capacity = LABEL_MAP_MINIMUM_CAPACITY;
+    
+    // keep load factor under 1/2
+    while (capacity < 2*expectedNumberOfLabels) capacity *= 2;
+    
+    map = (labelMap_t*) malloc(sizeof(labelMap_t));
+    if (!map) return NULL;
+    if (allocLabelMap(map, capacity) < 0)
+    {
+        free(map);
+        return NULL;
+    }
+    return map;
+}
+
+void destroyLabelMap(labelMap_t* map)
+{
+    if (!map) return;
+    free(map->keys);
+    free(map->values);
+    free(map->used);
+    free(map);
+}
+
+static int growLabelMap(labelMap_t* map)
+{
+    labelMap_t old = *map;
+    int i, s;
+    
+    if (allocLabelMap(map, 2*old.capacity) < 0)
+    {
+        *map = old;
+        return -1;
+    }
+    
+    for (i=0; i<old.capacity; i++)
+    {
+        if (!old.used[i]) continue;
+        s = slotOf(map->capacity, old.keys[i]);
+        while (map->used[s]) s = (s+1) & (map->capacity-1);
+        map->used[s] = 1;
+        map->keys[s] = old.keys[i];
+        map->values[s] = old.values[i];
+        map->count++;
+    }
+    
+    free(old.keys);
+    free(old.values);
+    free(old.used);
+    return 1;
+}
+
+int* labelMapInsert(labelMap_t* map, int label)
+{
+    int s;
+    
+    if (2*(map->count+1) > map->capacity)
+        if (growLabelMap(map) < 0) return NULL;
+    
+    s = slotOf(map->capacity, label);
+    while (map->used[s])
+    {
+        if (map->keys[s] == label) return &(map->values[s]);
+        s = (s+1) & (map->capacity-1);
+    }
+    
+    // new label, with value 0
+    map->used[s] = 1;
+    map->keys[s] = label;
+    map->values[s] = 0;
+    map->count++;
+    return &(map->values[s]);
+}
+
+int labelMapFind(const labelMap_t* map, int label, int missing)
+{
+    int s = slotOf(map->capacity, label);
+    
+    while (map->used[s])
+    {
+        if (map->keys[s] == label) return map->values[s];
+        s = (s+1) & (map->capacity-1);
+    }
+    return missing;
+}
+
+int labelMapKeys(const labelMap_t* map, int* keys)
+{
+    int i, n = 0;
+    
+    for (i=0; i<map->capacity; i++)
+        if (map->used[i]) keys[n++] = map->keys[i];
+    return n;
+}
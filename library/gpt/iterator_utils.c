@@ -0,0 +1,370 @@
+// 
+// Copyright 2010-2011 Herve BREDIN (bredin@limsi.fr)
+// Contact: http://pinocchio.niderb.fr/
+// 
+// This file is part of pinocchIO.
+//  
+//      pinocchIO is free software: you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation, either version 3 of the License, or
+//      (at your option) any later version.
+//  
+//      pinocchIO is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//  
+//      You should have received a copy of the GNU General Public License
+//      along with pinocchIO. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+
+#include "iterator_utils.h"
+#include "hash_utils.h"
+#include "data_utils.h"
+#include <stdlib.h>
+
+// splitmix64: same seed, same sequence on every platform
+static uint64_t nextRandom(uint64_t* state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// uniform integer in [0, n)
+static int randomIndex(uint64_t* state, int n)
+{
+    return (int)(((nextRandom(state) >> 32) * (uint64_t)n) >> 32);
+}
+
+// Fisher-Yates shuffle
+static void shufflePositions(iteratorPosition_t* positions, int n, uint64_t* state)
+{
+    iteratorPosition_t tmp;
+    int i, j;
+    
+    for (i=n-1; i>0; i--)
+    {
+        j = randomIndex(state, i+1);
+        tmp = positions[i]; positions[i] = positions[j]; positions[j] = tmp;
+    }
+}
+
+static int comparePositions(const void* p1, const void* p2)
+{
+    const iteratorPosition_t* a = (const iteratorPosition_t*) p1;
+    const iteratorPosition_t* b = (const iteratorPosition_t*) p2;
+    
+    if (a->fileIndex != b->fileIndex) return (a->fileIndex < b->fileIndex) ? -1 : 1;
+    if (a->timerangeIndex != b->timerangeIndex) return (a->timerangeIndex < b->timerangeIndex) ? -1 : 1;
+    return 0;
+}
+
+// same as comparePositions() with files in reverse order
+static int comparePositionsReverse(const void* p1, const void* p2)
+{
+    const iteratorPosition_t* a = (const iteratorPosition_t*) p1;
+    const iteratorPosition_t* b = (const iteratorPosition_t*) p2;
+    
+    if (a->fileIndex != b->fileIndex) return (a->fileIndex > b->fileIndex) ? -1 : 1;
+    return comparePositions(p1, p2);
+}
+
+// item j of group g is due at (2j+1)/(2*size[g]) of the epoch
+static int isDueBefore(int g1, int g2, const int* taken, const int* size)
+{
+    int64_t due1 = (2*(int64_t)taken[g1]+1)*size[g2];
+    int64_t due2 = (2*(int64_t)taken[g2]+1)*size[g1];
+    
+    if (due1 != due2) return due1 < due2;
+    return g1 < g2;
+}
+
+static void siftDown(int* heap, int n, int i, const int* taken, const int* size)
+{
+    int child, tmp;
+    
+    while ((child = 2*i+1) < n)
+    {
+        if ((child+1 < n) && isDueBefore(heap[child+1], heap[child], taken, size)) child++;
+        if (!isDueBefore(heap[child], heap[i], taken, size)) break;
+        tmp = heap[i]; heap[i] = heap[child]; heap[child] = tmp;
+        i = child;
+    }
+}
+
+/**
+ @brief Interleave label groups
+ 
+ @param[in] mode Round-robin or stratified
+ @param[in] grouped Positions, grouped by label
+ @param[in] first grouped[first[g]] to grouped[first[g+1]-1] is the gth group
+ @param[in] numberOfGroups Number of groups
+ @param[out] positions Interleaved positions
+ 
+ @returns
+ - 1 if successful
+ - -1 otherwise
+ */
+static int interleaveGroups(GPTIterationMode mode, const iteratorPosition_t* grouped, 
+                            const int* first, int numberOfGroups, iteratorPosition_t* positions)
+{
+    int* size = NULL;
+    int* taken = NULL;
+    int* active = NULL;
+    int numberOfActive;
+    int g, i, k = 0;
+    
+    if (numberOfGroups < 1) return 1;
+    
+    size = (int*) malloc(numberOfGroups*sizeof(int));
+    taken = (int*) calloc(numberOfGroups, sizeof(int));
+    active = (int*) malloc(numberOfGroups*sizeof(int));
+    if (!size || !taken || !active)
+    {
+        free(size); free(taken); free(active);
+        return -1;
+    }
+    
+    for (g=0; g<numberOfGroups; g++)
+    {
+        size[g] = first[g+1]-first[g];
+        active[g] = g;
+    }
+    numberOfActive = numberOfGroups;
+    
+    if (mode == GEPETTO_ITERATION_MODE_ROUND_ROBIN)
+    {
+        // one of each group per round, until every group is exhausted
+        while (numberOfActive > 0)
+        {
+            i = numberOfActive;
+            numberOfActive = 0;
+            for (g=0; g<i; g++)
+            {
+                positions[k++] = grouped[first[active[g]]+taken[active[g]]];
+                taken[active[g]]++;
+                if (taken[active[g]] < size[active[g]]) active[numberOfActive++] = active[g];
+            }
+        }
+    }
+    else
+    {
+        // smooth weighted round-robin: each group is spread evenly over the epoch
+        // (active is a min-heap on the next due time of each group)
+        for (i=numberOfActive/2-1; i>=0; i--) siftDown(active, numberOfActive, i, taken, size);
+        while (numberOfActive > 0)
+        {
+            g = active[0];
+            positions[k++] = grouped[first[g]+taken[g]];
+            taken[g]++;
+            if (taken[g] == size[g]) active[0] = active[--numberOfActive];
+            siftDown(active, numberOfActive, 0, taken, size);
+        }
+    }
+    
+    free(active);
+    free(taken);
+    free(size);
+    return 1;
+}
+
+/**
+ @brief Group served timeranges by label and interleave groups
+ 
+ Timeranges are grouped by their first accepted label 
+ (see getLabelOfDataTimerange()) and shuffled within each group.
+ 
+ @returns
+ - 1 if successful
+ - -1 otherwise
+ */
+static int groupPositions(iterator_t* iterator, GPTServer* server)
+{
+    labelMap_t* map = NULL;
+    iteratorPosition_t* grouped = NULL;
+    int* group = NULL;
+    int* first = NULL;
+    int* slot = NULL;
+    int numberOfGroups = 0;
+    int n = iterator->numberOfPositions;
+    int i, g, result = -1;
+    
+    map = newLabelMap(LBL_NUMBER(*server)+1);
+    group = (int*) malloc((n+1)*sizeof(int));
+    first = (int*) calloc(n+2, sizeof(int));
+    grouped = (iteratorPosition_t*) malloc((n+1)*sizeof(iteratorPosition_t));
+    
+    if (map && group && first && grouped)
+    {
+        // group of each timerange (in order of first appearance)
+        for (i=0; i<n; i++)
+        {
+            slot = labelMapInsert(map, getLabelOfDataTimerange(server, 
+                                                               iterator->positions[i].fileIndex,
+                                                               iterator->positions[i].timerangeIndex));
+            if (!slot) break;
+            if (*slot == 0) *slot = map->count;
+            group[i] = *slot-1;
+        }
+        numberOfGroups = map->count;
+        
+        if (i == n)
+        {
+            // counting sort by group (chronological order is kept within each group)
+            for (i=0; i<n; i++) first[group[i]+1]++;
+            for (g=0; g<numberOfGroups; g++) first[g+1] += first[g];
+            for (i=0; i<n; i++) grouped[first[group[i]]++] = iterator->positions[i];
+            for (g=numberOfGroups; g>0; g--) first[g] = first[g-1];
+            first[0] = 0;
+            
+            for (g=0; g<numberOfGroups; g++)
+                shufflePositions(grouped+first[g], first[g+1]-first[g], &(iterator->state));
+            
+            result = interleaveGroups(iterator->mode, grouped, first, numberOfGroups, iterator->positions);
+        }
+    }
+    
+    free(grouped);
+    free(first);
+    free(group);
+    if (map) destroyLabelMap(map);
+    return result;
+}
+
+/**
+ @brief Compute iteration order of next epoch
+ 
+ @returns
+ - 1 if successful
+ - -1 otherwise
+ */
+static int buildPositions(iterator_t* iterator, GPTServer* server)
+{
+    iteratorPosition_t* positions = NULL;
+    int n = 0;
+    int f, t, b;
+    
+    for (f=0; f<DAT_NFILES(*server); f++)
+        for (t=0; t<DAT_NTIMERANGES(*server, f); t++)
+            if (DAT_FILTERED(*server, f, t)) n++;
+    
+    positions = (iteratorPosition_t*) realloc(iterator->positions, (n+1)*sizeof(iteratorPosition_t));
+    if (!positions) return -1;
+    iterator->positions = positions;
+    iterator->numberOfPositions = n;
+    
+    n = 0;
+    for (f=0; f<DAT_NFILES(*server); f++)
+        for (t=0; t<DAT_NTIMERANGES(*server, f); t++)
+            if (DAT_FILTERED(*server, f, t))
+            {
+                positions[n].fileIndex = f;
+                positions[n].timerangeIndex = t;
+                n++;
+            }
+    
+    switch (iterator->mode)
+    {
+        case GEPETTO_ITERATION_MODE_SHUFFLE:
+            shufflePositions(positions, n, &(iterator->state));
+            break;
+        case GEPETTO_ITERATION_MODE_ROUND_ROBIN:
+        case GEPETTO_ITERATION_MODE_STRATIFIED:
+            if (groupPositions(iterator, server) < 0) return -1;
+            break;
+        default:
+            break;
+    }
+    
+    // read each block file by file, chronologically
+    // (files of a block in reverse order of the previous one: last files used are still open)
+    if (iterator->blockSize > 1)
+        for (b=0; b<n; b+=iterator->blockSize)
+            qsort(positions+b, (n-b < iterator->blockSize) ? n-b : iterator->blockSize,
+                  sizeof(iteratorPosition_t), 
+                  ((b/iterator->blockSize)%2) ? comparePositionsReverse : comparePositions);
+    
+    iterator->position = 0;
+    iterator->valid = 1;
+    return 1;
+}
+
+iterator_t* newIterator(GPTIterationMode mode, unsigned int seed, int blockSize)
+{
+    iterator_t* iterator = NULL;
+    
+    iterator = (iterator_t*) calloc(1, sizeof(iterator_t));
+    if (!iterator) return NULL;
+    
+    iterator->mode = mode;
+    iterator->blockSize = blockSize;
+    iterator->state = seed;
+    iterator->positions = NULL;
+    iterator->valid = 0;
+    
+    iterator->pool = NULL;
+    iterator->fileIndex = -1;
+    iterator->dataset = NULL;
+    
+    return iterator;
+}
+
+void destroyIterator(iterator_t* iterator)
+{
+    releaseIteratorDataset(iterator);
+    free(iterator->positions);
+    free(iterator);
+}
+
+int peekIteratorPosition(iterator_t* iterator, GPTServer* server, int* fileIndex, int* timerangeIndex)
+{
+    // first call of the epoch
+    if (!iterator->valid)
+        if (buildPositions(iterator, server) < 0) return -1;
+    
+    return peekIteratorPositionAt(iterator, 0, fileIndex, timerangeIndex);
+}
+
+int peekIteratorPositionAt(iterator_t* iterator, int offset, int* fileIndex, int* timerangeIndex)
+{
+    if (!iterator->valid || (iterator->position+offset >= iterator->numberOfPositions)) return 0;
+    
+    *fileIndex = iterator->positions[iterator->position+offset].fileIndex;
+    *timerangeIndex = iterator->positions[iterator->position+offset].timerangeIndex;
+    return 1;
+}
+
+void advanceIterator(iterator_t* iterator, int count)
+{
+    iterator->position += count;
+}
+
+void invalidateIterator(iterator_t* iterator)
+{
+    iterator->valid = 0;
+}
+
+PIODataset* getIteratorDataset(iterator_t* iterator, GPTServer* server, int fileIndex)
+{
+    if (iterator->dataset && (iterator->fileIndex == fileIndex)) return iterator->dataset;
+    
+    // server pool keeps recently used files open
+    releaseIteratorDataset(iterator);
+    iterator->pool = server->pool;
+    iterator->fileIndex = fileIndex;
+    iterator->dataset = pioPoolOpenDataset(server->pool, DAT_PATH(*server, fileIndex), DAT_DATASET(*server),
+                                           PINOCCHIO_DATASET_PRELOAD_LINKS);
+    
+    return iterator->dataset;
+}
+
+void releaseIteratorDataset(iterator_t* iterator)
+{
+    if (iterator->dataset) pioPoolReleaseDataset(iterator->pool, iterator->dataset);
+    iterator->dataset = NULL;
+    iterator->fileIndex = -1;
+}
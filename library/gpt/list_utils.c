@@ -23,20 +23,15 @@
 
 int numberOfLabelsInList (listOfLabels_t* list)
 {
-    if (list)
-        return 1+numberOfLabelsInList(list->next);
-    return 0;
+    int number = 0;
+    for (; list; list = list->next) number++;
+    return number;
 }
 
 listOfLabels_t* isLabelInList (listOfLabels_t* list, int label)
 {
-    if (list)
-    {
-        if (list->value == label) 
-            return list;
-        else 
-            return isLabelInList(list->next, label);
-    }
+    for (; list; list = list->next)
+        if (list->value == label) return list;
     return NULL;
 }
 
@@ -51,11 +46,12 @@ listOfLabels_t* addLabelToList (listOfLabels_t* list, int label)
 
 int destroyListOfLabels (listOfLabels_t* list)
 {
-    if (list)
+    listOfLabels_t* next = NULL;
+    while (list)
     {
-        if (list->next != NULL) 
-            destroyListOfLabels(list->next);
+        next = list->next;
         free(list);
+        list = next;
     }
     return 1;
 }
@@ -0,0 +1,256 @@
+// 
+// Copyright 2010-2011 Herve BREDIN (bredin@limsi.fr)
+// Contact: http://pinocchio.niderb.fr/
+// 
+// This file is part of pinocchIO.
+//  
+//      pinocchIO is free software: you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation, either version 3 of the License, or
+//      (at your option) any later version.
+//  
+//      pinocchIO is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//  
+//      You should have received a copy of the GNU General Public License
+//      along with pinocchIO. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+#include "prefetch_utils.h"
+#include "thread_utils.h"
+#include <stdlib.h>
+
+static void* prefetch(void* arg)
+{
+    prefetcher_t* prefetcher = (prefetcher_t*) arg;
+    PIODataset* dataset = NULL;
+    int openedFileIndex = -1;
+    prefetchSlot_t* slot = NULL;
+    void* data = NULL;
+    size_t size;
+    int f = prefetcher->fileIndex;
+    int t = prefetcher->timerangeIndex;
+    
+    for (;;)
+    {
+        // look for next filtered timerange
+        while ((f < prefetcher->numberOfFiles) && 
+               ((t >= prefetcher->numberOfTimeranges[f]) || !(prefetcher->filtered[f][t])))
+        {
+            if (t >= prefetcher->numberOfTimeranges[f]) { f++; t = 0; }
+            else t++;
+        }
+        
+        pthread_mutex_lock(&(prefetcher->mutex));
+        
+        if (f == prefetcher->numberOfFiles)
+        {
+            prefetcher->done = 1;
+            if (prefetcher->consumerWaiting) pthread_cond_signal(&(prefetcher->notEmpty));
+            pthread_mutex_unlock(&(prefetcher->mutex));
+            break;
+        }
+        
+        size = prefetcher->numberOfEntries[f][t]*prefetcher->entrySize;
+        
+        // wait for a free slot, within memory budget
+        while (!prefetcher->stop && 
+               ((prefetcher->count == prefetcher->numberOfSlots) || 
+                ((prefetcher->count > prefetcher->held) && (prefetcher->used+size > prefetcher->memory))))
+        {
+            // queue is full: wake consumer up if it is waiting
+            if (prefetcher->consumerWaiting) pthread_cond_signal(&(prefetcher->notEmpty));
+            prefetcher->producerWaiting = 1;
+            pthread_cond_wait(&(prefetcher->notFull), &(prefetcher->mutex));
+            prefetcher->producerWaiting = 0;
+        }
+        
+        if (prefetcher->stop)
+        {
+            pthread_mutex_unlock(&(prefetcher->mutex));
+            break;
+        }
+        
+        slot = &(prefetcher->slots[(prefetcher->first+prefetcher->count) % prefetcher->numberOfSlots]);
+        pthread_mutex_unlock(&(prefetcher->mutex));
+        
+        // this slot is not in the queue: fill it without holding the mutex
+        // (slot keeps its previous buffer if it cannot grow)
+        if (slot->capacity < size)
+        {
+            data = realloc(slot->data, size);
+            if (data)
+            {
+                slot->data = data;
+                slot->capacity = size;
+            }
+        }
+        
+        lockHDF5();
+        if (f != openedFileIndex)
+        {
+            if (dataset) pioPoolReleaseDataset(prefetcher->pool, dataset);
+            dataset = pioPoolOpenDataset(prefetcher->pool, prefetcher->pathToFile[f], prefetcher->pathToDataset,
+                                         PINOCCHIO_DATASET_PRELOAD_LINKS);
+            openedFileIndex = f;
+        }
+        if (dataset && (slot->capacity >= size))
+            slot->number = pioReadInto(dataset, t, prefetcher->datatype, slot->data, slot->capacity);
+        else
+            slot->number = -1;
+        H5Eclear2(H5E_DEFAULT);
+        unlockHDF5();
+        
+        slot->fileIndex = f;
+        slot->timerangeIndex = t;
+        slot->size = size;
+        t++;
+        
+        pthread_mutex_lock(&(prefetcher->mutex));
+        prefetcher->count++;
+        prefetcher->used += size;
+        // wake consumer up as soon as queue is no longer empty
+        if (prefetcher->consumerWaiting && (prefetcher->count == 1)) 
+            pthread_cond_signal(&(prefetcher->notEmpty));
+        pthread_mutex_unlock(&(prefetcher->mutex));
+    }
+    
+    lockHDF5();
+    if (dataset) pioPoolReleaseDataset(prefetcher->pool, dataset);
+    H5Eclear2(H5E_DEFAULT);
+    unlockHDF5();
+    
+    return NULL;
+}
+
+prefetcher_t* startPrefetcher(GPTServer server, PIODatatype datatype,
+                              int fileIndex, int timerangeIndex)
+{
+    prefetcher_t* prefetcher = NULL;
+    int s;
+    
+    prefetcher = (prefetcher_t*) malloc(sizeof(prefetcher_t));
+    if (!prefetcher) return NULL;
+    
+    prefetcher->numberOfFiles = DAT_NFILES(server);
+    prefetcher->pathToFile = DAT_PATHS(server);
+    prefetcher->pathToDataset = DAT_DATASET(server);
+    prefetcher->pool = server.pool;
+    prefetcher->numberOfTimeranges = server.lengthOfDataTimeline;
+    prefetcher->numberOfEntries = server.numberOfEntriesPerTimerangePerFile;
+    prefetcher->filtered = server.filtered;
+    
+    lockHDF5();
+    prefetcher->datatype = pioNewDatatype(datatype.type, datatype.dimension);
+    prefetcher->entrySize = pioGetSize(prefetcher->datatype);
+    unlockHDF5();
+    
+    prefetcher->fileIndex = fileIndex;
+    prefetcher->timerangeIndex = timerangeIndex;
+    
+    // one more slot for the timerange held by the consumer
+    prefetcher->numberOfSlots = server.options.prefetchDepth+1;
+    prefetcher->slots = (prefetchSlot_t*) malloc(prefetcher->numberOfSlots*sizeof(prefetchSlot_t));
+    for (s=0; s<prefetcher->numberOfSlots; s++)
+    {
+        prefetcher->slots[s].capacity = 0;
+        prefetcher->slots[s].data = NULL;
+    }
+    prefetcher->first = 0;
+    prefetcher->count = 0;
+    prefetcher->held = 0;
+    prefetcher->used = 0;
+    prefetcher->memory = server.options.prefetchMemory;
+    
+    prefetcher->done = 0;
+    prefetcher->stop = 0;
+    prefetcher->started = 0;
+    prefetcher->producerWaiting = 0;
+    prefetcher->consumerWaiting = 0;
+    
+    pthread_mutex_init(&(prefetcher->mutex), NULL);
+    pthread_cond_init(&(prefetcher->notEmpty), NULL);
+    pthread_cond_init(&(prefetcher->notFull), NULL);
+    
+    prefetcher->started = (pthread_create(&(prefetcher->thread), NULL, prefetch, prefetcher) == 0);
+    if (!prefetcher->started)
+    {
+        stopPrefetcher(prefetcher);
+        return NULL;
+    }
+    
+    return prefetcher;
+}
+
+int nextPrefetched(prefetcher_t* prefetcher,
+                   int* fileIndex, int* timerangeIndex,
+                   int* number, void** buffer)
+{
+    prefetchSlot_t* slot = NULL;
+    
+    pthread_mutex_lock(&(prefetcher->mutex));
+    
+    // release slot returned by previous call
+    if (prefetcher->held)
+    {
+        prefetcher->used -= prefetcher->slots[prefetcher->first].size;
+        prefetcher->first = (prefetcher->first+1) % prefetcher->numberOfSlots;
+        prefetcher->count--;
+        prefetcher->held = 0;
+        if (prefetcher->producerWaiting) pthread_cond_signal(&(prefetcher->notFull));
+    }
+    
+    while ((prefetcher->count == 0) && !prefetcher->done)
+    {
+        prefetcher->consumerWaiting = 1;
+        pthread_cond_wait(&(prefetcher->notEmpty), &(prefetcher->mutex));
+        prefetcher->consumerWaiting = 0;
+    }
+    
+    if (prefetcher->count == 0)
+    {
+        pthread_mutex_unlock(&(prefetcher->mutex));
+        return 0;
+    }
+    
+    // hold oldest slot until next call
+    slot = &(prefetcher->slots[prefetcher->first]);
+    prefetcher->held = 1;
+    pthread_mutex_unlock(&(prefetcher->mutex));
+    
+    *fileIndex = slot->fileIndex;
+    *timerangeIndex = slot->timerangeIndex;
+    *number = slot->number;
+    *buffer = slot->data;
+    
+    return 1;
+}
+
+int stopPrefetcher(prefetcher_t* prefetcher)
+{
+    int s;
+    
+    pthread_mutex_lock(&(prefetcher->mutex));
+    prefetcher->stop = 1;
+    pthread_cond_signal(&(prefetcher->notFull));
+    pthread_mutex_unlock(&(prefetcher->mutex));
+    
+    if (prefetcher->started) pthread_join(prefetcher->thread, NULL);
+    
+    pthread_cond_destroy(&(prefetcher->notFull));
+    pthread_cond_destroy(&(prefetcher->notEmpty));
+    pthread_mutex_destroy(&(prefetcher->mutex));
+    
+    for (s=0; s<prefetcher->numberOfSlots; s++) free(prefetcher->slots[s].data);
+    free(prefetcher->slots);
+    
+    lockHDF5();
+    pioCloseDatatype(&(prefetcher->datatype));
+    unlockHDF5();
+    
+    free(prefetcher);
+    return 1;
+}
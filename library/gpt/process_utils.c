@@ -0,0 +1,131 @@
+// 
+// Copyright 2010-2011 Herve BREDIN (bredin@limsi.fr)
+// Contact: http://pinocchio.niderb.fr/
+// 
+// This file is part of pinocchIO.
+//  
+//      pinocchIO is free software: you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation, either version 3 of the License, or
+//      (at your option) any later version.
+//  
+//      pinocchIO is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//  
+//      You should have received a copy of the GNU General Public License
+//      along with pinocchIO. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+#include "process_utils.h"
+#include "thread_utils.h"
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+// run every numberOfShares-th task, starting with share-th one, then exit
+static void runShare(int share, int numberOfShares, int numberOfTasks,
+                     processTask_t task, void* context, FILE* results)
+{
+    int index;
+    int failed = 0;
+    
+    for (index=share; (index<numberOfTasks) && !failed; index+=numberOfShares)
+        if (task(context, index, results) < 0) failed = 1;
+    if (fflush(results) != 0) failed = 1;
+    fflush(stdout);
+    fflush(stderr);
+    
+    // HDF5 handles inherited from the calling process must not be closed (nor flushed)
+    _exit(failed);
+}
+
+// wait for worker process, returns 1 if it succeeded
+static int waitForShare(pid_t worker)
+{
+    int status;
+    pid_t pid;
+    
+    if (worker <= 0) return 0;
+    do pid = waitpid(worker, &status, 0);
+    while ((pid < 0) && (errno == EINTR));
+    
+    return (pid == worker) && WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+}
+
+// Share tasks between numberOfProcesses processes: the calling one and forked workers,
+// each writing its results into a temporary file. Every task is run, whatever happens:
+// tasks of workers that failed (or could not be forked) are run by the calling process.
+// Returns the number of processes tasks were shared between.
+int runInProcesses(int numberOfProcesses, int numberOfTasks, 
+                   processTask_t task, processTask_t collect, void* context)
+{
+    pid_t* workers = NULL;
+    FILE** results = NULL;
+    char* done = NULL;
+    int share, index;
+    
+    if (numberOfTasks <= 0) return 0;
+    if (numberOfProcesses > numberOfTasks) numberOfProcesses = numberOfTasks;
+    if (numberOfProcesses < 1) numberOfProcesses = 1;
+    
+    workers = (pid_t*) malloc(numberOfProcesses*sizeof(pid_t));
+    results = (FILE**) malloc(numberOfProcesses*sizeof(FILE*));
+    done = (char*) calloc(numberOfTasks, sizeof(char));
+    if (!workers || !results || !done) numberOfProcesses = 1;
+    
+    // pending output would be written once per process otherwise
+    fflush(stdout);
+    fflush(stderr);
+    
+    // no other thread may be in the middle of an HDF5 call when forking
+    lockHDF5();
+    for (share=1; share<numberOfProcesses; share++)
+    {
+        workers[share] = -1;
+        results[share] = tmpfile();
+        if (results[share]) workers[share] = fork();
+        if (workers[share] == 0)
+        {
+            unlockHDF5();
+            runShare(share, numberOfProcesses, numberOfTasks, task, context, results[share]);
+        }
+    }
+    unlockHDF5();
+    
+    // calling process runs the first share...
+    for (index=0; index<numberOfTasks; index+=numberOfProcesses)
+    {
+        task(context, index, NULL);
+        if (done) done[index] = 1;
+    }
+    
+    // ... and collects results of the other ones
+    for (share=1; share<numberOfProcesses; share++)
+    {
+        if (waitForShare(workers[share]))
+        {
+            rewind(results[share]);
+            for (index=share; index<numberOfTasks; index+=numberOfProcesses)
+            {
+                if (collect(context, index, results[share]) < 0) break;
+                done[index] = 1;
+            }
+        }
+        if (results[share]) fclose(results[share]);
+    }
+    
+    // tasks of failed workers are run by calling process
+    for (index=0; done && (index<numberOfTasks); index++)
+        if (!done[index]) task(context, index, NULL);
+    
+    free(done);
+    free(results);
+    free(workers);
+    
+    return numberOfProcesses;
+}
@@ -0,0 +1,37 @@
+// 
+// Copyright 2010-2011 Herve BREDIN (bredin@limsi.fr)
+// Contact: http://pinocchio.niderb.fr/
+// 
+// This file is part of pinocchIO.
+//  
+//      pinocchIO is free software: you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation, either version 3 of the License, or
+//      (at your option) any later version.
+//  
+//      pinocchIO is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//  
+//      You should have received a copy of the GNU General Public License
+//      along with pinocchIO. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+#include "thread_utils.h"
+#include <pthread.h>
+
+// pinocchIO keeps a few HDF5 handles in library-wide caches:
+// all pinocchIO calls are serialized, whether HDF5 is thread-safe or not.
+static pthread_mutex_t hdf5Mutex = PTHREAD_MUTEX_INITIALIZER;
+
+void lockHDF5(void)
+{
+    pthread_mutex_lock(&hdf5Mutex);
+}
+
+void unlockHDF5(void)
+{
+    pthread_mutex_unlock(&hdf5Mutex);
+}
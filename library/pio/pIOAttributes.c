@@ -39,6 +39,7 @@ char* PIOAttribute_ListProtected[PIOAttribute_NumberProtected] = {
 	PIOAttribute_Description,
 	PIOAttribute_TimesUsed,
 	PIOAttribute_Timeline,
+	PIOAttribute_Regular,
 };
 
 int pioAttributeIsProtected( const char* attr_name)
@@ -25,15 +25,19 @@
 #include "pIOVersion.h"
 #include "structure_utils.h"
 #include "pIOTimeline.h"
+#include "pIOTimeComparison.h"
 #include "pIODatatype.h"
 #include "pIORead.h"
 #include "pIOWrite.h"
 
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include <hdf5_hl.h>
 
-int monoDimensionalDatasetExtent(hid_t monoDimensionalDataset)
+hsize_t monoDimensionalDatasetExtent(hid_t monoDimensionalDataset)
 {
 	hid_t dataDataspace;
 	hsize_t extent[1] = {-1};
@@ -42,7 +46,7 @@ int monoDimensionalDatasetExtent(hid_t monoDimensionalDataset)
 	H5Sget_simple_extent_dims(dataDataspace, extent, NULL);
 	H5Sclose(dataDataspace);
 	
-	return (int)extent[0];
+	return extent[0];
 }
 
 // Returns /dataset/path/data
@@ -71,10 +75,55 @@ int internalPathToDatasetLink( const char* path, char** internalPath )
 	return 1;
 }
 
+// Returns number of entries per chunk 
+// so that chunks are about chunkSize bytes (and contain at least one entry)
+hsize_t numberOfEntriesPerChunk(size_t chunkSize, size_t entrySize)
+{
+	if (entrySize == 0 || chunkSize < entrySize) return 1;
+	return (hsize_t)(chunkSize/entrySize);
+}
+
+// Adds shuffle and deflate filters to (chunked) creation property
+// Returns -1 if requested compression is not supported, 0 otherwise
+int setCompressionFilters(hid_t creationProperty, PIODatasetOptions pioOptions)
+{
+	unsigned int config = 0;
+	
+	if (pioOptions.compression == 0) return 0;
+	if ((pioOptions.compression < 0) || (pioOptions.compression > 9)) return -1;
+	
+	// make sure filters are available for both encoding and decoding
+	if (!H5Zfilter_avail(H5Z_FILTER_DEFLATE)) return -1;
+	if (H5Zget_filter_info(H5Z_FILTER_DEFLATE, &config) < 0) return -1;
+	if (!(config & H5Z_FILTER_CONFIG_ENCODE_ENABLED) ||
+		!(config & H5Z_FILTER_CONFIG_DECODE_ENABLED)) return -1;
+	
+	// shuffle must come first in the pipeline
+	if (pioOptions.shuffle)
+	{
+		if (!H5Zfilter_avail(H5Z_FILTER_SHUFFLE)) return -1;
+		if (H5Pset_shuffle(creationProperty) < 0) return -1;
+	}
+	
+	if (H5Pset_deflate(creationProperty, (unsigned int)pioOptions.compression) < 0) return -1;
+	return 0;
+}
+
 PIODataset pioNewDataset(PIOFile pioFile, 
 						 const char* path, const char* description,
 						 PIOTimeline pioTimeline,
 						 PIODatatype pioDatatype)
+{
+	return pioNewDatasetWithOptions(pioFile, path, description, 
+									pioTimeline, pioDatatype, 
+									PIODatasetOptionsDefault);
+}
+
+PIODataset pioNewDatasetWithOptions(PIOFile pioFile, 
+									const char* path, const char* description,
+									PIOTimeline pioTimeline,
+									PIODatatype pioDatatype,
+									PIODatasetOptions pioOptions)
 {
 	PIODataset pioDataset;
 	
@@ -82,14 +131,15 @@ PIODataset pioNewDataset(PIOFile pioFile,
 	char* internalPathToCount = NULL; // name says it all
 	
 	hid_t datasetCreationProperty, linkCreationProperty; 
+	hid_t countCreationProperty;
 	hid_t dataspaceForData;
 	hsize_t dataspaceForDataMinSize[1] = { 0 };
 	hsize_t dataspaceForDataMaxSize[1] = { H5S_UNLIMITED };
 	hsize_t dataspaceForDataChunkSize[1] = { 1 };
     
-	hid_t link_datatype;
 	hid_t dataspaceForLink;
 	hsize_t dataspaceForLinkFixedSize[1] = { pioTimeline.ntimeranges };
+	hsize_t dataspaceForLinkChunkSize[1] = { 1 };
 	
 	ERROR_SWITCH_INIT
 	
@@ -108,9 +158,39 @@ PIODataset pioNewDataset(PIOFile pioFile,
 	internalPathToDatasetData(path, &internalPathToData);
 	internalPathToDatasetLink(path, &internalPathToCount);
 	
-	// create dataset/link creation propery
+	// create data creation property
+	// chunk size is deduced from datatype size and target chunk size
+	dataspaceForDataChunkSize[0] = numberOfEntriesPerChunk(pioOptions.chunk_size, 
+														   pioGetSize(pioDatatype));
 	datasetCreationProperty = H5Pcreate(H5P_DATASET_CREATE);
 	H5Pset_chunk(datasetCreationProperty, 1, dataspaceForDataChunkSize);
+	
+	// create link creation property
+	// link dataset has a fixed size: chunks cannot be larger than the dataset
+	// and contiguous storage is used for empty timelines or when requested
+	countCreationProperty = H5Pcreate(H5P_DATASET_CREATE);
+	if ((pioOptions.link_chunk_size > 0) && (pioTimeline.ntimeranges > 0))
+	{
+		dataspaceForLinkChunkSize[0] = numberOfEntriesPerChunk(pioOptions.link_chunk_size, 
+															   sizeof(link_t));
+		if (dataspaceForLinkChunkSize[0] > dataspaceForLinkFixedSize[0])
+			dataspaceForLinkChunkSize[0] = dataspaceForLinkFixedSize[0];
+		H5Pset_chunk(countCreationProperty, 1, dataspaceForLinkChunkSize);
+	}
+	else
+		H5Pset_layout(countCreationProperty, H5D_CONTIGUOUS);
+	
+	// add compression filters (only chunked datasets can be compressed)
+	if ((setCompressionFilters(datasetCreationProperty, pioOptions) < 0) ||
+		((H5Pget_layout(countCreationProperty) == H5D_CHUNKED) &&
+		 (setCompressionFilters(countCreationProperty, pioOptions) < 0)))
+	{
+		free(internalPathToData);
+		free(internalPathToCount);
+		H5Pclose(datasetCreationProperty);
+		H5Pclose(countCreationProperty);
+		return PIODatasetInvalid;
+	}
     
 	linkCreationProperty    = H5Pcreate(H5P_LINK_CREATE);
 	H5Pset_create_intermediate_group(linkCreationProperty, 1);	
@@ -119,9 +199,6 @@ PIODataset pioNewDataset(PIOFile pioFile,
 	dataspaceForData = H5Screate_simple(1,  dataspaceForDataMinSize,    dataspaceForDataMaxSize);
 	dataspaceForLink = H5Screate_simple(1, dataspaceForLinkFixedSize, NULL);
 	
-	// create count datatype
-	link_datatype = linkDatatype();
-	
 	// create datasets
 	ERROR_SWITCH_OFF
 	
@@ -130,23 +207,23 @@ PIODataset pioNewDataset(PIOFile pioFile,
 									   linkCreationProperty, datasetCreationProperty, H5P_DEFAULT);
 	
 	pioDataset.link_identifier = H5Dcreate2(pioFile.identifier, internalPathToCount, 
-                                            link_datatype, dataspaceForLink, 
-                                            linkCreationProperty, datasetCreationProperty, H5P_DEFAULT);
+                                            linkDatatype(), dataspaceForLink, 
+                                            linkCreationProperty, countCreationProperty, H5P_DEFAULT);
 	ERROR_SWITCH_ON
 	
 	free(internalPathToData);
 	free(internalPathToCount);
 	// close creation properties
 	H5Pclose(datasetCreationProperty);
+	H5Pclose(countCreationProperty);
 	H5Pclose(linkCreationProperty);
 	// close dataspace
 	H5Sclose(dataspaceForData);
-	// close datatype
-	H5Tclose(link_datatype);
+	H5Sclose(dataspaceForLink);
 	
 	// check if dataset was created successfully
 	if (PIODatasetIsInvalid(pioDataset)) return PIODatasetInvalid;
-    
+	
 	// add description as attribute of data dataset
 	if (H5LTset_attribute_string(pioDataset.identifier, ".", PIOAttribute_Description, description) < 0)
 	{
@@ -185,10 +262,14 @@ PIODataset pioNewDataset(PIOFile pioFile,
 	pioDataset.description[strlen(description)] = '\0';
 	
 	pioDataset.stored = 0;
-	pioDataset.ntimeranges = monoDimensionalDatasetExtent(pioDataset.link_identifier);
+	pioDataset.ntimeranges = (int)monoDimensionalDatasetExtent(pioDataset.link_identifier);
 	
     pioDataset.buffer = NULL;
     pioDataset.buffer_size = 0;
+    pioDataset.writer = NULL;
+    pioDataset.flags = PINOCCHIO_DATASET_DEFAULT;
+    pioDataset.links = NULL;
+    pioDataset.mapping = NULL;
     
 	return pioDataset;
 }
@@ -210,7 +291,7 @@ int pioRemoveDataset(PIOObject pioObject, const char* path)
     // get information about dataset
     internalPathToDatasetData(pioDataset.path, &internalPathToData);
     internalPathToDatasetLink(pioDataset.path, &internalPathToLink);
-    pioTimeline = pioGetTimeline(pioDataset);
+    pioTimeline = pioGetTimelineWithFlags(pioDataset, PINOCCHIO_TIMELINE_LAZY);
     
     // close dataset
     pioCloseDataset(&pioDataset);
@@ -234,6 +315,11 @@ int pioRemoveDataset(PIOObject pioObject, const char* path)
 }
 
 PIODataset pioOpenDataset(PIOObject pioObject, const char* path)
+{
+	return pioOpenDatasetWithFlags(pioObject, path, PINOCCHIO_DATASET_DEFAULT);
+}
+
+PIODataset pioOpenDatasetWithFlags(PIOObject pioObject, const char* path, int flags)
 {
 	PIODataset pioDataset = PIODatasetInvalid;	
 	
@@ -261,10 +347,10 @@ PIODataset pioOpenDataset(PIOObject pioObject, const char* path)
 	if (PIODatasetIsInvalid(pioDataset)) return PIODatasetInvalid;
 	
 	// get dimension of dataset
-	pioDataset.stored = monoDimensionalDatasetExtent(pioDataset.identifier);
+	pioDataset.stored = (int64_t)monoDimensionalDatasetExtent(pioDataset.identifier);
 	
 	// get dimension of link dataset
-	pioDataset.ntimeranges = monoDimensionalDatasetExtent(pioDataset.link_identifier);
+	pioDataset.ntimeranges = (int)monoDimensionalDatasetExtent(pioDataset.link_identifier);
 	
     // internal read buffer
     pioDataset.buffer = NULL;
@@ -293,11 +379,33 @@ PIODataset pioOpenDataset(PIOObject pioObject, const char* path)
 				PINOCCHIO_VERSION, version);
 	free(version);	
     
+	// load link table if requested
+	pioDataset.flags = flags;
+	if (flags & (PINOCCHIO_DATASET_PRELOAD_LINKS | PINOCCHIO_DATASET_MMAP))
+		if (loadLinks(&pioDataset) < 0)
+		{
+			pioCloseDataset(&pioDataset);
+			return PIODatasetInvalid;
+		}
+	
+	// map data in memory if requested (and possible)
+	if (flags & PINOCCHIO_DATASET_MMAP)
+		if (mapDataset(&pioDataset) < 0)
+		{
+			pioCloseDataset(&pioDataset);
+			return PIODatasetInvalid;
+		}
+    
 	return pioDataset;
 }
 
 int pioCloseDataset(PIODataset* pioDataset)
 {
+	int flushed = 1;
+	
+	// write buffered data before closing
+	if (pioDataset->writer) flushed = pioCloseDatasetWriter(pioDataset);
+	
 	if (pioDataset->path) free(pioDataset->path);
 	pioDataset->path = NULL;
 	
@@ -312,6 +420,13 @@ int pioCloseDataset(PIODataset* pioDataset)
     
     pioDataset->buffer_size = 0;
     
+    if (pioDataset->links) free(pioDataset->links);
+    pioDataset->links = NULL;
+    
+    if (pioDataset->mapping) unmapDataset(pioDataset);
+    
+    pioDataset->flags = PINOCCHIO_DATASET_DEFAULT;
+    
     if (pioDataset->identifier > -1)
         if (H5Dclose(pioDataset->identifier) < 0) 
             return 0;
@@ -322,9 +437,263 @@ int pioCloseDataset(PIODataset* pioDataset)
             return 0;
 	pioDataset->link_identifier = -1;
     
+	return flushed;
+}
+
+// Maps data of a sealed (contiguous, unfiltered) dataset in memory
+// Returns 1 when mapped, 0 when dataset cannot be mapped, -1 in case of error
+int mapDataset(PIODataset* pioDataset)
+{
+	PIODatasetMapping* mapping = NULL;
+	hid_t creationProperty = -1;
+	hid_t file = -1;
+	hid_t fileAccessProperty = -1;
+	hid_t driver = -1;
+	haddr_t offset = HADDR_UNDEF;
+	hsize_t storage = 0;
+	ssize_t length = -1;
+	char* filename = NULL;
+	int fd = -1;
+	off_t aligned = 0;
+	
+	if (pioDataset->mapping) return 1;
+	if (pioDataset->stored <= 0) return 0;
+	
+	// only contiguous, unfiltered storage can be mapped
+	creationProperty = H5Dget_create_plist(pioDataset->identifier);
+	if ((H5Pget_layout(creationProperty) != H5D_CONTIGUOUS) ||
+		(H5Pget_nfilters(creationProperty) != 0))
+	{
+		H5Pclose(creationProperty);
+		return 0;
+	}
+	H5Pclose(creationProperty);
+	
+	// absolute position in file (user block included)
+	offset = H5Dget_offset(pioDataset->identifier);
+	storage = H5Dget_storage_size(pioDataset->identifier);
+	if ((offset == HADDR_UNDEF) || (storage == 0)) return 0;
+	
+	// offset is only meaningful for the default (single file, POSIX) driver
+	file = H5Iget_file_id(pioDataset->identifier);
+	fileAccessProperty = H5Fget_access_plist(file);
+	driver = H5Pget_driver(fileAccessProperty);
+	H5Pclose(fileAccessProperty);
+	if (driver != H5FD_SEC2)
+	{
+		H5Fclose(file);
+		return 0;
+	}
+	
+	length = H5Fget_name(file, NULL, 0);
+	if (length < 0)
+	{
+		H5Fclose(file);
+		return -1;
+	}
+	filename = (char*) malloc((length+1)*sizeof(char));
+	H5Fget_name(file, filename, length+1);
+	H5Fclose(file);
+	
+	fd = open(filename, O_RDONLY);
+	free(filename);
+	if (fd < 0) return -1;
+	
+	mapping = (PIODatasetMapping*) malloc(sizeof(PIODatasetMapping));
+	if (mapping == NULL)
+	{
+		close(fd);
+		return -1;
+	}
+	
+	// mmap offset must be a multiple of the page size
+	// private mapping: callers may modify what pioReadData() returns
+	aligned = (off_t)(offset - offset % sysconf(_SC_PAGESIZE));
+	mapping->region_size = (size_t)(offset - aligned + storage);
+	mapping->region = mmap(NULL, mapping->region_size, PROT_READ | PROT_WRITE, 
+						   MAP_PRIVATE, fd, aligned);
+	close(fd);
+	if (mapping->region == MAP_FAILED)
+	{
+		free(mapping);
+		return -1;
+	}
+	
+	mapping->data = (char*)(mapping->region) + (offset - aligned);
+	mapping->data_size = (size_t)storage;
+	mapping->datatype = H5Dget_type(pioDataset->identifier);
+	mapping->entry_size = H5Tget_size(mapping->datatype);
+	
+	pioDataset->mapping = mapping;
 	return 1;
 }
 
+int unmapDataset(PIODataset* pioDataset)
+{
+	int unmapped = 1;
+	
+	if (pioDataset->mapping == NULL) return 1;
+	
+	if (munmap(pioDataset->mapping->region, pioDataset->mapping->region_size) < 0) unmapped = -1;
+	H5Tclose(pioDataset->mapping->datatype);
+	free(pioDataset->mapping);
+	pioDataset->mapping = NULL;
+	
+	return unmapped;
+}
+
+// H5Aiterate2 callback copying attribute to object 'destination'
+static herr_t copyAttribute(hid_t source, const char* name, const H5A_info_t* info, void* destination)
+{
+	hid_t sourceAttribute = -1;
+	hid_t destinationAttribute = -1;
+	hid_t datatype = -1;
+	hid_t dataspace = -1;
+	void* value = NULL;
+	herr_t copied = -1;
+	
+	sourceAttribute = H5Aopen(source, name, H5P_DEFAULT);
+	datatype = H5Aget_type(sourceAttribute);
+	dataspace = H5Aget_space(sourceAttribute);
+	
+	value = malloc(H5Sget_simple_extent_npoints(dataspace)*H5Tget_size(datatype)+1);
+	if (value && (H5Aread(sourceAttribute, datatype, value) >= 0))
+	{
+		destinationAttribute = H5Acreate2(*((hid_t*)destination), name, 
+										  datatype, dataspace, H5P_DEFAULT, H5P_DEFAULT);
+		if (destinationAttribute >= 0)
+		{
+			copied = H5Awrite(destinationAttribute, datatype, value);
+			H5Aclose(destinationAttribute);
+		}
+	}
+	
+	free(value);
+	H5Sclose(dataspace);
+	H5Tclose(datatype);
+	H5Aclose(sourceAttribute);
+	
+	return copied;
+}
+
+int pioSealDataset(PIOObject pioObject, const char* path)
+{
+	PIODataset pioDataset = PIODatasetInvalid;
+	
+	char* internalPathToData = NULL;
+	char* internalPathToSealed = NULL;
+	char* internalPathToUnsealed = NULL;
+	
+	hid_t creationProperty = -1;
+	hid_t datatype = -1;
+	hid_t dataspace = -1;
+	hid_t sealed = -1;
+	hsize_t extent[1] = {0};
+	hsize_t position[1] = {0};
+	hsize_t number[1] = {0};
+	hsize_t entriesPerBatch = 0;
+	void* buffer = NULL;
+	herr_t err = 0;
+	
+	ERROR_SWITCH_INIT
+	
+	pioDataset = pioOpenDataset(pioObject, path);
+	if (PIODatasetIsInvalid(pioDataset)) return 0;
+	
+	// nothing to do if dataset is already sealed
+	creationProperty = H5Dget_create_plist(pioDataset.identifier);
+	if (H5Pget_layout(creationProperty) == H5D_CONTIGUOUS)
+	{
+		H5Pclose(creationProperty);
+		pioCloseDataset(&pioDataset);
+		return 1;
+	}
+	H5Pclose(creationProperty);
+	
+	internalPathToDatasetData(path, &internalPathToData);
+	internalPathToSealed = (char*) malloc((strlen(internalPathToData)+strlen("_sealed")+1)*sizeof(char));
+	sprintf(internalPathToSealed, "%s_sealed", internalPathToData);
+	internalPathToUnsealed = (char*) malloc((strlen(internalPathToData)+strlen("_unsealed")+1)*sizeof(char));
+	sprintf(internalPathToUnsealed, "%s_unsealed", internalPathToData);
+	
+	// create contiguous, fixed-size copy of data
+	// space is allocated right away so that its offset in file is known
+	datatype = H5Dget_type(pioDataset.identifier);
+	extent[0] = (hsize_t)pioDataset.stored;
+	dataspace = H5Screate_simple(1, extent, NULL);
+	creationProperty = H5Pcreate(H5P_DATASET_CREATE);
+	H5Pset_layout(creationProperty, H5D_CONTIGUOUS);
+	H5Pset_alloc_time(creationProperty, H5D_ALLOC_TIME_EARLY);
+	H5Pset_fill_time(creationProperty, H5D_FILL_TIME_NEVER);
+	ERROR_SWITCH_OFF
+	sealed = H5Dcreate2(pioObject.identifier, internalPathToSealed, datatype, dataspace,
+						H5P_DEFAULT, creationProperty, H5P_DEFAULT);
+	ERROR_SWITCH_ON
+	H5Pclose(creationProperty);
+	
+	if (sealed < 0)
+	{
+		H5Sclose(dataspace);
+		H5Tclose(datatype);
+		free(internalPathToUnsealed);
+		free(internalPathToSealed);
+		free(internalPathToData);
+		pioCloseDataset(&pioDataset);
+		return 0;
+	}
+	
+	// copy data (by batches) -- no datatype conversion involved
+	entriesPerBatch = numberOfEntriesPerChunk(PIODatasetWriterDefaultBudget, H5Tget_size(datatype));
+	if (pioDataset.stored > 0)
+	{
+		buffer = malloc(entriesPerBatch*H5Tget_size(datatype));
+		if (buffer == NULL) err = -1;
+	}
+	for (position[0]=0; (err >= 0) && (position[0] < extent[0]); position[0] += number[0])
+	{
+		number[0] = extent[0] - position[0];
+		if (number[0] > entriesPerBatch) number[0] = entriesPerBatch;
+		err = readHyperslab(pioDataset.identifier, datatype, position[0], number[0], buffer);
+		if (err >= 0)
+			err = writeHyperslab(sealed, datatype, position[0], number[0], buffer);
+	}
+	free(buffer);
+	H5Sclose(dataspace);
+	H5Tclose(datatype);
+	
+	// copy attributes (description, version, timeline...)
+	if (err >= 0)
+		err = H5Aiterate2(pioDataset.identifier, H5_INDEX_NAME, H5_ITER_NATIVE, NULL, 
+						  copyAttribute, &sealed);
+	
+	H5Dclose(sealed);
+	pioCloseDataset(&pioDataset);
+	
+	// replace original data by their sealed copy
+	// (original data are only deleted once sealed copy has taken their place)
+	if (err >= 0) err = H5Lmove(pioObject.identifier, internalPathToData, 
+								pioObject.identifier, internalPathToUnsealed, H5P_DEFAULT, H5P_DEFAULT);
+	if (err >= 0)
+	{
+		err = H5Lmove(pioObject.identifier, internalPathToSealed, 
+					  pioObject.identifier, internalPathToData, H5P_DEFAULT, H5P_DEFAULT);
+		// roll back
+		if (err < 0) H5Lmove(pioObject.identifier, internalPathToUnsealed, 
+							 pioObject.identifier, internalPathToData, H5P_DEFAULT, H5P_DEFAULT);
+	}
+	if (err >= 0) err = H5Ldelete(pioObject.identifier, internalPathToUnsealed, H5P_DEFAULT);
+	else H5Ldelete(pioObject.identifier, internalPathToSealed, H5P_DEFAULT);
+	
+	// make sure sealed data actually are on disk before anyone maps them
+	if (err >= 0) err = H5Fflush(pioObject.identifier, H5F_SCOPE_GLOBAL);
+	
+	free(internalPathToUnsealed);
+	free(internalPathToSealed);
+	free(internalPathToData);
+	
+	return (err >= 0);
+}
+
 int pioGetListOfDatasets(PIOFile pioFile, char*** pathsToDatasets)
 {	
 	int ds = -1;
@@ -373,6 +742,14 @@ int pioGetListOfDatasets(PIOFile pioFile, char*** pathsToDatasets)
 
 
 int pioCopyDataset(const char* dataset_path, PIOFile pioInputFile, PIOFile pioOutputFile)
+{
+    return pioCopyDatasetWithOptions(dataset_path, pioInputFile, pioOutputFile,
+                                     PIODatasetOptionsDefault);
+}
+
+int pioCopyDatasetWithOptions(const char* dataset_path, 
+                              PIOFile pioInputFile, PIOFile pioOutputFile,
+                              PIODatasetOptions pioOptions)
 {
     PIODataset pioInputDataset = PIODatasetInvalid;
     PIODataset pioOutputDataset = PIODatasetInvalid;
@@ -380,6 +757,8 @@ int pioCopyDataset(const char* dataset_path, PIOFile pioInputFile, PIOFile pioOu
     PIOTimeline pioOutputTimeline = PIOTimelineInvalid;
     char* timeline_path = NULL;
     PIODatatype pioDatatype = PIODatatypeInvalid;
+    PIOTimelineComparison comparison;
+    int* mapping = NULL;
     int t;
     int number;
     void* buffer = NULL;
@@ -393,7 +772,7 @@ int pioCopyDataset(const char* dataset_path, PIOFile pioInputFile, PIOFile pioOu
         return 0;
     }
     
-    pioInputTimeline = pioGetTimeline(pioInputDataset);
+    pioInputTimeline = pioGetTimelineWithFlags(pioInputDataset, PINOCCHIO_TIMELINE_LAZY);
     if (PIOTimelineIsInvalid(pioInputTimeline))
     {
         // Cannot get input dataset timeline
@@ -417,8 +796,9 @@ int pioCopyDataset(const char* dataset_path, PIOFile pioInputFile, PIOFile pioOu
     // now that output timeline is available,
     // copy the dataset
     
-    // open input dataset
-    pioInputDataset = pioOpenDataset(PIOMakeObject(pioInputFile), dataset_path);
+    // open input dataset (it is read time range after time range)
+    pioInputDataset = pioOpenDatasetWithFlags(PIOMakeObject(pioInputFile), dataset_path,
+                                              PINOCCHIO_DATASET_PRELOAD_LINKS);
     if (PIODatasetIsInvalid(pioInputDataset))
     {
         // Cannot open input dataset
@@ -426,51 +806,81 @@ int pioCopyDataset(const char* dataset_path, PIOFile pioInputFile, PIOFile pioOu
         return 0;
     }
     
-    // open output timeline
+    // open input and output timelines
+    pioInputTimeline = pioGetTimeline(pioInputDataset);
     pioOutputTimeline = pioOpenTimeline(PIOMakeObject(pioOutputFile), timeline_path);
     
     // free no longer needed path to timeline
     free(timeline_path);
 
-    if (PIOTimelineIsInvalid(pioOutputTimeline))
+    if (PIOTimelineIsInvalid(pioInputTimeline) || PIOTimelineIsInvalid(pioOutputTimeline))
+    {
+        // Cannot open input or output timeline
+        pioCloseTimeline(&pioOutputTimeline);
+        pioCloseTimeline(&pioInputTimeline);
+        pioCloseDataset(&pioInputDataset);
+        return 0;
+    }
+    
+    // output timeline may contain more time ranges than input timeline:
+    // find where each input time range goes in output dataset
+    mapping = (int*) malloc((pioInputTimeline.ntimeranges+1)*sizeof(int));
+    comparison = pioCompareTimeLinesWithMapping(pioInputTimeline.timeranges, pioInputTimeline.ntimeranges,
+                                                pioOutputTimeline.timeranges, pioOutputTimeline.ntimeranges,
+                                                mapping);
+    // each input time range needs its own output time range
+    if (comparison == PINOCCHIO_TIMELINE_COMPARISON_SUBSET)
+        for (t=1; t<pioInputTimeline.ntimeranges; t++)
+            if (mapping[t] == mapping[t-1]) comparison = PINOCCHIO_TIMELINE_COMPARISON_OTHER;
+    if ((comparison != PINOCCHIO_TIMELINE_COMPARISON_SAME) &&
+        (comparison != PINOCCHIO_TIMELINE_COMPARISON_SUBSET))
     {
-        // Cannot open output timeline
+        // Input timeline does not fit in output timeline
+        free(mapping);
+        pioCloseTimeline(&pioOutputTimeline);
+        pioCloseTimeline(&pioInputTimeline);
         pioCloseDataset(&pioInputDataset);
         return 0;
     }
+    pioCloseTimeline(&pioInputTimeline);
     
     // open input datatype
     pioDatatype = pioGetDatatype(pioInputDataset);
     if (PIODatatypeIsInvalid(pioDatatype))
     {
         // Cannot get input datatype
+        free(mapping);
         pioCloseTimeline(&pioOutputTimeline);
         pioCloseDataset(&pioInputDataset);
         return 0;
     }
     
     // create output dataset
-    pioOutputDataset = pioNewDataset(pioOutputFile, 
-                                     pioInputDataset.path, pioInputDataset.description, 
-                                     pioOutputTimeline,
-                                     pioDatatype);
+    pioOutputDataset = pioNewDatasetWithOptions(pioOutputFile, 
+                                                pioInputDataset.path, pioInputDataset.description, 
+                                                pioOutputTimeline,
+                                                pioDatatype, pioOptions);
     if (PIODatasetIsInvalid(pioOutputDataset))
     {
         // Cannot create output dataset
+        free(mapping);
         pioCloseDatatype(&pioDatatype);
         pioCloseTimeline(&pioOutputTimeline);
         pioCloseDataset(&pioInputDataset);
         return 0;
     }
     
-    // read input dataset and write it to output dataset
+    // read input dataset and write it to output dataset (by batches)
+    // output time ranges missing from input timeline are left empty
+    pioNewDatasetWriter(&pioOutputDataset, 0);
     
-    for (t=0; t<pioOutputTimeline.ntimeranges; t++) 
+    for (t=0; t<pioInputDataset.ntimeranges; t++) 
     {
         number = pioReadData(&pioInputDataset, t, pioDatatype, &buffer);
-        pioWrite(&pioOutputDataset, t, buffer, number, pioDatatype);
+        pioWrite(&pioOutputDataset, mapping[t], buffer, number, pioDatatype);
     }
     
+    free(mapping);
     pioCloseDatatype(&pioDatatype);
     pioCloseTimeline(&pioOutputTimeline);    
     pioCloseDataset(&pioOutputDataset);
@@ -0,0 +1,340 @@
+// 
+// Copyright 2010 Herve BREDIN (bredin@limsi.fr)
+// Contact: http://pinocchio.niderb.fr/
+// 
+// This file is part of pinocchIO.
+//  
+//      pinocchIO is free software: you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation, either version 3 of the License, or
+//      (at your option) any later version.
+//  
+//      pinocchIO is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//  
+//      You should have received a copy of the GNU General Public License
+//      along with pinocchIO. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+#include "pIOPool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "pIOFile.h"
+#include "pIODataset.h"
+
+// dataset kept open by a pool
+typedef struct {
+	char* path;
+	PIODataset dataset;
+	int flags;
+	int references;
+} poolDataset_t;
+
+// file kept open by a pool, with its datasets
+typedef struct {
+	char* path;
+	PIOFile file;
+	int references; // including references to its datasets
+	int64_t lastUse;
+	int numberOfDatasets;
+	poolDataset_t** datasets;
+} poolFile_t;
+
+struct PIOPool_s {
+	int maximumNumberOfFiles;
+	int numberOfFiles;
+	int allocatedFiles;
+	poolFile_t** files;
+	poolFile_t* lastFile; // most recently used file
+	int64_t clock;
+};
+
+static char* copyString(const char* string)
+{
+	char* copy = (char*) malloc((strlen(string)+1)*sizeof(char));
+	if (copy) strcpy(copy, string);
+	return copy;
+}
+
+static int closePoolDataset(poolDataset_t* pd)
+{
+	int closed = 1;
+	
+	if (PIODatasetIsValid(pd->dataset)) closed = pioCloseDataset(&(pd->dataset));
+	free(pd->path);
+	free(pd);
+	return closed;
+}
+
+static int closePoolFile(poolFile_t* pf)
+{
+	int closed = 1;
+	int d;
+	
+	for (d=0; d<pf->numberOfDatasets; d++)
+		if (!closePoolDataset(pf->datasets[d])) closed = 0;
+	free(pf->datasets);
+	if (PIOFileIsValid(pf->file) && !pioCloseFile(&(pf->file))) closed = 0;
+	free(pf->path);
+	free(pf);
+	return closed;
+}
+
+// close least recently used files that are not referenced anymore
+// until at most maximumNumberOfFiles are open (or every open file is referenced)
+static void evictFiles(PIOPool* pool, int maximumNumberOfFiles)
+{
+	int f, lru;
+	
+	while (pool->numberOfFiles > maximumNumberOfFiles)
+	{
+		lru = -1;
+		for (f=0; f<pool->numberOfFiles; f++)
+			if ((pool->files[f]->references == 0) && 
+				((lru < 0) || (pool->files[f]->lastUse < pool->files[lru]->lastUse)))
+				lru = f;
+		if (lru < 0) return;
+		
+		if (pool->lastFile == pool->files[lru]) pool->lastFile = NULL;
+		closePoolFile(pool->files[lru]);
+		pool->files[lru] = pool->files[pool->numberOfFiles-1];
+		pool->numberOfFiles--;
+	}
+}
+
+static poolFile_t* findFile(PIOPool* pool, const char* path)
+{
+	int f;
+	
+	if (pool->lastFile && !strcmp(pool->lastFile->path, path)) return pool->lastFile;
+	for (f=0; f<pool->numberOfFiles; f++)
+		if (!strcmp(pool->files[f]->path, path)) return pool->files[f];
+	return NULL;
+}
+
+// get pooled file at location path, opening it if needed
+static poolFile_t* getPoolFile(PIOPool* pool, const char* path)
+{
+	poolFile_t* pf = NULL;
+	poolFile_t** files = NULL;
+	PIOFile file = PIOFileInvalid;
+	
+	pf = findFile(pool, path);
+	if (!pf)
+	{
+		// make room first: HDF5 then has one less file open
+		evictFiles(pool, pool->maximumNumberOfFiles-1);
+		
+		if (pool->numberOfFiles == pool->allocatedFiles)
+		{
+			files = (poolFile_t**) realloc(pool->files, (2*pool->allocatedFiles+1)*sizeof(poolFile_t*));
+			if (!files) return NULL;
+			pool->files = files;
+			pool->allocatedFiles = 2*pool->allocatedFiles+1;
+		}
+		
+		file = pioOpenFile(path, PINOCCHIO_READONLY);
+		if (PIOFileIsInvalid(file)) return NULL;
+		
+		pf = (poolFile_t*) malloc(sizeof(poolFile_t));
+		pf->path = copyString(path);
+		pf->file = file;
+		pf->references = 0;
+		pf->numberOfDatasets = 0;
+		pf->datasets = NULL;
+		pool->files[pool->numberOfFiles] = pf;
+		pool->numberOfFiles++;
+	}
+	
+	pf->lastUse = ++(pool->clock);
+	pool->lastFile = pf;
+	return pf;
+}
+
+static void findDataset(PIOPool* pool, PIODataset* dataset, poolFile_t** pf, poolDataset_t** pd)
+{
+	int f, d;
+	
+	*pf = NULL;
+	*pd = NULL;
+	
+	for (f=-1; f<pool->numberOfFiles; f++)
+	{
+		// most recently used file first
+		*pf = (f < 0) ? pool->lastFile : pool->files[f];
+		if (!*pf) continue;
+		for (d=0; d<(*pf)->numberOfDatasets; d++)
+			if (&((*pf)->datasets[d]->dataset) == dataset)
+			{
+				*pd = (*pf)->datasets[d];
+				return;
+			}
+	}
+	*pf = NULL;
+}
+
+PIOPool* pioNewPool(int maximumNumberOfFiles)
+{
+	PIOPool* pool = NULL;
+	
+	if (maximumNumberOfFiles < 1) return NULL;
+	
+	pool = (PIOPool*) malloc(sizeof(PIOPool));
+	if (!pool) return NULL;
+	
+	pool->maximumNumberOfFiles = maximumNumberOfFiles;
+	pool->numberOfFiles = 0;
+	pool->allocatedFiles = 0;
+	pool->files = NULL;
+	pool->lastFile = NULL;
+	pool->clock = 0;
+	
+	return pool;
+}
+
+int pioClosePool(PIOPool** pool)
+{
+	int closed = 1;
+	int f;
+	
+	if (!*pool) return 0;
+	
+	for (f=0; f<(*pool)->numberOfFiles; f++)
+		if (!closePoolFile((*pool)->files[f])) closed = 0;
+	free((*pool)->files);
+	free(*pool);
+	*pool = NULL;
+	
+	return closed;
+}
+
+PIOFile* pioPoolOpenFile(PIOPool* pool, const char* path)
+{
+	poolFile_t* pf = NULL;
+	
+	if (!pool || !path) return NULL;
+	
+	pf = getPoolFile(pool, path);
+	if (!pf) return NULL;
+	
+	pf->references++;
+	return &(pf->file);
+}
+
+PIODataset* pioPoolOpenDataset(PIOPool* pool, const char* path, const char* pathToDataset, int flags)
+{
+	poolFile_t* pf = NULL;
+	poolDataset_t* pd = NULL;
+	poolDataset_t** datasets = NULL;
+	int unreferenced = -1;
+	int d;
+	
+	if (!pool || !path || !pathToDataset) return NULL;
+	
+	pf = getPoolFile(pool, path);
+	if (!pf) return NULL;
+	
+	// look for a pooled dataset with (at least) the requested flags
+	for (d=0; d<pf->numberOfDatasets; d++)
+		if (!strcmp(pf->datasets[d]->path, pathToDataset))
+		{
+			if (!(flags & ~(pf->datasets[d]->flags)))
+			{
+				pd = pf->datasets[d];
+				break;
+			}
+			// a new dataset will have the flags of the others as well
+			flags |= pf->datasets[d]->flags;
+			if (pf->datasets[d]->references == 0) unreferenced = d;
+		}
+	
+	// reopen unreferenced dataset when more flags are needed
+	if (!pd && (unreferenced > -1))
+	{
+		pd = pf->datasets[unreferenced];
+		pioCloseDataset(&(pd->dataset));
+		pd->flags = flags;
+		pd->dataset = pioOpenDatasetWithFlags(PIOMakeObject(pf->file), pathToDataset, pd->flags);
+		if (PIODatasetIsInvalid(pd->dataset))
+		{
+			closePoolDataset(pd);
+			pf->datasets[unreferenced] = pf->datasets[pf->numberOfDatasets-1];
+			pf->numberOfDatasets--;
+			evictFiles(pool, pool->maximumNumberOfFiles);
+			return NULL;
+		}
+	}
+	
+	// otherwise, open a new one
+	// (datasets still referenced with fewer flags are left untouched)
+	if (!pd)
+	{
+		datasets = (poolDataset_t**) realloc(pf->datasets, (pf->numberOfDatasets+1)*sizeof(poolDataset_t*));
+		if (!datasets)
+		{
+			evictFiles(pool, pool->maximumNumberOfFiles);
+			return NULL;
+		}
+		pf->datasets = datasets;
+		
+		pd = (poolDataset_t*) malloc(sizeof(poolDataset_t));
+		pd->dataset = pioOpenDatasetWithFlags(PIOMakeObject(pf->file), pathToDataset, flags);
+		if (PIODatasetIsInvalid(pd->dataset))
+		{
+			free(pd);
+			// file may have been opened for this dataset only
+			evictFiles(pool, pool->maximumNumberOfFiles);
+			return NULL;
+		}
+		pd->path = copyString(pathToDataset);
+		pd->flags = flags;
+		pd->references = 0;
+		pf->datasets[pf->numberOfDatasets] = pd;
+		pf->numberOfDatasets++;
+	}
+	
+	pd->references++;
+	pf->references++;
+	return &(pd->dataset);
+}
+
+int pioPoolReleaseFile(PIOPool* pool, PIOFile* file)
+{
+	int f;
+	
+	if (!pool || !file) return 0;
+	
+	for (f=0; f<pool->numberOfFiles; f++)
+		if ((&(pool->files[f]->file) == file) && (pool->files[f]->references > 0))
+		{
+			pool->files[f]->references--;
+			pool->files[f]->lastUse = ++(pool->clock);
+			evictFiles(pool, pool->maximumNumberOfFiles);
+			return 1;
+		}
+	
+	return 0;
+}
+
+int pioPoolReleaseDataset(PIOPool* pool, PIODataset* dataset)
+{
+	poolFile_t* pf = NULL;
+	poolDataset_t* pd = NULL;
+	
+	if (!pool || !dataset) return 0;
+	
+	findDataset(pool, dataset, &pf, &pd);
+	if (!pd || (pd->references == 0)) return 0;
+	
+	pd->references--;
+	pf->references--;
+	pf->lastUse = ++(pool->clock);
+	evictFiles(pool, pool->maximumNumberOfFiles);
+	
+	return 1;
+}
@@ -27,87 +27,176 @@
 #include "pIODatatype.h"
 #include "structure_utils.h"
 
-int getLink(PIODataset pioDataset, int timerangeIndex, link_t* link)
+int getLinkRange(PIODataset dataset, int firstTimerange, int count, link_t* links)
 {
-	ERROR_SWITCH_INIT
-	herr_t read_err;
-
-	hsize_t position[1] = {-1};
-	hsize_t number[1] = {-1};
-	hid_t dataspaceForLink = -1;
-	hid_t bufferDataspaceForLink = -1;
-	hid_t link_datatype = -1;
+	if ((firstTimerange < 0) || (count < 0)) return -1;
+	if (firstTimerange+count > dataset.ntimeranges) return -1;
+	if (count == 0) return 1;
+	
+	// use in-memory link table when available
+	if (dataset.links)
+	{
+		memcpy(links, dataset.links+firstTimerange, count*sizeof(link_t));
+		return 1;
+	}
+	
+	// write buffered links first
+	if (flushDatasetWriter(dataset) < 0) return -1;
 	
+	// read link dataset, from first to last 'link'
+	return readHyperslab(dataset.link_identifier, linkDatatype(), 
+						 (hsize_t)firstTimerange, (hsize_t)count, links);
+}
+
+int getLink(PIODataset pioDataset, int timerangeIndex, link_t* link)
+{
 	if (!(timerangeIndex<pioDataset.ntimeranges)) return -1;
 	
-	// read link dataset
-	position[0] = timerangeIndex;
-	number[0] = 1;
-	dataspaceForLink = H5Dget_space(pioDataset.link_identifier);
-	H5Sselect_hyperslab(dataspaceForLink, H5S_SELECT_SET, position, NULL, number, NULL);
-	bufferDataspaceForLink = H5Screate_simple(1, number, NULL);
-	link_datatype = linkDatatype();
-	ERROR_SWITCH_OFF
-	read_err = H5Dread(pioDataset.link_identifier, link_datatype, bufferDataspaceForLink, dataspaceForLink, H5P_DEFAULT, link);
-	ERROR_SWITCH_ON
-	H5Tclose(link_datatype);
-	H5Sclose(bufferDataspaceForLink);
-	H5Sclose(dataspaceForLink);
+	// use in-memory link table when available
+	if (pioDataset.links)
+	{
+		*link = pioDataset.links[timerangeIndex];
+		return 1;
+	}
 	
-	if (read_err < 0) return -1;
-	return 1;
+	return getLinkRange(pioDataset, timerangeIndex, 1, link);
 }
 
 int getLinks(PIODataset dataset, link_t* links)
 {
-	ERROR_SWITCH_INIT
-	herr_t read_err;
-    
-	hsize_t position[1] = {-1};
-	hsize_t number[1] = {-1};
-	hid_t dataspaceForLink = -1;
-	hid_t bufferDataspaceForLink = -1;
-	hid_t link_datatype = -1;
-	
-	// read link dataset
-	position[0] = 0; // from first 'link'
-	number[0] = dataset.ntimeranges;   // to last 'link'
-	dataspaceForLink = H5Dget_space(dataset.link_identifier);
-	H5Sselect_hyperslab(dataspaceForLink, H5S_SELECT_SET, position, NULL, number, NULL);
-	bufferDataspaceForLink = H5Screate_simple(1, number, NULL);
-	link_datatype = linkDatatype();
-	ERROR_SWITCH_OFF
-	read_err = H5Dread(dataset.link_identifier, link_datatype, bufferDataspaceForLink, dataspaceForLink, H5P_DEFAULT, links);
-	ERROR_SWITCH_ON
-	H5Tclose(link_datatype);
-	H5Sclose(bufferDataspaceForLink);
-	H5Sclose(dataspaceForLink);
+	return getLinkRange(dataset, 0, dataset.ntimeranges, links);
+}
+
+int loadLinks(PIODataset* pioDataset)
+{
+	link_t* links = NULL;
 	
-	if (read_err < 0) return -1;
+	if (pioDataset->links) return 1;
+	
+	links = (link_t*) malloc((pioDataset->ntimeranges+1)*sizeof(link_t));
+	if (links == NULL) return -1;
+	if (getLinks(*pioDataset, links) < 0)
+	{
+		free(links);
+		return -1;
+	}
+	
+	pioDataset->links = links;
 	return 1;
 }
 
+// Copy data for the time ranges described by links (in this order) from memory-mapped
+// data into buffer. Returns -2 if datatype conversion is needed (not handled here).
+int64_t copyMappedData(PIODataset dataset, int count, link_t* links,
+					   PIODatatype pioDatatype, void* buffer)
+{
+	PIODatasetMapping* mapping = dataset.mapping;
+	int tr;
+	int64_t totalNumber = 0;
+	size_t size = 0;
+	size_t offset = 0;
+	size_t length = 0;
+	
+	if (H5Tequal(mapping->datatype, pioDatatype.identifier) <= 0) return -2;
+	
+	for (tr=0; tr<count; tr++)
+	{
+		if (links[tr].number == 0) continue;
+		offset = links[tr].position*mapping->entry_size;
+		length = links[tr].number*mapping->entry_size;
+		if (offset+length > mapping->data_size) return -1;
+		memcpy((char*)buffer+size, mapping->data+offset, length);
+		size = size + length;
+		totalNumber += links[tr].number;
+	}
+	
+	return totalNumber;
+}
 
-int pioReadData(PIODataset* pioDataset, int timerangeIndex, 
-                PIODatatype pioDatatype, void** buffer)
+// Read data for the time ranges described by links (in this order) into buffer.
+// Data of consecutive time ranges are usually stored contiguously:
+// they are then read at once with a single hyperslab.
+int64_t readLinkedData(PIODataset dataset, int count, link_t* links,
+					   PIODatatype pioDatatype, void* buffer)
 {
-	ERROR_SWITCH_INIT
-	herr_t read_err;
+	int read_err = 1;
 	
-	link_t link = {0, 0};
+	int tr;
+	int64_t first = -1;
+	int64_t next = -1;
+	int contiguous = 1;
+	int64_t totalNumber = 0;
+	int64_t copied = -1;
+	size_t size = 0;
+	
+	for (tr=0; tr<count; tr++)
+	{
+		if (links[tr].number == 0) continue;
+		if (first < 0) first = links[tr].position;
+		else if (links[tr].position != next) contiguous = 0;
+		next = links[tr].position + links[tr].number;
+		totalNumber += links[tr].number;
+	}
+	if (totalNumber == 0) return 0;
+	
+	// copy memory-mapped data when available
+	if (dataset.mapping)
+	{
+		copied = copyMappedData(dataset, count, links, pioDatatype, buffer);
+		if (copied != -2) return copied;
+	}
+	
+	// write buffered data first
+	if (flushDatasetWriter(dataset) < 0) return -1;
 	
-	hsize_t position[1] = {-1};
-	hsize_t number[1] = {-1};
+	if (contiguous)
+	{
+		// one single read for all time ranges
+		read_err = readHyperslab(dataset.identifier, pioDatatype.identifier, 
+								 (hsize_t)first, (hsize_t)totalNumber, buffer);
+	}
+	else
+	{
+		// one read per time range (e.g. after time ranges were overwritten)
+		for (tr=0; tr<count; tr++)
+		{
+			if (links[tr].number == 0) continue;
+			read_err = readHyperslab(dataset.identifier, pioDatatype.identifier, 
+									 (hsize_t)(links[tr].position), (hsize_t)(links[tr].number), buffer+size);
+			if (read_err < 0) break;
+			size = size + links[tr].number*pioGetSize(pioDatatype);
+		}
+	}
 	
-	hid_t dataspaceForData = -1;
-	hid_t bufferDataspaceForData = -1;
+	if (read_err < 0) return -1;
+	return totalNumber;
+}
+
+int pioReadData(PIODataset* pioDataset, int timerangeIndex, 
+                PIODatatype pioDatatype, void** buffer)
+{
+	link_t link = {0, 0};
+	int64_t number = -1;
     size_t new_buffer_size = -1;
 
+	// load link table at first read if requested
+	if ((pioDataset->flags & PINOCCHIO_DATASET_CACHE_LINKS) && (pioDataset->links == NULL))
+		if (loadLinks(pioDataset) < 0) return -1;
+	
 	if (getLink(*pioDataset, timerangeIndex, &link)<0) return -1;
     
     // 
     if (link.number == 0) return 0; 
     
+    // point directly into memory-mapped data when no conversion is needed
+    if (pioDataset->mapping && (H5Tequal(pioDataset->mapping->datatype, pioDatatype.identifier) > 0))
+    {
+        if ((link.position+link.number)*pioDataset->mapping->entry_size > pioDataset->mapping->data_size) 
+            return -1;
+        *buffer = pioDataset->mapping->data + link.position*pioDataset->mapping->entry_size;
+        return (int)link.number;
+    }
+    
     // realloc internal buffer if necessary
     new_buffer_size = link.number*pioGetSize(pioDatatype);
     if (new_buffer_size > pioDataset->buffer_size)
@@ -122,36 +211,26 @@ int pioReadData(PIODataset* pioDataset, int timerangeIndex,
     }
 	
 	// read dataset
-	position[0] = (hsize_t)(link.position);
-	number[0] = (hsize_t)(link.number);
-	dataspaceForData = H5Dget_space(pioDataset->identifier);
-	H5Sselect_hyperslab(dataspaceForData, H5S_SELECT_SET, position, NULL, number, NULL);
-	bufferDataspaceForData = H5Screate_simple(1, number, NULL);
-	ERROR_SWITCH_OFF
-	read_err = H5Dread(pioDataset->identifier, pioDatatype.identifier, 
-                       bufferDataspaceForData, dataspaceForData, H5P_DEFAULT, pioDataset->buffer);
-	ERROR_SWITCH_ON
-	H5Sclose(bufferDataspaceForData);
-	H5Sclose(dataspaceForData);
-	if (read_err < 0) return -1;
+	number = readLinkedData(*pioDataset, 1, &link, pioDatatype, pioDataset->buffer);
+	if (number < 0) return -1;
 	
     *buffer = pioDataset->buffer;
     
-	return link.number;
+	return (int)number;
 }
 
 int pioReadNumber(PIODataset pioDataset, int timerangeIndex)
 {
 	link_t link = {0, 0};	
 	if (getLink(pioDataset, timerangeIndex, &link)<0) return -1;
-	return link.number;    
+	return (int)link.number;    
 }
 
-int pioReadAllNumbers(PIODataset dataset, int* number)
+int64_t pioReadAllNumbers(PIODataset dataset, int* number)
 {
     link_t* links = NULL;
     int tr;
-    int sumNumber;
+    int64_t sumNumber;
     
     // return expected length of @a number array
     if (!number) return dataset.ntimeranges;
@@ -166,77 +245,167 @@ int pioReadAllNumbers(PIODataset dataset, int* number)
     sumNumber = 0;
     for (tr=0; tr<dataset.ntimeranges; tr++)
     {
-        number[tr] = links[tr].number;
-        sumNumber += number[tr];
+        number[tr] = (int)links[tr].number;
+        sumNumber += links[tr].number;
     }
     
     free(links);
     return sumNumber;
 }
 
-int pioDumpDataset(PIODataset* pioDataset, 
-                   PIODatatype pioDatatype, 
-                   void* buffer,
-                   int* number)
+int64_t pioReadRange(PIODataset* pioDataset, int firstTimerange, int count,
+                     PIODatatype pioDatatype, void** buffer, int* number)
 {
-    int tr = 0;
+    link_t* links = NULL;
+    int tr;
+    int64_t totalNumber = 0;
+    size_t new_buffer_size = -1;
+    
+    if (count < 0) return -1;
+    if (count == 0) return 0;
     
-    int localNumber = -1;
-    int totalNumber = 0;
+    // load link table at first read if requested
+    if ((pioDataset->flags & PINOCCHIO_DATASET_CACHE_LINKS) && (pioDataset->links == NULL))
+        if (loadLinks(pioDataset) < 0) return -1;
+    
+    // read all links at once
+    links = (link_t*) malloc(count*sizeof(link_t));
+    if (links == NULL) return -1;
+    if (getLinkRange(*pioDataset, firstTimerange, count, links) < 0)
+    {
+        free(links);
+        return -1;
+    }
+    
+    for (tr=0; tr<count; tr++)
+    {
+        if (number) number[tr] = (int)links[tr].number;
+        totalNumber += links[tr].number;
+    }
+    
+    // realloc internal buffer if necessary
+    new_buffer_size = totalNumber*pioGetSize(pioDatatype);
+    if (new_buffer_size > pioDataset->buffer_size)
+    {
+        pioDataset->buffer = realloc(pioDataset->buffer, new_buffer_size);
+        if (pioDataset->buffer == NULL) 
+        {
+            pioDataset->buffer_size = 0;
+            free(links);
+            return -1;
+        }
+        pioDataset->buffer_size = new_buffer_size;
+    }
+    
+    // read data at once
+    totalNumber = readLinkedData(*pioDataset, count, links, pioDatatype, pioDataset->buffer);
+    free(links);
+    if (totalNumber < 0) return -1;
+    
+    *buffer = pioDataset->buffer;
+    
+    return totalNumber;
+}
 
-    size_t tmp_size = -1;
+int64_t pioReadRangeInto(PIODataset* pioDataset, int firstTimerange, int count,
+                         PIODatatype pioDatatype, void* buffer, size_t capacity, int* number)
+{
+    link_t oneLink = {0, 0};
+    link_t* links = NULL;
+    int tr;
+    int64_t totalNumber = 0;
+    
+    if (count < 0) return -1;
+    if (count == 0) return 0;
+    
+    // load link table at first read if requested
+    if ((pioDataset->flags & PINOCCHIO_DATASET_CACHE_LINKS) && (pioDataset->links == NULL))
+        if (loadLinks(pioDataset) < 0) return -1;
+    
+    // read all links at once
+    if (count == 1) links = &oneLink;
+    else links = (link_t*) malloc(count*sizeof(link_t));
+    if (links == NULL) return -1;
+    if (getLinkRange(*pioDataset, firstTimerange, count, links) < 0)
+    {
+        if (links != &oneLink) free(links);
+        return -1;
+    }
+    
+    for (tr=0; tr<count; tr++)
+    {
+        if (number) number[tr] = (int)links[tr].number;
+        totalNumber += links[tr].number;
+    }
+    
+    // make sure data fit into buffer
+    if (totalNumber*pioGetSize(pioDatatype) > capacity)
+    {
+        if (links != &oneLink) free(links);
+        return -1;
+    }
+    
+    // read data directly into buffer
+    totalNumber = readLinkedData(*pioDataset, count, links, pioDatatype, buffer);
+    if (links != &oneLink) free(links);
+    
+    return totalNumber;
+}
+
+int pioReadInto(PIODataset* pioDataset, int timerangeIndex,
+                PIODatatype pioDatatype, void* buffer, size_t capacity)
+{
+    return (int)pioReadRangeInto(pioDataset, timerangeIndex, 1, pioDatatype, buffer, capacity, NULL);
+}
+
+int64_t pioDumpDataset(PIODataset* pioDataset, 
+                       PIODatatype pioDatatype, 
+                       void* buffer,
+                       int* number)
+{
+    link_t* links = NULL;
+    int tr = 0;
+    int64_t totalNumber = 0;
     size_t size = 0;
-    void* localBuffer = NULL;
     
+    if (pioDataset->ntimeranges == 0) return 0;
+    
+    // load link table at first read if requested
+    if ((pioDataset->flags & PINOCCHIO_DATASET_CACHE_LINKS) && (pioDataset->links == NULL))
+        if (loadLinks(pioDataset) < 0) return -1;
+    
+    // read all links at once
+    links = (link_t*) malloc(pioDataset->ntimeranges*sizeof(link_t));
+    if (links == NULL) return -1;
+    if (getLinks(*pioDataset, links) < 0) 
+    {
+        free(links);
+        return -1;
+    }
+    
+    for (tr=0; tr<pioDataset->ntimeranges; tr++)
+    {
+        // store number of data
+        if (number) number[tr] = (int)links[tr].number;
+        
+        // update total number of data
+        totalNumber = totalNumber + links[tr].number;
+    }
     
     if (buffer)
     {
-        for (tr=0; tr<pioDataset->ntimeranges; tr++)
-        {
-            // read data for timerange tr
-            localNumber = pioReadData(pioDataset, tr, pioDatatype, &localBuffer);
-            if (localNumber < 0) 
-		return -1; // stop if something bad happened
-            
-            // deduce buffer size from number of read data
-            tmp_size = localNumber*pioGetSize(pioDatatype);
-            
-            // copy buffer at correct position
-            memcpy(buffer+size, localBuffer, tmp_size);
-            
-            // update position in output buffer
-            size = size + tmp_size;
-            
-            // update total number of read data
-            totalNumber = totalNumber + localNumber;
-            
-            // store number of read data
-            if (number) number[tr] = localNumber;
-        }
+        // read data directly into output buffer
+        totalNumber = readLinkedData(*pioDataset, pioDataset->ntimeranges, links,
+                                     pioDatatype, buffer);
     }
     else 
     {
-        for (tr=0; tr<pioDataset->ntimeranges; tr++)
-        {
-            // read number of data for timerange tr
-            localNumber = pioReadNumber(*pioDataset, tr);
-             if (localNumber < 0) 
-		return -1; // stop if something bad happened
-                        
-            // update total number of data
-            totalNumber = totalNumber + localNumber;
-            
-            // store number of data
-            if (number) number[tr] = localNumber;
-        }
-        
         // deduce buffer size from number of data
         size = totalNumber*pioGetSize(pioDatatype);
-        
+        free(links);
         return size;
     }
     
+    free(links);
     return totalNumber;
 }
-
-
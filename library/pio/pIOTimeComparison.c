@@ -20,102 +20,150 @@
 
 #include "pIOTimeComparison.h"
 
+#include <stdlib.h>
+
 // int64_t comparison
 int compare_int64_t( int64_t ll1, int64_t ll2 )
 {
-	if (( ll1 < ll2  )) return -1;
-	if (( ll1 == ll2 )) return 0;
-	if (( ll1 > ll2  )) return 1;
-	return 0; 
+	return (ll1 > ll2) - (ll1 < ll2);
 }
 
-PIOTimeRangeComparison pioCompareTimeRanges( PIOTimeRange tr1, PIOTimeRange tr2)
+static int64_t gcd_int64_t( int64_t a, int64_t b )
+{
+	int64_t r;
+	while (b) { r = a % b; a = b; b = r; }
+	return a;
+}
+
+// comparison of t1/s1 with t2/s2 (sign of t1*s2 - t2*s1, without overflow)
+static inline int helper_pioCompareScaledTimes( int64_t t1, int32_t s1, int64_t t2, int32_t s2 )
 {
-	int compareStart = compare_int64_t(tr1.time * tr2.scale, 
-									   tr2.time * tr1.scale);
-	int compareStop  = compare_int64_t((tr1.time+tr1.duration) * tr2.scale, 
-									   (tr2.time+tr2.duration) * tr1.scale);
+	// same scale: no need to cross-multiply
+	if (s1 == s2) return (t1 > t2) - (t1 < t2);
 	
-	switch (compareStart) {
-			// tr1 begins before tr2
-		case -1:
-			return PINOCCHIO_TIMERANGE_COMPARISON_ASCENDING;
-			break;
-			
-		case 0:
-			switch (compareStop) {
-					// tr1 stops before tr2
-				case -1:
-					return PINOCCHIO_TIMERANGE_COMPARISON_ASCENDING;
-					break;
-					
-				case 0:
-					return PINOCCHIO_TIMERANGE_COMPARISON_SAME;
-					break;
-					
-				case 1:
-					return PINOCCHIO_TIMERANGE_COMPARISON_DESCENDING;
-					break;				
-			}
-			break;
-			
-			// tr2 begins before tr1
-		case 1:
-			return PINOCCHIO_TIMERANGE_COMPARISON_DESCENDING;
-			break;		
+#ifdef __SIZEOF_INT128__
+	{
+		// products are less than 2^95 and so is their difference
+		__int128 d = (__int128)t1 * s2 - (__int128)t2 * s1;
+		return (int)(d >> 127) | (int)(d != 0);
 	}
-	return 0;
+#else
+	{
+		int64_t q1, q2, r1, r2;
+		
+		if ((s1 <= 0) || (s2 <= 0)) return compare_int64_t(t1 * s2, t2 * s1);
+		
+		// compare integer parts first, then fractional parts (r < s fits in 32 bits)
+		q1 = t1 / s1; r1 = t1 % s1; if (r1 < 0) { r1 += s1; q1--; }
+		q2 = t2 / s2; r2 = t2 % s2; if (r2 < 0) { r2 += s2; q2--; }
+		if (q1 != q2) return (q1 > q2) - (q1 < q2);
+		return compare_int64_t(r1 * s2, r2 * s1);
+	}
+#endif
 }
 
-PIOTimeComparison pioCompareTimes( PIOTime t1, PIOTime t2)
+// t1/s1 equals t2/s2 (cheaper than helper_pioCompareScaledTimes)
+static inline int helper_pioSameScaledTimes( int64_t t1, int32_t s1, int64_t t2, int32_t s2 )
 {
-	PIOTimeRange tr1; 
-	PIOTimeRange tr2;
+	if (s1 == s2) return (t1 == t2);
 	
-	tr1.time = t1.time;
-	tr1.scale = t1.scale;
-	tr1.duration = 0;
+#ifdef __SIZEOF_INT128__
+	return ((__int128)t1 * s2 == (__int128)t2 * s1);
+#else
+	return (helper_pioCompareScaledTimes(t1, s1, t2, s2) == 0);
+#endif
+}
+
+// t/s expressed in 1/scale units, rounded down (or up)
+static int64_t helper_pioRescaleTime( int64_t t, int32_t s, int32_t scale, int up )
+{
+	int64_t q, r, f;
 	
-	tr2.time = t2.time;
-	tr2.scale = t2.scale;
-	tr2.duration = 0;
+	if (s == scale) return t;
+	
+	q = t / s; r = t % s; if (r < 0) { r += s; q--; }
+	f = (r * scale) / s;
+	if (up && ((r * scale) % s)) f++;
+	return q * scale + f;
+}
+
+static inline PIOTimeRangeComparison helper_pioCompareTimeRanges( PIOTimeRange tr1, PIOTimeRange tr2 )
+{
+	// tr1 begins before (or after) tr2...
+	int compareStart = helper_pioCompareScaledTimes(tr1.time, tr1.scale, 
+													tr2.time, tr2.scale);
+	// ... or they begin simultaneously and tr1 stops before (or after, or with) tr2
+	int compareStop  = helper_pioCompareScaledTimes(tr1.time+tr1.duration, tr1.scale, 
+													tr2.time+tr2.duration, tr2.scale);
 	
-	return (PIOTimeComparison)pioCompareTimeRanges(tr1, tr2);
+	return (PIOTimeRangeComparison)(compareStart ? compareStart : compareStop);
+}
+
+PIOTimeRangeComparison pioCompareTimeRanges( PIOTimeRange tr1, PIOTimeRange tr2)
+{
+	return helper_pioCompareTimeRanges(tr1, tr2);
+}
+
+PIOTimeComparison pioCompareTimes( PIOTime t1, PIOTime t2)
+{
+	return (PIOTimeComparison)helper_pioCompareScaledTimes(t1.time, t1.scale, t2.time, t2.scale);
+}
+
+PIOTimeRangeComparison pioCompareTimeAndTimeRange( PIOTime t, PIOTimeRange tr)
+{
+	if (helper_pioCompareScaledTimes(t.time, t.scale, tr.time, tr.scale) < 0)
+		return PINOCCHIO_TIMERANGE_COMPARISON_ASCENDING;
+	if (helper_pioCompareScaledTimes(t.time, t.scale, tr.time+tr.duration, tr.scale) > 0)
+		return PINOCCHIO_TIMERANGE_COMPARISON_DESCENDING;
+	return PINOCCHIO_TIMERANGE_COMPARISON_SAME;
 }
 
 int pioTimeInTimeRange( PIOTime t, PIOTimeRange tr)
 {
-	return ((  tr.time              * t.scale <= t.time * tr.scale ) && 
-			( (tr.time+tr.duration) * t.scale >= t.time * tr.scale ));	
+	return ((helper_pioCompareScaledTimes(tr.time,             tr.scale, t.time, t.scale) <= 0) && 
+			(helper_pioCompareScaledTimes(tr.time+tr.duration, tr.scale, t.time, t.scale) >= 0));
 }
 
 int pioTimeRangeInTimeRange( PIOTimeRange tr1, PIOTimeRange tr2)
 {
-	return ((	tr1.time				* tr2.scale >=  tr2.time				* tr1.scale) && 
-			(  (tr1.time+tr1.duration)	* tr2.scale <= (tr2.time+tr2.duration)	* tr1.scale));
+	return ((helper_pioCompareScaledTimes(tr1.time,              tr1.scale, tr2.time,              tr2.scale) >= 0) && 
+			(helper_pioCompareScaledTimes(tr1.time+tr1.duration, tr1.scale, tr2.time+tr2.duration, tr2.scale) <= 0));
 }
 
 PIOTime pioGetTimeMax(PIOTime t1, PIOTime t2)
 {
-    if (t1.time * t2.scale > t2.time * t1.scale) return t1;
+    if (helper_pioCompareScaledTimes(t1.time, t1.scale, t2.time, t2.scale) > 0) return t1;
     else return t2;
 }
 
 PIOTime pioGetTimeMin(PIOTime t1, PIOTime t2)
 {
-    if (t1.time * t2.scale < t2.time * t1.scale) return t1;
+    if (helper_pioCompareScaledTimes(t1.time, t1.scale, t2.time, t2.scale) < 0) return t1;
     else return t2;    
 }
 
 PIOTimeRange pioGetTimeRangeBetweenTimes( PIOTime start, PIOTime stop)
 {
+    int64_t scale;
+    
     if (pioCompareTimes(start, stop) == PINOCCHIO_TIME_COMPARISON_DESCENDING)
         return PIOTimeRangeEmpty;
     
     if (start.scale == stop.scale)
         return (PIOTimeRange){start.time, stop.time-start.time, start.scale};
     
-    return (PIOTimeRange){start.time*stop.scale, stop.time*start.scale - start.time*stop.scale, start.scale*stop.scale};
+    if ((start.scale <= 0) || (stop.scale <= 0))
+        return (PIOTimeRange){start.time*stop.scale, stop.time*start.scale - start.time*stop.scale, start.scale*stop.scale};
+    
+    // least common multiple of both scales when it fits in 32 bits...
+    scale = (start.scale / gcd_int64_t(start.scale, stop.scale)) * (int64_t)stop.scale;
+    if ((scale <= 0) || (scale > INT32_MAX))
+        // ... finest of both scales otherwise (rounded outward)
+        scale = (start.scale > stop.scale) ? start.scale : stop.scale;
+    
+    start.time = helper_pioRescaleTime(start.time, start.scale, (int32_t)scale, 0);
+    stop.time = helper_pioRescaleTime(stop.time, stop.scale, (int32_t)scale, 1);
+    return (PIOTimeRange){start.time, stop.time-start.time, (int32_t)scale};
 }
 
 PIOTimeRange pioGetTimeRangeIntersection( PIOTimeRange tr1, PIOTimeRange tr2)
@@ -140,56 +188,63 @@ int pioTimeRangeIntersectsTimeRange( PIOTimeRange tr1, PIOTimeRange tr2)
 
 #pragma mark Timelines functions
 
-// dichotomic search
-int helper_pioFindTimeRangeInTimeLine( PIOTimeRange tr, PIOTimeRange* tl, int *left, int* right )
-{
-	int pivot;
-	
-	if (( *left >= *right )) return *left;
-	
-	pivot = (*left + *right) / 2;
-	switch (pioCompareTimeRanges(tr, tl[pivot]))
-	{
-			// pivot is (strictly) bigger than tr
-		case PINOCCHIO_TIMERANGE_COMPARISON_ASCENDING:
-			*right = pivot-1;
-			break;
-			// pivot is (strictly) smaller than tr
-		case PINOCCHIO_TIMERANGE_COMPARISON_DESCENDING:
-			*left = pivot+1;
-			break;
-			// found it!
-		case PINOCCHIO_TIMERANGE_COMPARISON_SAME:
-			*left = pivot; *right = pivot;
-			break;
-	}
-	return helper_pioFindTimeRangeInTimeLine( tr, tl, left, right);		
-}
+#if defined(__GNUC__)
+#define PINOCCHIO_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define PINOCCHIO_PREFETCH(address)
+#endif
+
+// dichotomic search of the first index of array (of n elements) for which BEFORE(index) is false
+// (BEFORE must be true up to some index and false from then on)
+// without branching on comparisons: both possible next pivots are prefetched instead
+#define PINOCCHIO_LOWER_BOUND(array, n, BEFORE, result) \
+	do { \
+		int _base = 0; \
+		int _length = (n); \
+		int _half; \
+		while (_length > 1) \
+		{ \
+			_half = _length / 2; \
+			PINOCCHIO_PREFETCH(&((array)[_base + _half/2])); \
+			PINOCCHIO_PREFETCH(&((array)[_base + _half + _half/2])); \
+			_base = BEFORE(_base + _half) ? _base + _half : _base; \
+			_length -= _half; \
+		} \
+		(result) = (_length > 0) ? _base + (BEFORE(_base) ? 1 : 0) : 0; \
+	} while (0)
 
 int pioFindTimeRangeInTimeLine( PIOTimeRange tr, PIOTimeRange* tl, int n)
 {
-	int found = -1;
-	
-	int left = 0; 
-	int right = n;
+	int found;
 	
-	found = helper_pioFindTimeRangeInTimeLine(tr, tl, &left, &right );
+	// first time range not before tr
+#define BEFORE(t) (helper_pioCompareTimeRanges(tl[t], tr) == PINOCCHIO_TIMERANGE_COMPARISON_ASCENDING)
+	PINOCCHIO_LOWER_BOUND(tl, n, BEFORE, found);
+#undef BEFORE
 	
-	if (( pioCompareTimeRanges(tr, tl[found]) != PINOCCHIO_TIMERANGE_COMPARISON_SAME ))
+	if (( found >= n ) || 
+		( helper_pioCompareTimeRanges(tr, tl[found]) != PINOCCHIO_TIMERANGE_COMPARISON_SAME ))
 		found = -1;
 	
 	return found;
 }
 
 PIOTimelineComparison pioCompareTimeLines (PIOTimeRange* tr1, int n1, PIOTimeRange* tr2, int n2)
+{
+	return pioCompareTimeLinesWithMapping(tr1, n1, tr2, n2, NULL);
+}
+
+PIOTimelineComparison pioCompareTimeLinesWithMapping (PIOTimeRange* tr1, int n1, PIOTimeRange* tr2, int n2, int* mapping)
 {
 	PIOTimelineComparison result;
 	int t;
+	int u; // next candidate time range in tr2
+	PIOTimeRangeComparison comparison = PINOCCHIO_TIMERANGE_COMPARISON_ASCENDING;
 	
 	if (( n1 > n2 ))
 	{
 		// switch roles of tr1 and tr2
-		result = pioCompareTimeLines( tr2, n2, tr1, n1 );
+		result = pioCompareTimeLinesWithMapping( tr2, n2, tr1, n1, mapping );
 		// result can be either PINOCCHIO_TIMELINE_SUBSET or PINOCCHIO_TIMELINE_OTHER
 		if (result == PINOCCHIO_TIMELINE_COMPARISON_SUBSET)
 			result = PINOCCHIO_TIMELINE_COMPARISON_SUPERSET;
@@ -199,22 +254,43 @@ PIOTimelineComparison pioCompareTimeLines (PIOTimeRange* tr1, int n1, PIOTimeRan
 		// check all timeranges
 		result = PINOCCHIO_TIMELINE_COMPARISON_SAME;
 		for (t=0; t<n1; t++) {
-			if (( pioCompareTimeRanges(tr1[t], tr2[t]) != PINOCCHIO_TIMERANGE_COMPARISON_SAME ))
+			// time ranges at the same scale (most common case) are compared without any product
+			if (( !helper_pioSameScaledTimes(tr1[t].time, tr1[t].scale, tr2[t].time, tr2[t].scale) ||
+				  !helper_pioSameScaledTimes(tr1[t].time+tr1[t].duration, tr1[t].scale,
+											 tr2[t].time+tr2[t].duration, tr2[t].scale) ))
 			{
 				result = PINOCCHIO_TIMELINE_COMPARISON_OTHER;
 				break;
 			}
+			if (mapping) mapping[t] = t;
 		}
 	}
 	else
 	{
 		// make sure all timeranges of smaller timeline is included in bigger one
+		// (both timelines are sorted: walk through them only once)
 		result = PINOCCHIO_TIMELINE_COMPARISON_SUBSET;
+		u = 0;
 		for (t=0; t<n1; t++)
 		{
-			// if timerange 1 is not included in timeline 2, stops 
-			if (( pioFindTimeRangeInTimeLine(tr1[t], tr2, n2) < 0 ))
+			// skip time ranges of timeline 2 coming before timerange 1
+			while ((u < n2) && 
+				   ((comparison = helper_pioCompareTimeRanges(tr2[u], tr1[t])) == PINOCCHIO_TIMERANGE_COMPARISON_ASCENDING)) u++;
+			
+			if ((u < n2) && (comparison == PINOCCHIO_TIMERANGE_COMPARISON_SAME))
 			{
+				if (mapping) mapping[t] = u;
+				u++;
+			}
+			// identical time ranges in timeline 1 share the same time range of timeline 2
+			// when timeline 2 does not contain as many of them
+			else if ((u > 0) && (helper_pioCompareTimeRanges(tr2[u-1], tr1[t]) == PINOCCHIO_TIMERANGE_COMPARISON_SAME))
+			{
+				if (mapping) mapping[t] = u-1;
+			}
+			else
+			{
+				// timerange 1 is not included in timeline 2
 				result = PINOCCHIO_TIMELINE_COMPARISON_OTHER;
 				break;
 			}
@@ -223,3 +299,316 @@ PIOTimelineComparison pioCompareTimeLines (PIOTimeRange* tr1, int n1, PIOTimeRan
 	
 	return result;
 }
+
+#pragma mark Timeline join
+
+// least common multiple of all scales of timeline (0 if it overflows or a scale is not positive)
+static int64_t helper_pioGetCommonScale( PIOTimeRange* tl, int n, int64_t scale )
+{
+	int t;
+	int64_t factor;
+	
+	for (t=0; t<n; t++)
+	{
+		if ((t > 0) && (tl[t].scale == tl[t-1].scale)) continue;
+		if (tl[t].scale <= 0) return 0;
+		if (scale % tl[t].scale == 0) continue;
+		factor = tl[t].scale / gcd_int64_t(scale, tl[t].scale);
+		if (scale > INT64_MAX / factor) return 0;
+		scale *= factor;
+	}
+	return scale;
+}
+
+// start and stop of every time range, in 1/scale units (0 if it overflows)
+static int helper_pioNormalizeTimeLine( PIOTimeRange* tl, int n, int64_t scale, int64_t* start, int64_t* stop )
+{
+	int t;
+	int64_t factor = 1;
+	int64_t limit = INT64_MAX;
+	int32_t current = 0;
+	
+	int64_t duration;
+	
+	for (t=0; t<n; t++)
+	{
+		if (tl[t].scale != current)
+		{
+			current = tl[t].scale;
+			factor = scale / current;
+			limit = INT64_MAX / factor;
+		}
+		if ((tl[t].time > limit) || (tl[t].time < -limit) ||
+			(tl[t].duration > limit) || (tl[t].duration < -limit)) return 0;
+		start[t] = tl[t].time * factor;
+		duration = tl[t].duration * factor;
+		if ((duration > 0) ? (start[t] > INT64_MAX - duration) : (start[t] < INT64_MIN - duration)) return 0;
+		stop[t] = start[t] + duration;
+	}
+	return 1;
+}
+
+// number of time ranges of first timeline normalized at once
+#define PINOCCHIO_JOIN_BLOCK 4096
+
+int pioJoinTimeLines( PIOTimeRange* tr1, int n1, PIOTimeRange* tr2, int n2, int* first, int* number )
+{
+	int64_t scale;
+	int64_t start1[PINOCCHIO_JOIN_BLOCK];
+	int64_t stop1[PINOCCHIO_JOIN_BLOCK];
+	int64_t* start2 = NULL;
+	int64_t* stop2 = NULL;
+	int normalized = 0;
+	int resume = 0;
+	int t1, t2, b;
+	
+	// common integer scale of both timelines
+	scale = helper_pioGetCommonScale(tr1, n1, 1);
+	if (scale > 0) scale = helper_pioGetCommonScale(tr2, n2, scale);
+	if (scale > 0)
+	{
+		// second timeline is normalized once and for all...
+		start2 = (int64_t*) malloc(2*(n2+1)*sizeof(int64_t));
+		if (!start2) return -1;
+		stop2 = start2 + n2;
+		normalized = helper_pioNormalizeTimeLine(tr2, n2, scale, start2, stop2);
+	}
+	
+	// tr2[t2] intersects tr1[t1] (latest start before earliest stop)
+#define INTERSECTS(t1, t2) \
+	(normalized ? ((start2[t2] < stop1[b]) && (start1[b] < stop2[t2]) && \
+	               (start1[b] < stop1[b]) && (start2[t2] < stop2[t2])) \
+	            : pioTimeRangeIntersectsTimeRange(tr2[t2], tr1[t1]))
+	// tr2[t2] comes after tr1[t1]
+#define AFTER(t1, t2) \
+	(normalized ? ((start2[t2] > start1[b]) || ((start2[t2] == start1[b]) && (stop2[t2] > stop1[b]))) \
+	            : (helper_pioCompareTimeRanges(tr2[t2], tr1[t1]) == PINOCCHIO_TIMERANGE_COMPARISON_DESCENDING))
+	
+	for (t1=0; t1<n1; t1++)
+	{
+		// ... while first one is normalized block by block
+		b = t1 % PINOCCHIO_JOIN_BLOCK;
+		if (normalized && (b == 0))
+			normalized = helper_pioNormalizeTimeLine(tr1+t1, (n1-t1 < PINOCCHIO_JOIN_BLOCK) ? n1-t1 : PINOCCHIO_JOIN_BLOCK, scale, start1, stop1);
+		
+		first[t1] = -1;
+		if (number) number[t1] = 0;
+		
+		// skip time ranges of tr2 before tr1[t1]
+		t2 = resume;
+		while ((t2 < n2) && !AFTER(t1, t2) && !INTERSECTS(t1, t2)) t2++;
+		if ((t2 >= n2) || !INTERSECTS(t1, t2))
+		{
+			// time ranges of tr2 skipped so far cannot intersect later time ranges of tr1...
+			// ... unless tr1[t1] is empty
+			if (normalized ? (stop1[b] > start1[b]) : (tr1[t1].duration > 0)) resume = t2;
+			continue;
+		}
+		
+		// next time range of tr1 may intersect the same time ranges of tr2
+		first[t1] = t2;
+		resume = t2;
+		
+		if (number)
+			while ((t2 < n2) && INTERSECTS(t1, t2))
+			{
+				number[t1]++;
+				t2++;
+			}
+	}
+	
+#undef INTERSECTS
+#undef AFTER
+	
+	free(start2);
+	return 1;
+}
+
+#pragma mark Timeline lookup
+
+int pioGetTimeLineMaximumStops( PIOTimeRange* tl, int n, PIOTime* maxStops )
+{
+	PIOTime stop;
+	int t;
+	
+	for (t=0; t<n; t++)
+	{
+		stop = (PIOTime){tl[t].time+tl[t].duration, tl[t].scale};
+		if ((t == 0) || (helper_pioCompareScaledTimes(stop.time, stop.scale, 
+													  maxStops[t-1].time, maxStops[t-1].scale) > 0))
+			maxStops[t] = stop;
+		else
+			maxStops[t] = maxStops[t-1];
+	}
+	return 1;
+}
+
+// time range t stops before bound (or with it, when strict)
+#define STOPS_BEFORE(t, bound, strict) \
+	(maxStops ? (helper_pioCompareScaledTimes(maxStops[t].time, maxStops[t].scale, (bound).time, (bound).scale) < (strict)) \
+	          : (helper_pioCompareScaledTimes(tl[t].time+tl[t].duration, tl[t].scale, (bound).time, (bound).scale) < (strict)))
+
+int pioFindTimeRangesContainingTime( PIOTimeRange* tl, PIOTime* maxStops, int n, PIOTime time, 
+									 int* indices, int maxIndices )
+{
+	int first, last, t;
+	int number = 0;
+	
+	// time ranges starting after time cannot contain it...
+#define STARTS_NOT_AFTER(t) (helper_pioCompareScaledTimes(tl[t].time, tl[t].scale, time.time, time.scale) <= 0)
+	PINOCCHIO_LOWER_BOUND(tl, n, STARTS_NOT_AFTER, last);
+#undef STARTS_NOT_AFTER
+	
+	// ... neither can time ranges stopping before time (along with all previous ones)
+#define STOPS_BEFORE_TIME(t) STOPS_BEFORE(t, time, 0)
+	PINOCCHIO_LOWER_BOUND(tl, last, STOPS_BEFORE_TIME, first);
+#undef STOPS_BEFORE_TIME
+	
+	for (t=first; t<last; t++)
+		if (helper_pioCompareScaledTimes(tl[t].time+tl[t].duration, tl[t].scale, time.time, time.scale) >= 0)
+		{
+			if (indices && (number < maxIndices)) indices[number] = t;
+			number++;
+		}
+	
+	return number;
+}
+
+int pioFindTimeRangesIntersectingTimeRange( PIOTimeRange* tl, PIOTime* maxStops, int n, PIOTimeRange tr, 
+											int* indices, int maxIndices )
+{
+	PIOTime start = {tr.time, tr.scale};
+	PIOTime stop = {tr.time+tr.duration, tr.scale};
+	int first, last, t;
+	int number = 0;
+	
+	// empty time range intersects nothing
+	if (tr.duration <= 0) return 0;
+	
+	// time ranges starting after tr cannot intersect it...
+#define STARTS_BEFORE_STOP(t) (helper_pioCompareScaledTimes(tl[t].time, tl[t].scale, stop.time, stop.scale) < 0)
+	PINOCCHIO_LOWER_BOUND(tl, n, STARTS_BEFORE_STOP, last);
+#undef STARTS_BEFORE_STOP
+	
+	// ... neither can time ranges stopping before tr (along with all previous ones)
+#define STOPS_BEFORE_START(t) STOPS_BEFORE(t, start, 1)
+	PINOCCHIO_LOWER_BOUND(tl, last, STOPS_BEFORE_START, first);
+#undef STOPS_BEFORE_START
+	
+	for (t=first; t<last; t++)
+		if ((helper_pioCompareScaledTimes(tl[t].time+tl[t].duration, tl[t].scale, start.time, start.scale) > 0) &&
+			(tl[t].duration > 0))
+		{
+			if (indices && (number < maxIndices)) indices[number] = t;
+			number++;
+		}
+	
+	return number;
+}
+
+#undef STOPS_BEFORE
+
+#pragma mark Regular timelines
+
+// a/b rounded down (or up), b > 0
+static inline int64_t helper_pioDivide( int64_t a, int64_t b, int up )
+{
+	int64_t q = a / b;
+	int64_t r = a % b;
+	if ((r < 0) && !up) q--;
+	if ((r > 0) && up) q++;
+	return q;
+}
+
+// tth time range of regular timeline
+#define REGULAR(t) ((PIOTimeRange){first.time + (int64_t)(t)*step, first.duration, first.scale})
+
+int pioIsRegularTimeLine( PIOTimeRange* tl, int n, PIOTimeRange* first, int64_t* step )
+{
+	int t;
+	
+	if ((n < 2) || (tl[0].scale <= 0) || (tl[0].duration < 0)) return 0;
+	if (tl[1].time - tl[0].time <= 0) return 0;
+	
+	for (t=1; t<n; t++)
+		if ((tl[t].scale != tl[0].scale) || (tl[t].duration != tl[0].duration) ||
+			(tl[t].time - tl[t-1].time != tl[1].time - tl[0].time))
+			return 0;
+	
+	if (first) *first = tl[0];
+	if (step) *step = tl[1].time - tl[0].time;
+	return 1;
+}
+
+int pioFindTimeRangeInRegularTimeLine( PIOTimeRange tr, PIOTimeRange first, int64_t step, int n )
+{
+	int64_t t;
+	
+	if (n < 1) return -1;
+	
+	// time ranges start between first and last one...
+	if ((helper_pioCompareScaledTimes(tr.time, tr.scale, first.time, first.scale) < 0) ||
+		(helper_pioCompareScaledTimes(tr.time, tr.scale, REGULAR(n-1).time, first.scale) > 0))
+		return -1;
+	
+	// ... so that the only candidate is the one starting last before tr
+	t = helper_pioDivide(helper_pioRescaleTime(tr.time, tr.scale, first.scale, 0) - first.time, step, 0);
+	if (helper_pioCompareTimeRanges(REGULAR(t), tr) != PINOCCHIO_TIMERANGE_COMPARISON_SAME) return -1;
+	return (int)t;
+}
+
+int pioFindTimeRangesContainingTimeInRegularTimeLine( PIOTimeRange first, int64_t step, int n, PIOTime time, 
+													  int* firstIndex )
+{
+	int64_t lower, upper;
+	
+	if (n < 1) return 0;
+	
+	// time is out of timeline
+	if ((helper_pioCompareScaledTimes(time.time, time.scale, first.time, first.scale) < 0) ||
+		(helper_pioCompareScaledTimes(time.time, time.scale, REGULAR(n-1).time+first.duration, first.scale) > 0))
+		return 0;
+	
+	// time ranges starting before time (start <= floor(time))
+	// and stopping after time (start + duration >= ceil(time))
+	upper = helper_pioDivide(helper_pioRescaleTime(time.time, time.scale, first.scale, 0) - first.time, step, 0);
+	lower = helper_pioDivide(helper_pioRescaleTime(time.time, time.scale, first.scale, 1) - first.duration - first.time, step, 1);
+	if (lower < 0) lower = 0;
+	if (upper > n-1) upper = n-1;
+	
+	if (firstIndex) *firstIndex = (int)lower;
+	return (upper < lower) ? 0 : (int)(upper - lower + 1);
+}
+
+int pioFindTimeRangesIntersectingTimeRangeInRegularTimeLine( PIOTimeRange first, int64_t step, int n, PIOTimeRange tr, 
+															 int* firstIndex )
+{
+	int64_t lower, upper;
+	
+	// empty time ranges intersect nothing
+	if ((n < 1) || (tr.duration <= 0) || (first.duration <= 0)) return 0;
+	
+	// time ranges starting before tr stops (start <= ceil(stop) - 1)
+	if (helper_pioCompareScaledTimes(tr.time+tr.duration, tr.scale, first.time, first.scale) <= 0)
+		return 0;
+	else if (helper_pioCompareScaledTimes(tr.time+tr.duration, tr.scale, REGULAR(n-1).time, first.scale) > 0) 
+		upper = n-1;
+	else
+		upper = helper_pioDivide(helper_pioRescaleTime(tr.time+tr.duration, tr.scale, first.scale, 1) - 1 - first.time, step, 0);
+	
+	// time ranges stopping after tr starts (start + duration >= floor(start) + 1)
+	if (helper_pioCompareScaledTimes(tr.time, tr.scale, first.time, first.scale) < 0)
+		lower = 0;
+	else if (helper_pioCompareScaledTimes(tr.time, tr.scale, REGULAR(n-1).time+first.duration, first.scale) >= 0)
+		return 0;
+	else
+		lower = helper_pioDivide(helper_pioRescaleTime(tr.time, tr.scale, first.scale, 0) + 1 - first.duration - first.time, step, 1);
+	
+	if (lower < 0) lower = 0;
+	if (upper > n-1) upper = n-1;
+	
+	if (firstIndex) *firstIndex = (int)lower;
+	return (upper < lower) ? 0 : (int)(upper - lower + 1);
+}
+
+#undef REGULAR
@@ -27,6 +27,7 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <hdf5_hl.h>
 
 int internalPathToTimeline( const char* path, char** internalPath )
@@ -38,26 +39,22 @@ int internalPathToTimeline( const char* path, char** internalPath )
 	return 1;
 }
 
-hid_t timelineDatatype()
+// Regular timelines are stored as an empty dataset of this opaque type:
+// pinocchIO versions older than 0.5 cannot read it, hence refuse to open them.
+static hid_t regularTimelineDatatype()
 {
-	hid_t timetype;
-	hid_t tInt64, tInt32;
-	
-	timetype = H5Tcreate(H5T_COMPOUND, sizeof(PIOTimeRange));
-	tInt64 = H5Tcopy(H5T_NATIVE_INT64);
-	tInt32 = H5Tcopy(H5T_NATIVE_INT32);
-	H5Tinsert(timetype, "time",     HOFFSET(PIOTimeRange, time) ,    tInt64);
-	H5Tinsert(timetype, "duration", HOFFSET(PIOTimeRange, duration), tInt64);
-	H5Tinsert(timetype, "scale",    HOFFSET(PIOTimeRange, scale),    tInt32);
-	H5Tclose(tInt64); H5Tclose(tInt32);	
-	
-	return timetype;
+	hid_t datatype = H5Tcreate(H5T_OPAQUE, 1);
+	H5Tset_tag(datatype, "pinocchIO regular timeline");
+	return datatype;
 }
 
-PIOTimeline pioNewTimeline(PIOFile pioFile, const char* path, const char* description,
-						   int numberOfTimeRanges, PIOTimeRange* timeranges)
+// timeranges is NULL for regular timelines (described by first and step)
+static PIOTimeline newTimeline(PIOFile pioFile, const char* path, const char* description,
+							   int numberOfTimeRanges, PIOTimeRange* timeranges,
+							   PIOTimeRange first, int64_t step)
 {
 	PIOTimeline pioTimeline;
+	long long regular[5] = { first.time, first.duration, first.scale, step, numberOfTimeRanges };
 
 	int t; // timerange loop index
 	char* internalPath = NULL; // name says it all
@@ -72,7 +69,7 @@ PIOTimeline pioNewTimeline(PIOFile pioFile, const char* path, const char* descri
 	ERROR_SWITCH_INIT
 	
 	// make sure a timeline doesn't already exist at path
-	pioTimeline = pioOpenTimeline(PIOMakeObject(pioFile), path);
+	pioTimeline = pioOpenTimelineWithFlags(PIOMakeObject(pioFile), path, PINOCCHIO_TIMELINE_LAZY);
 	if (PIOTimelineIsValid(pioTimeline))
 	{
 		pioCloseTimeline(&pioTimeline);
@@ -83,7 +80,7 @@ PIOTimeline pioNewTimeline(PIOFile pioFile, const char* path, const char* descri
 	if (!description) return PIOTimelineInvalid;
 	
 	// check if timeranges are sorted in chronological order
-	for (t=1; t<numberOfTimeRanges; t++)
+	for (t=1; timeranges && (t<numberOfTimeRanges); t++)
 		if (pioCompareTimeRanges(timeranges[t-1], timeranges[t]) == PINOCCHIO_TIMERANGE_COMPARISON_DESCENDING)
         {
             fprintf(stderr, "Timeranges should be sorted in chronological order (see timerange %d).\n", t+1);
@@ -99,10 +96,12 @@ PIOTimeline pioNewTimeline(PIOFile pioFile, const char* path, const char* descri
 	H5Pset_create_intermediate_group(linkCreationProperty, 1);	
 
 	// create dataspace
+	// (regular timelines do not store any time range)
+	if (!timeranges) dataspaceMinSize[0] = dataspaceMaxSize[0] = 0;
 	dataspace = H5Screate_simple(1, dataspaceMinSize, dataspaceMaxSize);
 	
 	// create datatype
-	datatype = timelineDatatype();
+	datatype = timeranges ? timelineDatatype() : regularTimelineDatatype();
 	
 	// create dataset
 	ERROR_SWITCH_OFF
@@ -117,8 +116,8 @@ PIOTimeline pioNewTimeline(PIOFile pioFile, const char* path, const char* descri
 	H5Pclose(linkCreationProperty);
 	// close dataspace
 	H5Sclose(dataspace);
-	// close datatype
-	H5Tclose(datatype);
+	// close datatype (timeline datatype is cached)
+	if (!timeranges) H5Tclose(datatype);
 	
 	// check if dataset was created successfully
 	if ( PIOTimelineIsInvalid(pioTimeline)) return PIOTimelineInvalid;
@@ -127,13 +126,14 @@ PIOTimeline pioNewTimeline(PIOFile pioFile, const char* path, const char* descri
 	datatype = timelineDatatype();
 		
 	// dump timeline into dataset
+	// (regular timelines only store first time range, step and number of time ranges)
 	ERROR_SWITCH_OFF
-	write_err = H5Dwrite(pioTimeline.identifier, datatype, H5S_ALL, H5S_ALL, H5P_DEFAULT, timeranges);	
+	if (timeranges)
+		write_err = H5Dwrite(pioTimeline.identifier, datatype, H5S_ALL, H5S_ALL, H5P_DEFAULT, timeranges);	
+	else
+		write_err = H5LTset_attribute_long_long(pioTimeline.identifier, ".", PIOAttribute_Regular, regular, 5);
 	ERROR_SWITCH_ON
 	
-	// close datatype
-	H5Tclose(datatype);
-	
 	// check if write was successfull
 	if (write_err < 0) 
 	{
@@ -165,8 +165,17 @@ PIOTimeline pioNewTimeline(PIOFile pioFile, const char* path, const char* descri
 	
 	// store everything in PIOTimeline structure
 	pioTimeline.ntimeranges = numberOfTimeRanges;
-	pioTimeline.timeranges = malloc(numberOfTimeRanges*sizeof(PIOTimeRange));
-	for (t=0; t<numberOfTimeRanges; t++) pioTimeline.timeranges[t] = timeranges[t];
+	if (timeranges)
+	{
+		pioTimeline.timeranges = malloc(numberOfTimeRanges*sizeof(PIOTimeRange));
+		for (t=0; t<numberOfTimeRanges; t++) pioTimeline.timeranges[t] = timeranges[t];
+	}
+	else
+	{
+		pioTimeline.flags = PINOCCHIO_TIMELINE_LAZY;
+		pioTimeline.first = first;
+		pioTimeline.step = step;
+	}
 	
 	pioTimeline.path = (char*) malloc((strlen(path)+1)*sizeof(char));
 	strncpy( pioTimeline.path, path, strlen(path));
@@ -179,15 +188,47 @@ PIOTimeline pioNewTimeline(PIOFile pioFile, const char* path, const char* descri
 	return pioTimeline;
 }
 
+PIOTimeline pioNewTimeline(PIOFile pioFile, const char* path, const char* description,
+						   int numberOfTimeRanges, PIOTimeRange* timeranges)
+{
+	return newTimeline(pioFile, path, description, numberOfTimeRanges, timeranges, PIOTimeRangeInvalid, 0);
+}
+
+PIOTimeline pioNewRegularTimeline(PIOFile pioFile, const char* path, const char* description,
+								  int numberOfTimeRanges, PIOTimeRange first, int64_t step)
+{
+	int64_t span; // from start of first time range to end of last one
+	
+	if ((numberOfTimeRanges < 1) || (step <= 0) || (first.scale <= 0) || (first.duration < 0))
+		return PIOTimelineInvalid;
+	
+	// end of last time range must fit in 64 bits
+	// (each term is checked separately: first.time may be negative)
+	if ((numberOfTimeRanges > 1) && (step > (INT64_MAX - first.duration) / (numberOfTimeRanges-1)))
+		return PIOTimelineInvalid;
+	span = (int64_t)(numberOfTimeRanges-1)*step + first.duration;
+	if ((first.time > 0) && (span > INT64_MAX - first.time))
+		return PIOTimelineInvalid;
+	
+	return newTimeline(pioFile, path, description, numberOfTimeRanges, NULL, first, step);
+}
+
 PIOTimeline pioOpenTimeline(PIOObject pioObjectInFile, const char* path)
+{
+	return pioOpenTimelineWithFlags(pioObjectInFile, path, PINOCCHIO_TIMELINE_DEFAULT);
+}
+
+PIOTimeline pioOpenTimelineWithFlags(PIOObject pioObjectInFile, const char* path, int flags)
 {
 	PIOTimeline pioTimeline = PIOTimelineInvalid;
 	
 	char* internalPath;
 	hid_t dataspace;
 	hsize_t dimensions[1];
-	hid_t datatype;
-	herr_t read_err;
+	long long regular[5];
+	hsize_t numberOfValues;
+	H5T_class_t typeClass;
+	size_t typeSize;
 	
 	hid_t attr;
 	hsize_t storage;
@@ -209,25 +250,30 @@ PIOTimeline pioOpenTimeline(PIOObject pioObjectInFile, const char* path)
 	// get dataspace extent
 	dataspace = H5Dget_space(pioTimeline.identifier);
 	H5Sget_simple_extent_dims(dataspace, dimensions, NULL);
-	
-	// allocate memory to store timeline data
+	H5Sclose(dataspace);
 	pioTimeline.ntimeranges = dimensions[0];
-	pioTimeline.timeranges = (PIOTimeRange*) malloc(pioTimeline.ntimeranges*sizeof(PIOTimeRange));
+	pioTimeline.flags = flags;
 	
-	// get timeline type
-	datatype = timelineDatatype();
-	
-	// load whole timeline
-	ERROR_SWITCH_OFF
-	read_err = H5Dread(pioTimeline.identifier, datatype, H5S_ALL, H5S_ALL, H5P_DEFAULT, pioTimeline.timeranges);
-	ERROR_SWITCH_ON
-	
-	// close dataspace
-	H5Sclose(dataspace);
-	// close datatype
-	H5Tclose(datatype);
+	// regular timelines are described by their first time range, step 
+	// and number of time ranges (their dataset is empty)
+	if (H5Aexists(pioTimeline.identifier, PIOAttribute_Regular) > 0)
+	{
+		if ((H5LTget_attribute_info(pioTimeline.identifier, ".", PIOAttribute_Regular, 
+									&numberOfValues, &typeClass, &typeSize) < 0) ||
+			(numberOfValues != 5) ||
+			(H5LTget_attribute_long_long(pioTimeline.identifier, ".", PIOAttribute_Regular, regular) < 0) ||
+			(regular[3] <= 0) || (regular[4] < 1) || (regular[4] > INT_MAX))
+		{
+			pioCloseTimeline(&pioTimeline);
+			return PIOTimelineInvalid;
+		}
+		pioTimeline.first = (PIOTimeRange){regular[0], regular[1], (int32_t)regular[2]};
+		pioTimeline.step = regular[3];
+		pioTimeline.ntimeranges = (int)regular[4];
+	}
 	
-	if (read_err < 0)
+	// load whole timeline (unless lazy)
+	if (!(flags & PINOCCHIO_TIMELINE_LAZY) && !pioLoadTimeline(&pioTimeline))
 	{
 		pioCloseTimeline(&pioTimeline);
 		return PIOTimelineInvalid;
@@ -259,6 +305,105 @@ PIOTimeline pioOpenTimeline(PIOObject pioObjectInFile, const char* path)
 	return pioTimeline;
 }
 
+int pioLoadTimeline( PIOTimeline* pioTimeline )
+{
+	PIOTimeRange* timeranges = NULL;
+	
+	if (PIOTimelineIsInvalid(*pioTimeline)) return 0;
+	if (pioTimeline->timeranges) return 1;
+	
+	// (malloc(0) may return NULL)
+	timeranges = (PIOTimeRange*) malloc((pioTimeline->ntimeranges+1)*sizeof(PIOTimeRange));
+	if (pioReadTimeRanges(*pioTimeline, 0, pioTimeline->ntimeranges, timeranges) < 0)
+	{
+		free(timeranges);
+		return 0;
+	}
+	pioTimeline->timeranges = timeranges;
+	
+	// window is no longer needed
+	if (pioTimeline->window) free(pioTimeline->window);
+	pioTimeline->window = NULL;
+	pioTimeline->window_first = 0;
+	pioTimeline->window_length = 0;
+	
+	return 1;
+}
+
+int pioReadTimeRanges( PIOTimeline pioTimeline, int first, int count, PIOTimeRange* timeranges )
+{
+	int t;
+	
+	if (PIOTimelineIsInvalid(pioTimeline)) return -1;
+	if ((first < 0) || (count < 0) || (first+count > pioTimeline.ntimeranges)) return -1;
+	if (count == 0) return 0;
+	
+	// already in memory
+	if (pioTimeline.timeranges)
+	{
+		memcpy(timeranges, pioTimeline.timeranges+first, count*sizeof(PIOTimeRange));
+		return count;
+	}
+	
+	// regular timeline
+	if (pioTimeline.step)
+	{
+		for (t=0; t<count; t++)
+		{
+			timeranges[t] = pioTimeline.first;
+			timeranges[t].time += (int64_t)(first+t)*pioTimeline.step;
+		}
+		return count;
+	}
+	
+	// read consecutive time ranges only
+	if (readHyperslab(pioTimeline.identifier, timelineDatatype(), 
+					  (hsize_t)first, (hsize_t)count, timeranges) < 0) 
+		return -1;
+	return count;
+}
+
+PIOTimeRange pioGetTimeRange( PIOTimeline* pioTimeline, int t )
+{
+	PIOTimeRange timerange;
+	int first;
+	int length;
+	
+	if ((t < 0) || (t >= pioTimeline->ntimeranges)) return PIOTimeRangeInvalid;
+	
+	if (pioTimeline->timeranges) return pioTimeline->timeranges[t];
+	
+	// regular timelines do not need to be read
+	if (pioTimeline->step)
+	{
+		timerange = pioTimeline->first;
+		timerange.time += (int64_t)t*pioTimeline->step;
+		return timerange;
+	}
+	
+	// page in the window containing time range t
+	if (!pioTimeline->window || (t < pioTimeline->window_first) || 
+		(t >= pioTimeline->window_first + pioTimeline->window_length))
+	{
+		if (!pioTimeline->window)
+			pioTimeline->window = (PIOTimeRange*) malloc(PIOTimelineWindowSize*sizeof(PIOTimeRange));
+		
+		first = t - t % PIOTimelineWindowSize;
+		length = pioTimeline->ntimeranges - first;
+		if (length > PIOTimelineWindowSize) length = PIOTimelineWindowSize;
+		
+		if (pioReadTimeRanges(*pioTimeline, first, length, pioTimeline->window) < 0)
+		{
+			pioTimeline->window_length = 0;
+			return PIOTimeRangeInvalid;
+		}
+		pioTimeline->window_first = first;
+		pioTimeline->window_length = length;
+	}
+	
+	return pioTimeline->window[t - pioTimeline->window_first];
+}
+
 int pioCloseTimeline( PIOTimeline* pioTimeline )
 {
 	if (pioTimeline->path) free(pioTimeline->path); 
@@ -270,7 +415,15 @@ int pioCloseTimeline( PIOTimeline* pioTimeline )
 	if (pioTimeline->timeranges) free(pioTimeline->timeranges);
 	pioTimeline->timeranges = NULL;
 	
+	if (pioTimeline->window) free(pioTimeline->window);
+	pioTimeline->window = NULL;
+	pioTimeline->window_first = 0;
+	pioTimeline->window_length = 0;
+	
 	pioTimeline->ntimeranges = -1;
+	pioTimeline->flags = 0;
+	pioTimeline->first = PIOTimeRangeInvalid;
+	pioTimeline->step = 0;
 
     if (pioTimeline->identifier > -1)
         if (H5Dclose(pioTimeline->identifier) < 0) 
@@ -337,6 +490,11 @@ int pioGetListOfTimelines(PIOFile pioFile, char*** pathsToTimelines)
 }
 
 PIOTimeline pioGetTimeline(PIODataset pioDataset)
+{
+	return pioGetTimelineWithFlags(pioDataset, PINOCCHIO_TIMELINE_DEFAULT);
+}
+
+PIOTimeline pioGetTimelineWithFlags(PIODataset pioDataset, int flags)
 {
 	hid_t attr;
 	hsize_t storage;
@@ -351,20 +509,60 @@ PIOTimeline pioGetTimeline(PIODataset pioDataset)
 	H5LTget_attribute_string(pioDataset.identifier, ".", PIOAttribute_Timeline, path2timeline);
 	
 	// open timeline
-	pioTimeline = pioOpenTimeline(PIOMakeObject(pioDataset), path2timeline);
+	pioTimeline = pioOpenTimelineWithFlags(PIOMakeObject(pioDataset), path2timeline, flags);
 	
 	free(path2timeline);
 	
 	return pioTimeline;
 }
 
+// compare timelines, without loading them when both are regular
+static PIOTimelineComparison compareTimelines(PIOTimeline* tl1, PIOTimeline* tl2)
+{
+    PIOTimeRange second;
+    int64_t k0, k1;
+    
+    if (tl1->ntimeranges > tl2->ntimeranges)
+    {
+        // switch roles of tl1 and tl2
+        if (compareTimelines(tl2, tl1) == PINOCCHIO_TIMELINE_COMPARISON_SUBSET)
+            return PINOCCHIO_TIMELINE_COMPARISON_SUPERSET;
+        return PINOCCHIO_TIMELINE_COMPARISON_OTHER;
+    }
+    
+    if (tl1->step && tl2->step)
+    {
+        // first two time ranges of tl1 are found in tl2 (k0, k1)...
+        k0 = pioFindTimeRangeInRegularTimeLine(tl1->first, tl2->first, tl2->step, tl2->ntimeranges);
+        if (k0 < 0) return PINOCCHIO_TIMELINE_COMPARISON_OTHER;
+        k1 = k0+1;
+        if (tl1->ntimeranges > 1)
+        {
+            second = tl1->first;
+            second.time += tl1->step;
+            k1 = pioFindTimeRangeInRegularTimeLine(second, tl2->first, tl2->step, tl2->ntimeranges);
+            if (k1 < 0) return PINOCCHIO_TIMELINE_COMPARISON_OTHER;
+        }
+        
+        // ... so are the next ones, every (k1-k0) time ranges, as long as tl2 is long enough
+        if (k0 + (tl1->ntimeranges-1)*(k1-k0) >= tl2->ntimeranges) return PINOCCHIO_TIMELINE_COMPARISON_OTHER;
+        if (tl1->ntimeranges == tl2->ntimeranges) return PINOCCHIO_TIMELINE_COMPARISON_SAME;
+        return PINOCCHIO_TIMELINE_COMPARISON_SUBSET;
+    }
+    
+    if (!pioLoadTimeline(tl1) || !pioLoadTimeline(tl2)) return PINOCCHIO_TIMELINE_COMPARISON_OTHER;
+    return pioCompareTimeLines(tl1->timeranges, tl1->ntimeranges, tl2->timeranges, tl2->ntimeranges);
+}
+
 int pioCopyTimeline(const char* timeline_path, PIOFile pioInputFile, PIOFile pioOutputFile)
 {
     PIOTimeline pioInputTimeline = PIOTimelineInvalid;
     PIOTimeline pioOutputTimeline = PIOTimelineInvalid;
+    PIOTimelineComparison comparison;
     
     // open input timeline
-    pioInputTimeline = pioOpenTimeline(PIOMakeObject(pioInputFile), timeline_path);
+    // (time ranges are only loaded when needed: regular timelines are copied as such)
+    pioInputTimeline = pioOpenTimelineWithFlags(PIOMakeObject(pioInputFile), timeline_path, PINOCCHIO_TIMELINE_LAZY);
     if (PIOTimelineIsInvalid(pioInputTimeline))
     {
         // Cannot open input timeline
@@ -372,12 +570,15 @@ int pioCopyTimeline(const char* timeline_path, PIOFile pioInputFile, PIOFile pio
     }
     
     // check if a timeline with same path already exists
-    pioOutputTimeline = pioOpenTimeline(PIOMakeObject(pioOutputFile), pioInputTimeline.path);
+    pioOutputTimeline = pioOpenTimelineWithFlags(PIOMakeObject(pioOutputFile), pioInputTimeline.path, 
+                                                 PINOCCHIO_TIMELINE_LAZY);
     if (PIOTimelineIsValid(pioOutputTimeline))
     {
         // if so, compare existing timeline with to-be-copied timeline
-        if (pioCompareTimeLines(pioInputTimeline.timeranges, pioInputTimeline.ntimeranges,
-                                pioOutputTimeline.timeranges, pioOutputTimeline.ntimeranges) != PINOCCHIO_TIMELINE_COMPARISON_SAME)
+        // (it may contain more time ranges than the to-be-copied one)
+        comparison = compareTimelines(&pioInputTimeline, &pioOutputTimeline);
+        if ((comparison != PINOCCHIO_TIMELINE_COMPARISON_SAME) &&
+            (comparison != PINOCCHIO_TIMELINE_COMPARISON_SUBSET))
         {
             // Timeline exists at same path
             // but is different
@@ -389,8 +590,13 @@ int pioCopyTimeline(const char* timeline_path, PIOFile pioInputFile, PIOFile pio
     else 
     {
         // otherwise, try and create new timeline
-        pioOutputTimeline = pioNewTimeline(pioOutputFile, pioInputTimeline.path, pioInputTimeline.description,
-                                           pioInputTimeline.ntimeranges, pioInputTimeline.timeranges);
+        if (pioInputTimeline.step)
+            pioOutputTimeline = pioNewRegularTimeline(pioOutputFile, pioInputTimeline.path, pioInputTimeline.description,
+                                                      pioInputTimeline.ntimeranges, 
+                                                      pioInputTimeline.first, pioInputTimeline.step);
+        else if (pioLoadTimeline(&pioInputTimeline))
+            pioOutputTimeline = pioNewTimeline(pioOutputFile, pioInputTimeline.path, pioInputTimeline.description,
+                                               pioInputTimeline.ntimeranges, pioInputTimeline.timeranges);
         if (PIOTimelineIsInvalid(pioOutputTimeline))
         {
             // Cannot create timeline in output file
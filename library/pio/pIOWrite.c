@@ -21,70 +21,39 @@
 #include "pIOWrite.h"
 
 #include "pIODataset.h"
+#include "pIODatatype.h"
 #include "structure_utils.h"
 
-int pioWrite(PIODataset* pioDataset, int timerangeIndex, 
+#include <stdlib.h>
+#include <string.h>
+
+// Write data and link straight to disk (no writer)
+int writeNow(PIODataset* pioDataset, int timerangeIndex, 
 			 void* dataBuffer, int dataNumber, PIODatatype dataType)
 {
-	ERROR_SWITCH_INIT
-	herr_t extend_err;
-	herr_t write_err;
-	
-	hsize_t newExtent[1] = {-1};
-	
-	hsize_t position[1] = {-1};
-	hsize_t number[1] = {-1};
-	
-	hid_t dataspaceForData = -1;
-	hid_t bufferDataspaceForData = -1;
-
 	link_t link = {-1, -1};
-	hid_t dataspaceForLink = -1;
-	hid_t bufferDataspaceForLink = -1;
-	hid_t link_datatype = -1;
 
-    if (dataNumber < 0) return -1;
-	if (!(timerangeIndex<pioDataset->ntimeranges)) return -1;
-	
     if (dataNumber > 0)
     {
         // extend dataset
-        newExtent[0] = (hsize_t)(pioDataset->stored + dataNumber);
-        ERROR_SWITCH_OFF
-        extend_err = H5Dextend(pioDataset->identifier, newExtent);
-        ERROR_SWITCH_ON
-        if (extend_err < 0) return -1;	
+        if (extendDataset(*pioDataset, (hsize_t)(pioDataset->stored + dataNumber)) < 0) 
+            return -1;	
 	
         // append data to dataset
-        position[0] = (hsize_t)pioDataset->stored;
-        number[0] = (hsize_t)dataNumber;
-        dataspaceForData = H5Dget_space(pioDataset->identifier);
-        H5Sselect_hyperslab(dataspaceForData, H5S_SELECT_SET, position, NULL, number, NULL);
-        bufferDataspaceForData = H5Screate_simple(1, number, NULL);
-        ERROR_SWITCH_OFF
-        write_err = H5Dwrite(pioDataset->identifier, dataType.identifier, bufferDataspaceForData, dataspaceForData, H5P_DEFAULT, dataBuffer);
-        ERROR_SWITCH_ON
-        H5Sclose(bufferDataspaceForData);
-        H5Sclose(dataspaceForData);
-        if (write_err < 0) return -1;
+        if (writeHyperslab(pioDataset->identifier, dataType.identifier, 
+                           (hsize_t)pioDataset->stored, (hsize_t)dataNumber, dataBuffer) < 0)
+            return -1;
     }
 	
 	// update link dataset
 	link.number = dataNumber;
 	link.position = pioDataset->stored;
-	position[0] = timerangeIndex;
-	number[0] = 1;
-	dataspaceForLink = H5Dget_space(pioDataset->link_identifier);
-	H5Sselect_hyperslab(dataspaceForLink, H5S_SELECT_SET, position, NULL, number, NULL);
-	bufferDataspaceForLink = H5Screate_simple(1, number, NULL);
-	link_datatype = linkDatatype();
-	ERROR_SWITCH_OFF
-	write_err = H5Dwrite(pioDataset->link_identifier, link_datatype, bufferDataspaceForLink, dataspaceForLink, H5P_DEFAULT, &link);
-	ERROR_SWITCH_ON
-	H5Tclose(link_datatype);
-	H5Sclose(bufferDataspaceForLink);
-	H5Sclose(dataspaceForLink);
-	if (write_err < 0) return -1;
+	if (writeHyperslab(pioDataset->link_identifier, linkDatatype(), 
+					   (hsize_t)timerangeIndex, 1, &link) < 0) 
+		return -1;
+	
+	// keep in-memory link table up to date
+	if (pioDataset->links) pioDataset->links[timerangeIndex] = link;
 	
 	// update dataset
 	pioDataset->stored = pioDataset->stored + dataNumber;
@@ -92,5 +61,238 @@ int pioWrite(PIODataset* pioDataset, int timerangeIndex,
 	return dataNumber;
 }
 
+// Flush writer buffers, then write data and link straight to disk
+// (data too large for the writer, or writer buffers that cannot grow)
+static int flushAndWriteNow(PIODataset* pioDataset, int timerangeIndex, 
+							void* dataBuffer, int dataNumber, PIODatatype dataType)
+{
+	if (flushDatasetWriter(*pioDataset) < 0) return -1;
+	if (writeNow(pioDataset, timerangeIndex, dataBuffer, dataNumber, dataType) < 0) 
+		return -1;
+	pioDataset->writer->flushed = pioDataset->stored;
+	return dataNumber;
+}
 
+// Append data and link to writer buffers (flushing them first if needed)
+int writeBuffered(PIODataset* pioDataset, int timerangeIndex, 
+				  void* dataBuffer, int dataNumber, PIODatatype dataType)
+{
+	PIODatasetWriter* writer = pioDataset->writer;
+	size_t entry_size = pioGetSize(dataType);
+	size_t data_size = dataNumber*entry_size;
+	size_t new_size = 0;
+	void* data = NULL;
+	link_t* links = NULL;
+	int* indices = NULL;
+	int links_size = 0;
+	
+	// one batch only contains data of one datatype,
+	// and links for strictly increasing time ranges
+	if (writer->nlinks > 0)
+	{
+		if ((writer->number > 0) && (dataNumber > 0) && 
+			(writer->datatype != dataType.identifier) &&
+			(H5Tequal(writer->datatype, dataType.identifier) <= 0))
+			if (flushDatasetWriter(*pioDataset) < 0) return -1;
+		if ((writer->nlinks > 0) && 
+			(timerangeIndex <= writer->indices[writer->nlinks-1]))
+			if (flushDatasetWriter(*pioDataset) < 0) return -1;
+	}
+	
+	// flush when memory budget would be exceeded
+	if (writer->number*writer->entry_size + data_size + 
+		(writer->nlinks+1)*(sizeof(link_t)+sizeof(int)) > writer->budget)
+		if (flushDatasetWriter(*pioDataset) < 0) return -1;
+	
+	// data that would not fit in an empty writer are written directly
+	if (data_size + sizeof(link_t) + sizeof(int) > writer->budget)
+		return flushAndWriteNow(pioDataset, timerangeIndex, dataBuffer, dataNumber, dataType);
+	
+	// buffer data
+	if (dataNumber > 0)
+	{
+		if (writer->number == 0)
+		{
+			if (writer->datatype > -1) H5Tclose(writer->datatype);
+			writer->datatype = H5Tcopy(dataType.identifier);
+			writer->entry_size = entry_size;
+		}
+		
+		if (writer->number*entry_size + data_size > writer->data_size)
+		{
+			new_size = 2*writer->data_size;
+			if (new_size < writer->number*entry_size + data_size) 
+				new_size = writer->number*entry_size + data_size;
+			if (new_size > writer->budget) new_size = writer->budget;
+			// keep buffered data if buffer cannot grow
+			data = realloc(writer->data, new_size);
+			if (data == NULL)
+				return flushAndWriteNow(pioDataset, timerangeIndex, dataBuffer, dataNumber, dataType);
+			writer->data = data;
+			writer->data_size = new_size;
+		}
+		memcpy(writer->data + writer->number*entry_size, dataBuffer, data_size);
+	}
+	
+	// buffer link
+	if (writer->nlinks == writer->links_size)
+	{
+		// keep buffered links if buffers cannot grow
+		links_size = (writer->links_size > 0) ? 2*writer->links_size : 256;
+		links = (link_t*) realloc(writer->links, links_size*sizeof(link_t));
+		if (links == NULL)
+			return flushAndWriteNow(pioDataset, timerangeIndex, dataBuffer, dataNumber, dataType);
+		writer->links = links;
+		indices = (int*) realloc(writer->indices, links_size*sizeof(int));
+		if (indices == NULL)
+			return flushAndWriteNow(pioDataset, timerangeIndex, dataBuffer, dataNumber, dataType);
+		writer->indices = indices;
+		writer->links_size = links_size;
+	}
+	writer->links[writer->nlinks].position = writer->flushed + writer->number;
+	writer->links[writer->nlinks].number = dataNumber;
+	writer->indices[writer->nlinks] = timerangeIndex;
+	
+	// keep in-memory link table up to date
+	if (pioDataset->links) pioDataset->links[timerangeIndex] = writer->links[writer->nlinks];
+	
+	writer->nlinks++;
+	writer->number += dataNumber;
+	
+	// update dataset
+	pioDataset->stored = pioDataset->stored + dataNumber;
+	
+	return dataNumber;
+}
 
+int pioWrite(PIODataset* pioDataset, int timerangeIndex, 
+			 void* dataBuffer, int dataNumber, PIODatatype dataType)
+{
+    if (dataNumber < 0) return -1;
+	if (!(timerangeIndex<pioDataset->ntimeranges)) return -1;
+	
+	if (pioDataset->writer)
+		return writeBuffered(pioDataset, timerangeIndex, dataBuffer, dataNumber, dataType);
+	
+	return writeNow(pioDataset, timerangeIndex, dataBuffer, dataNumber, dataType);
+}
+
+int flushDatasetWriter(PIODataset pioDataset)
+{
+	ERROR_SWITCH_INIT
+	herr_t write_err;
+	
+	PIODatasetWriter* writer = pioDataset.writer;
+	
+	hsize_t number[1] = {-1};
+	hsize_t* coordinates = NULL;
+	hid_t fileDataspace = -1;
+	hid_t memoryDataspace = -1;
+	
+	int l;
+	int contiguous;
+	
+	if (writer == NULL) return 0;
+	if (writer->nlinks == 0) return 0;
+	
+	if (writer->number > 0)
+	{
+		// extend dataset once for the whole batch
+		if (extendDataset(pioDataset, (hsize_t)(writer->flushed + writer->number)) < 0) 
+			return -1;
+		
+		// append buffered data to dataset
+		if (writeHyperslab(pioDataset.identifier, writer->datatype, 
+						   (hsize_t)writer->flushed, (hsize_t)writer->number, writer->data) < 0)
+			return -1;
+	}
+	
+	// write buffered links
+	// (hyperslab when they are consecutive, list of points otherwise)
+	contiguous = (writer->indices[writer->nlinks-1] - writer->indices[0] == writer->nlinks-1);
+	if (contiguous)
+	{
+		if (writeHyperslab(pioDataset.link_identifier, linkDatatype(), 
+						   (hsize_t)writer->indices[0], (hsize_t)writer->nlinks, writer->links) < 0)
+			return -1;
+	}
+	else
+	{
+		coordinates = (hsize_t*) malloc(writer->nlinks*sizeof(hsize_t));
+		for (l=0; l<writer->nlinks; l++) coordinates[l] = (hsize_t)writer->indices[l];
+		number[0] = (hsize_t)writer->nlinks;
+		
+		ERROR_SWITCH_OFF
+		fileDataspace = H5Dget_space(pioDataset.link_identifier);
+		memoryDataspace = H5Screate_simple(1, number, NULL);
+		H5Sselect_elements(fileDataspace, H5S_SELECT_SET, writer->nlinks, coordinates);
+		write_err = H5Dwrite(pioDataset.link_identifier, linkDatatype(), 
+							 memoryDataspace, fileDataspace, H5P_DEFAULT, writer->links);
+		H5Sclose(memoryDataspace);
+		H5Sclose(fileDataspace);
+		ERROR_SWITCH_ON
+		
+		free(coordinates);
+		if (write_err < 0) return -1;
+	}
+	
+	// empty writer
+	writer->flushed = writer->flushed + writer->number;
+	writer->number = 0;
+	writer->nlinks = 0;
+	
+	return 1;
+}
+
+int pioNewDatasetWriter(PIODataset* pioDataset, size_t budget)
+{
+	PIODatasetWriter* writer = NULL;
+	
+	if (PIODatasetIsInvalid(*pioDataset)) return -1;
+	if (pioDataset->writer) return -1;
+	
+	writer = (PIODatasetWriter*) malloc(sizeof(PIODatasetWriter));
+	if (writer == NULL) return -1;
+	
+	writer->budget = (budget > 0) ? budget : PIODatasetWriterDefaultBudget;
+	writer->datatype = -1;
+	writer->entry_size = 0;
+	writer->data = NULL;
+	writer->data_size = 0;
+	writer->number = 0;
+	writer->flushed = pioDataset->stored;
+	writer->links = NULL;
+	writer->indices = NULL;
+	writer->nlinks = 0;
+	writer->links_size = 0;
+	
+	pioDataset->writer = writer;
+	return 1;
+}
+
+int pioFlushDatasetWriter(PIODataset* pioDataset)
+{
+	if (pioDataset->writer == NULL) return -1;
+	if (flushDatasetWriter(*pioDataset) < 0) return -1;
+	return 1;
+}
+
+int pioCloseDatasetWriter(PIODataset* pioDataset)
+{
+	PIODatasetWriter* writer = pioDataset->writer;
+	int flush_err;
+	
+	if (writer == NULL) return 0;
+	
+	flush_err = flushDatasetWriter(*pioDataset);
+	
+	if (writer->datatype > -1) H5Tclose(writer->datatype);
+	if (writer->data) free(writer->data);
+	if (writer->links) free(writer->links);
+	if (writer->indices) free(writer->indices);
+	free(writer);
+	pioDataset->writer = NULL;
+	
+	if (flush_err < 0) return 0;
+	return 1;
+}
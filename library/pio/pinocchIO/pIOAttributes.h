@@ -93,6 +93,19 @@
  */
 #define PIOAttribute_Timeline     "timeline"
 
+/**
+ @brief Name of the HDF5 attributes meant to store regular timelines
+ 
+ Regular timelines (see pioNewRegularTimeline()) do not store their time ranges:
+ their first time range, the step between two time ranges and their number of 
+ time ranges are stored instead, as an HDF5 attribute (time, duration, scale, step, number).
+ The name of this HDF5 attribute is defined here.
+ 
+ @note
+ This is a @ref PIOAttribute_ListProtected "protected" attribute.
+ */
+#define PIOAttribute_Regular      "regular"
+
 /**
  @brief Number of protected attributes
  
@@ -101,7 +114,7 @@
  The list of protected attributes is stored in @ref PIOAttribute_ListProtected,
  the length of which is defined here.
  */
-#define PIOAttribute_NumberProtected 5
+#define PIOAttribute_NumberProtected 6
 
 /**
  @brief Check protection of attribute
@@ -91,12 +91,55 @@
  
  @note
  Use pioCloseDataset() to close the timeline when no longer needed. 
+ 
+ @note
+ Storage uses \ref PIODatasetOptionsDefault. 
+ See pioNewDatasetWithOptions() for more control.
  */
 PIODataset pioNewDataset(PIOFile pioFile,
 						 const char* path, const char* description,
 						 PIOTimeline pioTimeline,
 						 PIODatatype pioDatatype);
 
+/**
+ @brief Create new pinocchIO dataset with storage options
+ 
+ Same as pioNewDataset() except that the HDF5 storage layout is driven by \a pioOptions.
+ 
+ - Data are stored in chunks of about \a pioOptions.chunk_size bytes 
+ (the number of entries per chunk is deduced from the size of \a pioDatatype).
+ - Links are stored in chunks of about \a pioOptions.link_chunk_size bytes 
+ (but never more than the number of time ranges in \a pioTimeline), 
+ or contiguously if \a pioOptions.link_chunk_size is 0.
+ - Chunks are compressed with deflate at level \a pioOptions.compression (1 to 9),
+ after byte-shuffling if \a pioOptions.shuffle is TRUE. 
+ Use 0 to disable compression.
+ 
+ Use small chunks for datasets that are mostly accessed randomly, 
+ and large ones for datasets that are mostly written and read sequentially.
+ Compression works on whole chunks: reading one time range requires the whole
+ chunk containing it to be decompressed.
+ 
+ @param[in] pioFile pinocchIO file handle
+ @param[in] path Internal path to the new dataset
+ @param[in] description Textual description of the new dataset
+ @param[in] pioTimeline Dataset timeline
+ @param[in] pioDatatype Dataset datatype
+ @param[in] pioOptions Dataset storage options
+ @returns 
+ - a pinocchIO dataset handle when successful
+ - \ref PIODatasetInvalid otherwise (including when requested compression
+ is not available in the HDF5 library)
+ 
+ @note
+ Use pioCloseDataset() to close the timeline when no longer needed. 
+ */
+PIODataset pioNewDatasetWithOptions(PIOFile pioFile,
+									const char* path, const char* description,
+									PIOTimeline pioTimeline,
+									PIODatatype pioDatatype,
+									PIODatasetOptions pioOptions);
+
 /**
  @brief Open pinocchIO dataset
  
@@ -115,6 +158,43 @@ PIODataset pioNewDataset(PIOFile pioFile,
  */
 PIODataset pioOpenDataset(PIOObject pioObject, const char* path);
 
+/**
+ @brief Open pinocchIO dataset with flags
+ 
+ Same as pioOpenDataset() except that the behavior of the 
+ dataset handle can be tuned with \a flags (see \ref PIODatasetFlags).
+ 
+ For instance, the following keeps the whole link table in memory,
+ making pioReadData() and pioReadNumber() one HDF5 read cheaper:
+\verbatim
+ PIODataset dataset = pioOpenDatasetWithFlags(PIOMakeObject(pioFile), path,
+                                              PINOCCHIO_DATASET_PRELOAD_LINKS);
+\endverbatim
+ 
+ @param[in] pioObject PIOObject stored in the same file as requested timeline 
+ @param[in] path Path to the existing pinocchIO dataset
+ @param[in] flags Combination of \ref PIODatasetFlags
+ @returns
+ - a pinocchIO dataset handle when successful
+ - \ref PIODatasetInvalid otherwise
+ 
+ @note
+ The in-memory link table is kept up to date by pioWrite(). 
+ With \ref PINOCCHIO_DATASET_CACHE_LINKS, it is loaded by the first call to 
+ pioReadData(), pioReadRange() or pioDumpDataset() -- functions that take the dataset 
+ handle by value (such as pioReadNumber()) use it once it is loaded.
+ 
+ @note
+ With \ref PINOCCHIO_DATASET_MMAP, data of sealed datasets (see pioSealDataset()) 
+ are memory-mapped: reading them no longer involves HDF5 or any system call.
+ Datasets that are not sealed (or stored in files not opened with the default 
+ HDF5 file driver) are silently read the usual way.
+ 
+ @note
+ Use pioCloseDataset() to close the dataset when no longer needed. 
+ */
+PIODataset pioOpenDatasetWithFlags(PIOObject pioObject, const char* path, int flags);
+
 /**
  @brief Close pinocchIO dataset
  
@@ -149,6 +229,29 @@ int pioCloseDataset(PIODataset* pioDataset);
  */    
 int pioRemoveDataset(PIOObject pioObject, const char* path);
 
+/**
+ @brief Seal pinocchIO dataset
+ 
+ Rewrite data of the pinocchIO dataset at internal location \a path 
+ into one contiguous, uncompressed and fixed-size HDF5 dataset.\n
+ Sealed datasets can be memory-mapped (see \ref PINOCCHIO_DATASET_MMAP) 
+ but can no longer be written to.
+ 
+ @param[in] pioObject PIOObject stored in the same file as requested dataset 
+ @param[in] path Path to the pinocchIO dataset to be sealed
+ @returns
+ - 1 if dataset was successfully sealed (or was already sealed)
+ - 0 otherwise
+ 
+ @note
+ The dataset must not be opened elsewhere while being sealed.
+ Space used by the original data is not reclaimed by HDF5: 
+ use h5repack to shrink the file afterwards if needed.
+ 
+ @ingroup file
+ */    
+int pioSealDataset(PIOObject pioObject, const char* path);
+
 /**
  @brief Get list of pinocchIO datasets
  
@@ -197,10 +300,35 @@ int pioGetListOfDatasets(PIOFile pioFile, char*** pathsToDatasets);
  pioCopyDataset() will return FALSE, even if input and output datasets are
  identical.
  
+ @note
+ In case the @a output file already contains a timeline with more time ranges 
+ than the one of the input dataset (see pioCopyTimeline()), data are copied into 
+ their matching time ranges and the other ones are left empty.
+ 
  @ingroup file
  */
 int pioCopyDataset(const char* path, PIOFile input, PIOFile output);
 
+/**
+ @brief Copy a dataset from one file to another one with storage options
+ 
+ Same as pioCopyDataset() except that the output dataset is created 
+ with pioNewDatasetWithOptions(). 
+ This is typically used to (re)compress an existing dataset.
+ 
+ @param[in] path Path to dataset
+ @param[in] input Input file
+ @param[in] output Output file
+ @param[in] options Output dataset storage options
+ @returns 
+ - TRUE when successful
+ - FALSE otherwise
+ 
+ @ingroup file
+ */
+int pioCopyDatasetWithOptions(const char* path, PIOFile input, PIOFile output,
+                              PIODatasetOptions options);
+
 
 #endif
 
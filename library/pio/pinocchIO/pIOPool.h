@@ -0,0 +1,164 @@
+// 
+// Copyright 2010 Herve BREDIN (bredin@limsi.fr)
+// Contact: http://pinocchio.niderb.fr/
+// 
+// This file is part of pinocchIO.
+//  
+//      pinocchIO is free software: you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation, either version 3 of the License, or
+//      (at your option) any later version.
+//  
+//      pinocchIO is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//  
+//      You should have received a copy of the GNU General Public License
+//      along with pinocchIO. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+/**
+ \defgroup pool Handle pool API
+ \ingroup api
+ 
+ @brief Keep pinocchIO files and datasets open between uses
+ 
+ Opening a pinocchIO file means opening the HDF5 file and reading its medium
+ and version attributes. Opening a dataset also reads its description and
+ (depending on \ref PIODatasetFlags) its whole link table. Applications that
+ go back and forth between many files pay this price again and again.
+ 
+ A pool keeps read-only files and datasets open once they have been used, 
+ up to a maximum number of open files. Handles are reference counted: 
+ pioPoolOpenFile() and pioPoolOpenDataset() return the pooled handle and
+ pioPoolReleaseFile() and pioPoolReleaseDataset() give it back. Once the pool
+ is full, the least recently used file that is no longer referenced is closed
+ (along with its datasets) to make room for the next one.
+ 
+\verbatim
+PIOPool* pool = pioNewPool(16);
+PIODataset* dataset = NULL;
+ 
+for (f=0; f<numberOfFiles; f++)
+{
+    dataset = pioPoolOpenDataset(pool, path[f], "features", PINOCCHIO_DATASET_PRELOAD_LINKS);
+    if (!dataset) continue;
+    number = pioRead(dataset, t, datatype, &buffer);
+    pioPoolReleaseDataset(pool, dataset);
+}
+ 
+pioClosePool(&pool);
+\endverbatim
+ 
+ Pooled handles must not be closed with pioCloseFile() or pioCloseDataset().
+ Like the rest of the pinocchIO API, pools are not thread-safe.
+ 
+ @{
+ */
+
+#ifndef _PINOCCHIO_POOL_H
+#define _PINOCCHIO_POOL_H
+
+#include "pIOTypes.h"
+
+/**
+ @brief Create new pool of pinocchIO handles
+ 
+ @param[in] maximumNumberOfFiles Maximum number of files kept open
+ @returns
+ - new pool when successful
+ - NULL otherwise
+ 
+ @note
+ More files are open as long as they are all referenced:
+ the pool shrinks back as soon as they are released.
+ 
+ @note
+ Use pioClosePool() to close the pool (and every handle it contains) when no longer needed.
+ */
+PIOPool* pioNewPool(int maximumNumberOfFiles);
+
+/**
+ @brief Close pool of pinocchIO handles
+ 
+ Close every file and dataset of the pool, and the pool itself.
+ Upon success, @a pool is set to NULL.
+ 
+ @param[in,out] pool Pool of pinocchIO handles
+ @returns
+ - 1 when every file is successfully closed
+ - 0 otherwise
+ */
+int pioClosePool(PIOPool** pool);
+
+/**
+ @brief Open pinocchIO file from pool
+ 
+ Get read-only pinocchIO file at location @a path, opening it only 
+ if it is not already in the pool.
+ 
+ @param[in,out] pool Pool of pinocchIO handles
+ @param[in] path Path to the existing pinocchIO file
+ @returns
+ - pooled pinocchIO file handle when successful
+ - NULL otherwise
+ 
+ @note
+ Use pioPoolReleaseFile() when the file is no longer needed.
+ */
+PIOFile* pioPoolOpenFile(PIOPool* pool, const char* path);
+
+/**
+ @brief Open pinocchIO dataset from pool
+ 
+ Get the pinocchIO dataset at internal location @a pathToDataset in 
+ read-only pinocchIO file at location @a path, opening them only 
+ if they are not already in the pool.
+ 
+ A pooled dataset opened with fewer @a flags is reopened with 
+ both sets of flags when it is not referenced anymore. Otherwise, 
+ the dataset is opened once more, with both sets of flags: 
+ the returned dataset always has (at least) the requested @a flags.
+ 
+ @param[in,out] pool Pool of pinocchIO handles
+ @param[in] path Path to the existing pinocchIO file
+ @param[in] pathToDataset Path to the existing pinocchIO dataset
+ @param[in] flags Combination of \ref PIODatasetFlags
+ @returns
+ - pooled pinocchIO dataset handle when successful
+ - NULL otherwise
+ 
+ @note
+ Use pioPoolReleaseDataset() when the dataset is no longer needed.
+ */
+PIODataset* pioPoolOpenDataset(PIOPool* pool, const char* path, const char* pathToDataset, int flags);
+
+/**
+ @brief Release pooled pinocchIO file
+ 
+ @param[in,out] pool Pool of pinocchIO handles
+ @param[in] file Handle returned by pioPoolOpenFile()
+ @returns
+ - 1 when successful
+ - 0 if @a file does not come from @a pool
+ */
+int pioPoolReleaseFile(PIOPool* pool, PIOFile* file);
+
+/**
+ @brief Release pooled pinocchIO dataset
+ 
+ @param[in,out] pool Pool of pinocchIO handles
+ @param[in] dataset Handle returned by pioPoolOpenDataset()
+ @returns
+ - 1 when successful
+ - 0 if @a dataset does not come from @a pool
+ */
+int pioPoolReleaseDataset(PIOPool* pool, PIODataset* dataset);
+
+/**
+	@}
+ */
+
+#endif
@@ -35,6 +35,12 @@
  Typically, one would call pioReadData() and then copy the buffer content 
  into another variable before calling pioReadData() again.
  
+ @note
+ When @a dataset is memory-mapped (see \ref PINOCCHIO_DATASET_MMAP) and @a datatype 
+ matches @a dataset datatype exactly, @a buffer points directly into the mapped data
+ (no copy, no system call). It remains valid until the dataset is closed. 
+ Modifying it is allowed but does not modify the file.
+ 
  @param[in,out] dataset pinocchIO dataset
  @param[in] timerangeIndex Index of timerange
  @param[in] datatype Buffer datatype
@@ -71,6 +77,107 @@ int pioReadData(PIODataset* dataset,
  */
 #define pioRead pioReadData
 
+/**
+ @brief Read data stored in dataset for a range of consecutive time ranges
+ 
+ Update @a buffer so that it points to data stored in @a dataset for the 
+ @a count time ranges starting at position @a firstTimerange in @a dataset timeline.
+ 
+ Entries are stored in the buffer the one after the other, sorted in time 
+ range chronological order. Their number per time range are stored in 
+ array @a number if it is not NULL.
+ 
+ Links are read at once and, as long as data for these time ranges are stored 
+ contiguously (which is the case when they were written in chronological order),
+ data are also read at once. This is much faster than calling pioReadData() 
+ for each time range.
+ 
+ @note
+ pinocchIO uses the same internal buffer as pioReadData(). <b>Do not free it!</b>\n
+ This buffer is modified (and possibly moved) by each call to pioReadData() or pioReadRange().
+ 
+ @param[in,out] dataset pinocchIO dataset
+ @param[in] firstTimerange Index of first timerange
+ @param[in] count Number of time ranges
+ @param[in] datatype Buffer datatype
+ @param[out] buffer Data buffer
+ @param[out] number Number of entries per time range (array of size @a count, or NULL)
+ 
+ @returns
+ - total number of entries when successful
+ - negative value otherwise
+ 
+\par Example
+\verbatim
+ int* number = (int*) malloc(count*sizeof(int));
+ int64_t totalNumber = pioReadRange(&dataset, firstTimerange, count, datatype, &buffer, number);
+\endverbatim
+ 
+ @ingroup dataset
+ */
+int64_t pioReadRange(PIODataset* dataset,
+                     int firstTimerange, int count,
+                     PIODatatype datatype,
+                     void** buffer, int* number);
+
+/**
+ @brief Read data stored in dataset for a given time range into buffer
+ 
+ Same as pioReadData() except that data are read directly into 
+ caller-provided @a buffer (no internal buffer, no copy).
+ 
+ @param[in,out] dataset pinocchIO dataset
+ @param[in] timerangeIndex Index of timerange
+ @param[in] datatype Buffer datatype
+ @param[out] buffer Data buffer
+ @param[in] capacity Size of @a buffer, in bytes
+ 
+ @returns
+ - @a number of entries when successful
+ - negative value otherwise (including when data do not fit into @a buffer)
+ 
+ @note
+ Use pioReadNumber() and pioGetSize() to get the required @a capacity.
+ 
+\par Example
+\verbatim
+ // buffer large enough for 10 entries
+ float buffer[10*dimension];
+ int number = pioReadInto(&dataset, timerangeIndex, datatype, buffer, sizeof(buffer));
+\endverbatim
+ 
+ @ingroup dataset
+ */
+int pioReadInto(PIODataset* dataset,
+                int timerangeIndex,
+                PIODatatype datatype,
+                void* buffer, size_t capacity);
+
+/**
+ @brief Read data stored in dataset for a range of consecutive time ranges into buffer
+ 
+ Same as pioReadRange() except that data are read directly into 
+ caller-provided @a buffer (no internal buffer, no copy).
+ 
+ @param[in,out] dataset pinocchIO dataset
+ @param[in] firstTimerange Index of first timerange
+ @param[in] count Number of time ranges
+ @param[in] datatype Buffer datatype
+ @param[out] buffer Data buffer
+ @param[in] capacity Size of @a buffer, in bytes
+ @param[out] number Number of entries per time range (array of size @a count, or NULL)
+ 
+ @returns
+ - total number of entries when successful
+ - negative value otherwise (including when data do not fit into @a buffer)
+ 
+ @ingroup dataset
+ */
+int64_t pioReadRangeInto(PIODataset* dataset,
+                         int firstTimerange, int count,
+                         PIODatatype datatype,
+                         void* buffer, size_t capacity, int* number);
+
 /**
  @brief Get number of entries stored in dataset for a given time range
  
@@ -111,12 +218,16 @@ int pioReadNumber(PIODataset dataset,
 \verbatim
  int ntimeranges = pioReadAllNumbers(dataset, NULL);
  int* number = (int*) malloc(ntimeranges*sizeof(int));
- int totalNumber = pioReadAllNumbers(dataset, number);
+ int64_t totalNumber = pioReadAllNumbers(dataset, number);
 \endverbatim
  
+ @note
+ While the number of entries of one time range always fits into an int,
+ the total number of entries may not: it is returned as a 64-bit integer.
+ 
  @ingroup dataset
  */
-int pioReadAllNumbers(PIODataset dataset, int* number);
+int64_t pioReadAllNumbers(PIODataset dataset, int* number);
 
 /**
  @brief Dump whole dataset into buffer
@@ -158,16 +269,16 @@ int pioReadAllNumbers(PIODataset dataset, int* number);
  buffer = malloc(size);
  number = (int*)malloc(dataset.ntimeranges*sizeof(int));
  // Dump the whole dataset
- totalNumber = pioDumpDataset(dataset, datatype, buffer, number)
+ int64_t totalNumber = pioDumpDataset(dataset, datatype, buffer, number)
 \endverbatim
  
  
  @ingroup dataset
  */
-int pioDumpDataset(PIODataset* dataset,
-                   PIODatatype datatype,
-                   void* buffer,
-                   int* number);
+int64_t pioDumpDataset(PIODataset* dataset,
+                       PIODatatype datatype,
+                       void* buffer,
+                       int* number);
 
 #endif
 
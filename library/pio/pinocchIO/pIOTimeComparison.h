@@ -34,6 +34,10 @@
           or \a tr1 and \a tr2 starts simultaneously and \a tr1 ends before \a tr2
         - @ref PINOCCHIO_TIMERANGE_COMPARISON_DESCENDING if \a tr1 starts after \a tr2
           or \a tr1 and \a tr2 starts simultaneously and \a tr1 ends after \a tr2
+ 
+    Time ranges sharing the same scale are compared directly.
+    Otherwise, times are cross-multiplied by scales on 128 bits, so that
+    fine scales (such as 90 kHz or nanoseconds) do not overflow over long periods.
     
     @image	html timecomparison.png "Comparing tr1 with tr2"
     @image	latex timecomparison.eps "Comparing tr1 with tr2" width=\textwidth
@@ -174,7 +178,7 @@ int pioTimeRangeIntersectsTimeRange( PIOTimeRange tr1, PIOTimeRange tr2);
 	@param[in] tl Array of time ranges sorted chronologically
 	@param[in] n Number of time ranges in \a tl
 	@returns 
-        - Index of \a tr in \a tl when found
+        - Index of \a tr in \a tl when found (first one when \a tl contains several of them)
         - Negative value otherwise
  
     @ingroup time
@@ -199,6 +203,209 @@ int pioFindTimeRangeInTimeLine( PIOTimeRange tr, PIOTimeRange* tl, int n);
  */
 PIOTimelineComparison pioCompareTimeLines (PIOTimeRange* tr1, int n1, PIOTimeRange* tr2, int n2);
 
+/**
+ @brief Compare two timelines and match their time ranges
+ 
+ Same as pioCompareTimeLines(), except that it also tells where each time range 
+ of the smaller timeline is found in the larger one.
+ Both timelines are walked through only once, in O(\a n1 + \a n2).
+ 
+ @param[in] tr1 First array of time ranges sorted chronologically 
+ @param[in] n1 Number of time ranges in \a tr1
+ @param[in] tr2 Second array of time ranges sorted chronologically
+ @param[in] n2 Number of time ranges in \a tr2
+ @param[out] mapping Array of min(\a n1, \a n2) indices (may be NULL).
+             When timelines are not @ref PINOCCHIO_TIMELINE_COMPARISON_OTHER, 
+             \a mapping[t] is the index in the larger timeline of time range \a t of the smaller one
+             (\a mapping[t] = \a t when they are the same).
+ 
+ @returns 
+    - same as pioCompareTimeLines()
+ 
+ @note
+ Indices are sorted. 
+ Identical time ranges of the smaller timeline are matched with as many identical time ranges
+ of the larger one as possible, and share the last one otherwise.
+ 
+ @ingroup timeline
+ */
+PIOTimelineComparison pioCompareTimeLinesWithMapping (PIOTimeRange* tr1, int n1, PIOTimeRange* tr2, int n2, int* mapping);
+
+/**
+ @brief Match time ranges of two timelines
+ 
+ For each time range of @a tr1, look for the time ranges of @a tr2 intersecting it,
+ in one pass over both timelines.
+ 
+ Both timelines are first converted to a common integer scale
+ (the least common multiple of their scales), so that time ranges are compared
+ with plain integer comparisons.
+ Timelines whose common scale does not fit in 64 bits are compared
+ with pioCompareTimeRanges() and pioTimeRangeIntersectsTimeRange() instead.
+ 
+ @param[in] tr1 First array of time ranges sorted chronologically
+ @param[in] n1 Number of time ranges in \a tr1
+ @param[in] tr2 Second array of time ranges sorted chronologically
+ @param[in] n2 Number of time ranges in \a tr2
+ @param[out] first Array of \a n1 indices: first time range of \a tr2 intersecting each time range of \a tr1 (-1 if none)
+ @param[out] number Array of \a n1 numbers of consecutive time ranges of \a tr2 (starting at \a first) intersecting each time range of \a tr1 (may be NULL)
+ 
+ @returns
+ - 1 when successful
+ - -1 otherwise (out of memory)
+ 
+ @ingroup timeline
+ */
+int pioJoinTimeLines( PIOTimeRange* tr1, int n1, PIOTimeRange* tr2, int n2, int* first, int* number );
+
+/**
+ @brief Get latest stop among first time ranges of timeline
+ 
+ Time ranges of a timeline are sorted by start time but, when they overlap,
+ not by stop time. @a maxStops[t] is the latest stop time among time ranges 0 to t:
+ unlike stop times, it never decreases. It is used by pioFindTimeRangesContainingTime()
+ and pioFindTimeRangesIntersectingTimeRange() to skip all time ranges stopping 
+ before the query at once.
+ 
+ @param[in] tl Array of time ranges sorted chronologically
+ @param[in] n Number of time ranges in \a tl
+ @param[out] maxStops Array of \a n latest stop times
+ 
+ @returns
+ - 1 when successful
+ 
+ @ingroup timeline
+ */
+int pioGetTimeLineMaximumStops( PIOTimeRange* tl, int n, PIOTime* maxStops );
+
+/**
+ @brief Find time ranges of timeline containing a timestamp
+ 
+ Time ranges containing @a time (see pioTimeInTimeRange()) are found by 
+ two dichotomic searches, then by checking every time range in between.
+ 
+ @param[in] tl Array of time ranges sorted chronologically
+ @param[in] maxStops Array of latest stop times, as returned by pioGetTimeLineMaximumStops().
+            May be NULL when time ranges of \a tl do not overlap (their stop times are sorted as well).
+ @param[in] n Number of time ranges in \a tl
+ @param[in] time Timestamp
+ @param[out] indices Array of (at most) \a maxIndices indices of time ranges containing \a time,
+             in chronological order (may be NULL)
+ @param[in] maxIndices Size of \a indices
+ 
+ @returns
+ - number of time ranges containing \a time (possibly more than \a maxIndices)
+ 
+ @ingroup timeline
+ */
+int pioFindTimeRangesContainingTime( PIOTimeRange* tl, PIOTime* maxStops, int n, PIOTime time, 
+                                     int* indices, int maxIndices );
+
+/**
+ @brief Find time ranges of timeline intersecting a time range
+ 
+ Same as pioFindTimeRangesContainingTime() for time ranges whose intersection
+ with @a tr is not empty (see pioTimeRangeIntersectsTimeRange()).
+ 
+ @param[in] tl Array of time ranges sorted chronologically
+ @param[in] maxStops Array of latest stop times, as returned by pioGetTimeLineMaximumStops().
+            May be NULL when time ranges of \a tl do not overlap (their stop times are sorted as well).
+ @param[in] n Number of time ranges in \a tl
+ @param[in] tr Time range
+ @param[out] indices Array of (at most) \a maxIndices indices of time ranges intersecting \a tr,
+             in chronological order (may be NULL)
+ @param[in] maxIndices Size of \a indices
+ 
+ @returns
+ - number of time ranges intersecting \a tr (possibly more than \a maxIndices)
+ 
+ @ingroup timeline
+ */
+int pioFindTimeRangesIntersectingTimeRange( PIOTimeRange* tl, PIOTime* maxStops, int n, PIOTimeRange tr, 
+                                            int* indices, int maxIndices );
+
+/**
+ @brief Check whether timeline is regular
+ 
+ A timeline is regular when all its time ranges share the same scale and duration, 
+ and consecutive time ranges start at a constant (positive) interval.
+ Its \a n time ranges are then fully described by \a first and \a step
+ (see pioNewRegularTimeline()).
+ 
+ @param[in] tl Array of time ranges
+ @param[in] n Number of time ranges in \a tl (at least 2)
+ @param[out] first First time range of \a tl (may be NULL)
+ @param[out] step Interval between the start of consecutive time ranges, 
+             in 1/\a first.scale units (may be NULL)
+ 
+ @returns
+ - TRUE if timeline is regular
+ - FALSE otherwise
+ 
+ @ingroup timeline
+ */
+int pioIsRegularTimeLine( PIOTimeRange* tl, int n, PIOTimeRange* first, int64_t* step );
+
+/**
+ @brief Search time range in regular timeline
+ 
+ Same as pioFindTimeRangeInTimeLine(), in constant time, for the regular timeline
+ made of \a n time ranges starting every \a step from \a first.
+ 
+ @param[in] tr Time range
+ @param[in] first First time range of timeline
+ @param[in] step Interval between consecutive time ranges, in 1/\a first.scale units
+ @param[in] n Number of time ranges in timeline
+ @returns 
+ - Index of \a tr in timeline when found
+ - Negative value otherwise
+ 
+ @ingroup timeline
+ */
+int pioFindTimeRangeInRegularTimeLine( PIOTimeRange tr, PIOTimeRange first, int64_t step, int n );
+
+/**
+ @brief Find time ranges of regular timeline containing a timestamp
+ 
+ Same as pioFindTimeRangesContainingTime(), in constant time, for the regular timeline
+ made of \a n time ranges starting every \a step from \a first.
+ Time ranges containing \a time are consecutive.
+ 
+ @param[in] first First time range of timeline
+ @param[in] step Interval between consecutive time ranges, in 1/\a first.scale units
+ @param[in] n Number of time ranges in timeline
+ @param[in] time Timestamp
+ @param[out] firstIndex Index of first time range containing \a time (may be NULL)
+ 
+ @returns
+ - number of time ranges containing \a time
+ 
+ @ingroup timeline
+ */
+int pioFindTimeRangesContainingTimeInRegularTimeLine( PIOTimeRange first, int64_t step, int n, PIOTime time, 
+                                                      int* firstIndex );
+
+/**
+ @brief Find time ranges of regular timeline intersecting a time range
+ 
+ Same as pioFindTimeRangesIntersectingTimeRange(), in constant time, for the regular timeline
+ made of \a n time ranges starting every \a step from \a first.
+ Time ranges intersecting \a tr are consecutive.
+ 
+ @param[in] first First time range of timeline
+ @param[in] step Interval between consecutive time ranges, in 1/\a first.scale units
+ @param[in] n Number of time ranges in timeline
+ @param[in] tr Time range
+ @param[out] firstIndex Index of first time range intersecting \a tr (may be NULL)
+ 
+ @returns
+ - number of time ranges intersecting \a tr
+ 
+ @ingroup timeline
+ */
+int pioFindTimeRangesIntersectingTimeRangeInRegularTimeLine( PIOTimeRange first, int64_t step, int n, PIOTimeRange tr, 
+                                                             int* firstIndex );
+
 
 
 #endif
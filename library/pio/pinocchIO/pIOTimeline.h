@@ -87,6 +87,40 @@
 PIOTimeline pioNewTimeline(PIOFile pioFile, const char* path, const char* description,
 							 int numberOfTimeRanges, PIOTimeRange* timeranges);
 
+/**
+ @brief Create new regular pinocchIO timeline
+ 
+ Create a new pinocchIO timeline made of \a numberOfTimeRanges time ranges with the same
+ duration and scale as \a first, starting every \a step (such as video frames or audio frames).
+ 
+ Time ranges of regular timelines are not stored: only \a first, \a step and
+ \a numberOfTimeRanges are (see \ref PIOAttribute_Regular). They are computed when the 
+ timeline is loaded (or when a single time range is requested, see pioGetTimeRange()), 
+ and can be searched in constant time (see pioFindTimeRangeInRegularTimeLine()).
+ 
+ @note
+ Regular timelines (and datasets using them) cannot be opened by pinocchIO versions 
+ older than 0.5.
+ 
+ @param[in] pioFile pinocchIO file handle
+ @param[in] path Internal path to the new timeline
+ @param[in] description Textual description of the new timeline
+ @param[in] numberOfTimeRanges Number of time ranges in the new timeline
+ @param[in] first First time range
+ @param[in] step Interval between the start of consecutive time ranges, in 1/\a first.scale units
+ @returns 
+ - a (lazy) pinocchIO timeline handle when successful
+ - \ref PIOTimelineInvalid otherwise
+ 
+ @note
+ Use pioIsRegularTimeLine() to check whether an array of time ranges can be stored as a regular timeline.
+ 
+ @note
+ Use pioCloseTimeline() to close the timeline when no longer needed. 
+ */
+PIOTimeline pioNewRegularTimeline(PIOFile pioFile, const char* path, const char* description,
+                                  int numberOfTimeRanges, PIOTimeRange first, int64_t step);
+
 /**
  @brief Open pinocchIO timeline
  
@@ -105,6 +139,81 @@ PIOTimeline pioNewTimeline(PIOFile pioFile, const char* path, const char* descri
  */
 PIOTimeline pioOpenTimeline(PIOObject pioObjectInFile, const char* path);
 
+/**
+ @brief Open pinocchIO timeline with flags
+ 
+ Same as pioOpenTimeline() except that the behavior of the 
+ timeline handle can be tuned with \a flags (see \ref PIOTimelineFlags).
+ 
+ For instance, the following only reads the number of time ranges of the timeline
+ (\a timeranges field of the handle is NULL):
+\verbatim
+ PIOTimeline timeline = pioOpenTimelineWithFlags(PIOMakeObject(pioFile), path,
+                                                 PINOCCHIO_TIMELINE_LAZY);
+\endverbatim
+ 
+ @param[in] pioObjectInFile PIOObject stored in the same file as requested timeline 
+ @param[in] path Path to the existing pinocchIO timeline
+ @param[in] flags Combination of \ref PIOTimelineFlags
+ @returns
+ - a pinocchIO timeline handle when successful
+ - \ref PIOTimelineInvalid otherwise
+ 
+ @note
+ Time ranges of lazy timelines are read with pioGetTimeRange() or pioReadTimeRanges(),
+ or all at once with pioLoadTimeline().
+ 
+ @note
+ Use pioCloseTimeline() to close the timeline when no longer needed. 
+ */
+PIOTimeline pioOpenTimelineWithFlags(PIOObject pioObjectInFile, const char* path, int flags);
+
+/**
+ @brief Load whole pinocchIO timeline
+ 
+ Read every time range of a timeline opened with \ref PINOCCHIO_TIMELINE_LAZY
+ into its \a timeranges field. Does nothing if they are already loaded.
+ 
+ @param[in,out] pioTimeline pinocchIO timeline handle
+ @returns
+ - 1 when successful
+ - 0 otherwise
+ */
+int pioLoadTimeline( PIOTimeline* pioTimeline );
+
+/**
+ @brief Read consecutive time ranges of pinocchIO timeline
+ 
+ Read \a count time ranges starting at time range \a first into \a timeranges,
+ without loading the rest of the timeline.
+ 
+ @param[in] pioTimeline pinocchIO timeline handle
+ @param[in] first Index of first time range
+ @param[in] count Number of time ranges
+ @param[out] timeranges Array of (at least) \a count time ranges
+ @returns
+ - \a count when successful
+ - -1 otherwise
+ */
+int pioReadTimeRanges( PIOTimeline pioTimeline, int first, int count, PIOTimeRange* timeranges );
+
+/**
+ @brief Get time range of pinocchIO timeline
+ 
+ Get time range \a t of timeline.
+ Unless the whole timeline is loaded, time ranges are read by windows of 
+ \ref PIOTimelineWindowSize consecutive time ranges, and the last window is 
+ kept with the timeline handle: going through a lazy timeline in 
+ chronological order only keeps one window in memory.
+ 
+ @param[in,out] pioTimeline pinocchIO timeline handle
+ @param[in] t Index of time range
+ @returns
+ - time range \a t when successful
+ - \ref PIOTimeRangeInvalid otherwise
+ */
+PIOTimeRange pioGetTimeRange( PIOTimeline* pioTimeline, int t );
+
 /**
  @brief Close pinocchIO timeline
  
@@ -162,6 +271,23 @@ int pioRemoveTimeline(PIOObject pioObject, const char* path);
  */
 PIOTimeline pioGetTimeline(PIODataset pioDataset);
 
+/**
+ @brief Get pinocchIO timeline from pinocchIO dataset with flags
+ 
+ Same as pioGetTimeline() except that the timeline is opened with 
+ pioOpenTimelineWithFlags(). Use \ref PINOCCHIO_TIMELINE_LAZY when 
+ only the number of time ranges (or a few of them) is needed.
+ 
+ @param[in] pioDataset  pinocchIO dataset handle
+ @param[in] flags Combination of \ref PIOTimelineFlags
+ @returns
+    - a pinocchIO timeline handle when successful
+    - \ref PIOTimelineInvalid otherwise
+ 
+ @ingroup dataset
+ */
+PIOTimeline pioGetTimelineWithFlags(PIODataset pioDataset, int flags);
+
 /**
  @brief Get list of pinocchIO timelines
  
@@ -208,9 +334,14 @@ int pioGetListOfTimelines(PIOFile pioFile, char*** pathsToTimelines);
  
  @note
  In case a timeline already exists at the same @a path in the @a output file,
- pioCopyTimeline() will check whether it is identical to the input timeline.
+ pioCopyTimeline() will check whether it is identical to the input timeline
+ or contains all of its time ranges (see pioCompareTimeLines()).
  If so, it will do nothing and return TRUE. Otherwise, it will return FALSE.
  
+ @note
+ Regular timelines (see pioNewRegularTimeline()) are copied as regular timelines,
+ and compared with each other without computing their time ranges.
+ 
  @ingroup file
  */
 int pioCopyTimeline(const char* path, PIOFile input, PIOFile output);
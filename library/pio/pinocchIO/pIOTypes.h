@@ -22,6 +22,7 @@
 #ifndef _PINOCCHIO_TYPES_H
 #define _PINOCCHIO_TYPES_H
 
+#include <stdint.h>
 #include <hdf5.h>
 
 #define ERROR_SWITCH_INIT herr_t (*old_func)(hid_t, void*); void *old_client_data;		
@@ -216,6 +217,31 @@ typedef enum {
 } PIOTimeRangeComparison;
 
 
+/**
+ @brief pinocchIO timeline opening flags
+ 
+ Flags can be combined with a bitwise OR and passed to pioOpenTimelineWithFlags().
+ 
+ By default, the whole timeline (20 bytes per time range) is read when it is opened.
+ Lazy timelines only read their number of time ranges: time ranges are then read
+ on demand, window after window (see pioGetTimeRange()), or all at once with pioLoadTimeline().
+ 
+ @ingroup timeline
+ */
+typedef enum {
+    /** Default behavior: read the whole timeline when opening it */
+    PINOCCHIO_TIMELINE_DEFAULT = 0,
+    /** Only read the number of time ranges when opening the timeline */
+    PINOCCHIO_TIMELINE_LAZY = 1
+} PIOTimelineFlags;
+
+/**
+ @brief Number of time ranges read at once by pioGetTimeRange()
+ 
+ @ingroup timeline
+ */
+#define PIOTimelineWindowSize 4096
+
 /**
  @brief pinocchIO timeline handle
  
@@ -235,12 +261,24 @@ typedef struct {
 	hid_t identifier;
     /** number of time ranges in timeline */
 	int ntimeranges;
-    /** time ranges sorted in chronological order */
+    /** time ranges sorted in chronological order (NULL if not loaded, see \ref PINOCCHIO_TIMELINE_LAZY) */
 	PIOTimeRange* timeranges;
     /** internal path to timeline in pinocchIO file */
 	char* path;
     /** timeline textual description */
 	char* description;
+    /** flags used when opening the timeline (see \ref PIOTimelineFlags) */
+    int flags;
+    /** time ranges last read by pioGetTimeRange() (NULL if none) */
+    PIOTimeRange* window;
+    /** index of first time range in window */
+    int window_first;
+    /** number of time ranges in window */
+    int window_length;
+    /** first time range of regular timelines (see pioNewRegularTimeline()) */
+    PIOTimeRange first;
+    /** step between time ranges of regular timelines, in 1/first.scale units (0 if not regular) */
+    int64_t step;
 } PIOTimeline;
 
 /**
@@ -251,7 +289,7 @@ typedef struct {
  
  @ingroup timeline
  */
-#define PIOTimelineInvalid ((PIOTimeline) {-1, -1, NULL, NULL, NULL})
+#define PIOTimelineInvalid ((PIOTimeline) {-1, -1, NULL, NULL, NULL, 0, NULL, 0, 0, {-1, -1, -1}, 0})
 
 /**
  @brief Timelines comparison result
@@ -350,6 +388,71 @@ typedef struct {
 #define PIODatatypeInvalid ((PIODatatype) {-1, -1, -1})
 
 
+/**
+ @brief pinocchIO dataset opening flags
+ 
+ Flags can be combined with a bitwise OR and passed to pioOpenDatasetWithFlags().
+ 
+ Every time range of a dataset is associated with a link (the position and 
+ number of its entries). By default, links are read from disk each time they 
+ are needed. Datasets accessed time range after time range benefit from 
+ keeping the whole link table (8 bytes per time range) in memory.
+ 
+ Sealed datasets (see pioSealDataset()) can also be memory-mapped:
+ reading a time range then boils down to pointer arithmetic.
+ 
+ @ingroup dataset
+ */
+typedef enum {
+    /** Default behavior */
+    PINOCCHIO_DATASET_DEFAULT = 0,
+    /** Load the whole link table in memory at first read */
+    PINOCCHIO_DATASET_CACHE_LINKS = 1,
+    /** Load the whole link table in memory when opening the dataset */
+    PINOCCHIO_DATASET_PRELOAD_LINKS = 2,
+    /** Memory-map data of sealed datasets (implies PINOCCHIO_DATASET_PRELOAD_LINKS) */
+    PINOCCHIO_DATASET_MMAP = 4
+} PIODatasetFlags;
+
+/**
+ @brief pinocchIO dataset writer
+ 
+ Opaque structure holding data and links waiting to be written into a 
+ pinocchIO dataset. See pioNewDatasetWriter().
+ 
+ @ingroup dataset
+ */
+typedef struct PIODatasetWriter_s PIODatasetWriter;
+
+/**
+ @brief Default memory budget of pinocchIO dataset writers
+ 
+ 16MB. See pioNewDatasetWriter().
+ 
+ @ingroup dataset
+ */
+#define PIODatasetWriterDefaultBudget (16*1048576)
+
+/**
+ @brief pinocchIO dataset memory mapping
+ 
+ Opaque structure describing the memory-mapped data of a sealed pinocchIO 
+ dataset. See \ref PINOCCHIO_DATASET_MMAP.
+ 
+ @ingroup dataset
+ */
+typedef struct PIODatasetMapping_s PIODatasetMapping;
+
+/**
+ @brief Pool of open pinocchIO files and datasets
+ 
+ Opaque structure keeping read-only pinocchIO files and datasets open 
+ between uses. See pioNewPool().
+ 
+ @ingroup pool
+ */
+typedef struct PIOPool_s PIOPool;
+
 /**
  @brief pinocchIO dataset handle
  
@@ -374,13 +477,21 @@ typedef struct {
     /** dataset textual description */
 	char* description;
     /** total number of entries stored in dataset */
-	int stored;
+	int64_t stored;
     /** number of time ranges in dataset timeline */
 	int ntimeranges; 
     /** internal buffer - mostly used by pioWrite() */
 	void* buffer;
     /** size of internal buffer, in bytes */
 	size_t buffer_size;
+    /** buffered writer attached to the dataset (NULL if none) */
+    PIODatasetWriter* writer;
+    /** flags used when opening the dataset (see \ref PIODatasetFlags) */
+    int flags;
+    /** in-memory copy of the link table (NULL if not loaded) */
+    struct link_s* links;
+    /** memory-mapped data (NULL if not mapped) */
+    PIODatasetMapping* mapping;
 } PIODataset;
 
 /**
@@ -391,6 +502,43 @@ typedef struct {
 
  @ingroup dataset
  */
-#define PIODatasetInvalid ((PIODataset) {-1, -1, NULL, NULL, -1, -1, NULL, 0})
+#define PIODatasetInvalid ((PIODataset) {-1, -1, NULL, NULL, -1, -1, NULL, 0, NULL, 0, NULL, NULL})
+
+/**
+ @brief pinocchIO dataset creation options
+ 
+ Storage options used by pioNewDatasetWithOptions() when creating the pair 
+ of HDF5 datasets behind a pinocchIO dataset.
+ 
+ Data entries are stored in chunks of (approximately) \a chunk_size bytes:
+ the actual number of entries per chunk is deduced from the size of the 
+ dataset datatype. The fixed-size link dataset (one entry per time range)
+ follows its own policy, driven by \a link_chunk_size.
+ 
+ Chunks can be compressed with the deflate (zlib) filter that ships with HDF5,
+ optionally preceded by the byte-shuffle filter which usually improves the
+ compression ratio of numerical data a lot.
+ 
+ @ingroup dataset
+ */
+typedef struct {
+    /** target size of data chunks, in bytes */
+    size_t chunk_size;
+    /** target size of link chunks, in bytes (0 for contiguous link storage) */
+    size_t link_chunk_size;
+    /** deflate compression level, from 1 (fastest) to 9 (best) -- 0 for no compression */
+    int compression;
+    /** apply byte-shuffle filter before compression (TRUE or FALSE) */
+    int shuffle;
+} PIODatasetOptions;
+
+/**
+ @brief Default pinocchIO dataset creation options
+ 
+ 1MB data chunks and 64kB link chunks, no compression.
+ 
+ @ingroup dataset
+ */
+#define PIODatasetOptionsDefault ((PIODatasetOptions) {1048576, 65536, 0, 0})
 
 #endif
@@ -87,6 +87,73 @@
 int pioWrite(PIODataset* dataset, int timerangeIndex,
 			 void* buffer, int number, PIODatatype datatype);
 
+/**
+ @brief Attach a buffered writer to dataset
+ 
+ Once a writer is attached to @a dataset, pioWrite() no longer writes to disk 
+ directly: data and links are accumulated in memory and written by batches, 
+ with one extension of the dataset and one write per batch.
+ 
+ A batch is written to disk when 
+ - the memory it uses would exceed @a budget bytes,
+ - pioWrite() is called with a different datatype, 
+   or for a time range that does not come after the previous one,
+ - data are read from @a dataset (pioReadData(), pioReadNumber(), etc.),
+ - pioFlushDatasetWriter() or pioCloseDatasetWriter() is called,
+ - @a dataset is closed with pioCloseDataset().
+ 
+ Writing time ranges in chronological order gives the largest batches.
+ 
+ @param[in,out] dataset pinocchIO dataset
+ @param[in] budget Memory budget in bytes (0 for \ref PIODatasetWriterDefaultBudget)
+ @returns 
+ - 1 when successful
+ - negative value otherwise (e.g. a writer is already attached)
+ 
+ \par Example
+\verbatim
+ PIODataset dataset = pioNewDataset(...);
+ pioNewDatasetWriter(&dataset, 0);
+ for (t=0; t<ntimeranges; t++)
+    pioWrite(&dataset, t, buffer[t], number[t], datatype);
+ pioCloseDatasetWriter(&dataset);
+ pioCloseDataset(&dataset);
+\endverbatim
+ 
+ @ingroup dataset
+ */
+int pioNewDatasetWriter(PIODataset* dataset, size_t budget);
+
+/**
+ @brief Write buffered data to disk
+ 
+ Write data and links buffered by the writer attached to @a dataset.
+ 
+ @param[in,out] dataset pinocchIO dataset
+ @returns 
+ - 1 when successful
+ - negative value otherwise (e.g. no writer is attached)
+ 
+ @ingroup dataset
+ */
+int pioFlushDatasetWriter(PIODataset* dataset);
+
+/**
+ @brief Detach buffered writer from dataset
+ 
+ Write buffered data and links to disk, then detach and free 
+ the writer attached to @a dataset. 
+ Subsequent calls to pioWrite() write directly to disk.
+ 
+ @param[in,out] dataset pinocchIO dataset
+ @returns 
+ - 1 when successful
+ - 0 otherwise
+ 
+ @ingroup dataset
+ */
+int pioCloseDatasetWriter(PIODataset* dataset);
+
 
 #endif
 
@@ -152,6 +152,7 @@ extern "C" {
 #include "pIODataset.h"
 #include "pIOWrite.h"
 #include "pIORead.h"
+#include "pIOPool.h"
     
 #ifdef __cplusplus    
 }
@@ -27,15 +27,94 @@
 /**
  @internal
  @brief Type of data stored in /path/to/dataset/link HDF5 dataset
+ 
+ Links are stored as 64-bit integers since pinocchIO 0.4 (see dataset 'version' 
+ attribute). Older datasets use 32-bit integers: HDF5 converts them on the fly.
  */
-typedef struct {
+typedef struct link_s {
     /** @internal @brief position of first data entry in HDF5 dataset */
-	int32_t position;
+	int64_t position;
     /** @internal @brief number of data entries in HDF5 dataset */
-	int32_t number;
+	int64_t number;
 } link_t;
 
+/**
+ @internal
+ @brief Largest position that can be stored in pre-0.4 (32-bit) link datasets
+ */
+#define PIOLink32Max INT32_MAX
+
+/*
+ Cached HDF5 datatypes: do not close them.
+ */
 hid_t linkDatatype();
+hid_t timelineDatatype();
+
+/*
+ Read or write number entries of 1-dimensional HDF5 dataset, starting at position
+ (dataspaces are allocated for this very call, so that concurrent calls on
+ different handles never share a selection).
+ */
+int readHyperslab(hid_t dataset, hid_t datatype, hsize_t position, hsize_t number, void* buffer);
+int writeHyperslab(hid_t dataset, hid_t datatype, hsize_t position, hsize_t number, const void* buffer);
+
+int extendDataset(PIODataset pioDataset, hsize_t extent);
+int hasLink32(PIODataset pioDataset);
+
+/**
+ @internal
+ @brief Data and links buffered by a pinocchIO dataset writer
+ */
+struct PIODatasetWriter_s {
+    /** @internal @brief memory budget, in bytes */
+    size_t budget;
+    /** @internal @brief HDF5 datatype of buffered data (-1 if none) */
+    hid_t datatype;
+    /** @internal @brief size of one buffered entry, in bytes */
+    size_t entry_size;
+    /** @internal @brief buffered data */
+    void* data;
+    /** @internal @brief size of allocated data buffer, in bytes */
+    size_t data_size;
+    /** @internal @brief number of buffered data entries */
+    int64_t number;
+    /** @internal @brief number of data entries already written to disk */
+    int64_t flushed;
+    /** @internal @brief buffered links */
+    link_t* links;
+    /** @internal @brief time range index of each buffered link */
+    int* indices;
+    /** @internal @brief number of buffered links */
+    int nlinks;
+    /** @internal @brief number of allocated links */
+    int links_size;
+};
+
+int flushDatasetWriter(PIODataset pioDataset);
+
+int loadLinks(PIODataset* pioDataset);
+
+/**
+ @internal
+ @brief Memory-mapped data of a sealed pinocchIO dataset
+ */
+struct PIODatasetMapping_s {
+    /** @internal @brief mapped region (starts at a page boundary) */
+    void* region;
+    /** @internal @brief size of mapped region, in bytes */
+    size_t region_size;
+    /** @internal @brief first data entry, within mapped region */
+    char* data;
+    /** @internal @brief size of data, in bytes */
+    size_t data_size;
+    /** @internal @brief HDF5 datatype of data entries, as stored in file */
+    hid_t datatype;
+    /** @internal @brief size of one data entry, in bytes */
+    size_t entry_size;
+};
+
+int mapDataset(PIODataset* pioDataset);
+int unmapDataset(PIODataset* pioDataset);
 
 /**
 	@internal
@@ -22,26 +22,156 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 #include <hdf5_hl.h>
 
 #include "pIOTypes.h"
 #include "pIOAttributes.h"
 
 
+// Library-level cache of HDF5 datatypes used over and over again.
+// They are created once (whatever the number of threads), never modified,
+// and released when the program exits.
+// (dataspaces carry selections and are therefore allocated for each read or write)
+static hid_t cachedLinkDatatype = -1;
+static hid_t cachedTimelineDatatype = -1;
+static pthread_once_t cachedDatatypesOnce = PTHREAD_ONCE_INIT;
+
+static void releaseCachedDatatypes(void)
+{
+	ERROR_SWITCH_INIT
+	
+	ERROR_SWITCH_OFF
+	if (cachedLinkDatatype > -1) H5Tclose(cachedLinkDatatype);
+	if (cachedTimelineDatatype > -1) H5Tclose(cachedTimelineDatatype);
+	ERROR_SWITCH_ON
+	
+	cachedLinkDatatype = -1;
+	cachedTimelineDatatype = -1;
+}
+
+static void createCachedDatatypes(void)
+{
+	hid_t tInt64, tInt32;
+	
+	tInt64 = H5Tcopy(H5T_NATIVE_INT64);
+	tInt32 = H5Tcopy(H5T_NATIVE_INT32);
+	
+	cachedLinkDatatype = H5Tcreate(H5T_COMPOUND, sizeof(link_t));
+	H5Tinsert(cachedLinkDatatype, "position", HOFFSET(link_t, position), tInt64);
+	H5Tinsert(cachedLinkDatatype, "number", HOFFSET(link_t, number), tInt64);
+	
+	cachedTimelineDatatype = H5Tcreate(H5T_COMPOUND, sizeof(PIOTimeRange));
+	H5Tinsert(cachedTimelineDatatype, "time",     HOFFSET(PIOTimeRange, time) ,    tInt64);
+	H5Tinsert(cachedTimelineDatatype, "duration", HOFFSET(PIOTimeRange, duration), tInt64);
+	H5Tinsert(cachedTimelineDatatype, "scale",    HOFFSET(PIOTimeRange, scale),    tInt32);
+	
+	H5Tclose(tInt64); H5Tclose(tInt32);
+	atexit(releaseCachedDatatypes);
+}
+
 hid_t linkDatatype()
 {
-	hid_t tLink;
-	hid_t tPosition;
-	hid_t tNumber;	
-	
-	tLink = H5Tcreate(H5T_COMPOUND, sizeof(link_t));
-	tPosition = H5Tcopy(H5T_NATIVE_INT32);
-	tNumber = H5Tcopy(H5T_NATIVE_INT32);
-	H5Tinsert(tLink, "position", HOFFSET(link_t, position), tPosition);
-	H5Tinsert(tLink, "number", HOFFSET(link_t, number), tNumber);
-	H5Tclose(tPosition);
-	H5Tclose(tNumber);
-	return tLink;
+	pthread_once(&cachedDatatypesOnce, createCachedDatatypes);
+	return cachedLinkDatatype;
+}
+
+hid_t timelineDatatype()
+{
+	pthread_once(&cachedDatatypesOnce, createCachedDatatypes);
+	return cachedTimelineDatatype;
+}
+
+// Select number entries starting at position in file dataspace of dataset,
+// and create matching memory dataspace. Both have to be closed by caller.
+static int selectHyperslab(hid_t dataset, hsize_t position, hsize_t number, 
+						   hid_t* fileDataspace, hid_t* memoryDataspace)
+{
+	hsize_t start[1] = { position };
+	hsize_t count[1] = { number };
+	
+	*fileDataspace = H5Dget_space(dataset);
+	if (*fileDataspace < 0) return -1;
+	*memoryDataspace = H5Screate_simple(1, count, NULL);
+	if ((*memoryDataspace < 0) ||
+		(H5Sselect_hyperslab(*fileDataspace, H5S_SELECT_SET, start, NULL, count, NULL) < 0))
+	{
+		if (*memoryDataspace > -1) H5Sclose(*memoryDataspace);
+		H5Sclose(*fileDataspace);
+		return -1;
+	}
+	return 1;
+}
+
+int readHyperslab(hid_t dataset, hid_t datatype, hsize_t position, hsize_t number, void* buffer)
+{
+	ERROR_SWITCH_INIT
+	herr_t read_err = -1;
+	hid_t fileDataspace, memoryDataspace;
+	
+	ERROR_SWITCH_OFF
+	if (selectHyperslab(dataset, position, number, &fileDataspace, &memoryDataspace) > 0)
+	{
+		read_err = H5Dread(dataset, datatype, memoryDataspace, fileDataspace, H5P_DEFAULT, buffer);
+		H5Sclose(memoryDataspace);
+		H5Sclose(fileDataspace);
+	}
+	ERROR_SWITCH_ON
+	
+	if (read_err < 0) return -1;
+	return 1;
+}
+
+int writeHyperslab(hid_t dataset, hid_t datatype, hsize_t position, hsize_t number, const void* buffer)
+{
+	ERROR_SWITCH_INIT
+	herr_t write_err = -1;
+	hid_t fileDataspace, memoryDataspace;
+	
+	ERROR_SWITCH_OFF
+	if (selectHyperslab(dataset, position, number, &fileDataspace, &memoryDataspace) > 0)
+	{
+		write_err = H5Dwrite(dataset, datatype, memoryDataspace, fileDataspace, H5P_DEFAULT, buffer);
+		H5Sclose(memoryDataspace);
+		H5Sclose(fileDataspace);
+	}
+	ERROR_SWITCH_ON
+	
+	if (write_err < 0) return -1;
+	return 1;
+}
+
+int extendDataset(PIODataset pioDataset, hsize_t extent)
+{
+	ERROR_SWITCH_INIT
+	herr_t extend_err;
+	hsize_t newExtent[1] = { extent };
+	
+	// pre-0.4 link datasets cannot address more than 2^31 entries
+	if ((extent > PIOLink32Max) && hasLink32(pioDataset)) return -1;
+	
+	ERROR_SWITCH_OFF
+	extend_err = H5Dextend(pioDataset.identifier, newExtent);
+	ERROR_SWITCH_ON
+	if (extend_err < 0) return -1;
+	return 1;
+}
+
+// Returns 1 if links are stored as 32-bit integers (pre-0.4 datasets), 0 otherwise
+int hasLink32(PIODataset pioDataset)
+{
+	hid_t fileLinkDatatype;
+	hid_t filePositionDatatype;
+	size_t positionSize;
+	
+	fileLinkDatatype = H5Dget_type(pioDataset.link_identifier);
+	filePositionDatatype = H5Tget_member_type(fileLinkDatatype, 
+											  H5Tget_member_index(fileLinkDatatype, "position"));
+	positionSize = H5Tget_size(filePositionDatatype);
+	H5Tclose(filePositionDatatype);
+	H5Tclose(fileLinkDatatype);
+	
+	return (positionSize < sizeof(int64_t));
 }
 
 int lengthOfList( listOfPaths_t* list)
@@ -24,7 +24,8 @@ def _fromFile(pyoFile, path, loadTimeline=True, assumeSorted=False):
     # number[t] is the number of vectors for tth time range
     number = np.zeros(linkset.shape, dtype=np.int32)
     # position[t] is the position of first vector for tth time range
-    position = np.zeros(linkset.shape, dtype=np.int32)
+    # (links are stored as 64-bit integers since pinocchIO 0.4)
+    position = np.zeros(linkset.shape, dtype=np.int64)
     for t in range(linkset.shape[0]):
         number[t] = linkset[t][1]
         position[t] = linkset[t][0]
@@ -83,7 +84,7 @@ class PYODataset(object):
         
         stored, dimension = self._data.shape
         self._number = np.array(np.copy(number), dtype=np.int32)
-        self._position = np.copy(self._number)
+        self._position = np.array(self._number, dtype=np.int64)
         self._position[1:] = self._number[:-1].cumsum()
         self._position[0]  = 0
     
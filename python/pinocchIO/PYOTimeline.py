@@ -2,6 +2,7 @@ from pinocchIO import PYOTimerange
 # from matplotlib.collections import LineCollection
 # from matplotlib import pyplot
 from datetime import timedelta
+from bisect import bisect_left, bisect_right
 
 def Empty():
     return PYOTimeline( [] )
@@ -16,13 +17,16 @@ def _fromFile(pyoFile, path):
     # Read HDF5 dataset used to store timeline
     timeset = pyoFile.h5file['/timeline/' + path]
     
-    # Number of time ranges in timeline
-    ntimeranges = timeset.shape[0]
-    
     # Time ranges
     timeranges = []
-    for t in range(ntimeranges):
-        timeranges.append(PYOTimerange.FromTimeset(timeset[t]))
+    if 'regular' in timeset.attrs:
+        # Regular timeline: only first time range, step and number of time ranges are stored
+        time, duration, scale, step, ntimeranges = timeset.attrs['regular']
+        for t in range(ntimeranges):
+            timeranges.append(PYOTimerange.FromTimeset((time + t*step, duration, scale)))
+    else:
+        for t in range(timeset.shape[0]):
+            timeranges.append(PYOTimerange.FromTimeset(timeset[t]))
     
     return PYOTimeline(timeranges)
 
@@ -32,6 +36,7 @@ class PYOTimeline(object):
     def __init__(self, timeranges):
         super(PYOTimeline, self).__init__()
         self.timeranges = timeranges
+        self._index = None
     
     
     def __getitem__(self, t):
@@ -61,15 +66,57 @@ class PYOTimeline(object):
         return len(self.timeranges) < 1
     
     
+    def _getIndex(self):
+        """
+        Returns start times and latest stop times so far (as lists of datetime.datetime)
+            or None if time ranges are not sorted by start time
+        Latest stop times never decrease, even when time ranges overlap
+            (same as pioGetTimeLineMaximumStops in C)
+        """
+        
+        if self._index != None and self._index[0] is self.timeranges \
+                               and self._index[1] == len(self.timeranges):
+            return self._index[2]
+        
+        starts = [timerange.getStart() for timerange in self.timeranges]
+        maxStops = []
+        for timerange in self.timeranges:
+            stop = timerange.getStop()
+            if maxStops and maxStops[-1] > stop:
+                stop = maxStops[-1]
+            maxStops.append(stop)
+        
+        index = (starts, maxStops)
+        for i in range(1, len(starts)):
+            if starts[i-1] > starts[i]:
+                index = None
+                break
+        
+        self._index = (self.timeranges, len(self.timeranges), index)
+        return index
+    
+    
     def indexOfTimerangesInPeriod(self, period, strict=False):
         """
         Find index of every time range (strictly?) contained by the provided period timerange
         """
         
+        index = self._getIndex()
+        if index == None:
+            candidates = range(self.getNumberOfTimeranges())
+        elif strict:
+            # time ranges starting during period
+            starts, maxStops = index
+            candidates = range(bisect_left(starts, period.getStart()), bisect_right(starts, period.getStop()))
+        else:
+            # time ranges starting before period stops and not stopping before period starts
+            starts, maxStops = index
+            candidates = range(bisect_right(maxStops, period.getStart()), bisect_left(starts, period.getStop()))
+        
         if strict:
-            Is = [ i for i, timerange in enumerate(self) if period.includes(timerange, strict=False)]
+            Is = [ i for i in candidates if period.includes(self.timeranges[i], strict=False)]
         else:
-            Is = [ i for i, timerange in enumerate(self) if period.intersects(timerange)]
+            Is = [ i for i in candidates if period.intersects(self.timeranges[i])]
         
         return Is
     
@@ -96,9 +143,21 @@ class PYOTimeline(object):
         Find index of every time range containing the provided timestamp
         """
         
+        index = self._getIndex()
+        if index == None:
+            candidates = range(self.getNumberOfTimeranges())
+        else:
+            # time ranges starting before timestamp and not stopping before timestamp
+            # (same as pioFindTimeRangesContainingTime in C)
+            starts, maxStops = index
+            if strict:
+                candidates = range(bisect_right(maxStops, timestamp), bisect_left(starts, timestamp))
+            else:
+                candidates = range(bisect_left(maxStops, timestamp), bisect_right(starts, timestamp))
+        
         Is = []
-        for i, timerange in enumerate(self):
-            if timerange.contains(timestamp, strict=strict):
+        for i in candidates:
+            if self.timeranges[i].contains(timestamp, strict=strict):
                 # timerange contains timestamp. Yeaaaay!
                 Is.append(i)
         
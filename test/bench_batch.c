@@ -0,0 +1,160 @@
+/*
+ *  bench_batch.c
+ *  pinocchIO
+ *
+ *  Compares the throughput of gptReadNext() and gptReadBatch() on a filtered
+ *  Gepetto server.
+ *  See test_ReadBatch for correctness checks.
+ *
+ *  usage: bench_batch [nfiles [ntimeranges [dimension [batch]]]]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gepetto/gepetto.h"
+#include "test_utils.h"
+
+#define BENCH_FILE "/tmp/bench_batch_%d.pio"
+
+static void create(int f, int ntimeranges, int dimension)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = PIODatatypeInvalid;
+    PIODatatype labelDatatype = PIODatatypeInvalid;
+    PIODataset pioDataset = PIODatasetInvalid;
+    char path[256];
+    float* data = NULL;
+    int label;
+    int t, d;
+
+    // up to 2 entries per time range
+    data = (float*) malloc(2*dimension*sizeof(float));
+
+    sprintf(path, BENCH_FILE, f);
+    pioFile = newFramesFile(path, ntimeranges, &pioTimeline);
+
+    pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, dimension);
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    pioNewDatasetWriter(&pioDataset, 0);
+    for (t=0; t<ntimeranges; t++)
+    {
+        for (d=0; d<2*dimension; d++) data[d] = (float)(f+t+d);
+        pioWrite(&pioDataset, t, data, t%5 == 4 ? 0 : 1+t%2, pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    // long runs of label 0 (filtered out) between runs of labels 1 and 2
+    labelDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    pioDataset = pioNewDataset(pioFile, "labels", "labels", pioTimeline, labelDatatype);
+    for (t=0; t<ntimeranges; t++)
+    {
+        label = (t/1000)%2 ? 0 : 1+(t/100)%2;
+        pioWrite(&pioDataset, t, &label, 1, labelDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    pioCloseDatatype(&labelDatatype);
+    pioCloseDatatype(&pioDatatype);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+    free(data);
+}
+
+int main (int argc, char *const  argv[])
+{
+    int nfiles = 10;
+    int ntimeranges = 20000;
+    int dimension = 64;
+    int batch = 4096;
+    char** paths = NULL;
+    GPTServer server = GPTServerInvalid;
+    PIODatatype pioDatatype = PIODatatypeInvalid;
+    int64_t total;
+    float* nextData = NULL;
+    int* nextLabels = NULL;
+    float* data = NULL;
+    int* labels = NULL;
+    int* fileIndices = NULL;
+    int* timeranges = NULL;
+    void* buffer = NULL;
+    int* entryLabels = NULL;
+    int nLabels;
+    double start, nextTime, batchTime;
+    int64_t v;
+    int f, number, n;
+
+    if (argc > 1) nfiles = atoi(argv[1]);
+    if (argc > 2) ntimeranges = atoi(argv[2]);
+    if (argc > 3) dimension = atoi(argv[3]);
+    if (argc > 4) batch = atoi(argv[4]);
+
+    paths = (char**) malloc(nfiles*sizeof(char*));
+    for (f=0; f<nfiles; f++)
+    {
+        create(f, ntimeranges, dimension);
+        paths[f] = (char*) malloc(256);
+        sprintf(paths[f], BENCH_FILE, f);
+    }
+
+    server = gptNewServer(nfiles, paths, "features",
+                          GEPETTO_LABEL_FILTER_TYPE_GREATER_THAN, 0, -1,
+                          nfiles, paths, "labels");
+    if (GPTServerIsInvalid(server))
+    {
+        fprintf(stderr, "Could not create Gepetto server.\n");
+        exit(-1);
+    }
+    pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, dimension);
+
+    total = gptDumpServer(&server, pioDatatype, NULL)/pioGetSize(pioDatatype);
+    nextData = (float*) malloc(total*dimension*sizeof(float));
+    nextLabels = (int*) malloc(total*sizeof(int));
+    data = (float*) malloc(total*dimension*sizeof(float));
+    labels = (int*) malloc(total*sizeof(int));
+    fileIndices = (int*) malloc(total*sizeof(int));
+    timeranges = (int*) malloc(total*sizeof(int));
+
+    fprintf(stdout, "%d files, %d time ranges, %d-dimensional float vectors, %lld served vectors\n",
+            nfiles, ntimeranges, dimension, (long long)total);
+
+    // one time range at a time
+    start = now();
+    v = 0;
+    while ((number = gptReadNext(&server, pioDatatype, &buffer, &nLabels, &entryLabels)) >= 0)
+    {
+        memcpy(nextData+v*dimension, buffer, number*dimension*sizeof(float));
+        for (n=0; n<number; n++) nextLabels[v+n] = entryLabels[0];
+        v += number;
+    }
+    nextTime = now() - start;
+    fprintf(stdout, "%-28s %8.3fs\n", "gptReadNext", nextTime);
+
+    // by batches
+    start = now();
+    v = 0;
+    while ((number = gptReadBatch(&server, pioDatatype, batch,
+                                  data+v*dimension, labels+v, fileIndices+v, timeranges+v)) >= 0)
+        v += number;
+    batchTime = now() - start;
+    fprintf(stdout, "%-28s %8.3fs (x%.1f)\n", "gptReadBatch", batchTime, nextTime/batchTime);
+
+    pioCloseDatatype(&pioDatatype);
+    gptCloseServer(&server);
+
+    free(timeranges);
+    free(fileIndices);
+    free(labels);
+    free(data);
+    free(nextLabels);
+    free(nextData);
+    for (f=0; f<nfiles; f++)
+    {
+        remove(paths[f]);
+        free(paths[f]);
+    }
+    free(paths);
+    return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ *  bench_cache.c
+ *  pinocchIO
+ *
+ *  Measures Gepetto server creation time without index cache, with a cold cache,
+ *  with a warm cache and with a stale cache (once a file changed).
+ *  See test_ServerCache for correctness checks.
+ *
+ *  usage: bench_cache [nfiles [ntimeranges]]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gepetto/gepetto.h"
+#include "test_utils.h"
+
+#define BENCH_FILE "/tmp/bench_cache_%d.pio"
+#define CACHE_FILE "/tmp/bench_cache.cache"
+
+static void create(int f, int ntimeranges, int offset)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIOTimeline labelTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = PIODatatypeInvalid;
+    PIODatatype labelDatatype = PIODatatypeInvalid;
+    PIODataset pioDataset = PIODatasetInvalid;
+    PIOTimeRange* timeranges = NULL;
+    char path[256];
+    float data[4];
+    int label;
+    int t, d;
+
+    sprintf(path, BENCH_FILE, f);
+    pioFile = newFramesFile(path, ntimeranges, &pioTimeline);
+
+    pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, 4);
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    pioNewDatasetWriter(&pioDataset, 0);
+    for (t=0; t<ntimeranges; t++)
+    {
+        for (d=0; d<4; d++) data[d] = (float)(f+t+d+offset);
+        pioWrite(&pioDataset, t, data, t%5 == 4 ? 0 : 1, pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    // one label every 10 frames
+    timeranges = newFrames(ntimeranges/10);
+    for (t=0; t<ntimeranges/10; t++)
+    {
+        timeranges[t].time = 10*t;
+        timeranges[t].duration = 10;
+    }
+    labelTimeline = pioNewTimeline(pioFile, "shots", "shots", ntimeranges/10, timeranges);
+    labelDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    pioDataset = pioNewDataset(pioFile, "labels", "labels", labelTimeline, labelDatatype);
+    for (t=0; t<ntimeranges/10; t++)
+    {
+        label = (f+t)%3;
+        pioWrite(&pioDataset, t, &label, 1, labelDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    pioCloseDatatype(&labelDatatype);
+    pioCloseDatatype(&pioDatatype);
+    pioCloseTimeline(&labelTimeline);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+    free(timeranges);
+}
+
+// create server, then go through it
+static double bench(const char* name, char** paths, int nfiles, const char* cacheFile)
+{
+    GPTServer server = GPTServerInvalid;
+    GPTServerOptions options = GPTServerOptionsDefault;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, 4);
+    void* buffer = NULL;
+    double start, elapsed;
+
+    options.cacheFile = cacheFile;
+    start = now();
+    server = gptNewServerWithOptions(nfiles, paths, "features",
+                                     GEPETTO_LABEL_FILTER_TYPE_DIFFERS_FROM, 1, 100000,
+                                     nfiles, paths, "labels", options);
+    elapsed = now() - start;
+    if (GPTServerIsInvalid(server))
+    {
+        fprintf(stderr, "Could not create Gepetto server.\n");
+        exit(-1);
+    }
+
+    while (gptReadNext(&server, pioDatatype, &buffer, NULL, NULL) >= 0);
+
+    gptCloseServer(&server);
+    pioCloseDatatype(&pioDatatype);
+
+    fprintf(stdout, "%-28s %8.3fs\n", name, elapsed);
+    return elapsed;
+}
+
+int main (int argc, char *const  argv[])
+{
+    int nfiles = 200;
+    int ntimeranges = 10000;
+    char** paths = NULL;
+    int f;
+
+    if (argc > 1) nfiles = atoi(argv[1]);
+    if (argc > 2) ntimeranges = atoi(argv[2]);
+
+    paths = (char**) malloc(nfiles*sizeof(char*));
+    for (f=0; f<nfiles; f++)
+    {
+        create(f, ntimeranges, 0);
+        paths[f] = (char*) malloc(256);
+        sprintf(paths[f], BENCH_FILE, f);
+    }
+    remove(CACHE_FILE);
+
+    fprintf(stdout, "%d files, %d time ranges\n", nfiles, ntimeranges);
+
+    bench("no cache", paths, nfiles, NULL);
+    bench("cold cache", paths, nfiles, CACHE_FILE);
+    bench("warm cache", paths, nfiles, CACHE_FILE);
+
+    // change one file: cache is rebuilt
+    create(nfiles/2, ntimeranges/2, 1);
+    bench("no cache (changed file)", paths, nfiles, NULL);
+    bench("stale cache", paths, nfiles, CACHE_FILE);
+
+    for (f=0; f<nfiles; f++)
+    {
+        remove(paths[f]);
+        free(paths[f]);
+    }
+    free(paths);
+    remove(CACHE_FILE);
+    return 0;
+}
@@ -0,0 +1,92 @@
+/*
+ *  bench_chunking.c
+ *  pinocchIO
+ *
+ *  Compares write and sequential read throughput of the historical
+ *  one-entry-per-chunk layout with size-aware chunking.
+ *
+ *  usage: bench_chunking [ntimeranges [dimension]]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "test_utils.h"
+
+#define BENCH_FILE "/tmp/bench_chunking.pio"
+
+static int bench(const char* name, PIODatasetOptions options, int ntimeranges, int dimension)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = PIODatatypeInvalid;
+    PIODataset pioDataset = PIODatasetInvalid;
+    float* data = NULL;
+    void* buffer = NULL;
+    double start, write_time, read_time;
+    double megabytes;
+    int t, d;
+
+    data = (float*) malloc(dimension*sizeof(float));
+    for (d=0; d<dimension; d++) data[d] = (float)d;
+
+    pioFile = newFramesFile(BENCH_FILE, ntimeranges, &pioTimeline);
+    pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, dimension);
+
+    start = now();
+    pioDataset = pioNewDatasetWithOptions(pioFile, "features", "features",
+                                          pioTimeline, pioDatatype, options);
+    if (PIODatasetIsInvalid(pioDataset))
+    {
+        fprintf(stderr, "Could not create benchmark dataset.\n");
+        exit(-1);
+    }
+    for (t=0; t<ntimeranges; t++)
+        pioWrite(&pioDataset, t, data, 1, pioDatatype);
+    pioCloseDataset(&pioDataset);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+    write_time = now() - start;
+
+    start = now();
+    pioFile = pioOpenFile(BENCH_FILE, PINOCCHIO_READONLY);
+    pioDataset = pioOpenDataset(PIOMakeObject(pioFile), "features");
+    for (t=0; t<ntimeranges; t++)
+        if (pioReadData(&pioDataset, t, pioDatatype, &buffer) != 1)
+        {
+            fprintf(stderr, "Could not read timerange %d.\n", t);
+            exit(-1);
+        }
+    pioCloseDataset(&pioDataset);
+    pioCloseFile(&pioFile);
+    read_time = now() - start;
+
+    megabytes = ntimeranges*pioGetSize(pioDatatype)/1048576.;
+    fprintf(stdout, "%-10s write %8.3fs (%8.2f MB/s)  read %8.3fs (%8.2f MB/s)\n",
+            name, write_time, megabytes/write_time, read_time, megabytes/read_time);
+
+    pioCloseDatatype(&pioDatatype);
+    free(data);
+    remove(BENCH_FILE);
+    return 0;
+}
+
+int main (int argc, char *const  argv[])
+{
+    int ntimeranges = 100000;
+    int dimension = 16;
+    PIODatasetOptions historical = PIODatasetOptionsDefault;
+
+    if (argc > 1) ntimeranges = atoi(argv[1]);
+    if (argc > 2) dimension = atoi(argv[2]);
+
+    // one entry per data chunk, one link per link chunk
+    historical.chunk_size = 1;
+    historical.link_chunk_size = 1;
+
+    fprintf(stdout, "%d time ranges, %d-dimensional float vectors\n", ntimeranges, dimension);
+    bench("chunk={1}", historical, ntimeranges, dimension);
+    bench("default", PIODatasetOptionsDefault, ntimeranges, dimension);
+
+    return 0;
+}
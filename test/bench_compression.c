@@ -0,0 +1,132 @@
+/*
+ *  bench_compression.c
+ *  pinocchIO
+ *
+ *  Measures compression ratio (of the data part) and write/read throughput of
+ *  uncompressed, deflate and shuffle+deflate datasets
+ *  for float, double, int and char datatypes.
+ *
+ *  usage: bench_compression [ntimeranges [dimension]]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "test_utils.h"
+
+#define BENCH_FILE "/tmp/bench_compression.pio"
+
+// smooth, slowly varying values -- typical of audio/video features
+static void fill(void* data, PIODatatype pioDatatype, int t)
+{
+    int d;
+    double value;
+
+    for (d=0; d<pioDatatype.dimension; d++)
+    {
+        value = 100.*sin(0.001*t + 0.1*d);
+        switch (pioDatatype.type)
+        {
+            case PINOCCHIO_TYPE_FLOAT:  ((float*)data)[d] = (float)value; break;
+            case PINOCCHIO_TYPE_DOUBLE: ((double*)data)[d] = value; break;
+            case PINOCCHIO_TYPE_INT:    ((int*)data)[d] = (int)value; break;
+            case PINOCCHIO_TYPE_CHAR:   ((char*)data)[d] = (char)value; break;
+            default: break;
+        }
+    }
+}
+
+static void bench(const char* typeName, PIOBaseType type,
+                  const char* name, PIODatasetOptions options,
+                  int ntimeranges, int dimension)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = PIODatatypeInvalid;
+    PIODataset pioDataset = PIODatasetInvalid;
+    void* data = NULL;
+    void* buffer = NULL;
+    double start, write_time, read_time;
+    double megabytes;
+    hsize_t size;
+    int t;
+
+    pioFile = newFramesFile(BENCH_FILE, ntimeranges, &pioTimeline);
+    pioDatatype = pioNewDatatype(type, dimension);
+    data = malloc(pioGetSize(pioDatatype));
+
+    start = now();
+    pioDataset = pioNewDatasetWithOptions(pioFile, "features", "features",
+                                          pioTimeline, pioDatatype, options);
+    if (PIODatasetIsInvalid(pioDataset))
+    {
+        fprintf(stderr, "Could not create benchmark dataset.\n");
+        exit(-1);
+    }
+    pioNewDatasetWriter(&pioDataset, 0);
+    for (t=0; t<ntimeranges; t++)
+    {
+        fill(data, pioDatatype, t);
+        pioWrite(&pioDataset, t, data, 1, pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+    write_time = now() - start;
+
+    start = now();
+    pioFile = pioOpenFile(BENCH_FILE, PINOCCHIO_READONLY);
+    pioDataset = pioOpenDatasetWithFlags(PIOMakeObject(pioFile), "features",
+                                         PINOCCHIO_DATASET_PRELOAD_LINKS);
+    // storage size of data only (timeline and links are left out)
+    size = H5Dget_storage_size(pioDataset.identifier);
+    for (t=0; t<ntimeranges; t++)
+        if (pioReadData(&pioDataset, t, pioDatatype, &buffer) != 1)
+        {
+            fprintf(stderr, "Could not read timerange %d.\n", t);
+            exit(-1);
+        }
+    pioCloseDataset(&pioDataset);
+    pioCloseFile(&pioFile);
+    read_time = now() - start;
+
+    megabytes = ntimeranges*pioGetSize(pioDatatype)/1048576.;
+    fprintf(stdout, "%-6s %-16s %9.2f MB  ratio %6.2f  write %8.2f MB/s  read %8.2f MB/s\n",
+            typeName, name, size/1048576., 1048576.*megabytes/size,
+            megabytes/write_time, megabytes/read_time);
+
+    pioCloseDatatype(&pioDatatype);
+    free(data);
+    remove(BENCH_FILE);
+}
+
+int main (int argc, char *const  argv[])
+{
+    int ntimeranges = 100000;
+    int dimension = 16;
+    int i, j;
+
+    PIOBaseType types[4] = {PINOCCHIO_TYPE_FLOAT, PINOCCHIO_TYPE_DOUBLE,
+                            PINOCCHIO_TYPE_INT, PINOCCHIO_TYPE_CHAR};
+    const char* typeNames[4] = {"float", "double", "int", "char"};
+
+    PIODatasetOptions options[4];
+    const char* names[4] = {"none", "deflate=1", "deflate=6", "shuffle+deflate=6"};
+
+    if (argc > 1) ntimeranges = atoi(argv[1]);
+    if (argc > 2) dimension = atoi(argv[2]);
+
+    for (j=0; j<4; j++) options[j] = PIODatasetOptionsDefault;
+    options[1].compression = 1;
+    options[2].compression = 6;
+    options[3].compression = 6;
+    options[3].shuffle = 1;
+
+    fprintf(stdout, "%d time ranges, %d-dimensional vectors\n", ntimeranges, dimension);
+    for (i=0; i<4; i++)
+        for (j=0; j<4; j++)
+            bench(typeNames[i], types[i], names[j], options[j], ntimeranges, dimension);
+
+    return 0;
+}
@@ -0,0 +1,188 @@
+/*
+ *  bench_filter.c
+ *  pinocchIO
+ *
+ *  Measures how long it takes to switch a Gepetto server from one concept to
+ *  the next with gptSetLabelFilter() compared to creating a new server, and
+ *  how many timeranges simple and compound label filters serve.
+ *  See test_LabelFilter for correctness checks.
+ *
+ *  usage: bench_filter [nfiles [ntimeranges [nconcepts]]]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "gepetto/gepetto.h"
+#include "test_utils.h"
+
+#define BENCH_FILE "/tmp/bench_filter_%d.pio"
+
+static void create(int f, int ntimeranges, int nconcepts)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = PIODatatypeInvalid;
+    PIODataset pioDataset = PIODatasetInvalid;
+    char path[256];
+    float data[4];
+    int labels[3];
+    int t;
+
+    sprintf(path, BENCH_FILE, f);
+    pioFile = newFramesFile(path, ntimeranges, &pioTimeline);
+
+    pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, 2);
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    pioNewDatasetWriter(&pioDataset, 0);
+    for (t=0; t<ntimeranges; t++)
+    {
+        data[0] = data[2] = (float) f;
+        data[1] = data[3] = (float) t;
+        pioWrite(&pioDataset, t, data, t%7 == 6 ? 0 : 1+t%2, pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+    pioCloseDatatype(&pioDatatype);
+
+    // up to 3 concepts per time range, some of them negative
+    pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    pioDataset = pioNewDataset(pioFile, "labels", "labels", pioTimeline, pioDatatype);
+    for (t=0; t<ntimeranges; t++)
+    {
+        labels[0] = (t*7919 + f*104729) % nconcepts;
+        labels[1] = (t*31 + f) % nconcepts - nconcepts/2;
+        labels[2] = (t/10) % nconcepts;
+        pioWrite(&pioDataset, t, labels, 1+(t+f)%3, pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+    pioCloseDatatype(&pioDatatype);
+
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+}
+
+// number of served timeranges
+static int64_t served(GPTServer server)
+{
+    int64_t number = 0;
+    int f, t;
+
+    for (f=0; f<DAT_NFILES(server); f++)
+        for (t=0; t<DAT_NTIMERANGES(server, f); t++)
+            number += DAT_FILTERED(server, f, t);
+    return number;
+}
+
+int main (int argc, char *const  argv[])
+{
+    int nfiles = 10;
+    int ntimeranges = 100000;
+    int nconcepts = 1000;
+    char** paths = NULL;
+    GPTServer server = GPTServerInvalid;
+    GPTServer other = GPTServerInvalid;
+    GPTServerOptions options = GPTServerOptionsDefault;
+    double start, setTime, newTime;
+    int f, c, n;
+
+    int two[1] = {2};
+    int set[5] = {3, 17, 42, -5, 999};
+    int range[2] = {100, 299};
+    int hole[2] = {150, 160};
+    GPTLabelPredicate in_range[2] = {
+        {GEPETTO_LABEL_PREDICATE_IN_RANGE, 2, range, 0, NULL},
+        {GEPETTO_LABEL_PREDICATE_IN_RANGE, 2, hole, 0, NULL}};
+    GPTLabelPredicate not_hole = {GEPETTO_LABEL_PREDICATE_NOT, 0, NULL, 1, &(in_range[1])};
+    GPTLabelPredicate range_but_hole[2] = {
+        {GEPETTO_LABEL_PREDICATE_IN_RANGE, 2, range, 0, NULL},
+        {GEPETTO_LABEL_PREDICATE_NOT, 0, NULL, 1, &(in_range[1])}};
+    GPTLabelPredicate either[2] = {
+        {GEPETTO_LABEL_PREDICATE_IN_SET, 5, set, 0, NULL},
+        {GEPETTO_LABEL_PREDICATE_AND, 0, NULL, 2, range_but_hole}};
+    GPTLabelPredicate predicates[9] = {
+        {GEPETTO_LABEL_PREDICATE_ANY, 0, NULL, 0, NULL},
+        {GEPETTO_LABEL_PREDICATE_EQUALS_TO, 1, two, 0, NULL},
+        {GEPETTO_LABEL_PREDICATE_DIFFERS_FROM, 1, two, 0, NULL},
+        {GEPETTO_LABEL_PREDICATE_GREATER_THAN, 1, two, 0, NULL},
+        {GEPETTO_LABEL_PREDICATE_SMALLER_THAN, 1, two, 0, NULL},
+        {GEPETTO_LABEL_PREDICATE_IN_SET, 5, set, 0, NULL},
+        {GEPETTO_LABEL_PREDICATE_AND, 0, NULL, 2, in_range},
+        {GEPETTO_LABEL_PREDICATE_OR, 0, NULL, 2, either},
+        {GEPETTO_LABEL_PREDICATE_NOT, 0, NULL, 1, &not_hole}};
+    const char* names[9] = {"any", "equalsTo 2", "differsFrom 2", "greaterThan 2", "smallerThan 2",
+                            "in set", "and", "or", "not not"};
+    GPTLabelFilterType types[5] = {GEPETTO_LABEL_FILTER_TYPE_NONE,
+                                   GEPETTO_LABEL_FILTER_TYPE_EQUALS_TO,
+                                   GEPETTO_LABEL_FILTER_TYPE_DIFFERS_FROM,
+                                   GEPETTO_LABEL_FILTER_TYPE_GREATER_THAN,
+                                   GEPETTO_LABEL_FILTER_TYPE_SMALLER_THAN};
+    GPTLabelPredicate concept = {GEPETTO_LABEL_PREDICATE_EQUALS_TO, 1, &c, 0, NULL};
+
+    if (argc > 1) nfiles = atoi(argv[1]);
+    if (argc > 2) ntimeranges = atoi(argv[2]);
+    if (argc > 3) nconcepts = atoi(argv[3]);
+
+    paths = (char**) malloc(nfiles*sizeof(char*));
+    for (f=0; f<nfiles; f++)
+    {
+        create(f, ntimeranges, nconcepts);
+        paths[f] = (char*) malloc(256);
+        sprintf(paths[f], BENCH_FILE, f);
+    }
+
+    fprintf(stdout, "%d files, %d time ranges, %d concepts\n", nfiles, ntimeranges, nconcepts);
+
+    // simple filters
+    for (n=0; n<5; n++)
+    {
+        server = gptNewServer(nfiles, paths, "features", types[n], 2, -1,
+                              nfiles, paths, "labels");
+        if (GPTServerIsInvalid(server))
+        {
+            fprintf(stderr, "Could not create Gepetto server.\n");
+            exit(-1);
+        }
+        fprintf(stdout, "%-28s %10lld served time ranges\n", names[n], (long long)served(server));
+        gptCloseServer(&server);
+    }
+
+    // compound predicates, on the fly
+    options.labelPredicate = &(predicates[7]);
+    server = gptNewServerWithOptions(nfiles, paths, "features",
+                                     GEPETTO_LABEL_FILTER_TYPE_NONE, 0, -1,
+                                     nfiles, paths, "labels", options);
+    for (n=5; n<9; n++)
+    {
+        gptSetLabelFilter(&server, &(predicates[n]));
+        fprintf(stdout, "%-28s %10lld served time ranges\n", names[n], (long long)served(server));
+    }
+
+    // one concept after the other
+    start = now();
+    for (c=0; c<20; c++) gptSetLabelFilter(&server, &concept);
+    setTime = (now() - start)/20;
+
+    options.labelPredicate = &concept;
+    start = now();
+    for (c=0; c<5; c++)
+    {
+        other = gptNewServerWithOptions(nfiles, paths, "features",
+                                        GEPETTO_LABEL_FILTER_TYPE_NONE, 0, -1,
+                                        nfiles, paths, "labels", options);
+        gptCloseServer(&other);
+    }
+    newTime = (now() - start)/5;
+
+    fprintf(stdout, "%-28s %8.3fms per concept\n", "gptNewServer", 1e3*newTime);
+    fprintf(stdout, "%-28s %8.3fms per concept (x%.1f)\n", "gptSetLabelFilter", 1e3*setTime, newTime/setTime);
+
+    gptCloseServer(&server);
+
+    for (f=0; f<nfiles; f++)
+    {
+        remove(paths[f]);
+        free(paths[f]);
+    }
+    free(paths);
+    return 0;
+}
@@ -0,0 +1,189 @@
+/*
+ *  bench_iteration.c
+ *  pinocchIO
+ *
+ *  Measures how long an epoch takes in every iteration mode (shuffled depending
+ *  on the block size, round-robin per label, stratified), and how far blocks are
+ *  from the overall label distribution.
+ *  See test_IterationModes for correctness checks.
+ *
+ *  usage: bench_iteration [nfiles [ntimeranges]]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "gepetto/gepetto.h"
+#include "test_utils.h"
+
+#define BENCH_FILE "/tmp/bench_iteration_%d.pio"
+
+// 60% of label 0, 30% of label 1, 10% of label 2
+static int labelOf(int t)
+{
+    return (t%10 < 6) ? 0 : ((t%10 < 9) ? 1 : 2);
+}
+
+static void create(int f, int ntimeranges)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = PIODatatypeInvalid;
+    PIODataset pioDataset = PIODatasetInvalid;
+    char path[256];
+    int data[2];
+    int label;
+    int t;
+
+    sprintf(path, BENCH_FILE, f);
+    pioFile = newFramesFile(path, ntimeranges, &pioTimeline);
+
+    // each entry tells where it comes from
+    pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 2);
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    pioNewDatasetWriter(&pioDataset, 0);
+    for (t=0; t<ntimeranges; t++)
+    {
+        data[0] = f;
+        data[1] = t;
+        pioWrite(&pioDataset, t, data, 1, pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+    pioCloseDatatype(&pioDatatype);
+
+    pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    pioDataset = pioNewDataset(pioFile, "labels", "labels", pioTimeline, pioDatatype);
+    for (t=0; t<ntimeranges; t++)
+    {
+        label = labelOf(t);
+        pioWrite(&pioDataset, t, &label, 1, pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+    pioCloseDatatype(&pioDatatype);
+
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+}
+
+// one epoch with gptReadNext(): position (f*ntimeranges+t) of each served timerange
+static int epoch(GPTServer* server, int ntimeranges, int* order)
+{
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 2);
+    void* buffer = NULL;
+    int* labels = NULL;
+    int nLabels;
+    int n = 0;
+
+    while (gptReadNext(server, pioDatatype, &buffer, &nLabels, &labels) == 1)
+        order[n++] = ((int*)buffer)[0]*ntimeranges + ((int*)buffer)[1];
+    pioCloseDatatype(&pioDatatype);
+    return n;
+}
+
+// largest deviation (in timeranges) from the overall label distribution over every block
+static double stratification(const int* order, int n, int ntimeranges, int blockSize)
+{
+    double expected[3] = {0.6, 0.3, 0.1};
+    double worst = 0., deviation;
+    int count[3];
+    int b, i, l;
+
+    for (b=0; b+blockSize<=n; b+=blockSize)
+    {
+        count[0] = count[1] = count[2] = 0;
+        for (i=b; i<b+blockSize; i++) count[labelOf(order[i]%ntimeranges)]++;
+        for (l=0; l<3; l++)
+        {
+            deviation = count[l] - expected[l]*blockSize;
+            if (deviation < 0) deviation = -deviation;
+            if (deviation > worst) worst = deviation;
+        }
+    }
+    return worst;
+}
+
+int main (int argc, char *const  argv[])
+{
+    int nfiles = 20;
+    int ntimeranges = 2000;
+    char** paths = NULL;
+    GPTServer server = GPTServerInvalid;
+    PIODatatype pioDatatype = PIODatatypeInvalid;
+    int* order = NULL;
+    int* buffer = NULL;
+    int* labels = NULL;
+    int blockSizes[3] = {1, 256, 4096};
+    double start;
+    int f, i, n, total;
+
+    if (argc > 1) nfiles = atoi(argv[1]);
+    if (argc > 2) ntimeranges = atoi(argv[2]);
+    total = nfiles*ntimeranges;
+
+    paths = (char**) malloc(nfiles*sizeof(char*));
+    for (f=0; f<nfiles; f++)
+    {
+        create(f, ntimeranges);
+        paths[f] = (char*) malloc(256);
+        sprintf(paths[f], BENCH_FILE, f);
+    }
+    order = (int*) malloc(total*sizeof(int));
+
+    fprintf(stdout, "%d files, %d time ranges\n", nfiles, ntimeranges);
+
+    server = gptNewServer(nfiles, paths, "features",
+                          GEPETTO_LABEL_FILTER_TYPE_NONE, 0, -1,
+                          nfiles, paths, "labels");
+    if (GPTServerIsInvalid(server))
+    {
+        fprintf(stderr, "Could not create Gepetto server.\n");
+        exit(-1);
+    }
+
+    start = now();
+    epoch(&server, ntimeranges, order);
+    fprintf(stdout, "%-28s %8.3fs\n", "sequential", now()-start);
+
+    // shuffled epochs, depending on block size
+    for (i=0; i<3; i++)
+    {
+        gptSetIterationMode(&server, GEPETTO_ITERATION_MODE_SHUFFLE, 42, blockSizes[i]);
+        start = now();
+        epoch(&server, ntimeranges, order);
+        fprintf(stdout, "shuffle (block size %-4d)    %8.3fs\n", blockSizes[i], now()-start);
+    }
+
+    // label distribution over blocks
+    gptSetIterationMode(&server, GEPETTO_ITERATION_MODE_ROUND_ROBIN, 42, 1);
+    n = epoch(&server, ntimeranges, order);
+    fprintf(stdout, "%-28s %8.1f timeranges off in worst 30-block\n", "round-robin",
+            stratification(order, n, ntimeranges, 30));
+
+    gptSetIterationMode(&server, GEPETTO_ITERATION_MODE_STRATIFIED, 42, 1);
+    n = epoch(&server, ntimeranges, order);
+    fprintf(stdout, "%-28s %8.1f timeranges off in worst 30-block\n", "stratified",
+            stratification(order, n, ntimeranges, 30));
+
+    // stratified mini-batches with gptReadBatch()
+    gptSetIterationMode(&server, GEPETTO_ITERATION_MODE_STRATIFIED, 42, 100);
+    pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 2);
+    buffer = (int*) malloc(100*2*sizeof(int));
+    labels = (int*) malloc(100*sizeof(int));
+    start = now();
+    while (gptReadBatch(&server, pioDatatype, 100, buffer, labels, NULL, NULL) > 0);
+    fprintf(stdout, "%-28s %8.3fs\n", "stratified gptReadBatch", now()-start);
+
+    free(labels);
+    free(buffer);
+    pioCloseDatatype(&pioDatatype);
+    gptCloseServer(&server);
+
+    free(order);
+    for (f=0; f<nfiles; f++)
+    {
+        remove(paths[f]);
+        free(paths[f]);
+    }
+    free(paths);
+    return 0;
+}
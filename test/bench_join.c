@@ -0,0 +1,157 @@
+/*
+ *  bench_join.c
+ *  pinocchIO
+ *
+ *  Compares pioJoinTimeLines() with the former time range by time range matching
+ *  of a data timeline (frames) with a label timeline (segments at another scale).
+ *  See test_JoinTimeLines for correctness checks.
+ *
+ *  usage: bench_join [nframes]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test_utils.h"
+
+// 25 frames per second (some of them empty when holes is set)
+static PIOTimeRange* frames(int n, int holes)
+{
+    PIOTimeRange* timeranges = (PIOTimeRange*) malloc(n*sizeof(PIOTimeRange));
+    int t;
+
+    for (t=0; t<n; t++)
+    {
+        timeranges[t].time = t;
+        timeranges[t].duration = (holes && (t%97 == 0)) ? 0 : 1;
+        timeranges[t].scale = 25;
+    }
+    return timeranges;
+}
+
+// segments of 0.2 to 3 seconds, in milliseconds (with gaps when holes is set)
+static PIOTimeRange* segments(int64_t duration, int holes, int* n)
+{
+    PIOTimeRange* timeranges = NULL;
+    int64_t time = 0;
+    int capacity = 0;
+
+    *n = 0;
+    srand(42);
+    while (time < duration)
+    {
+        if (*n == capacity)
+        {
+            capacity = 2*capacity+1024;
+            timeranges = (PIOTimeRange*) realloc(timeranges, capacity*sizeof(PIOTimeRange));
+        }
+        timeranges[*n].time = time;
+        timeranges[*n].duration = 200 + rand()%2800;
+        timeranges[*n].scale = 1000;
+        time += timeranges[*n].duration;
+        if (holes && (rand()%4 == 0)) time += 5000;
+        (*n)++;
+    }
+    return timeranges;
+}
+
+// former matching loop of initDataFiltering()
+static void reference(PIOTimeRange* data, int ndata, PIOTimeRange* label, int nlabel, int* first, int* number)
+{
+    int data_t, label_t;
+
+    for (data_t=0; data_t<ndata; data_t++)
+    {
+        first[data_t] = -1;
+        number[data_t] = 0;
+
+        if (data_t == 0) label_t = 0;
+        else label_t = first[data_t-1] > 0 ? first[data_t-1] : 0;
+
+        while ((label_t < nlabel) &&
+               (pioCompareTimeRanges(label[label_t], data[data_t]) != PINOCCHIO_TIMERANGE_COMPARISON_DESCENDING) &&
+               (!pioTimeRangeIntersectsTimeRange(label[label_t], data[data_t])))
+            label_t++;
+
+        if ((label_t < nlabel) && pioTimeRangeIntersectsTimeRange(label[label_t], data[data_t]))
+        {
+            first[data_t] = label_t;
+            while ((label_t < nlabel) && pioTimeRangeIntersectsTimeRange(label[label_t], data[data_t]))
+            {
+                number[data_t]++;
+                label_t++;
+            }
+        }
+    }
+}
+
+static void bench(int nframes, int holes)
+{
+    PIOTimeRange* data = NULL;
+    PIOTimeRange* label = NULL;
+    int nlabel;
+    int* expectedFirst = NULL;
+    int* expectedNumber = NULL;
+    int* first = NULL;
+    int* number = NULL;
+    double start, referenceTime, joinTime;
+
+    data = frames(nframes, holes);
+    label = segments(40LL*nframes, holes, &nlabel);
+
+    expectedFirst = (int*) malloc(nframes*sizeof(int));
+    expectedNumber = (int*) malloc(nframes*sizeof(int));
+    first = (int*) malloc(nframes*sizeof(int));
+    number = (int*) malloc(nframes*sizeof(int));
+    // page in output arrays before timing
+    memset(expectedFirst, 0, nframes*sizeof(int));
+    memset(expectedNumber, 0, nframes*sizeof(int));
+    memset(first, 0, nframes*sizeof(int));
+    memset(number, 0, nframes*sizeof(int));
+
+    fprintf(stdout, "%d frames, %d segments%s\n", nframes, nlabel, holes ? " (with gaps and empty frames)" : "");
+
+    start = now();
+    reference(data, nframes, label, nlabel, expectedFirst, expectedNumber);
+    referenceTime = now() - start;
+    fprintf(stdout, "%-28s %8.3fs\n", "time range by time range", referenceTime);
+
+    start = now();
+    if (pioJoinTimeLines(data, nframes, label, nlabel, first, number) < 0)
+    {
+        fprintf(stderr, "Could not join timelines.\n");
+        exit(-1);
+    }
+    joinTime = now() - start;
+    fprintf(stdout, "%-28s %8.3fs (x%.1f)\n", "pioJoinTimeLines", joinTime, referenceTime/joinTime);
+
+    // without scale normalization (common scale does not fit in 64 bits)
+    label[0].scale = 2147483629;
+    label[0].time = 0;
+    label[0].duration = 429496726;
+    data[0].scale = 2147483587;
+    start = now();
+    pioJoinTimeLines(data, nframes, label, nlabel, first, number);
+    fprintf(stdout, "%-28s %8.3fs\n", "pioJoinTimeLines (mixed)", now() - start);
+
+    free(number);
+    free(first);
+    free(expectedNumber);
+    free(expectedFirst);
+    free(label);
+    free(data);
+}
+
+int main (int argc, char *const  argv[])
+{
+    int nframes = 10000000;
+
+    if (argc > 1) nframes = atoi(argv[1]);
+
+    bench(nframes, 0);
+    // former matching restarts from the beginning after each unmatched time range
+    bench(nframes < 20000 ? nframes : 20000, 1);
+
+    return 0;
+}
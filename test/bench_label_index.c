@@ -0,0 +1,158 @@
+/*
+ *  bench_label_index.c
+ *  pinocchIO
+ *
+ *  Measures gptGetTimerangesForLabel() and gptGetTimerangesForLabelNoCopy()
+ *  for every label value, against a scan of all label timeranges.
+ *  See test_LabelIndex for correctness checks.
+ *
+ *  usage: bench_label_index [nfiles [ntimeranges [nlabels]]]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "gepetto/gepetto.h"
+#include "test_utils.h"
+
+#define BENCH_FILE "/tmp/bench_label_index_%d.pio"
+
+static void create(int f, int ntimeranges, int nlabels)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype labelDatatype = PIODatatypeInvalid;
+    PIODataset pioDataset = PIODatasetInvalid;
+    PIOTimeRange* timeranges = NULL;
+    char path[256];
+    int labels[3];
+    int t;
+
+    timeranges = (PIOTimeRange*) malloc(ntimeranges*sizeof(PIOTimeRange));
+    for (t=0; t<ntimeranges; t++)
+    {
+        timeranges[t].time = 10*t;
+        timeranges[t].duration = 10;
+        timeranges[t].scale = 25;
+    }
+
+    sprintf(path, BENCH_FILE, f);
+    remove(path);
+    pioFile = pioNewFile(path, "/path/to/medium");
+    pioTimeline = pioNewTimeline(pioFile, "shots", "shots", ntimeranges, timeranges);
+
+    // up to 3 labels per timerange, sometimes twice the same
+    labelDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    pioDataset = pioNewDataset(pioFile, "labels", "labels", pioTimeline, labelDatatype);
+    pioNewDatasetWriter(&pioDataset, 0);
+    for (t=0; t<ntimeranges; t++)
+    {
+        labels[0] = rand()%nlabels;
+        labels[1] = rand()%nlabels;
+        labels[2] = (t%7 == 0) ? labels[0] : rand()%nlabels;
+        pioWrite(&pioDataset, t, labels, 1+t%3, labelDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    pioCloseDatatype(&labelDatatype);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+    free(timeranges);
+}
+
+// scan every label timerange of every file
+static int scan(GPTServer server, int labelValue, GPTTimeRange* timeranges)
+{
+    int f, t, i;
+    int number = 0;
+
+    for (f=0; f<LBL_NFILES(server); f++)
+        for (t=0; t<LBL_NTIMERANGES(server, f); t++)
+            for (i=0; i<LBL_NLABELS(server, f, t); i++)
+                if (LBL_LABEL(server, f, t, i) == labelValue)
+                {
+                    timeranges[number].fileIndex = f;
+                    timeranges[number].timerange = LBL_TIMERANGE(server, f, t);
+                    number++;
+                    break;
+                }
+    return number;
+}
+
+int main (int argc, char *const  argv[])
+{
+    int nfiles = 50;
+    int ntimeranges = 2000;
+    int nlabels = 500;
+    char** paths = NULL;
+    GPTServer server = GPTServerInvalid;
+    GPTTimeRange* expected = NULL;
+    GPTTimeRange* copied = NULL;
+    const GPTTimeRange* indexed = NULL;
+    int* labels = NULL;
+    int numberOfLabels;
+    double start, scanTime, copyTime, noCopyTime;
+    int f, n, number, total;
+
+    if (argc > 1) nfiles = atoi(argv[1]);
+    if (argc > 2) ntimeranges = atoi(argv[2]);
+    if (argc > 3) nlabels = atoi(argv[3]);
+
+    srand(42);
+    paths = (char**) malloc(nfiles*sizeof(char*));
+    for (f=0; f<nfiles; f++)
+    {
+        create(f, ntimeranges, nlabels);
+        paths[f] = (char*) malloc(256);
+        sprintf(paths[f], BENCH_FILE, f);
+    }
+
+    server = gptNewServer(0, NULL, NULL, GEPETTO_LABEL_FILTER_TYPE_NONE, 0, -1,
+                          nfiles, paths, "labels");
+    if (GPTServerIsInvalid(server))
+    {
+        fprintf(stderr, "Could not create Gepetto server.\n");
+        exit(-1);
+    }
+
+    numberOfLabels = gptGetListOfDistinctLabels(server, NULL);
+    labels = (int*) malloc(numberOfLabels*sizeof(int));
+    gptGetListOfDistinctLabels(server, labels);
+    expected = (GPTTimeRange*) malloc(nfiles*ntimeranges*sizeof(GPTTimeRange));
+    copied = (GPTTimeRange*) malloc(nfiles*ntimeranges*sizeof(GPTTimeRange));
+
+    fprintf(stdout, "%d files, %d time ranges, %d distinct labels\n", nfiles, ntimeranges, numberOfLabels);
+
+    start = now();
+    for (n=0, total=0; n<numberOfLabels; n++) total += scan(server, labels[n], expected);
+    scanTime = now() - start;
+    fprintf(stdout, "%-32s %8.3fms per label\n", "scan", 1e3*scanTime/numberOfLabels);
+
+    start = now();
+    for (n=0, total=0; n<numberOfLabels; n++)
+    {
+        number = gptGetTimerangesForLabel(server, labels[n], NULL);
+        total += gptGetTimerangesForLabel(server, labels[n], copied);
+    }
+    copyTime = now() - start;
+    fprintf(stdout, "%-32s %8.3fms per label (x%.0f)\n", "gptGetTimerangesForLabel",
+            1e3*copyTime/numberOfLabels, scanTime/copyTime);
+
+    start = now();
+    for (n=0, total=0; n<numberOfLabels; n++) total += gptGetTimerangesForLabelNoCopy(server, labels[n], &indexed);
+    noCopyTime = now() - start;
+    fprintf(stdout, "%-32s %8.3fms per label (x%.0f)\n", "gptGetTimerangesForLabelNoCopy",
+            1e3*noCopyTime/numberOfLabels, scanTime/noCopyTime);
+
+    gptCloseServer(&server);
+    free(copied);
+    free(expected);
+    free(labels);
+    for (f=0; f<nfiles; f++)
+    {
+        remove(paths[f]);
+        free(paths[f]);
+    }
+    free(paths);
+    return 0;
+}
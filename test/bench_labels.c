@@ -0,0 +1,110 @@
+/*
+ *  bench_labels.c
+ *  pinocchIO
+ *
+ *  Measures Gepetto server creation time with many distinct label values
+ *  (several labels per timerange, e.g. concept IDs).
+ *  See test_LabelCounts for correctness checks.
+ *
+ *  usage: bench_labels [nfiles [ntimeranges [nlabels [labelsPerTimerange]]]]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "gepetto/gepetto.h"
+#include "test_utils.h"
+
+#define BENCH_FILE "/tmp/bench_labels_%d.pio"
+
+static void create(int f, int ntimeranges, int nlabels, int labelsPerTimerange)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = PIODatatypeInvalid;
+    PIODatatype labelDatatype = PIODatatypeInvalid;
+    PIODataset pioDataset = PIODatasetInvalid;
+    char path[256];
+    float data[4] = {0., 1., 2., 3.};
+    int* labels = NULL;
+    int t, l;
+
+    labels = (int*) malloc(labelsPerTimerange*sizeof(int));
+
+    sprintf(path, BENCH_FILE, f);
+    pioFile = newFramesFile(path, ntimeranges, &pioTimeline);
+
+    pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, 2);
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    pioNewDatasetWriter(&pioDataset, 0);
+    for (t=0; t<ntimeranges; t++)
+        pioWrite(&pioDataset, t, data, 1+t%2, pioDatatype);
+    pioCloseDataset(&pioDataset);
+
+    // sparse, scattered concept IDs (possibly repeated within a timerange)
+    labelDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    pioDataset = pioNewDataset(pioFile, "labels", "labels", pioTimeline, labelDatatype);
+    pioNewDatasetWriter(&pioDataset, 0);
+    for (t=0; t<ntimeranges; t++)
+    {
+        for (l=0; l<labelsPerTimerange; l++)
+            labels[l] = 1000*(rand()%nlabels) - 7;
+        pioWrite(&pioDataset, t, labels, labelsPerTimerange, labelDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    pioCloseDatatype(&labelDatatype);
+    pioCloseDatatype(&pioDatatype);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+    free(labels);
+}
+
+int main (int argc, char *const  argv[])
+{
+    int nfiles = 20;
+    int ntimeranges = 10000;
+    int nlabels = 5000;
+    int labelsPerTimerange = 5;
+    char** paths = NULL;
+    GPTServer server = GPTServerInvalid;
+    double start;
+    int f;
+
+    if (argc > 1) nfiles = atoi(argv[1]);
+    if (argc > 2) ntimeranges = atoi(argv[2]);
+    if (argc > 3) nlabels = atoi(argv[3]);
+    if (argc > 4) labelsPerTimerange = atoi(argv[4]);
+
+    srand(42);
+    paths = (char**) malloc(nfiles*sizeof(char*));
+    for (f=0; f<nfiles; f++)
+    {
+        create(f, ntimeranges, nlabels, labelsPerTimerange);
+        paths[f] = (char*) malloc(256);
+        sprintf(paths[f], BENCH_FILE, f);
+    }
+
+    start = now();
+    server = gptNewServer(nfiles, paths, "features",
+                          GEPETTO_LABEL_FILTER_TYPE_NONE, 0, -1,
+                          nfiles, paths, "labels");
+    if (GPTServerIsInvalid(server))
+    {
+        fprintf(stderr, "Could not create Gepetto server.\n");
+        exit(-1);
+    }
+    fprintf(stdout, "%d files, %d time ranges, %d labels per time range, %d distinct labels\n",
+            nfiles, ntimeranges, labelsPerTimerange, LBL_NUMBER(server));
+    fprintf(stdout, "%-28s %8.3fs\n", "gptNewServer", now() - start);
+
+    gptCloseServer(&server);
+
+    for (f=0; f<nfiles; f++)
+    {
+        remove(paths[f]);
+        free(paths[f]);
+    }
+    free(paths);
+    return 0;
+}
@@ -0,0 +1,104 @@
+/*
+ *  bench_lazy.c
+ *  pinocchIO
+ *
+ *  Compares how long it takes to open a large timeline and get its length
+ *  with pioOpenTimeline() and with lazy timelines (PINOCCHIO_TIMELINE_LAZY),
+ *  and how long pioGetTimeRange() takes to page in time ranges.
+ *  See test_LazyTimeline for correctness checks.
+ *
+ *  usage: bench_lazy [ntimeranges [nopen]]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "test_utils.h"
+
+#define BENCH_FILE "/tmp/bench_lazy.pio"
+
+int main (int argc, char *const  argv[])
+{
+    int ntimeranges = 5000000;
+    int nopen = 20;
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIOTimeline lazy = PIOTimelineInvalid;
+    PIODatatype pioDatatype = PIODatatypeInvalid;
+    PIODataset pioDataset = PIODatasetInvalid;
+    PIOTimeRange* timeranges = NULL;
+    double start, eagerTime, lazyTime;
+    int64_t length = 0;
+    int i, t;
+
+    if (argc > 1) ntimeranges = atoi(argv[1]);
+    if (argc > 2) nopen = atoi(argv[2]);
+
+    // frames at 25 Hz, with a few gaps
+    timeranges = (PIOTimeRange*) malloc(ntimeranges*sizeof(PIOTimeRange));
+    for (t=0; t<ntimeranges; t++)
+    {
+        timeranges[t].time = t + t/1000;
+        timeranges[t].duration = 1;
+        timeranges[t].scale = 25;
+    }
+
+    remove(BENCH_FILE);
+    pioFile = pioNewFile(BENCH_FILE, "/path/to/medium");
+    pioTimeline = pioNewTimeline(pioFile, "frames", "frames", ntimeranges, timeranges);
+    pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    pioCloseDataset(&pioDataset);
+    pioCloseDatatype(&pioDatatype);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+
+    fprintf(stdout, "%d time ranges\n", ntimeranges);
+
+    pioFile = pioOpenFile(BENCH_FILE, PINOCCHIO_READONLY);
+    pioDataset = pioOpenDataset(PIOMakeObject(pioFile), "features");
+
+    // length of timeline of dataset (what piols does)
+    start = now();
+    for (i=0; i<nopen; i++)
+    {
+        pioTimeline = pioGetTimeline(pioDataset);
+        length += pioTimeline.ntimeranges;
+        pioCloseTimeline(&pioTimeline);
+    }
+    eagerTime = (now() - start)/nopen;
+    start = now();
+    for (i=0; i<nopen; i++)
+    {
+        pioTimeline = pioGetTimelineWithFlags(pioDataset, PINOCCHIO_TIMELINE_LAZY);
+        length -= pioTimeline.ntimeranges;
+        pioCloseTimeline(&pioTimeline);
+    }
+    lazyTime = (now() - start)/nopen;
+    fprintf(stdout, "%-28s %8.3fms %8.3fms (x%.0f)\n", "timeline length",
+            1e3*eagerTime, 1e3*lazyTime, eagerTime/lazyTime);
+
+    lazy = pioOpenTimelineWithFlags(PIOMakeObject(pioFile), "frames", PINOCCHIO_TIMELINE_LAZY);
+
+    // going through the whole timeline, window after window
+    start = now();
+    for (t=0; t<ntimeranges; t++) length += pioGetTimeRange(&lazy, t).duration;
+    fprintf(stdout, "%-28s %8.3fms\n", "pioGetTimeRange (in order)", 1e3*(now() - start));
+
+    // random time ranges
+    srand(42);
+    start = now();
+    for (i=0; i<10000; i++)
+    {
+        t = (int)(((int64_t)rand()*RAND_MAX + rand()) % ntimeranges);
+        length += pioGetTimeRange(&lazy, t).duration;
+    }
+    fprintf(stdout, "%-28s %8.3fus\n", "pioGetTimeRange (random)", 1e6*(now() - start)/10000);
+
+    pioCloseTimeline(&lazy);
+    pioCloseDataset(&pioDataset);
+    pioCloseFile(&pioFile);
+    remove(BENCH_FILE);
+    free(timeranges);
+    return 0;
+}
@@ -0,0 +1,144 @@
+/*
+ *  bench_lookup.c
+ *  pinocchIO
+ *
+ *  Compares how long pioFindTimeRangeInTimeLine(), pioFindTimeRangesContainingTime()
+ *  and pioFindTimeRangesIntersectingTimeRange() queries take with a linear scan
+ *  of timelines with and without overlapping time ranges.
+ *  See test_Lookup for correctness checks.
+ *
+ *  usage: bench_lookup [ntimeranges [nqueries]]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "test_utils.h"
+
+#define MAX_INDICES 100000
+
+static int compare(const void* tr1, const void* tr2)
+{
+    return pioCompareTimeRanges(*(PIOTimeRange*)tr1, *(PIOTimeRange*)tr2);
+}
+
+// segments (in milliseconds) of 10 to 100 ms, some of them much longer
+// and overlapping many others when overlap is set
+static PIOTimeRange* segments(int n, int overlap)
+{
+    PIOTimeRange* timeranges = (PIOTimeRange*) malloc(n*sizeof(PIOTimeRange));
+    int64_t time = 0;
+    int t;
+
+    for (t=0; t<n; t++)
+    {
+        timeranges[t].time = time;
+        timeranges[t].duration = 10 + rand()%90;
+        timeranges[t].scale = 1000;
+        if (overlap)
+        {
+            if (rand()%100 == 0) timeranges[t].duration = rand()%100000;
+            time += rand()%50;
+        }
+        else
+            time += timeranges[t].duration + rand()%10;
+    }
+    qsort(timeranges, n, sizeof(PIOTimeRange), compare);
+    return timeranges;
+}
+
+static int linearContaining(PIOTimeRange* tl, int n, PIOTime time, int* indices)
+{
+    int t, number = 0;
+    for (t=0; t<n; t++)
+        if (pioTimeInTimeRange(time, tl[t])) indices[number++] = t;
+    return number;
+}
+
+static int linearIntersecting(PIOTimeRange* tl, int n, PIOTimeRange tr, int* indices)
+{
+    int t, number = 0;
+    for (t=0; t<n; t++)
+        if (pioTimeRangeIntersectsTimeRange(tl[t], tr)) indices[number++] = t;
+    return number;
+}
+
+static void bench(int n, int nqueries, int overlap)
+{
+    PIOTimeRange* tl = segments(n, overlap);
+    PIOTime* maxStops = (PIOTime*) malloc(n*sizeof(PIOTime));
+    PIOTime* times = (PIOTime*) malloc(nqueries*sizeof(PIOTime));
+    PIOTimeRange* periods = (PIOTimeRange*) malloc(nqueries*sizeof(PIOTimeRange));
+    int* indices = (int*) malloc(MAX_INDICES*sizeof(int));
+    int* expected = (int*) malloc(MAX_INDICES*sizeof(int));
+    int* picked = (int*) malloc(nqueries*sizeof(int));
+    PIOTime* stops = overlap ? maxStops : NULL;
+    int64_t extent = tl[n-1].time;
+    double start, linearTime, lookupTime;
+    int64_t found = 0;
+    int nlinear = nqueries < 200 ? nqueries : 200;
+    int q;
+
+    pioGetTimeLineMaximumStops(tl, n, maxStops);
+
+    // queries at 90 kHz, periods of up to one second
+    for (q=0; q<nqueries; q++)
+    {
+        times[q] = (PIOTime){(((int64_t)rand()*RAND_MAX + rand()) % (extent+1000))*90, 90000};
+        periods[q] = (PIOTimeRange){times[q].time, rand()%90000, 90000};
+    }
+
+    fprintf(stdout, "%d %s time ranges, %d queries\n", n, overlap ? "overlapping" : "consecutive", nqueries);
+
+    // timestamps
+    start = now();
+    for (q=0; q<nlinear; q++) linearContaining(tl, n, times[q], expected);
+    linearTime = (now() - start)/nlinear;
+    start = now();
+    for (q=0; q<nqueries; q++)
+        found += pioFindTimeRangesContainingTime(tl, stops, n, times[q], indices, MAX_INDICES);
+    lookupTime = (now() - start)/nqueries;
+    fprintf(stdout, "%-28s %8.3fus %8.3fus (x%.0f), %.1f time ranges per query\n", "containing timestamp",
+            1e6*linearTime, 1e6*lookupTime, linearTime/lookupTime, (double)found/nqueries);
+
+    // periods
+    found = 0;
+    start = now();
+    for (q=0; q<nlinear; q++) linearIntersecting(tl, n, periods[q], expected);
+    linearTime = (now() - start)/nlinear;
+    start = now();
+    for (q=0; q<nqueries; q++)
+        found += pioFindTimeRangesIntersectingTimeRange(tl, stops, n, periods[q], indices, MAX_INDICES);
+    lookupTime = (now() - start)/nqueries;
+    fprintf(stdout, "%-28s %8.3fus %8.3fus (x%.0f), %.1f time ranges per query\n", "intersecting period",
+            1e6*linearTime, 1e6*lookupTime, linearTime/lookupTime, (double)found/nqueries);
+
+    // search of time ranges
+    for (q=0; q<nqueries; q++) picked[q] = (int)(((int64_t)rand()*RAND_MAX + rand()) % n);
+    start = now();
+    for (q=0; q<nqueries; q++) pioFindTimeRangeInTimeLine(tl[picked[q]], tl, n);
+    fprintf(stdout, "%-28s %8s   %8.3fus\n", "pioFindTimeRangeInTimeLine", "", 1e6*(now() - start)/nqueries);
+
+    free(picked);
+    free(expected);
+    free(indices);
+    free(periods);
+    free(times);
+    free(maxStops);
+    free(tl);
+}
+
+int main (int argc, char *const  argv[])
+{
+    int ntimeranges = 1000000;
+    int nqueries = 100000;
+
+    if (argc > 1) ntimeranges = atoi(argv[1]);
+    if (argc > 2) nqueries = atoi(argv[2]);
+
+    srand(42);
+    bench(ntimeranges, nqueries, 0);
+    bench(ntimeranges, nqueries, 1);
+
+    return 0;
+}
@@ -0,0 +1,112 @@
+/*
+ *  bench_mmap.c
+ *  pinocchIO
+ *
+ *  Measures random-access pioReadData() latency on a sealed dataset,
+ *  with and without memory-mapping.
+ *  See test_SealDataset for correctness checks.
+ *
+ *  usage: bench_mmap [ntimeranges [dimension]]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "test_utils.h"
+
+#define BENCH_FILE "/tmp/bench_mmap.pio"
+
+static void create(int ntimeranges, int dimension)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = PIODatatypeInvalid;
+    PIODataset pioDataset = PIODatasetInvalid;
+    float* data = NULL;
+    int t, d;
+
+    // up to 3 entries per time range
+    data = (float*) malloc(3*dimension*sizeof(float));
+
+    pioFile = newFramesFile(BENCH_FILE, ntimeranges, &pioTimeline);
+    pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, dimension);
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    pioNewDatasetWriter(&pioDataset, 0);
+    for (t=0; t<ntimeranges; t++)
+    {
+        for (d=0; d<3*dimension; d++) data[d] = (float)(t+d);
+        pioWrite(&pioDataset, t, data, t%4 == 3 ? 0 : 1+t%3, pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    if (!pioSealDataset(PIOMakeObject(pioFile), "features"))
+    {
+        fprintf(stderr, "Could not seal dataset.\n");
+        exit(-1);
+    }
+
+    pioCloseDatatype(&pioDatatype);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+    free(data);
+}
+
+static double bench(int flags, int* order, int ntimeranges, int dimension)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIODatatype pioDatatype = PIODatatypeInvalid;
+    PIODataset pioDataset = PIODatasetInvalid;
+    void* buffer = NULL;
+    double start, elapsed;
+    int t;
+
+    pioFile = pioOpenFile(BENCH_FILE, PINOCCHIO_READONLY);
+    pioDataset = pioOpenDatasetWithFlags(PIOMakeObject(pioFile), "features", flags);
+    pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, dimension);
+
+    start = now();
+    for (t=0; t<ntimeranges; t++) pioReadData(&pioDataset, order[t], pioDatatype, &buffer);
+    elapsed = now() - start;
+
+    pioCloseDatatype(&pioDatatype);
+    pioCloseDataset(&pioDataset);
+    pioCloseFile(&pioFile);
+
+    return 1e6*elapsed/ntimeranges;
+}
+
+int main (int argc, char *const  argv[])
+{
+    int ntimeranges = 200000;
+    int dimension = 16;
+    int* order = NULL;
+    int t, swap, tmp;
+
+    if (argc > 1) ntimeranges = atoi(argv[1]);
+    if (argc > 2) dimension = atoi(argv[2]);
+
+    create(ntimeranges, dimension);
+
+    // random access order
+    order = (int*) malloc(ntimeranges*sizeof(int));
+    for (t=0; t<ntimeranges; t++) order[t] = t;
+    srand(42);
+    for (t=ntimeranges-1; t>0; t--)
+    {
+        swap = rand() % (t+1);
+        tmp = order[t]; order[t] = order[swap]; order[swap] = tmp;
+    }
+
+    fprintf(stdout, "%d time ranges, %d-dimensional float vectors, random order\n",
+            ntimeranges, dimension);
+    fprintf(stdout, "%-28s %8.3f us/timerange\n", "pioReadData",
+            bench(PINOCCHIO_DATASET_DEFAULT, order, ntimeranges, dimension));
+    fprintf(stdout, "%-28s %8.3f us/timerange\n", "pioReadData (cached links)",
+            bench(PINOCCHIO_DATASET_PRELOAD_LINKS, order, ntimeranges, dimension));
+    fprintf(stdout, "%-28s %8.3f us/timerange\n", "pioReadData (mmap)",
+            bench(PINOCCHIO_DATASET_MMAP, order, ntimeranges, dimension));
+
+    free(order);
+    remove(BENCH_FILE);
+    return 0;
+}
@@ -0,0 +1,134 @@
+/*
+ *  bench_pool.c
+ *  pinocchIO
+ *
+ *  Compares random reads across many pinocchIO files when files and datasets are
+ *  opened for each read with the same reads through a pool of open handles
+ *  (pioNewPool()). Pool behaviour is checked by test_Pool.
+ *
+ *  usage: bench_pool [nfiles [ntimeranges [nreads [poolsize]]]]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test_utils.h"
+
+#define BENCH_FILE "/tmp/bench_pool_%d.pio"
+
+static void create(int f, int ntimeranges)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = PIODatatypeInvalid;
+    PIODataset pioDataset = PIODatasetInvalid;
+    char path[256];
+    int data[2];
+    int t;
+
+    sprintf(path, BENCH_FILE, f);
+    pioFile = newFramesFile(path, ntimeranges, &pioTimeline);
+    pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 2);
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    pioNewDatasetWriter(&pioDataset, 0);
+    for (t=0; t<ntimeranges; t++)
+    {
+        data[0] = f;
+        data[1] = t;
+        pioWrite(&pioDataset, t, data, 1, pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+    pioCloseDatatype(&pioDatatype);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+}
+
+int main (int argc, char *const  argv[])
+{
+    int nfiles = 64;
+    int ntimeranges = 1000;
+    int nreads = 20000;
+    int poolsize = 16;
+    char** paths = NULL;
+    int* files = NULL;
+    int* timeranges = NULL;
+    PIODatatype pioDatatype = PIODatatypeInvalid;
+    PIOFile pioFile = PIOFileInvalid;
+    PIODataset pioDataset = PIODatasetInvalid;
+    PIODataset* pooled = NULL;
+    PIOPool* pool = NULL;
+    void* buffer = NULL;
+    double start, openTime, poolTime;
+    int f, i;
+
+    if (argc > 1) nfiles = atoi(argv[1]);
+    if (argc > 2) ntimeranges = atoi(argv[2]);
+    if (argc > 3) nreads = atoi(argv[3]);
+    if (argc > 4) poolsize = atoi(argv[4]);
+
+    paths = (char**) malloc(nfiles*sizeof(char*));
+    for (f=0; f<nfiles; f++)
+    {
+        create(f, ntimeranges);
+        paths[f] = (char*) malloc(256);
+        sprintf(paths[f], BENCH_FILE, f);
+    }
+
+    // most reads hit a few files, the others are spread over all of them
+    srand(42);
+    files = (int*) malloc(nreads*sizeof(int));
+    timeranges = (int*) malloc(nreads*sizeof(int));
+    for (i=0; i<nreads; i++)
+    {
+        files[i] = (rand()%10 < 8) ? rand()%(poolsize/2) : rand()%nfiles;
+        timeranges[i] = rand()%ntimeranges;
+    }
+
+    fprintf(stdout, "%d files, %d time ranges, %d random reads, pool of %d files\n",
+            nfiles, ntimeranges, nreads, poolsize);
+
+    pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 2);
+
+    start = now();
+    for (i=0; i<nreads; i++)
+    {
+        pioFile = pioOpenFile(paths[files[i]], PINOCCHIO_READONLY);
+        pioDataset = pioOpenDatasetWithFlags(PIOMakeObject(pioFile), "features",
+                                             PINOCCHIO_DATASET_PRELOAD_LINKS);
+        pioRead(&pioDataset, timeranges[i], pioDatatype, &buffer);
+        pioCloseDataset(&pioDataset);
+        pioCloseFile(&pioFile);
+    }
+    openTime = now() - start;
+    fprintf(stdout, "%-28s %8.3fs\n", "open for each read", openTime);
+
+    pool = pioNewPool(poolsize);
+    start = now();
+    for (i=0; i<nreads; i++)
+    {
+        pooled = pioPoolOpenDataset(pool, paths[files[i]], "features", PINOCCHIO_DATASET_PRELOAD_LINKS);
+        if (!pooled)
+        {
+            fprintf(stderr, "Could not open dataset from pool.\n");
+            exit(-1);
+        }
+        pioRead(pooled, timeranges[i], pioDatatype, &buffer);
+        pioPoolReleaseDataset(pool, pooled);
+    }
+    poolTime = now() - start;
+    fprintf(stdout, "%-28s %8.3fs (x%.1f)\n", "pool", poolTime, openTime/poolTime);
+
+    pioClosePool(&pool);
+
+    pioCloseDatatype(&pioDatatype);
+    free(timeranges);
+    free(files);
+    for (f=0; f<nfiles; f++)
+    {
+        remove(paths[f]);
+        free(paths[f]);
+    }
+    free(paths);
+    return 0;
+}
@@ -0,0 +1,177 @@
+/*
+ *  bench_prefetch.c
+ *  pinocchIO
+ *
+ *  Measures how long a consumer doing some work on each entry takes to go through
+ *  a Gepetto server with gptReadNext(), with and without read-ahead,
+ *  and how long the first entry takes to come.
+ *  See test_Prefetch for correctness checks.
+ *
+ *  usage: bench_prefetch [nfiles [ntimeranges [dimension [work]]]]
+ *
+ *  (work is the number of microseconds spent by the consumer on each timerange)
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "gepetto/gepetto.h"
+#include "test_utils.h"
+
+#define BENCH_FILE "/tmp/bench_prefetch_%d.pio"
+
+static void create(int f, int ntimeranges, int dimension)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = PIODatatypeInvalid;
+    PIODatatype labelDatatype = PIODatatypeInvalid;
+    PIODataset pioDataset = PIODatasetInvalid;
+    char path[256];
+    float* data = NULL;
+    int label;
+    int t, d;
+
+    // up to 2 entries per time range
+    data = (float*) malloc(2*dimension*sizeof(float));
+
+    sprintf(path, BENCH_FILE, f);
+    pioFile = newFramesFile(path, ntimeranges, &pioTimeline);
+
+    pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, dimension);
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    pioNewDatasetWriter(&pioDataset, 0);
+    for (t=0; t<ntimeranges; t++)
+    {
+        for (d=0; d<2*dimension; d++) data[d] = (float)(f+t+d);
+        pioWrite(&pioDataset, t, data, t%5 == 4 ? 0 : 1+t%2, pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    labelDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    pioDataset = pioNewDataset(pioFile, "labels", "labels", pioTimeline, labelDatatype);
+    for (t=0; t<ntimeranges; t++)
+    {
+        label = (f+t)%3;
+        pioWrite(&pioDataset, t, &label, 1, labelDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    pioCloseDatatype(&labelDatatype);
+    pioCloseDatatype(&pioDatatype);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+    free(data);
+}
+
+// drop files from page cache so that reads actually hit the disk
+static void evict(char** paths, int nfiles)
+{
+    int f, fd;
+    for (f=0; f<nfiles; f++)
+    {
+        fd = open(paths[f], O_RDONLY);
+        if (fd < 0) continue;
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+static void work(double microseconds)
+{
+    double start = now();
+    while (1e6*(now()-start) < microseconds);
+}
+
+// go through the server twice, switching to double precision in the middle of second pass
+// (latency is the time taken by the very first gptReadNext())
+static double bench(GPTServer* server, int dimension, double microseconds, double* latency)
+{
+    PIODatatype floatDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, dimension);
+    PIODatatype doubleDatatype = pioNewDatatype(PINOCCHIO_TYPE_DOUBLE, dimension);
+    void* buffer = NULL;
+    double start, elapsed;
+    int pass, count, number;
+
+    start = now();
+    for (pass=0; pass<2; pass++)
+    {
+        count = 0;
+        while (1)
+        {
+            if ((pass == 1) && (count > 1000))
+                number = gptReadNext(server, doubleDatatype, &buffer, NULL, NULL);
+            else
+                number = gptReadNext(server, floatDatatype, &buffer, NULL, NULL);
+            if ((pass == 0) && (count == 0)) *latency = now() - start;
+            if (number < 0) break;
+            count++;
+            work(microseconds);
+        }
+    }
+    elapsed = now() - start;
+
+    pioCloseDatatype(&doubleDatatype);
+    pioCloseDatatype(&floatDatatype);
+    return elapsed;
+}
+
+int main (int argc, char *const  argv[])
+{
+    int nfiles = 20;
+    int ntimeranges = 10000;
+    int dimension = 64;
+    double microseconds = 2.;
+    char** paths = NULL;
+    GPTServer server = GPTServerInvalid;
+    GPTServerOptions options = GPTServerOptionsDefault;
+    double elapsed, prefetchedElapsed;
+    double latency, prefetchedLatency;
+    int f;
+
+    if (argc > 1) nfiles = atoi(argv[1]);
+    if (argc > 2) ntimeranges = atoi(argv[2]);
+    if (argc > 3) dimension = atoi(argv[3]);
+    if (argc > 4) microseconds = atof(argv[4]);
+
+    paths = (char**) malloc(nfiles*sizeof(char*));
+    for (f=0; f<nfiles; f++)
+    {
+        create(f, ntimeranges, dimension);
+        paths[f] = (char*) malloc(256);
+        sprintf(paths[f], BENCH_FILE, f);
+    }
+
+    fprintf(stdout, "%d files, %d time ranges, %d-dimensional float vectors, %.1f us of work per time range\n",
+            nfiles, ntimeranges, dimension, microseconds);
+
+    server = gptNewServer(nfiles, paths, "features",
+                          GEPETTO_LABEL_FILTER_TYPE_DIFFERS_FROM, 1, -1,
+                          nfiles, paths, "labels");
+    evict(paths, nfiles);
+    elapsed = bench(&server, dimension, microseconds, &latency);
+    gptCloseServer(&server);
+    fprintf(stdout, "%-28s %8.3fs (first entry after %.3fms)\n", "gptReadNext", elapsed, 1e3*latency);
+
+    options.prefetchDepth = 256;
+    options.prefetchMemory = 16*1048576;
+    server = gptNewServerWithOptions(nfiles, paths, "features",
+                                     GEPETTO_LABEL_FILTER_TYPE_DIFFERS_FROM, 1, -1,
+                                     nfiles, paths, "labels", options);
+    evict(paths, nfiles);
+    prefetchedElapsed = bench(&server, dimension, microseconds, &prefetchedLatency);
+    gptCloseServer(&server);
+    fprintf(stdout, "%-28s %8.3fs (first entry after %.3fms)\n", "gptReadNext (read-ahead)", 
+            prefetchedElapsed, 1e3*prefetchedLatency);
+
+    for (f=0; f<nfiles; f++)
+    {
+        remove(paths[f]);
+        free(paths[f]);
+    }
+    free(paths);
+    return 0;
+}
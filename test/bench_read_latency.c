@@ -0,0 +1,94 @@
+/*
+ *  bench_read_latency.c
+ *  pinocchIO
+ *
+ *  Measures per-timerange latency of pioReadNumber() and pioReadData()
+ *  (with and without in-memory link table).
+ *
+ *  usage: bench_read_latency [ntimeranges [dimension]]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "test_utils.h"
+
+#define BENCH_FILE "/tmp/bench_read_latency.pio"
+
+static void create(int ntimeranges, int dimension)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = PIODatatypeInvalid;
+    PIODataset pioDataset = PIODatasetInvalid;
+    float* data = NULL;
+    int t, d;
+
+    data = (float*) malloc(dimension*sizeof(float));
+    for (d=0; d<dimension; d++) data[d] = (float)d;
+
+    pioFile = newFramesFile(BENCH_FILE, ntimeranges, &pioTimeline);
+    pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, dimension);
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    pioNewDatasetWriter(&pioDataset, 0);
+    for (t=0; t<ntimeranges; t++)
+        pioWrite(&pioDataset, t, data, 1, pioDatatype);
+    pioCloseDataset(&pioDataset);
+    pioCloseDatatype(&pioDatatype);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+    free(data);
+}
+
+static void bench(const char* name, int flags, int readData, int ntimeranges, int dimension)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIODatatype pioDatatype = PIODatatypeInvalid;
+    PIODataset pioDataset = PIODatasetInvalid;
+    void* buffer = NULL;
+    double start, elapsed;
+    int t;
+    int number;
+
+    pioFile = pioOpenFile(BENCH_FILE, PINOCCHIO_READONLY);
+    pioDataset = pioOpenDatasetWithFlags(PIOMakeObject(pioFile), "features", flags);
+    pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, dimension);
+
+    start = now();
+    for (t=0; t<ntimeranges; t++)
+    {
+        if (readData) number = pioReadData(&pioDataset, t, pioDatatype, &buffer);
+        else number = pioReadNumber(pioDataset, t);
+        if (number != 1)
+        {
+            fprintf(stderr, "Could not read timerange %d.\n", t);
+            exit(-1);
+        }
+    }
+    elapsed = now() - start;
+
+    fprintf(stdout, "%-28s %8.3f us/timerange\n", name, 1e6*elapsed/ntimeranges);
+
+    pioCloseDatatype(&pioDatatype);
+    pioCloseDataset(&pioDataset);
+    pioCloseFile(&pioFile);
+}
+
+int main (int argc, char *const  argv[])
+{
+    int ntimeranges = 200000;
+    int dimension = 16;
+
+    if (argc > 1) ntimeranges = atoi(argv[1]);
+    if (argc > 2) dimension = atoi(argv[2]);
+
+    create(ntimeranges, dimension);
+
+    fprintf(stdout, "%d time ranges, %d-dimensional float vectors\n", ntimeranges, dimension);
+    bench("pioReadNumber", PINOCCHIO_DATASET_DEFAULT, 0, ntimeranges, dimension);
+    bench("pioReadData", PINOCCHIO_DATASET_DEFAULT, 1, ntimeranges, dimension);
+    bench("pioReadData (cached links)", PINOCCHIO_DATASET_PRELOAD_LINKS, 1, ntimeranges, dimension);
+
+    remove(BENCH_FILE);
+    return 0;
+}
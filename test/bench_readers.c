@@ -0,0 +1,209 @@
+/*
+ *  bench_readers.c
+ *  pinocchIO
+ *
+ *  Measures how long an epoch takes when several threads consume their own shard
+ *  of a Gepetto server (gptNewReader()), and how balanced shards are, sharded by
+ *  file or by entries.
+ *  See test_Readers for correctness checks.
+ *
+ *  usage: bench_readers [nfiles [ntimeranges [work]]]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "gepetto/gepetto.h"
+#include "test_utils.h"
+
+#define BENCH_FILE "/tmp/bench_readers_%d.pio"
+#define MAX_THREADS 8
+
+typedef struct {
+    GPTServer* server;
+    GPTShardingMode mode;
+    int shard;
+    int numberOfShards;
+    int work;
+    int64_t entries;
+} consumer_t;
+
+// files do not have the same size, timeranges do not have the same number of entries
+static int sizeOf(int f, int ntimeranges)
+{
+    return ntimeranges*(1+f%3);
+}
+
+static int entriesOf(int t)
+{
+    return 1+t%3;
+}
+
+static void create(int f, int ntimeranges)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = PIODatatypeInvalid;
+    PIODataset pioDataset = PIODatasetInvalid;
+    char path[256];
+    int data[6];
+    int label;
+    int t, e;
+
+    sprintf(path, BENCH_FILE, f);
+    pioFile = newFramesFile(path, ntimeranges, &pioTimeline);
+
+    // each entry tells where it comes from
+    pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 2);
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    pioNewDatasetWriter(&pioDataset, 0);
+    for (t=0; t<ntimeranges; t++)
+    {
+        for (e=0; e<entriesOf(t); e++)
+        {
+            data[2*e] = f;
+            data[2*e+1] = t;
+        }
+        pioWrite(&pioDataset, t, data, entriesOf(t), pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+    pioCloseDatatype(&pioDatatype);
+
+    pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    pioDataset = pioNewDataset(pioFile, "labels", "labels", pioTimeline, pioDatatype);
+    for (t=0; t<ntimeranges; t++)
+    {
+        label = t%4;
+        pioWrite(&pioDataset, t, &label, 1, pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+    pioCloseDatatype(&pioDatatype);
+
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+}
+
+// simulated processing of one entry
+static void process(int work)
+{
+    volatile double x = 0.;
+    int i;
+    for (i=0; i<work; i++) x += i;
+}
+
+static void* consume(void* arg)
+{
+    consumer_t* consumer = (consumer_t*) arg;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 2);
+    GPTReader* reader = NULL;
+    void* buffer = NULL;
+    int* labels = NULL;
+    int nLabels;
+    int number, e;
+
+    reader = gptNewReaderWithSharding(consumer->server, consumer->shard,
+                                      consumer->numberOfShards, consumer->mode);
+    consumer->entries = 0;
+
+    while ((number = gptReaderReadNext(reader, pioDatatype, &buffer, &nLabels, &labels)) >= 0)
+    {
+        for (e=0; e<number; e++) process(consumer->work);
+        consumer->entries += number;
+    }
+
+    gptCloseReader(&reader);
+    pioCloseDatatype(&pioDatatype);
+    return NULL;
+}
+
+// one epoch with n threads, each of them consuming its own shard
+static double epoch(GPTServer* server, GPTShardingMode mode, int n, int work, double* imbalance)
+{
+    pthread_t threads[MAX_THREADS];
+    consumer_t consumers[MAX_THREADS];
+    int64_t maximum = 0, sum = 0;
+    double start, duration;
+    int s;
+
+    start = now();
+    for (s=0; s<n; s++)
+    {
+        consumers[s].server = server;
+        consumers[s].mode = mode;
+        consumers[s].shard = s;
+        consumers[s].numberOfShards = n;
+        consumers[s].work = work;
+        pthread_create(&(threads[s]), NULL, consume, &(consumers[s]));
+    }
+    for (s=0; s<n; s++) pthread_join(threads[s], NULL);
+    duration = now() - start;
+
+    for (s=0; s<n; s++)
+    {
+        if (consumers[s].entries > maximum) maximum = consumers[s].entries;
+        sum += consumers[s].entries;
+    }
+
+    // largest shard compared to a perfectly balanced one
+    *imbalance = sum ? ((double)maximum*n)/sum : 1.;
+    return duration;
+}
+
+int main (int argc, char *const  argv[])
+{
+    int nfiles = 10;
+    int ntimeranges = 2000;
+    int work = 2000;
+    int threads[4] = {1, 2, 4, 8};
+    char** paths = NULL;
+    GPTServer server = GPTServerInvalid;
+    double duration, single = 0., imbalance;
+    int f, i;
+
+    if (argc > 1) nfiles = atoi(argv[1]);
+    if (argc > 2) ntimeranges = atoi(argv[2]);
+    if (argc > 3) work = atoi(argv[3]);
+
+    paths = (char**) malloc(nfiles*sizeof(char*));
+    for (f=0; f<nfiles; f++)
+    {
+        create(f, sizeOf(f, ntimeranges));
+        paths[f] = (char*) malloc(256);
+        sprintf(paths[f], BENCH_FILE, f);
+    }
+
+    fprintf(stdout, "%d files, %d to %d time ranges\n", nfiles, ntimeranges, 3*ntimeranges);
+
+    server = gptNewServer(nfiles, paths, "features",
+                          GEPETTO_LABEL_FILTER_TYPE_DIFFERS_FROM, 3, -1,
+                          nfiles, paths, "labels");
+    if (GPTServerIsInvalid(server))
+    {
+        fprintf(stderr, "Could not create Gepetto server.\n");
+        exit(-1);
+    }
+
+    epoch(&server, GEPETTO_SHARDING_BY_FILE, 4, 0, &imbalance);
+    fprintf(stdout, "%-28s %8.3f x balanced shard\n", "4 shards by file", imbalance);
+    epoch(&server, GEPETTO_SHARDING_BY_ENTRIES, 4, 0, &imbalance);
+    fprintf(stdout, "%-28s %8.3f x balanced shard\n", "4 shards by entries", imbalance);
+
+    for (i=0; i<4; i++)
+    {
+        duration = epoch(&server, GEPETTO_SHARDING_BY_ENTRIES, threads[i], work, &imbalance);
+        if (i == 0) single = duration;
+        fprintf(stdout, "%d thread(s)                  %8.3fs (x%.1f)\n",
+                threads[i], duration, single/duration);
+    }
+
+    gptCloseServer(&server);
+
+    for (f=0; f<nfiles; f++)
+    {
+        remove(paths[f]);
+        free(paths[f]);
+    }
+    free(paths);
+    return 0;
+}
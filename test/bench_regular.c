@@ -0,0 +1,194 @@
+/*
+ *  bench_regular.c
+ *  pinocchIO
+ *
+ *  Stores the same frames as a regular timeline (pioNewRegularTimeline()) and as
+ *  an explicit one, compares their size and how long it takes to open them,
+ *  and compares constant-time lookups in regular timelines with lookups in
+ *  the explicit ones (overlapping windows, queries at other scales).
+ *  See test_RegularTimeline for correctness checks.
+ *
+ *  usage: bench_regular [ntimeranges [nqueries]]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "test_utils.h"
+
+#define BENCH_FILE "/tmp/bench_regular_%s.pio"
+#define MAX_INDICES 1000
+
+static int64_t random64(int64_t n)
+{
+    return (((int64_t)rand()*RAND_MAX + rand()) % n);
+}
+
+// queries (at 90 kHz) in regular timeline of n time ranges, and in explicit one
+static void bench(const char* name, PIOTimeRange first, int64_t step, int n, int nqueries)
+{
+    PIOTimeRange* tl = (PIOTimeRange*) malloc(n*sizeof(PIOTimeRange));
+    PIOTime* maxStops = (PIOTime*) malloc(n*sizeof(PIOTime));
+    PIOTime* times = (PIOTime*) malloc(nqueries*sizeof(PIOTime));
+    PIOTimeRange* periods = (PIOTimeRange*) malloc(nqueries*sizeof(PIOTimeRange));
+    int* indices = (int*) malloc(MAX_INDICES*sizeof(int));
+    int64_t extent = ((first.time + n*step)/first.scale + 1)*90000;
+    double start, explicitTime, regularTime;
+    int firstIndex = 0;
+    int q, t;
+
+    for (t=0; t<n; t++)
+    {
+        tl[t] = first;
+        tl[t].time += t*step;
+    }
+    pioGetTimeLineMaximumStops(tl, n, maxStops);
+
+    // random queries, a few of them at the bounds of time ranges
+    for (q=0; q<nqueries; q++)
+    {
+        times[q] = (PIOTime){random64(extent) - 90000, 90000};
+        periods[q] = (PIOTimeRange){times[q].time, random64(9000), 90000};
+        if (q%10 == 0)
+        {
+            t = (int)random64(n);
+            times[q] = (PIOTime){tl[t].time + (q%20 ? tl[t].duration : 0), tl[t].scale};
+            periods[q] = (PIOTimeRange){times[q].time, random64(first.duration+1), tl[t].scale};
+        }
+    }
+
+    fprintf(stdout, "%s\n", name);
+
+    start = now();
+    for (q=0; q<nqueries; q++)
+        pioFindTimeRangesContainingTime(tl, maxStops, n, times[q], indices, MAX_INDICES);
+    explicitTime = (now() - start)/nqueries;
+    start = now();
+    for (q=0; q<nqueries; q++)
+        pioFindTimeRangesContainingTimeInRegularTimeLine(first, step, n, times[q], &firstIndex);
+    regularTime = (now() - start)/nqueries;
+    fprintf(stdout, "   %-25s %8.3fus %8.3fus (x%.0f)\n", "containing timestamp",
+            1e6*explicitTime, 1e6*regularTime, explicitTime/regularTime);
+
+    start = now();
+    for (q=0; q<nqueries; q++)
+        pioFindTimeRangesIntersectingTimeRange(tl, maxStops, n, periods[q], indices, MAX_INDICES);
+    explicitTime = (now() - start)/nqueries;
+    start = now();
+    for (q=0; q<nqueries; q++)
+        pioFindTimeRangesIntersectingTimeRangeInRegularTimeLine(first, step, n, periods[q], &firstIndex);
+    regularTime = (now() - start)/nqueries;
+    fprintf(stdout, "   %-25s %8.3fus %8.3fus (x%.0f)\n", "intersecting period",
+            1e6*explicitTime, 1e6*regularTime, explicitTime/regularTime);
+
+    // time ranges themselves
+    start = now();
+    for (q=0; q<nqueries; q++)
+        pioFindTimeRangeInRegularTimeLine(tl[(int)random64(n)], first, step, n);
+    fprintf(stdout, "   %-25s %8s   %8.3fus\n", "time range", "", 1e6*(now() - start)/nqueries);
+
+    free(indices);
+    free(periods);
+    free(times);
+    free(maxStops);
+    free(tl);
+}
+
+int main (int argc, char *const  argv[])
+{
+    int ntimeranges = 5000000;
+    int nqueries = 100000;
+    char path[256], explicitPath[256], copyPath[256];
+    PIOFile pioFile = PIOFileInvalid;
+    PIOFile pioExplicitFile = PIOFileInvalid;
+    PIOFile pioCopyFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIOTimeline pioExplicitTimeline = PIOTimelineInvalid;
+    PIOTimeRange* frames = NULL;
+    PIOTimeRange frame = {0, 1, 25};
+    FILE* file = NULL;
+    long size, explicitSize;
+    double start, explicitTime, regularTime;
+    int t;
+
+    if (argc > 1) ntimeranges = atoi(argv[1]);
+    if (argc > 2) nqueries = atoi(argv[2]);
+
+    // frames at 25 Hz, 1 hour in
+    frame.time = 3600*25;
+    frames = (PIOTimeRange*) malloc(ntimeranges*sizeof(PIOTimeRange));
+    for (t=0; t<ntimeranges; t++)
+    {
+        frames[t] = frame;
+        frames[t].time += t;
+    }
+
+    sprintf(path, BENCH_FILE, "regular");
+    sprintf(explicitPath, BENCH_FILE, "explicit");
+    sprintf(copyPath, BENCH_FILE, "copy");
+    remove(path); remove(explicitPath); remove(copyPath);
+
+    pioFile = pioNewFile(path, "/path/to/medium");
+    pioTimeline = pioNewRegularTimeline(pioFile, "frames", "frames", ntimeranges, frame, 1);
+    if (PIOTimelineIsInvalid(pioTimeline))
+    {
+        fprintf(stderr, "Could not create regular timeline.\n");
+        exit(-1);
+    }
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+
+    pioExplicitFile = pioNewFile(explicitPath, "/path/to/medium");
+    pioExplicitTimeline = pioNewTimeline(pioExplicitFile, "frames", "frames", ntimeranges, frames);
+    pioCloseTimeline(&pioExplicitTimeline);
+    pioCloseFile(&pioExplicitFile);
+
+    file = fopen(path, "r"); fseek(file, 0, SEEK_END); size = ftell(file); fclose(file);
+    file = fopen(explicitPath, "r"); fseek(file, 0, SEEK_END); explicitSize = ftell(file); fclose(file);
+    fprintf(stdout, "%d frames\n", ntimeranges);
+    fprintf(stdout, "%-28s %8ldkB %8ldkB\n", "file size", explicitSize/1024, size/1024);
+
+    // open and load
+    pioFile = pioOpenFile(path, PINOCCHIO_READONLY);
+    pioExplicitFile = pioOpenFile(explicitPath, PINOCCHIO_READONLY);
+    start = now();
+    pioExplicitTimeline = pioOpenTimeline(PIOMakeObject(pioExplicitFile), "frames");
+    explicitTime = now() - start;
+    start = now();
+    pioTimeline = pioOpenTimeline(PIOMakeObject(pioFile), "frames");
+    regularTime = now() - start;
+    fprintf(stdout, "%-28s %8.3fms %8.3fms\n", "pioOpenTimeline", 1e3*explicitTime, 1e3*regularTime);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseTimeline(&pioExplicitTimeline);
+
+    // every other frame (at 50 Hz), copied onto frames
+    pioCopyFile = pioNewFile(copyPath, "/path/to/medium");
+    pioTimeline = pioNewRegularTimeline(pioCopyFile, "half", "half",
+                                        ntimeranges/2, (PIOTimeRange){2*frame.time, 2, 50}, 4);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioCopyFile);
+    pioCloseFile(&pioExplicitFile);
+    pioCloseFile(&pioFile);
+    remove(explicitPath);
+
+    pioCopyFile = pioOpenFile(copyPath, PINOCCHIO_READONLY);
+    pioExplicitFile = pioNewFile(explicitPath, "/path/to/medium");
+    pioTimeline = pioNewRegularTimeline(pioExplicitFile, "half", "half", ntimeranges, frame, 1);
+    pioCloseTimeline(&pioTimeline);
+    start = now();
+    pioCopyTimeline("half", pioCopyFile, pioExplicitFile);
+    fprintf(stdout, "%-28s %8s   %8.3fms\n", "pioCopyTimeline (subset)", "", 1e3*(now() - start));
+
+    pioCloseFile(&pioExplicitFile);
+    pioCloseFile(&pioCopyFile);
+    remove(path); remove(explicitPath); remove(copyPath);
+    free(frames);
+
+    // lookups, with overlapping time ranges and queries at other scales
+    srand(42);
+    bench("25 Hz frames", frame, 1, ntimeranges, nqueries);
+    bench("25 ms windows every 10 ms", (PIOTimeRange){-5, 25, 1000}, 10, ntimeranges, nqueries);
+    bench("3 s windows every 1/3 s", (PIOTimeRange){0, 90000, 30000}, 10000, ntimeranges/100, nqueries);
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+/*
+ *  bench_timeline.c
+ *  pinocchIO
+ *
+ *  Measures how long pioCompareTimeLines() takes on large timelines, at a single scale
+ *  and at mixed scales (including scales whose cross products do not fit in 64 bits).
+ *  Subsets are also searched time range after time range with pioFindTimeRangeInTimeLine(),
+ *  to compare with the mapping returned by pioCompareTimeLinesWithMapping(), and a dataset
+ *  is copied onto a timeline containing more time ranges than its own.
+ *  See test_TimeComparison and test_TimelineMapping for correctness checks.
+ *
+ *  usage: bench_timeline [ntimeranges]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "test_utils.h"
+
+// one frame every 1/25 second starting at offset seconds, in 1/scale units
+static PIOTimeRange* frames(int n, int32_t scale, int step, int64_t offset)
+{
+    PIOTimeRange* timeranges = (PIOTimeRange*) malloc(n*sizeof(PIOTimeRange));
+    int t;
+
+    for (t=0; t<n; t++)
+    {
+        timeranges[t].time = offset*scale + ((int64_t)t*step*scale)/25;
+        timeranges[t].duration = scale/25;
+        timeranges[t].scale = scale;
+    }
+    return timeranges;
+}
+
+#define BENCH_FILE "/tmp/bench_timeline_%s.pio"
+
+static void bench(const char* name, PIOTimeRange* tr1, int n1, PIOTimeRange* tr2, int n2, int repeat)
+{
+    double start;
+    int r;
+
+    start = now();
+    for (r=0; r<repeat; r++) pioCompareTimeLines(tr1, n1, tr2, n2);
+    fprintf(stdout, "%-36s %8.3fms\n", name, 1e3*(now() - start)/repeat);
+}
+
+// subset tr1 of superset tr2, compared with a search of each time range of tr1 in tr2
+static void benchMapping(const char* name, PIOTimeRange* tr1, int n1, PIOTimeRange* tr2, int n2)
+{
+    int* mapping = (int*) malloc(n1*sizeof(int));
+    int* expected = (int*) malloc(n1*sizeof(int));
+    double start, searchTime, mappingTime;
+    int t;
+
+    start = now();
+    for (t=0; t<n1; t++) expected[t] = pioFindTimeRangeInTimeLine(tr1[t], tr2, n2);
+    searchTime = now() - start;
+
+    start = now();
+    pioCompareTimeLinesWithMapping(tr1, n1, tr2, n2, mapping);
+    mappingTime = now() - start;
+    fprintf(stdout, "%-36s %8.3fms %8.3fms (x%.1f)\n", name, 1e3*searchTime, 1e3*mappingTime, searchTime/mappingTime);
+
+    free(expected);
+    free(mapping);
+}
+
+// copy a dataset whose timeline is tr1 into a file whose timeline is tr2
+static void benchCopy(PIOTimeRange* tr1, int n1, PIOTimeRange* tr2, int n2)
+{
+    PIOFile pioInputFile = PIOFileInvalid;
+    PIOFile pioOutputFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    PIODataset pioDataset = PIODatasetInvalid;
+    char input[256], output[256];
+    double start;
+    int t;
+
+    sprintf(input, BENCH_FILE, "input");
+    sprintf(output, BENCH_FILE, "output");
+    remove(input);
+    remove(output);
+
+    pioInputFile = pioNewFile(input, "/path/to/medium");
+    pioTimeline = pioNewTimeline(pioInputFile, "frames", "frames", n1, tr1);
+    pioDataset = pioNewDataset(pioInputFile, "index", "index", pioTimeline, pioDatatype);
+    pioNewDatasetWriter(&pioDataset, 0);
+    for (t=0; t<n1; t++) pioWrite(&pioDataset, t, &t, 1, pioDatatype);
+    pioCloseDataset(&pioDataset);
+    pioCloseTimeline(&pioTimeline);
+
+    pioOutputFile = pioNewFile(output, "/path/to/medium");
+    pioTimeline = pioNewTimeline(pioOutputFile, "frames", "frames", n2, tr2);
+    pioCloseTimeline(&pioTimeline);
+
+    start = now();
+    pioCopyDataset("index", pioInputFile, pioOutputFile);
+    fprintf(stdout, "%-36s %8.3fms\n", "pioCopyDataset (subset)", 1e3*(now() - start));
+
+    pioCloseDatatype(&pioDatatype);
+    pioCloseFile(&pioOutputFile);
+    pioCloseFile(&pioInputFile);
+    remove(input);
+    remove(output);
+}
+
+int main (int argc, char *const  argv[])
+{
+    int ntimeranges = 10000000;
+    int64_t years = 3LL*365*86400;
+    PIOTimeRange* frames90k = NULL;
+    PIOTimeRange* frames25 = NULL;
+    PIOTimeRange* every10 = NULL;
+    PIOTimeRange* late90k = NULL;
+    PIOTimeRange* late1G = NULL;
+    PIOTimeRange* lateEvery10 = NULL;
+
+    if (argc > 1) ntimeranges = atoi(argv[1]);
+
+    frames90k = frames(ntimeranges, 90000, 1, 0);
+    frames25 = frames(ntimeranges, 25, 1, 0);
+    every10 = frames(ntimeranges/10, 90000, 10, 0);
+    // 90 kHz and nanoseconds, 3 years in: cross products do not fit in 64 bits
+    late90k = frames(ntimeranges, 90000, 1, years);
+    late1G = frames(ntimeranges, 1000000000, 1, years);
+    lateEvery10 = frames(ntimeranges/10, 90000, 10, years);
+
+    fprintf(stdout, "%d time ranges\n", ntimeranges);
+
+    bench("same (90 kHz)", frames90k, ntimeranges, frames90k, ntimeranges, 10);
+    bench("same (90 kHz vs 25 Hz)", frames90k, ntimeranges, frames25, ntimeranges, 10);
+    bench("same (90 kHz vs 1 GHz, 3 years in)", late90k, ntimeranges, late1G, ntimeranges, 10);
+    bench("subset (90 kHz)", every10, ntimeranges/10, frames90k, ntimeranges, 1);
+    bench("superset (25 Hz vs 90 kHz)", frames25, ntimeranges, every10, ntimeranges/10, 1);
+    bench("subset (90 kHz vs 1 GHz, 3 years in)", lateEvery10, ntimeranges/10, late1G, ntimeranges, 1);
+
+    fprintf(stdout, "%-36s %10s %10s\n", "mapping", "search", "merge");
+    benchMapping("subset (90 kHz)", every10, ntimeranges/10, frames90k, ntimeranges);
+    benchMapping("subset (90 kHz vs 25 Hz)", every10, ntimeranges/10, frames25, ntimeranges);
+    benchMapping("subset (90 kHz vs 1 GHz, 3 years in)", lateEvery10, ntimeranges/10, late1G, ntimeranges);
+
+    benchCopy(every10, ntimeranges/1000, frames25, ntimeranges/100);
+
+    free(lateEvery10);
+    free(late1G);
+    free(late90k);
+    free(every10);
+    free(frames25);
+    free(frames90k);
+    return 0;
+}
@@ -0,0 +1,114 @@
+/*
+ *  test_Chunking.c
+ *  pinocchIO
+ *
+ *  Checks the HDF5 layout chosen by pioNewDatasetWithOptions(): number of
+ *  entries per data chunk (deduced from the target chunk size and the size of
+ *  the datatype), number of links per link chunk (never more than the number
+ *  of time ranges) or contiguous links, and that data read back the same
+ *  whatever the layout.
+ *
+ *  usage: test_Chunking
+ *
+ */
+
+#include <string.h>
+#include <hdf5.h>
+#include "test_utils.h"
+
+#define TEST_FILE "/tmp/test_Chunking.pio"
+#define NTIMERANGES 500
+#define DIMENSION 16
+
+// number of entries per chunk of HDF5 dataset (0 if not chunked)
+static hsize_t chunk(hid_t dataset)
+{
+    hid_t creationProperty = H5Dget_create_plist(dataset);
+    hsize_t dimensions[1] = {0};
+
+    if (H5Pget_layout(creationProperty) == H5D_CHUNKED)
+        H5Pget_chunk(creationProperty, 1, dimensions);
+    H5Pclose(creationProperty);
+    return dimensions[0];
+}
+
+static void check(size_t chunkSize, size_t linkChunkSize,
+                  hsize_t expectedDataChunk, hsize_t expectedLinkChunk, const char* name)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, DIMENSION);
+    PIODataset pioDataset = PIODatasetInvalid;
+    PIODatasetOptions options = PIODatasetOptionsDefault;
+    float data[3*DIMENSION];
+    int numbers[NTIMERANGES];
+    void* buffer = NULL;
+    int t, i, total;
+
+    options.chunk_size = chunkSize;
+    options.link_chunk_size = linkChunkSize;
+
+    pioFile = newFramesFile(TEST_FILE, NTIMERANGES, &pioTimeline);
+    pioDataset = pioNewDatasetWithOptions(pioFile, "features", "features", pioTimeline, pioDatatype, options);
+    expect(PIODatasetIsValid(pioDataset), 1, name);
+    expect(chunk(pioDataset.identifier), expectedDataChunk, name);
+    expect(chunk(pioDataset.link_identifier), expectedLinkChunk, name);
+
+    // 0 to 2 entries per time range
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        for (i=0; i<(t%3)*DIMENSION; i++) data[i] = (float)(t*100+i);
+        pioWrite(&pioDataset, t, data, t%3, pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+
+    // read back, one time range at a time and all at once
+    pioFile = pioOpenFile(TEST_FILE, PINOCCHIO_READONLY);
+    pioDataset = pioOpenDataset(PIOMakeObject(pioFile), "features");
+    expect(chunk(pioDataset.identifier), expectedDataChunk, name);
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        expect(pioRead(&pioDataset, t, pioDatatype, &buffer), t%3, name);
+        for (i=0; i<(t%3)*DIMENSION; i++) expect(((float*)buffer)[i], t*100+i, name);
+    }
+    expect(pioReadRange(&pioDataset, 0, NTIMERANGES, pioDatatype, &buffer, numbers), NTIMERANGES-1, name);
+    total = 0;
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        expect(numbers[t], t%3, name);
+        for (i=0; i<(t%3)*DIMENSION; i++) expect(((float*)buffer)[total*DIMENSION+i], t*100+i, name);
+        total += numbers[t];
+    }
+    pioCloseDataset(&pioDataset);
+    pioCloseFile(&pioFile);
+
+    pioCloseDatatype(&pioDatatype);
+    remove(TEST_FILE);
+}
+
+int main (int argc, char *const  argv[])
+{
+    size_t entrySize = DIMENSION*sizeof(float);
+    size_t linkSize = 2*sizeof(int64_t);
+
+    // 1MB data chunks, 64kB link chunks (but no more links than time ranges)
+    check(1048576, 65536, 1048576/entrySize, NTIMERANGES, "default options");
+    check(PIODatasetOptionsDefault.chunk_size, PIODatasetOptionsDefault.link_chunk_size,
+          1048576/entrySize, NTIMERANGES, "PIODatasetOptionsDefault");
+
+    // one entry (link) per chunk, whenever target size is smaller than one entry (link)
+    check(1, 1, 1, 1, "one entry per chunk");
+    check(entrySize-1, linkSize-1, 1, 1, "smaller than one entry");
+
+    // entries never overlap chunks
+    check(10*entrySize, 10*linkSize, 10, 10, "ten entries per chunk");
+    check(10*entrySize+entrySize/2, 10*linkSize+linkSize/2, 10, 10, "ten and a half entries per chunk");
+
+    // contiguous links
+    check(4096, 0, 4096/entrySize, 0, "contiguous links");
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
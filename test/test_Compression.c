@@ -0,0 +1,181 @@
+/*
+ *  test_Compression.c
+ *  pinocchIO
+ *
+ *  Checks that compressed datasets (PIODatasetOptions compression and shuffle)
+ *  read back exactly what was written, for float, double, int and char
+ *  datatypes, that the requested filters are set (shuffle before deflate, on
+ *  links only when they are chunked), that smooth data are actually stored in
+ *  less space, and that unsupported compression levels are rejected.
+ *
+ *  usage: test_Compression
+ *
+ */
+
+#include <string.h>
+#include <math.h>
+#include <hdf5.h>
+#include "test_utils.h"
+
+#define TEST_FILE "/tmp/test_Compression.pio"
+#define NTIMERANGES 2000
+#define DIMENSION 16
+
+// smooth, slowly varying values -- typical of audio/video features
+static void fill(void* data, PIODatatype pioDatatype, int t)
+{
+    int d;
+    double value;
+
+    for (d=0; d<pioDatatype.dimension; d++)
+    {
+        value = 100.*sin(0.001*t + 0.1*d);
+        switch (pioDatatype.type)
+        {
+            case PINOCCHIO_TYPE_FLOAT:  ((float*)data)[d] = (float)value; break;
+            case PINOCCHIO_TYPE_DOUBLE: ((double*)data)[d] = value; break;
+            case PINOCCHIO_TYPE_INT:    ((int*)data)[d] = (int)value; break;
+            case PINOCCHIO_TYPE_CHAR:   ((char*)data)[d] = (char)value; break;
+            default: break;
+        }
+    }
+}
+
+// compare filter pipeline of HDF5 dataset with requested options
+static void checkFilters(hid_t dataset, PIODatasetOptions options, const char* name)
+{
+    hid_t creationProperty = H5Dget_create_plist(dataset);
+    unsigned int flags;
+    unsigned int level;
+    size_t numberOfValues = 1;
+    unsigned int filterConfig;
+    int n = 0;
+
+    if (options.compression == 0)
+    {
+        expect(H5Pget_nfilters(creationProperty), 0, name);
+        H5Pclose(creationProperty);
+        return;
+    }
+
+    expect(H5Pget_nfilters(creationProperty), options.shuffle ? 2 : 1, name);
+    if (options.shuffle)
+    {
+        numberOfValues = 0;
+        expect(H5Pget_filter2(creationProperty, n++, &flags, &numberOfValues, NULL,
+                              0, NULL, &filterConfig), H5Z_FILTER_SHUFFLE, name);
+        numberOfValues = 1;
+    }
+    expect(H5Pget_filter2(creationProperty, n, &flags, &numberOfValues, &level,
+                          0, NULL, &filterConfig), H5Z_FILTER_DEFLATE, name);
+    expect(level, options.compression, name);
+    H5Pclose(creationProperty);
+}
+
+static void check(PIOBaseType type, PIODatasetOptions options, const char* name)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = pioNewDatatype(type, DIMENSION);
+    PIODataset pioDataset = PIODatasetInvalid;
+    PIODatasetOptions contiguous = options;
+    hid_t creationProperty;
+    size_t size = pioGetSize(pioDatatype);
+    char* data = (char*) malloc(NTIMERANGES*size);
+    void* buffer = NULL;
+    int numbers[NTIMERANGES];
+    int t;
+
+    pioFile = newFramesFile(TEST_FILE, NTIMERANGES, &pioTimeline);
+    pioDataset = pioNewDatasetWithOptions(pioFile, "features", "features", pioTimeline, pioDatatype, options);
+    expect(PIODatasetIsValid(pioDataset), 1, name);
+    checkFilters(pioDataset.identifier, options, name);
+    checkFilters(pioDataset.link_identifier, options, name);
+    pioNewDatasetWriter(&pioDataset, 0);
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        fill(data + t*size, pioDatatype, t);
+        pioWrite(&pioDataset, t, data + t*size, 1, pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    // contiguous links are never compressed
+    contiguous.link_chunk_size = 0;
+    pioDataset = pioNewDatasetWithOptions(pioFile, "contiguous", "contiguous", pioTimeline, pioDatatype, contiguous);
+    expect(PIODatasetIsValid(pioDataset), 1, name);
+    creationProperty = H5Dget_create_plist(pioDataset.link_identifier);
+    expect(H5Pget_layout(creationProperty), H5D_CONTIGUOUS, name);
+    H5Pclose(creationProperty);
+    contiguous.compression = 0;
+    checkFilters(pioDataset.link_identifier, contiguous, name);
+    pioCloseDataset(&pioDataset);
+
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+
+    // exact round trip, one time range at a time and all at once
+    pioFile = pioOpenFile(TEST_FILE, PINOCCHIO_READONLY);
+    pioDataset = pioOpenDataset(PIOMakeObject(pioFile), "features");
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        expect(pioRead(&pioDataset, t, pioDatatype, &buffer), 1, name);
+        expect(memcmp(buffer, data + t*size, size), 0, name);
+    }
+    expect(pioReadRange(&pioDataset, 0, NTIMERANGES, pioDatatype, &buffer, numbers), NTIMERANGES, name);
+    expect(memcmp(buffer, data, NTIMERANGES*size), 0, name);
+
+    // smooth data take less space once compressed
+    if (options.compression > 0)
+        expect(H5Dget_storage_size(pioDataset.identifier) < NTIMERANGES*size, 1, name);
+    pioCloseDataset(&pioDataset);
+    pioCloseFile(&pioFile);
+
+    pioCloseDatatype(&pioDatatype);
+    free(data);
+    remove(TEST_FILE);
+}
+
+// unsupported compression levels are rejected
+static void checkInvalid(int compression, const char* name)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, DIMENSION);
+    PIODataset pioDataset = PIODatasetInvalid;
+    PIODatasetOptions options = PIODatasetOptionsDefault;
+
+    options.compression = compression;
+    pioFile = newFramesFile(TEST_FILE, NTIMERANGES, &pioTimeline);
+    pioDataset = pioNewDatasetWithOptions(pioFile, "features", "features", pioTimeline, pioDatatype, options);
+    expect(PIODatasetIsInvalid(pioDataset), 1, name);
+
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+    pioCloseDatatype(&pioDatatype);
+    remove(TEST_FILE);
+}
+
+int main (int argc, char *const  argv[])
+{
+    PIOBaseType types[4] = {PINOCCHIO_TYPE_FLOAT, PINOCCHIO_TYPE_DOUBLE,
+                            PINOCCHIO_TYPE_INT, PINOCCHIO_TYPE_CHAR};
+    const char* names[4] = {"none", "deflate=1", "deflate=6", "shuffle+deflate=6"};
+    PIODatasetOptions options[4];
+    int i, j;
+
+    for (j=0; j<4; j++) options[j] = PIODatasetOptionsDefault;
+    options[1].compression = 1;
+    options[2].compression = 6;
+    options[3].compression = 6;
+    options[3].shuffle = 1;
+
+    for (i=0; i<4; i++)
+        for (j=0; j<4; j++)
+            check(types[i], options[j], names[j]);
+
+    checkInvalid(10, "compression level 10");
+    checkInvalid(-1, "compression level -1");
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
@@ -0,0 +1,120 @@
+/*
+ *  test_DatasetWriter.c
+ *  pinocchIO
+ *
+ *  Checks that data written through a buffered writer (pioNewDatasetWriter())
+ *  read back exactly as if they had been written directly: small budgets,
+ *  entries larger than the budget, empty and skipped time ranges, time ranges
+ *  written backwards, buffers of another datatype and reads between writes.
+ *
+ *  usage: test_DatasetWriter
+ *
+ */
+
+#include <string.h>
+#include "test_utils.h"
+
+#define TEST_FILE "/tmp/test_DatasetWriter.pio"
+#define NTIMERANGES 1000
+#define MAX_NUMBER 200
+
+// what each time range is expected to contain (last write wins)
+static int expectedNumber[NTIMERANGES];
+static int expectedData[NTIMERANGES][2*MAX_NUMBER];
+
+static int writeExpected(PIODataset* pioDataset, int t, int number, int value, PIODatatype intDatatype, PIODatatype floatDatatype)
+{
+    int intBuffer[2*MAX_NUMBER];
+    float floatBuffer[2*MAX_NUMBER];
+    int i;
+
+    for (i=0; i<2*number; i++)
+    {
+        expectedData[t][i] = value + i;
+        intBuffer[i] = value + i;
+        floatBuffer[i] = (float)(value + i);
+    }
+    expectedNumber[t] = number;
+
+    // odd values go through float buffers (converted by HDF5)
+    if (value%2) return pioWrite(pioDataset, t, floatBuffer, number, floatDatatype);
+    return pioWrite(pioDataset, t, intBuffer, number, intDatatype);
+}
+
+static void check(PIODataset* pioDataset, PIODatatype intDatatype, const char* name)
+{
+    void* buffer = NULL;
+    int t;
+
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        expect(pioRead(pioDataset, t, intDatatype, &buffer), expectedNumber[t], name);
+        expect(memcmp(buffer, expectedData[t], 2*expectedNumber[t]*sizeof(int)), 0, name);
+    }
+}
+
+int main (int argc, char *const  argv[])
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype intDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 2);
+    PIODatatype floatDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, 2);
+    PIODataset pioDataset = PIODatasetInvalid;
+    PIOTimeRange* timeranges = newFrames(NTIMERANGES);
+    int number, t;
+
+    remove(TEST_FILE);
+    pioFile = pioNewFile(TEST_FILE, "/path/to/medium");
+    pioTimeline = pioNewTimeline(pioFile, "frames", "frames", NTIMERANGES, timeranges);
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, intDatatype);
+
+    expect(pioFlushDatasetWriter(&pioDataset), -1, "flush without writer");
+    // budget of 8 entries
+    expect(pioNewDatasetWriter(&pioDataset, 8*2*sizeof(int)+8*(sizeof(int)+16)), 1, "pioNewDatasetWriter");
+    expect(pioNewDatasetWriter(&pioDataset, 0), -1, "second writer");
+
+    // chronological writes, some time ranges skipped or empty, some too large for budget
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        if (t%7 == 3) continue;
+        number = (t%50 == 0) ? MAX_NUMBER : t%4;
+        expect(writeExpected(&pioDataset, t, number, 10*t, intDatatype, floatDatatype), number, "chronological write");
+        // datatype changes within a batch
+        if (t%11 == 0)
+        {
+            t++;
+            expect(writeExpected(&pioDataset, t, 2, 10*t+1, intDatatype, floatDatatype), 2, "float write");
+        }
+    }
+
+    // buffered data are visible to reads
+    expect(writeExpected(&pioDataset, 3, 3, 7, intDatatype, floatDatatype), 3, "backward write");
+    expect(pioReadNumber(pioDataset, 3), 3, "read of buffered time range");
+    for (t=NTIMERANGES-1; t>=0; t-=97)
+        expect(writeExpected(&pioDataset, t, 1, -t, intDatatype, floatDatatype), 1, "backward write");
+    check(&pioDataset, intDatatype, "read with writer attached");
+
+    expect(writeExpected(&pioDataset, 0, 5, 1000, intDatatype, floatDatatype), 5, "write after read");
+    expect(pioCloseDatasetWriter(&pioDataset), 1, "pioCloseDatasetWriter");
+    expect(pioCloseDatasetWriter(&pioDataset), 0, "second pioCloseDatasetWriter");
+
+    // direct writes after writer is detached, then writer again, flushed by close
+    expect(writeExpected(&pioDataset, 1, 4, 2000, intDatatype, floatDatatype), 4, "direct write");
+    expect(pioNewDatasetWriter(&pioDataset, 0), 1, "pioNewDatasetWriter (default budget)");
+    expect(writeExpected(&pioDataset, 2, 6, 3000, intDatatype, floatDatatype), 6, "buffered write");
+    pioCloseDataset(&pioDataset);
+
+    pioDataset = pioOpenDataset(PIOMakeObject(pioFile), "features");
+    check(&pioDataset, intDatatype, "read after close");
+    pioCloseDataset(&pioDataset);
+
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+    pioCloseDatatype(&floatDatatype);
+    pioCloseDatatype(&intDatatype);
+    remove(TEST_FILE);
+    free(timeranges);
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
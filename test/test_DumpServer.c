@@ -0,0 +1,126 @@
+/*
+ *  test_DumpServer.c
+ *  pinocchIO
+ *
+ *  Checks that gptDumpServer() returns the same entries, in the same order,
+ *  as successive calls to gptReadNext() on a filtered Gepetto server, and
+ *  that it leaves the gptReadNext() position untouched.
+ *
+ *  usage: test_DumpServer
+ *
+ */
+
+#include <string.h>
+#include "gepetto/gepetto.h"
+#include "test_utils.h"
+
+#define TEST_FILE "/tmp/test_DumpServer_%d.pio"
+#define NFILES 3
+#define NTIMERANGES 500
+#define DIMENSION 3
+
+static void create(int f)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, DIMENSION);
+    PIODatatype labelDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    PIODataset pioDataset = PIODatasetInvalid;
+    char path[256];
+    float data[3*DIMENSION];
+    int label;
+    int t, d;
+
+    sprintf(path, TEST_FILE, f);
+    pioFile = newFramesFile(path, NTIMERANGES, &pioTimeline);
+
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        for (d=0; d<3*DIMENSION; d++) data[d] = (float)(1000*f+10*t+d);
+        pioWrite(&pioDataset, t, data, t%4, pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    // runs of label 0 (filtered out) between runs of label 1
+    pioDataset = pioNewDataset(pioFile, "labels", "labels", pioTimeline, labelDatatype);
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        label = ((t+f)/30)%2;
+        pioWrite(&pioDataset, t, &label, 1, labelDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    pioCloseDatatype(&labelDatatype);
+    pioCloseDatatype(&pioDatatype);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+}
+
+int main (int argc, char *const  argv[])
+{
+    char* paths[NFILES];
+    GPTServer server = GPTServerInvalid;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, DIMENSION);
+    size_t entry = pioGetSize(pioDatatype);
+    int64_t size, v;
+    char* dumped = NULL;
+    void* buffer = NULL;
+    int number, n, f;
+
+    for (f=0; f<NFILES; f++)
+    {
+        create(f);
+        paths[f] = (char*) malloc(256);
+        sprintf(paths[f], TEST_FILE, f);
+    }
+
+    server = gptNewServer(NFILES, paths, "features",
+                          GEPETTO_LABEL_FILTER_TYPE_GREATER_THAN, 0, -1,
+                          NFILES, paths, "labels");
+    expect(GPTServerIsInvalid(server), 0, "gptNewServer");
+
+    size = gptDumpServer(&server, pioDatatype, NULL);
+    expect(size > 0, 1, "size of server");
+    dumped = (char*) malloc(size);
+
+    // dump in the middle of reading...
+    v = 0;
+    for (n=0; n<10; n++)
+    {
+        number = gptReadNext(&server, pioDatatype, &buffer, NULL, NULL);
+        expect(number >= 0, 1, "gptReadNext");
+        v += number;
+    }
+    expect(gptDumpServer(&server, pioDatatype, dumped)*entry, size, "gptDumpServer");
+
+    // ... does not move the reading position
+    while ((number = gptReadNext(&server, pioDatatype, &buffer, NULL, NULL)) >= 0)
+    {
+        expect(memcmp(buffer, dumped+v*entry, number*entry), 0, "dumped data");
+        v += number;
+    }
+    expect(v*entry, size, "number of served entries");
+
+    // reading from the start gives the same entries
+    expect(gptSetIterationMode(&server, GEPETTO_ITERATION_MODE_SEQUENTIAL, 0, 1), 1, "rewind");
+    v = 0;
+    while ((number = gptReadNext(&server, pioDatatype, &buffer, NULL, NULL)) >= 0)
+    {
+        expect(memcmp(buffer, dumped+v*entry, number*entry), 0, "dumped data (rewound)");
+        v += number;
+    }
+    expect(v*entry, size, "number of served entries (rewound)");
+
+    gptCloseServer(&server);
+    pioCloseDatatype(&pioDatatype);
+    for (f=0; f<NFILES; f++)
+    {
+        remove(paths[f]);
+        free(paths[f]);
+    }
+    free(dumped);
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
@@ -0,0 +1,289 @@
+/*
+ *  test_IterationModes.c
+ *  pinocchIO
+ *
+ *  Checks that every iteration mode of gptSetIterationMode() serves each
+ *  timerange exactly once per epoch, with its labels: shuffled (differently
+ *  at each epoch, reproducibly from the seed, file by file within blocks),
+ *  round-robin per label, stratified (with gptReadNext() and gptReadBatch()),
+ *  and sequential again; and that modes grouping timeranges by label are
+ *  rejected by servers without labels.
+ *
+ *  usage: test_IterationModes
+ *
+ */
+
+#include <string.h>
+#include "gepetto/gepetto.h"
+#include "test_utils.h"
+
+#define TEST_FILE "/tmp/test_IterationModes_%d.pio"
+#define NFILES 4
+#define NTIMERANGES 500
+#define TOTAL (NFILES*NTIMERANGES)
+
+// 60% of label 0, 30% of label 1, 10% of label 2
+static int labelOf(int t)
+{
+    return (t%10 < 6) ? 0 : ((t%10 < 9) ? 1 : 2);
+}
+
+static void create(int f)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 2);
+    PIODatatype labelDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    PIODataset pioDataset = PIODatasetInvalid;
+    char path[256];
+    int data[2];
+    int label;
+    int t;
+
+    sprintf(path, TEST_FILE, f);
+    pioFile = newFramesFile(path, NTIMERANGES, &pioTimeline);
+
+    // each entry tells where it comes from
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    pioNewDatasetWriter(&pioDataset, 0);
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        data[0] = f;
+        data[1] = t;
+        pioWrite(&pioDataset, t, data, 1, pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    pioDataset = pioNewDataset(pioFile, "labels", "labels", pioTimeline, labelDatatype);
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        label = labelOf(t);
+        pioWrite(&pioDataset, t, &label, 1, labelDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    pioCloseDatatype(&labelDatatype);
+    pioCloseDatatype(&pioDatatype);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+}
+
+// one epoch with gptReadNext(): position (f*NTIMERANGES+t) of each served timerange
+static int epoch(GPTServer* server, int* order, int withLabels)
+{
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 2);
+    void* buffer = NULL;
+    int* labels = NULL;
+    int nLabels;
+    int n = 0;
+
+    while (gptReadNext(server, pioDatatype, &buffer, &nLabels, &labels) == 1)
+    {
+        if (withLabels)
+        {
+            expect(nLabels, 1, "number of labels");
+            expect(labels[0], labelOf(((int*)buffer)[1]), "label");
+        }
+        expect(n < TOTAL, 1, "epoch length");
+        order[n++] = ((int*)buffer)[0]*NTIMERANGES + ((int*)buffer)[1];
+    }
+    pioCloseDatatype(&pioDatatype);
+    return n;
+}
+
+// every timerange is served exactly once
+static void checkPermutation(const int* order, int n, const char* name)
+{
+    char seen[TOTAL];
+    int i;
+
+    expect(n, TOTAL, name);
+    memset(seen, 0, TOTAL);
+    for (i=0; i<n; i++)
+    {
+        expect(order[i] >= 0 && order[i] < TOTAL, 1, name);
+        expect(seen[order[i]], 0, name);
+        seen[order[i]] = 1;
+    }
+}
+
+// each block is read file by file, chronologically
+static void checkBlocks(const int* order, int n, int blockSize, const char* name)
+{
+    char done[NFILES];
+    int i, f, previous;
+
+    for (i=0; i<n; i++)
+    {
+        f = order[i]/NTIMERANGES;
+        if (i%blockSize == 0) memset(done, 0, NFILES);
+        else
+        {
+            previous = order[i-1]/NTIMERANGES;
+            if (f == previous) expect(order[i] > order[i-1], 1, name);
+            else done[previous] = 1;
+        }
+        expect(done[f], 0, name);
+    }
+}
+
+// largest deviation (in timeranges) from the overall label distribution over every block
+static double stratification(const int* order, int n, int blockSize)
+{
+    double expected[3] = {0.6, 0.3, 0.1};
+    double worst = 0., deviation;
+    int count[3];
+    int b, i, l;
+
+    for (b=0; b+blockSize<=n; b+=blockSize)
+    {
+        count[0] = count[1] = count[2] = 0;
+        for (i=b; i<b+blockSize; i++) count[labelOf(order[i]%NTIMERANGES)]++;
+        for (l=0; l<3; l++)
+        {
+            deviation = count[l] - expected[l]*blockSize;
+            if (deviation < 0) deviation = -deviation;
+            if (deviation > worst) worst = deviation;
+        }
+    }
+    return worst;
+}
+
+static int compare(void const* a, void const* b)
+{
+    int x = *(int const*)a, y = *(int const*)b;
+    return (x > y) - (x < y);
+}
+
+int main (int argc, char *const  argv[])
+{
+    char* paths[NFILES];
+    GPTServer server = GPTServerInvalid;
+    GPTServer unlabelled = GPTServerInvalid;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 2);
+    int sequential[TOTAL], order[TOTAL], other[TOTAL];
+    int buffer[100*2], labels[100];
+    void* read = NULL;
+    int blockSizes[3] = {1, 16, 256};
+    int f, i, b, n, number;
+
+    for (f=0; f<NFILES; f++)
+    {
+        create(f);
+        paths[f] = (char*) malloc(256);
+        sprintf(paths[f], TEST_FILE, f);
+    }
+
+    server = gptNewServer(NFILES, paths, "features",
+                          GEPETTO_LABEL_FILTER_TYPE_NONE, 0, -1,
+                          NFILES, paths, "labels");
+    expect(GPTServerIsInvalid(server), 0, "gptNewServer");
+
+    n = epoch(&server, sequential, 1);
+    checkPermutation(sequential, n, "sequential");
+    for (i=0; i<n; i++) expect(sequential[i], i, "sequential order");
+
+    // shuffled epochs
+    for (b=0; b<3; b++)
+    {
+        expect(gptSetIterationMode(&server, GEPETTO_ITERATION_MODE_SHUFFLE, 42, blockSizes[b]), 1, "shuffle");
+        n = epoch(&server, order, 1);
+        checkPermutation(order, n, "shuffle");
+        expect(memcmp(order, sequential, n*sizeof(int)) != 0, 1, "epoch is shuffled");
+        checkBlocks(order, n, blockSizes[b], "shuffle");
+    }
+
+    // next epoch is shuffled again, same seed gives same epochs
+    gptSetIterationMode(&server, GEPETTO_ITERATION_MODE_SHUFFLE, 7, 16);
+    epoch(&server, order, 1);
+    epoch(&server, other, 1);
+    expect(memcmp(order, other, TOTAL*sizeof(int)) != 0, 1, "epochs differ");
+    gptSetIterationMode(&server, GEPETTO_ITERATION_MODE_SHUFFLE, 7, 16);
+    epoch(&server, other, 1);
+    expect(memcmp(order, other, TOTAL*sizeof(int)), 0, "same seed gives same epoch");
+    gptSetIterationMode(&server, GEPETTO_ITERATION_MODE_SHUFFLE, 8, 16);
+    epoch(&server, other, 1);
+    expect(memcmp(order, other, TOTAL*sizeof(int)) != 0, 1, "other seed gives other epoch");
+
+    // position is reset
+    gptSetIterationMode(&server, GEPETTO_ITERATION_MODE_SHUFFLE, 7, 16);
+    expect(gptReadNext(&server, pioDatatype, &read, NULL, NULL), 1, "gptReadNext");
+    gptSetIterationMode(&server, GEPETTO_ITERATION_MODE_SHUFFLE, 7, 16);
+    epoch(&server, other, 1);
+    expect(memcmp(order, other, TOTAL*sizeof(int)), 0, "position reset by gptSetIterationMode");
+
+    // round-robin: labels 0, 1, 2, 0, 1, 2... until label 2 is exhausted, then 0, 1...
+    expect(gptSetIterationMode(&server, GEPETTO_ITERATION_MODE_ROUND_ROBIN, 42, 1), 1, "round-robin");
+    n = epoch(&server, order, 1);
+    checkPermutation(order, n, "round-robin");
+    for (i=0; i<3*(TOTAL/10); i++) expect(labelOf(order[i]%NTIMERANGES), i%3, "round-robin");
+    for (; i<3*(TOTAL/10)+2*(2*TOTAL/10); i++)
+        expect(labelOf(order[i]%NTIMERANGES), (i-3*(TOTAL/10))%2, "round-robin without label 2");
+
+    // stratified: each block follows 60/30/10
+    expect(gptSetIterationMode(&server, GEPETTO_ITERATION_MODE_STRATIFIED, 42, 1), 1, "stratified");
+    n = epoch(&server, order, 1);
+    checkPermutation(order, n, "stratified");
+    expect(stratification(order, n, 10) < 1., 1, "blocks are stratified");
+    expect(stratification(order, n, 30) < 1., 1, "blocks are stratified");
+
+    // stratified mini-batches with gptReadBatch()
+    gptSetIterationMode(&server, GEPETTO_ITERATION_MODE_STRATIFIED, 42, 100);
+    n = 0;
+    while ((number = gptReadBatch(&server, pioDatatype, 100, buffer, labels, NULL, NULL)) > 0)
+    {
+        for (i=0; i<number; i++)
+        {
+            expect(n+i < TOTAL, 1, "epoch length");
+            order[n+i] = buffer[2*i]*NTIMERANGES + buffer[2*i+1];
+            expect(labels[i], labelOf(buffer[2*i+1]), "batch label");
+        }
+        n += number;
+    }
+    checkPermutation(order, n, "stratified batches");
+    expect(stratification(order, n, 100) < 1., 1, "batches are stratified");
+
+    // back to file order
+    expect(gptSetIterationMode(&server, GEPETTO_ITERATION_MODE_SEQUENTIAL, 0, 0), 1, "sequential");
+    n = epoch(&server, order, 1);
+    expect(n, TOTAL, "sequential");
+    expect(memcmp(order, sequential, n*sizeof(int)), 0, "sequential order");
+
+    // label filter: only accepted timeranges are served, grouped by accepted label
+    gptCloseServer(&server);
+    server = gptNewServer(NFILES, paths, "features",
+                          GEPETTO_LABEL_FILTER_TYPE_DIFFERS_FROM, 0, -1,
+                          NFILES, paths, "labels");
+    gptSetIterationMode(&server, GEPETTO_ITERATION_MODE_ROUND_ROBIN, 42, 1);
+    n = epoch(&server, order, 1);
+    expect(n, 4*TOTAL/10, "filtered round-robin");
+    qsort(order, n, sizeof(int), compare);
+    for (i=0, b=0; i<TOTAL; i++)
+        if (labelOf(i%NTIMERANGES) != 0) expect(order[b++], i, "filtered timeranges");
+    gptSetIterationMode(&server, GEPETTO_ITERATION_MODE_ROUND_ROBIN, 42, 1);
+    n = epoch(&server, order, 1);
+    for (i=0; i<2*(TOTAL/10); i++) expect(labelOf(order[i]%NTIMERANGES), 1+i%2, "filtered round-robin");
+    gptCloseServer(&server);
+
+    // no label: only shuffling makes sense
+    unlabelled = gptNewServer(NFILES, paths, "features",
+                              GEPETTO_LABEL_FILTER_TYPE_NONE, 0, -1,
+                              0, NULL, NULL);
+    expect(GPTServerIsInvalid(unlabelled), 0, "server without labels");
+    expect(gptSetIterationMode(&unlabelled, GEPETTO_ITERATION_MODE_ROUND_ROBIN, 42, 1), -1, "round-robin without labels");
+    expect(gptSetIterationMode(&unlabelled, GEPETTO_ITERATION_MODE_STRATIFIED, 42, 1), -1, "stratified without labels");
+    expect(gptSetIterationMode(&unlabelled, GEPETTO_ITERATION_MODE_SHUFFLE, 42, 16), 1, "shuffle without labels");
+    n = epoch(&unlabelled, order, 0);
+    checkPermutation(order, n, "shuffle without labels");
+    gptCloseServer(&unlabelled);
+
+    pioCloseDatatype(&pioDatatype);
+    for (f=0; f<NFILES; f++)
+    {
+        remove(paths[f]);
+        free(paths[f]);
+    }
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
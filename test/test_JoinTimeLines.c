@@ -0,0 +1,155 @@
+/*
+ *  test_JoinTimeLines.c
+ *  pinocchIO
+ *
+ *  Checks that pioJoinTimeLines() finds, for each time range of a timeline,
+ *  the same corresponding time ranges of another timeline as a brute-force
+ *  search: frames against segments at another scale, with gaps, empty frames,
+ *  negative times, empty timelines, and scales whose common multiple does not
+ *  fit in 64 bits.
+ *
+ *  usage: test_JoinTimeLines
+ *
+ */
+
+#include <string.h>
+#include "test_utils.h"
+
+#define NFRAMES 5000
+
+// 25 frames per second, starting at given frame (some of them empty when holes is set)
+static PIOTimeRange* frames(int n, int64_t start, int holes)
+{
+    PIOTimeRange* timeranges = (PIOTimeRange*) malloc(n*sizeof(PIOTimeRange));
+    int t;
+
+    for (t=0; t<n; t++)
+    {
+        timeranges[t].time = start + t;
+        timeranges[t].duration = (holes && (t%97 == 0)) ? 0 : 1;
+        timeranges[t].scale = 25;
+    }
+    return timeranges;
+}
+
+// segments of 0.2 to 3 seconds, in milliseconds (with gaps when holes is set)
+static PIOTimeRange* segments(int64_t start, int64_t duration, int holes, int* n)
+{
+    PIOTimeRange* timeranges = NULL;
+    int64_t time = start;
+    int capacity = 0;
+
+    *n = 0;
+    while (time < start + duration)
+    {
+        if (*n == capacity)
+        {
+            capacity = 2*capacity+1024;
+            timeranges = (PIOTimeRange*) realloc(timeranges, capacity*sizeof(PIOTimeRange));
+        }
+        timeranges[*n].time = time;
+        timeranges[*n].duration = 200 + rand()%2800;
+        timeranges[*n].scale = 1000;
+        time += timeranges[*n].duration;
+        if (holes && (rand()%4 == 0)) time += 5000;
+        (*n)++;
+    }
+    return timeranges;
+}
+
+// first intersecting time range of tr2, then consecutive intersecting ones
+static void bruteForce(PIOTimeRange* tr1, int n1, PIOTimeRange* tr2, int n2, int* first, int* number)
+{
+    int t1, t2;
+
+    for (t1=0; t1<n1; t1++)
+    {
+        first[t1] = -1;
+        number[t1] = 0;
+        for (t2=0; t2<n2; t2++)
+            if (pioTimeRangeIntersectsTimeRange(tr1[t1], tr2[t2])) break;
+        if (t2 == n2) continue;
+        first[t1] = t2;
+        while ((t2 < n2) && pioTimeRangeIntersectsTimeRange(tr1[t1], tr2[t2]))
+        {
+            number[t1]++;
+            t2++;
+        }
+    }
+}
+
+static void check(PIOTimeRange* tr1, int n1, PIOTimeRange* tr2, int n2, const char* name)
+{
+    int* expectedFirst = (int*) malloc((n1 > 0 ? n1 : 1)*sizeof(int));
+    int* expectedNumber = (int*) malloc((n1 > 0 ? n1 : 1)*sizeof(int));
+    int* first = (int*) malloc((n1 > 0 ? n1 : 1)*sizeof(int));
+    int* number = (int*) malloc((n1 > 0 ? n1 : 1)*sizeof(int));
+    int t;
+
+    bruteForce(tr1, n1, tr2, n2, expectedFirst, expectedNumber);
+    expect(pioJoinTimeLines(tr1, n1, tr2, n2, first, number), 1, name);
+    for (t=0; t<n1; t++)
+    {
+        expect(first[t], expectedFirst[t], name);
+        expect(number[t], expectedNumber[t], name);
+    }
+
+    // number is optional
+    memset(first, 0, (n1 > 0 ? n1 : 1)*sizeof(int));
+    expect(pioJoinTimeLines(tr1, n1, tr2, n2, first, NULL), 1, name);
+    for (t=0; t<n1; t++) expect(first[t], expectedFirst[t], name);
+
+    free(number);
+    free(first);
+    free(expectedNumber);
+    free(expectedFirst);
+}
+
+int main (int argc, char *const  argv[])
+{
+    PIOTimeRange* data = NULL;
+    PIOTimeRange* label = NULL;
+    int nlabel;
+
+    srand(42);
+
+    // frames and segments, both ways
+    data = frames(NFRAMES, 0, 0);
+    label = segments(0, 40LL*NFRAMES, 0, &nlabel);
+    check(data, NFRAMES, label, nlabel, "frames and segments");
+    check(label, nlabel, data, NFRAMES, "segments and frames");
+    check(data, NFRAMES, data, NFRAMES, "same timeline");
+
+    // without scale normalization (common scale does not fit in 64 bits)
+    label[0].scale = 2147483629;
+    label[0].time = 0;
+    label[0].duration = 429496726;
+    data[0].scale = 2147483587;
+    check(data, NFRAMES, label, nlabel, "mixed scales");
+    check(label, nlabel, data, NFRAMES, "mixed scales (other way)");
+    free(label);
+    free(data);
+
+    // gaps between segments, empty frames
+    data = frames(NFRAMES, 0, 1);
+    label = segments(0, 40LL*NFRAMES, 1, &nlabel);
+    check(data, NFRAMES, label, nlabel, "gaps and empty frames");
+    check(label, nlabel, data, NFRAMES, "gaps and empty frames (other way)");
+    free(label);
+    free(data);
+
+    // negative times, segments starting after first frames and ending before last ones
+    data = frames(NFRAMES, -NFRAMES/2, 0);
+    label = segments(-40LL*NFRAMES/4, 40LL*NFRAMES/2, 1, &nlabel);
+    check(data, NFRAMES, label, nlabel, "negative times");
+    check(label, nlabel, data, NFRAMES, "negative times (other way)");
+
+    // empty timelines
+    check(data, NFRAMES, label, 0, "no segment");
+    check(data, 0, label, nlabel, "no frame");
+    free(label);
+    free(data);
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
@@ -0,0 +1,186 @@
+/*
+ *  test_LabelCounts.c
+ *  pinocchIO
+ *
+ *  Checks the label statistics of a Gepetto server (sorted list of distinct
+ *  labels, number of label timeranges and of data entries per label, overall
+ *  and per file) against a sort-based count, with many distinct, scattered
+ *  and extreme label values, repeated labels and unlabelled timeranges.
+ *
+ *  usage: test_LabelCounts
+ *
+ */
+
+#include <string.h>
+#include <limits.h>
+#include "gepetto/gepetto.h"
+#include "test_utils.h"
+
+#define TEST_FILE "/tmp/test_LabelCounts_%d.pio"
+#define NFILES 4
+#define NTIMERANGES 2000
+#define MAXLABELS 4
+
+// labels of every timerange of every file, and number of data entries
+static int labels[NFILES][NTIMERANGES][MAXLABELS];
+static int numberOfLabels[NFILES][NTIMERANGES];
+static int numberOfEntries[NFILES][NTIMERANGES];
+
+static int compare(void const* a, void const* b)
+{
+    int x = *(int const*)a, y = *(int const*)b;
+    return (x > y) - (x < y);
+}
+
+static int rankOf(int* sorted, int number, int label)
+{
+    int* found = (int*) bsearch(&label, sorted, number, sizeof(int), compare);
+    return found ? (int)(found - sorted) : -1;
+}
+
+// scattered values (multiples of 4096 share their low bits), extreme values
+static int newLabel(void)
+{
+    switch (rand()%20)
+    {
+        case 0: return INT_MIN;
+        case 1: return INT_MAX;
+        case 2: return 0;
+        case 3: return -1;
+        case 4: return 4096*(rand()%1000);
+        default: return 1000*(rand()%3000) - 7;
+    }
+}
+
+static void create(int f)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, 2);
+    PIODatatype labelDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    PIODataset pioDataset = PIODatasetInvalid;
+    char path[256];
+    float data[2*2] = {0., 1., 2., 3.};
+    int t, l;
+
+    sprintf(path, TEST_FILE, f);
+    pioFile = newFramesFile(path, NTIMERANGES, &pioTimeline);
+
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    pioNewDatasetWriter(&pioDataset, 0);
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        numberOfEntries[f][t] = (t+f)%3;
+        pioWrite(&pioDataset, t, data, numberOfEntries[f][t], pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    // 0 to MAXLABELS labels per timerange (possibly repeated within a timerange)
+    pioDataset = pioNewDataset(pioFile, "labels", "labels", pioTimeline, labelDatatype);
+    pioNewDatasetWriter(&pioDataset, 0);
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        numberOfLabels[f][t] = rand()%(MAXLABELS+1);
+        for (l=0; l<numberOfLabels[f][t]; l++)
+            labels[f][t][l] = (l > 0 && rand()%4 == 0) ? labels[f][t][l-1] : newLabel();
+        pioWrite(&pioDataset, t, labels[f][t], numberOfLabels[f][t], labelDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    pioCloseDatatype(&labelDatatype);
+    pioCloseDatatype(&pioDatatype);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+}
+
+int main (int argc, char *const  argv[])
+{
+    char* paths[NFILES];
+    GPTServer server = GPTServerInvalid;
+    int* sorted = (int*) malloc(NFILES*NTIMERANGES*MAXLABELS*sizeof(int));
+    int* labelCounts = NULL;
+    int* dataCounts = NULL;
+    int* labelCountsPerFile = NULL;
+    int* dataCountsPerFile = NULL;
+    int timerange[MAXLABELS];
+    int total = 0;
+    int distinct = 0;
+    int f, t, l, n;
+
+    srand(42);
+    for (f=0; f<NFILES; f++)
+    {
+        create(f);
+        paths[f] = (char*) malloc(256);
+        sprintf(paths[f], TEST_FILE, f);
+    }
+
+    // sorted list of distinct labels
+    for (f=0; f<NFILES; f++)
+        for (t=0; t<NTIMERANGES; t++)
+            for (l=0; l<numberOfLabels[f][t]; l++)
+                sorted[total++] = labels[f][t][l];
+    qsort(sorted, total, sizeof(int), compare);
+    for (n=0; n<total; n++)
+        if ((n == 0) || (sorted[n] != sorted[distinct-1])) sorted[distinct++] = sorted[n];
+
+    server = gptNewServer(NFILES, paths, "features",
+                          GEPETTO_LABEL_FILTER_TYPE_NONE, 0, -1,
+                          NFILES, paths, "labels");
+    expect(GPTServerIsInvalid(server), 0, "gptNewServer");
+    expect(LBL_NUMBER(server), distinct, "number of distinct labels");
+    for (n=0; n<distinct; n++) expect(LBL_VALUE(server, n), sorted[n], "sorted list of labels");
+
+    // label timeranges (each occurrence) and data entries (once per timerange) per label
+    labelCounts = (int*) calloc(distinct, sizeof(int));
+    dataCounts = (int*) calloc(distinct, sizeof(int));
+    labelCountsPerFile = (int*) malloc(distinct*sizeof(int));
+    dataCountsPerFile = (int*) malloc(distinct*sizeof(int));
+    for (f=0; f<NFILES; f++)
+    {
+        memset(labelCountsPerFile, 0, distinct*sizeof(int));
+        memset(dataCountsPerFile, 0, distinct*sizeof(int));
+        for (t=0; t<NTIMERANGES; t++)
+        {
+            expect(LBL_NLABELS(server, f, t), numberOfLabels[f][t], "number of labels per timerange");
+            memcpy(timerange, labels[f][t], numberOfLabels[f][t]*sizeof(int));
+            qsort(timerange, numberOfLabels[f][t], sizeof(int), compare);
+            for (l=0; l<numberOfLabels[f][t]; l++)
+            {
+                n = rankOf(sorted, distinct, timerange[l]);
+                labelCounts[n]++;
+                labelCountsPerFile[n]++;
+                if ((l == 0) || (timerange[l] != timerange[l-1]))
+                {
+                    dataCounts[n] += numberOfEntries[f][t];
+                    dataCountsPerFile[n] += numberOfEntries[f][t];
+                }
+            }
+        }
+        for (n=0; n<distinct; n++)
+        {
+            expect(LBL_COUNTF(server, f, n), labelCountsPerFile[n], "label count per file");
+            expect(DAT_COUNTF(server, f, n), dataCountsPerFile[n], "data count per file");
+        }
+    }
+    for (n=0; n<distinct; n++)
+    {
+        expect(LBL_COUNT(server, n), labelCounts[n], "label count");
+        expect(DAT_COUNT(server, n), dataCounts[n], "data count");
+    }
+    gptCloseServer(&server);
+
+    free(dataCountsPerFile);
+    free(labelCountsPerFile);
+    free(dataCounts);
+    free(labelCounts);
+    free(sorted);
+    for (f=0; f<NFILES; f++)
+    {
+        remove(paths[f]);
+        free(paths[f]);
+    }
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
@@ -0,0 +1,283 @@
+/*
+ *  test_LabelFilter.c
+ *  pinocchIO
+ *
+ *  Checks that compiled label filters (simple filter types and compound
+ *  predicates, at creation and on the fly) serve the same timeranges as a
+ *  naive evaluation of the predicate on every label, that gptSetLabelFilter()
+ *  rewinds the Gepetto server, and that an invalid predicate (or a change
+ *  while readers are open) is rejected without changing served timeranges
+ *  nor reading position.
+ *
+ *  usage: test_LabelFilter
+ *
+ */
+
+#include <string.h>
+#include "gepetto/gepetto.h"
+#include "test_utils.h"
+
+#define TEST_FILE "/tmp/test_LabelFilter_%d.pio"
+#define NFILES 3
+#define NTIMERANGES 500
+#define NCONCEPTS 50
+
+static void create(int f)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, 1);
+    PIODatatype labelDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    PIODataset pioDataset = PIODatasetInvalid;
+    char path[256];
+    float data;
+    int label;
+    int concepts[3];
+    int t;
+
+    sprintf(path, TEST_FILE, f);
+    pioFile = newFramesFile(path, NTIMERANGES, &pioTimeline);
+
+    // one entry per timerange, labelled 0 to 4
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        data = (float)(1000*f+t);
+        pioWrite(&pioDataset, t, &data, 1, pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    pioDataset = pioNewDataset(pioFile, "labels", "labels", pioTimeline, labelDatatype);
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        label = t%5;
+        pioWrite(&pioDataset, t, &label, 1, labelDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    // up to 3 concepts per timerange, some of them negative
+    pioDataset = pioNewDataset(pioFile, "concepts", "concepts", pioTimeline, labelDatatype);
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        concepts[0] = (t*7919 + f*104729) % NCONCEPTS;
+        concepts[1] = (t*31 + f) % NCONCEPTS - NCONCEPTS/2;
+        concepts[2] = (t/10) % NCONCEPTS;
+        pioWrite(&pioDataset, t, concepts, 1+(t+f)%3, labelDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    pioCloseDatatype(&labelDatatype);
+    pioCloseDatatype(&pioDatatype);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+}
+
+// reference evaluation of predicate on one label value
+static int accepts(const GPTLabelPredicate* predicate, int label)
+{
+    int i;
+
+    switch (predicate->type)
+    {
+        case GEPETTO_LABEL_PREDICATE_ANY: return 1;
+        case GEPETTO_LABEL_PREDICATE_EQUALS_TO: return label == predicate->values[0];
+        case GEPETTO_LABEL_PREDICATE_DIFFERS_FROM: return label != predicate->values[0];
+        case GEPETTO_LABEL_PREDICATE_GREATER_THAN: return label > predicate->values[0];
+        case GEPETTO_LABEL_PREDICATE_SMALLER_THAN: return label < predicate->values[0];
+        case GEPETTO_LABEL_PREDICATE_IN_RANGE:
+            return (label >= predicate->values[0]) && (label <= predicate->values[1]);
+        case GEPETTO_LABEL_PREDICATE_IN_SET:
+            for (i=0; i<predicate->numberOfValues; i++)
+                if (label == predicate->values[i]) return 1;
+            return 0;
+        case GEPETTO_LABEL_PREDICATE_AND:
+            for (i=0; i<predicate->numberOfOperands; i++)
+                if (!accepts(&(predicate->operands[i]), label)) return 0;
+            return 1;
+        case GEPETTO_LABEL_PREDICATE_OR:
+            for (i=0; i<predicate->numberOfOperands; i++)
+                if (accepts(&(predicate->operands[i]), label)) return 1;
+            return 0;
+        case GEPETTO_LABEL_PREDICATE_NOT:
+            return !accepts(&(predicate->operands[0]), label);
+    }
+    return 0;
+}
+
+// label and data datasets share their timeline: data timerange t has labels of label timerange t
+static void checkFilter(GPTServer server, const GPTLabelPredicate* predicate, const char* name)
+{
+    int f, t, l, expected;
+
+    for (f=0; f<DAT_NFILES(server); f++)
+        for (t=0; t<DAT_NTIMERANGES(server, f); t++)
+        {
+            expected = 0;
+            for (l=0; l<LBL_NLABELS(server, f, t); l++)
+                if (accepts(predicate, LBL_LABEL(server, f, t, l))) expected = 1;
+            expect(DAT_FILTERED(server, f, t), expected, name);
+        }
+}
+
+// simple filter types and compound predicates on concepts
+static void checkPredicates(char** paths)
+{
+    GPTServer server = GPTServerInvalid;
+    GPTServerOptions options = GPTServerOptionsDefault;
+    int n;
+
+    int two[1] = {2};
+    int set[5] = {3, 17, 42, -5, 49};
+    int range[2] = {-10, 29};
+    int hole[2] = {5, 8};
+    GPTLabelPredicate in_range[2] = {
+        {GEPETTO_LABEL_PREDICATE_IN_RANGE, 2, range, 0, NULL},
+        {GEPETTO_LABEL_PREDICATE_IN_RANGE, 2, hole, 0, NULL}};
+    GPTLabelPredicate not_hole = {GEPETTO_LABEL_PREDICATE_NOT, 0, NULL, 1, &(in_range[1])};
+    GPTLabelPredicate range_but_hole[2] = {
+        {GEPETTO_LABEL_PREDICATE_IN_RANGE, 2, range, 0, NULL},
+        {GEPETTO_LABEL_PREDICATE_NOT, 0, NULL, 1, &(in_range[1])}};
+    GPTLabelPredicate either[2] = {
+        {GEPETTO_LABEL_PREDICATE_IN_SET, 5, set, 0, NULL},
+        {GEPETTO_LABEL_PREDICATE_AND, 0, NULL, 2, range_but_hole}};
+    GPTLabelPredicate predicates[9] = {
+        {GEPETTO_LABEL_PREDICATE_ANY, 0, NULL, 0, NULL},
+        {GEPETTO_LABEL_PREDICATE_EQUALS_TO, 1, two, 0, NULL},
+        {GEPETTO_LABEL_PREDICATE_DIFFERS_FROM, 1, two, 0, NULL},
+        {GEPETTO_LABEL_PREDICATE_GREATER_THAN, 1, two, 0, NULL},
+        {GEPETTO_LABEL_PREDICATE_SMALLER_THAN, 1, two, 0, NULL},
+        {GEPETTO_LABEL_PREDICATE_IN_SET, 5, set, 0, NULL},
+        {GEPETTO_LABEL_PREDICATE_AND, 0, NULL, 2, in_range},
+        {GEPETTO_LABEL_PREDICATE_OR, 0, NULL, 2, either},
+        {GEPETTO_LABEL_PREDICATE_NOT, 0, NULL, 1, &not_hole}};
+    const char* names[9] = {"any", "equalsTo 2", "differsFrom 2", "greaterThan 2", "smallerThan 2",
+                            "in set", "and", "or", "not not"};
+    GPTLabelFilterType types[5] = {GEPETTO_LABEL_FILTER_TYPE_NONE,
+                                   GEPETTO_LABEL_FILTER_TYPE_EQUALS_TO,
+                                   GEPETTO_LABEL_FILTER_TYPE_DIFFERS_FROM,
+                                   GEPETTO_LABEL_FILTER_TYPE_GREATER_THAN,
+                                   GEPETTO_LABEL_FILTER_TYPE_SMALLER_THAN};
+
+    // simple filter types
+    for (n=0; n<5; n++)
+    {
+        server = gptNewServer(NFILES, paths, "features", types[n], 2, -1,
+                              NFILES, paths, "concepts");
+        expect(GPTServerIsInvalid(server), 0, names[n]);
+        checkFilter(server, &(predicates[n]), names[n]);
+        gptCloseServer(&server);
+    }
+
+    // compound predicates, at creation and on the fly
+    options.labelPredicate = &(predicates[7]);
+    server = gptNewServerWithOptions(NFILES, paths, "features",
+                                     GEPETTO_LABEL_FILTER_TYPE_NONE, 0, -1,
+                                     NFILES, paths, "concepts", options);
+    expect(GPTServerIsInvalid(server), 0, "or (at creation)");
+    checkFilter(server, &(predicates[7]), "or (at creation)");
+    for (n=0; n<9; n++)
+    {
+        expect(gptSetLabelFilter(&server, &(predicates[n])), 1, names[n]);
+        checkFilter(server, &(predicates[n]), names[n]);
+    }
+
+    // nested invalid predicate is rejected, filter is kept
+    in_range[1].numberOfValues = 1;
+    expect(gptSetLabelFilter(&server, &(predicates[7])), -1, "nested invalid predicate");
+    in_range[1].numberOfValues = 2;
+    checkFilter(server, &(predicates[8]), "filter kept after nested invalid predicate");
+
+    gptCloseServer(&server);
+}
+
+// next value served by gptReadNext()
+static float readNext(GPTServer* server, PIODatatype pioDatatype, const char* name)
+{
+    void* buffer = NULL;
+
+    expect(gptReadNext(server, pioDatatype, &buffer, NULL, NULL), 1, name);
+    return *((float*)buffer);
+}
+
+int main (int argc, char *const  argv[])
+{
+    char* paths[NFILES];
+    GPTServer server = GPTServerInvalid;
+    GPTReader* reader = NULL;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, 1);
+    int three = 3;
+    int invalid[2] = {1, 2};
+    GPTLabelPredicate equalsToThree = {GEPETTO_LABEL_PREDICATE_EQUALS_TO, 1, &three, 0, NULL};
+    GPTLabelPredicate invalidPredicate = {GEPETTO_LABEL_PREDICATE_EQUALS_TO, 2, invalid, 0, NULL};
+    GPTLabelPredicate emptySet = {GEPETTO_LABEL_PREDICATE_IN_SET, 0, NULL, 0, NULL};
+    GPTLabelPredicate any = {GEPETTO_LABEL_PREDICATE_ANY, 0, NULL, 0, NULL};
+    float* dumped = NULL;
+    void* buffer = NULL;
+    int64_t size;
+    int n, f;
+
+    for (f=0; f<NFILES; f++)
+    {
+        create(f);
+        paths[f] = (char*) malloc(256);
+        sprintf(paths[f], TEST_FILE, f);
+    }
+
+    // labels 1 to 4
+    server = gptNewServer(NFILES, paths, "features",
+                          GEPETTO_LABEL_FILTER_TYPE_GREATER_THAN, 0, -1,
+                          NFILES, paths, "labels");
+    expect(GPTServerIsInvalid(server), 0, "gptNewServer");
+    size = gptDumpServer(&server, pioDatatype, NULL);
+    expect(size, NFILES*NTIMERANGES*4/5*sizeof(float), "size of server");
+    dumped = (float*) malloc(size);
+    gptDumpServer(&server, pioDatatype, dumped);
+
+    // invalid predicate leaves the server untouched
+    for (n=0; n<10; n++) readNext(&server, pioDatatype, "gptReadNext");
+    expect(gptSetLabelFilter(&server, &invalidPredicate), -1, "invalid predicate");
+    expect(gptDumpServer(&server, pioDatatype, NULL), size, "size after invalid predicate");
+    expect(readNext(&server, pioDatatype, "position after invalid predicate"), dumped[10],
+           "position after invalid predicate");
+
+    // valid predicate updates served timeranges and rewinds the server
+    expect(gptSetLabelFilter(&server, &equalsToThree), 1, "gptSetLabelFilter");
+    expect(gptDumpServer(&server, pioDatatype, NULL), NFILES*NTIMERANGES/5*sizeof(float),
+           "size after gptSetLabelFilter");
+    expect(readNext(&server, pioDatatype, "first value"), 3, "first value");
+    expect(readNext(&server, pioDatatype, "second value"), 8, "second value");
+
+    // nothing served
+    expect(gptSetLabelFilter(&server, &emptySet), 1, "empty set");
+    expect(gptReadNext(&server, pioDatatype, &buffer, NULL, NULL), -1, "empty server");
+
+    // everything served, from the start
+    expect(gptSetLabelFilter(&server, &any), 1, "any label");
+    expect(gptDumpServer(&server, pioDatatype, NULL), NFILES*NTIMERANGES*sizeof(float), "size with any label");
+    for (n=0; n<NTIMERANGES+2; n++)
+        expect(readNext(&server, pioDatatype, "any label"), (n<NTIMERANGES) ? n : 1000+n-NTIMERANGES, "any label");
+
+    // reader shares depend on served timeranges: filter is kept while readers are open
+    reader = gptNewReader(&server, 0, 2);
+    expect(reader != NULL, 1, "gptNewReader");
+    expect(gptSetLabelFilter(&server, &equalsToThree), -1, "gptSetLabelFilter with open reader");
+    expect(gptDumpServer(&server, pioDatatype, NULL), NFILES*NTIMERANGES*sizeof(float), "size with open reader");
+    expect(readNext(&server, pioDatatype, "position with open reader"), 1000+2, "position with open reader");
+    gptCloseReader(&reader);
+    expect(gptSetLabelFilter(&server, &equalsToThree), 1, "gptSetLabelFilter after gptCloseReader");
+
+    gptCloseServer(&server);
+
+    checkPredicates(paths);
+
+    pioCloseDatatype(&pioDatatype);
+    for (f=0; f<NFILES; f++)
+    {
+        remove(paths[f]);
+        free(paths[f]);
+    }
+    free(dumped);
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
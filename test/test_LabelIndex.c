@@ -0,0 +1,188 @@
+/*
+ *  test_LabelIndex.c
+ *  pinocchIO
+ *
+ *  Checks that gptGetTimerangesForLabel() and gptGetTimerangesForLabelNoCopy()
+ *  return, for every label value, every label timerange with this label (once,
+ *  even when the label is repeated within the timerange), sorted by file then
+ *  chronologically, and nothing for unknown labels.
+ *
+ *  usage: test_LabelIndex
+ *
+ */
+
+#include <string.h>
+#include <limits.h>
+#include "gepetto/gepetto.h"
+#include "test_utils.h"
+
+#define TEST_FILE "/tmp/test_LabelIndex_%d.pio"
+#define NFILES 6
+#define NTIMERANGES 1500
+#define NLABELS 200
+
+// labels of every timerange of every file
+static int labels[NFILES][NTIMERANGES][3];
+static int numberOfLabels[NFILES][NTIMERANGES];
+static int numberOfTimeranges[NFILES];
+
+static PIOTimeRange timerangeOf(int f, int t)
+{
+    PIOTimeRange timerange;
+
+    timerange.time = 10*t + f;
+    timerange.duration = 5 + t%7;
+    timerange.scale = 25;
+    return timerange;
+}
+
+static void create(int f)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype labelDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    PIODataset pioDataset = PIODatasetInvalid;
+    PIOTimeRange* timeranges = NULL;
+    char path[256];
+    int t;
+
+    // files of different lengths
+    numberOfTimeranges[f] = NTIMERANGES - 100*f;
+    timeranges = newFrames(NTIMERANGES);
+    for (t=0; t<numberOfTimeranges[f]; t++) timeranges[t] = timerangeOf(f, t);
+
+    sprintf(path, TEST_FILE, f);
+    remove(path);
+    pioFile = pioNewFile(path, "/path/to/medium");
+    pioTimeline = pioNewTimeline(pioFile, "shots", "shots", numberOfTimeranges[f], timeranges);
+
+    // 0 to 3 labels per timerange, sometimes twice the same, some extreme values
+    pioDataset = pioNewDataset(pioFile, "labels", "labels", pioTimeline, labelDatatype);
+    for (t=0; t<numberOfTimeranges[f]; t++)
+    {
+        numberOfLabels[f][t] = t%4;
+        labels[f][t][0] = (t%50 == 0) ? INT_MIN : rand()%NLABELS;
+        labels[f][t][1] = (t%60 == 2) ? INT_MAX : rand()%NLABELS;
+        labels[f][t][2] = (t%7 == 3) ? labels[f][t][0] : -(rand()%NLABELS);
+        pioWrite(&pioDataset, t, labels[f][t], numberOfLabels[f][t], labelDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    pioCloseDatatype(&labelDatatype);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+    free(timeranges);
+}
+
+// label timeranges with given label, by brute force
+static int scan(int labelValue, GPTTimeRange* timeranges)
+{
+    int f, t, i;
+    int number = 0;
+
+    for (f=0; f<NFILES; f++)
+        for (t=0; t<numberOfTimeranges[f]; t++)
+            for (i=0; i<numberOfLabels[f][t]; i++)
+                if (labels[f][t][i] == labelValue)
+                {
+                    timeranges[number].fileIndex = f;
+                    timeranges[number].timerange = timerangeOf(f, t);
+                    number++;
+                    break;
+                }
+    return number;
+}
+
+// number of distinct labels of timerange t of file f
+static int numberOfDistinctLabelsOf(int f, int t)
+{
+    int i, j;
+    int number = 0;
+
+    for (i=0; i<numberOfLabels[f][t]; i++)
+    {
+        for (j=0; j<i; j++)
+            if (labels[f][t][j] == labels[f][t][i]) break;
+        if (j == i) number++;
+    }
+    return number;
+}
+
+static void compare(const GPTTimeRange* timeranges, const GPTTimeRange* expected, int number, const char* name)
+{
+    int i;
+
+    for (i=0; i<number; i++)
+    {
+        expect(timeranges[i].fileIndex, expected[i].fileIndex, name);
+        expect(pioCompareTimeRanges(timeranges[i].timerange, expected[i].timerange),
+               PINOCCHIO_TIMERANGE_COMPARISON_SAME, name);
+    }
+}
+
+int main (int argc, char *const  argv[])
+{
+    char* paths[NFILES];
+    GPTServer server = GPTServerInvalid;
+    GPTTimeRange* expected = (GPTTimeRange*) malloc(NFILES*NTIMERANGES*sizeof(GPTTimeRange));
+    GPTTimeRange* copied = (GPTTimeRange*) malloc(NFILES*NTIMERANGES*sizeof(GPTTimeRange));
+    const GPTTimeRange* indexed = NULL;
+    int* distinct = NULL;
+    int numberOfDistinctLabels;
+    int number, total, f, n;
+
+    srand(42);
+    for (f=0; f<NFILES; f++)
+    {
+        create(f);
+        paths[f] = (char*) malloc(256);
+        sprintf(paths[f], TEST_FILE, f);
+    }
+
+    server = gptNewServer(0, NULL, NULL, GEPETTO_LABEL_FILTER_TYPE_NONE, 0, -1,
+                          NFILES, paths, "labels");
+    expect(GPTServerIsInvalid(server), 0, "gptNewServer");
+
+    numberOfDistinctLabels = gptGetListOfDistinctLabels(server, NULL);
+    distinct = (int*) malloc(numberOfDistinctLabels*sizeof(int));
+    gptGetListOfDistinctLabels(server, distinct);
+    expect(distinct[0], INT_MIN, "smallest label");
+    expect(distinct[numberOfDistinctLabels-1], INT_MAX, "largest label");
+
+    // every label timerange is indexed under each of its (distinct) labels
+    total = 0;
+    for (n=0; n<numberOfDistinctLabels; n++)
+    {
+        number = scan(distinct[n], expected);
+        expect(number > 0, 1, "known label");
+        expect(gptGetTimerangesForLabel(server, distinct[n], NULL), number, "gptGetTimerangesForLabel (count)");
+        expect(gptGetTimerangesForLabel(server, distinct[n], copied), number, "gptGetTimerangesForLabel");
+        compare(copied, expected, number, "gptGetTimerangesForLabel");
+        expect(gptGetTimerangesForLabelNoCopy(server, distinct[n], &indexed), number, "gptGetTimerangesForLabelNoCopy");
+        compare(indexed, expected, number, "gptGetTimerangesForLabelNoCopy");
+        total += number;
+    }
+    for (f=0, number=0; f<NFILES; f++)
+        for (n=0; n<numberOfTimeranges[f]; n++)
+            number += numberOfDistinctLabelsOf(f, n);
+    expect(total, number, "total number of indexed timeranges");
+
+    // unknown labels
+    expect(gptGetTimerangesForLabel(server, NLABELS, copied), 0, "unknown label");
+    expect(gptGetTimerangesForLabelNoCopy(server, NLABELS, &indexed), 0, "unknown label (no copy)");
+    expect(indexed == NULL, 1, "unknown label (no copy)");
+    expect(gptGetTimerangesForLabel(server, INT_MIN+1, copied), 0, "unknown extreme label");
+
+    gptCloseServer(&server);
+    free(distinct);
+    free(copied);
+    free(expected);
+    for (f=0; f<NFILES; f++)
+    {
+        remove(paths[f]);
+        free(paths[f]);
+    }
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
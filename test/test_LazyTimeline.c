@@ -0,0 +1,137 @@
+/*
+ *  test_LazyTimeline.c
+ *  pinocchIO
+ *
+ *  Checks that lazy timelines (PINOCCHIO_TIMELINE_LAZY) only read their length
+ *  when opened, and that time ranges paged in by pioGetTimeRange() (in order,
+ *  backwards, at random and across window bounds), read by pioReadTimeRanges()
+ *  or loaded by pioLoadTimeline() are the ones loaded by pioOpenTimeline().
+ *
+ *  usage: test_LazyTimeline
+ *
+ */
+
+#include "test_utils.h"
+
+#define TEST_FILE "/tmp/test_LazyTimeline.pio"
+#define NTIMERANGES (3*PIOTimelineWindowSize+123)
+
+static void check(PIOTimeRange timerange, PIOTimeRange expected, const char* name)
+{
+    expect(timerange.time, expected.time, name);
+    expect(timerange.duration, expected.duration, name);
+    expect(timerange.scale, expected.scale, name);
+}
+
+int main (int argc, char *const  argv[])
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIOTimeline lazy = PIOTimelineInvalid;
+    PIODatatype pioDatatype = PIODatatypeInvalid;
+    PIODataset pioDataset = PIODatasetInvalid;
+    PIOTimeRange* timeranges = NULL;
+    PIOTimeRange some[2*PIOTimelineWindowSize];
+    int bounds[] = {0, 1, PIOTimelineWindowSize-1, PIOTimelineWindowSize, PIOTimelineWindowSize+1,
+                    2*PIOTimelineWindowSize-1, NTIMERANGES-2, NTIMERANGES-1};
+    int nbounds = sizeof(bounds)/sizeof(int);
+    int i, t, u;
+
+    // frames at 25 Hz, with a few gaps
+    timeranges = (PIOTimeRange*) malloc(NTIMERANGES*sizeof(PIOTimeRange));
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        timeranges[t].time = t + t/1000;
+        timeranges[t].duration = 1 + t%3;
+        timeranges[t].scale = 25;
+    }
+
+    remove(TEST_FILE);
+    pioFile = pioNewFile(TEST_FILE, "/path/to/medium");
+    pioTimeline = pioNewTimeline(pioFile, "frames", "frames", NTIMERANGES, timeranges);
+    pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    pioCloseDataset(&pioDataset);
+    pioCloseDatatype(&pioDatatype);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+
+    pioFile = pioOpenFile(TEST_FILE, PINOCCHIO_READONLY);
+    pioDataset = pioOpenDataset(PIOMakeObject(pioFile), "features");
+
+    // timeline of dataset: length only
+    lazy = pioGetTimelineWithFlags(pioDataset, PINOCCHIO_TIMELINE_LAZY);
+    expect(PIOTimelineIsInvalid(lazy), 0, "pioGetTimelineWithFlags");
+    expect(lazy.ntimeranges, NTIMERANGES, "length of lazy timeline of dataset");
+    expect(lazy.timeranges == NULL, 1, "lazy timeline of dataset is not loaded");
+    pioCloseTimeline(&lazy);
+
+    pioTimeline = pioOpenTimeline(PIOMakeObject(pioFile), "frames");
+    expect(pioTimeline.ntimeranges, NTIMERANGES, "pioOpenTimeline");
+    for (t=0; t<NTIMERANGES; t++) check(pioTimeline.timeranges[t], timeranges[t], "pioOpenTimeline");
+    check(pioGetTimeRange(&pioTimeline, NTIMERANGES-1), timeranges[NTIMERANGES-1], "pioGetTimeRange (loaded)");
+    expect(pioTimeline.window == NULL, 1, "no window when loaded");
+
+    lazy = pioOpenTimelineWithFlags(PIOMakeObject(pioFile), "frames", PINOCCHIO_TIMELINE_LAZY);
+    expect(PIOTimelineIsInvalid(lazy), 0, "pioOpenTimelineWithFlags");
+    expect(lazy.ntimeranges, NTIMERANGES, "length of lazy timeline");
+    expect(lazy.timeranges == NULL, 1, "lazy timeline is not loaded");
+    expect(lazy.window == NULL, 1, "no window yet");
+
+    // whole timeline, window after window, in order then backwards
+    for (t=0; t<NTIMERANGES; t++) check(pioGetTimeRange(&lazy, t), timeranges[t], "pioGetTimeRange (in order)");
+    expect(lazy.window_length <= PIOTimelineWindowSize, 1, "one window at a time");
+    for (t=NTIMERANGES-1; t>=0; t--) check(pioGetTimeRange(&lazy, t), timeranges[t], "pioGetTimeRange (backwards)");
+
+    // random time ranges, window bounds
+    srand(42);
+    for (i=0; i<1000; i++)
+    {
+        t = rand()%NTIMERANGES;
+        check(pioGetTimeRange(&lazy, t), timeranges[t], "pioGetTimeRange (random)");
+    }
+    for (i=0; i<nbounds; i++)
+        check(pioGetTimeRange(&lazy, bounds[i]), timeranges[bounds[i]], "pioGetTimeRange (window bounds)");
+    expect(lazy.timeranges == NULL, 1, "lazy timeline is still not loaded");
+
+    // consecutive time ranges, across windows
+    for (i=0; i<nbounds; i++)
+    {
+        t = bounds[i];
+        expect(pioReadTimeRanges(lazy, t, 1, some), 1, "pioReadTimeRanges (one)");
+        check(some[0], timeranges[t], "pioReadTimeRanges (one)");
+        if (t+2*PIOTimelineWindowSize > NTIMERANGES) continue;
+        expect(pioReadTimeRanges(lazy, t, 2*PIOTimelineWindowSize, some), 2*PIOTimelineWindowSize,
+               "pioReadTimeRanges (several windows)");
+        for (u=0; u<2*PIOTimelineWindowSize; u++)
+            check(some[u], timeranges[t+u], "pioReadTimeRanges (several windows)");
+    }
+    expect(pioReadTimeRanges(lazy, NTIMERANGES-10, 10, some), 10, "pioReadTimeRanges (last ones)");
+    for (i=0; i<10; i++) check(some[i], timeranges[NTIMERANGES-10+i], "pioReadTimeRanges (last ones)");
+
+    // out of timeline
+    expect(pioReadTimeRanges(lazy, NTIMERANGES-10, 11, some), -1, "pioReadTimeRanges (after last one)");
+    expect(pioReadTimeRanges(lazy, -1, 2, some), -1, "pioReadTimeRanges (before first one)");
+    expect(pioGetTimeRange(&lazy, NTIMERANGES).scale, -1, "pioGetTimeRange (after last one)");
+    expect(pioGetTimeRange(&lazy, -1).scale, -1, "pioGetTimeRange (before first one)");
+    check(pioGetTimeRange(&lazy, 0), timeranges[0], "pioGetTimeRange (after failure)");
+
+    // whole timeline, on request (twice)
+    expect(pioLoadTimeline(&lazy), 1, "pioLoadTimeline");
+    expect(lazy.timeranges != NULL, 1, "pioLoadTimeline");
+    expect(lazy.window == NULL, 1, "window released");
+    for (t=0; t<NTIMERANGES; t++) check(lazy.timeranges[t], timeranges[t], "pioLoadTimeline");
+    expect(pioLoadTimeline(&lazy), 1, "pioLoadTimeline (loaded)");
+    check(pioGetTimeRange(&lazy, PIOTimelineWindowSize), timeranges[PIOTimelineWindowSize], "pioGetTimeRange (loaded)");
+    expect(lazy.window == NULL, 1, "no window when loaded");
+
+    pioCloseTimeline(&lazy);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseDataset(&pioDataset);
+    pioCloseFile(&pioFile);
+    remove(TEST_FILE);
+    free(timeranges);
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
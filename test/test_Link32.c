@@ -0,0 +1,174 @@
+/*
+ *  test_Link32.c
+ *  pinocchIO
+ *
+ *  Checks that datasets written by pinocchIO versions older than 0.4 (links
+ *  stored as 32-bit integers, recreated here with raw HDF5) can still be read
+ *  with pioRead() and pioReadRange() and appended to, directly or through a
+ *  writer, and that appending past 2^31 entries fails without corrupting them.
+ *
+ *  usage: test_Link32
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <hdf5.h>
+#include "test_utils.h"
+
+#define TEST_FILE "/tmp/test_Link32.pio"
+#define LINK_PATH "/dataset/features/link"
+#define DATA_PATH "/dataset/features/data"
+#define NTIMERANGES 300
+#define DIMENSION 2
+
+// what each time range is expected to contain (last write wins)
+static int expectedNumber[NTIMERANGES];
+static int expectedData[NTIMERANGES][4*DIMENSION];
+
+// same layout as links in memory
+typedef struct {
+    int64_t position;
+    int64_t number;
+} link64_t;
+
+static int write(PIODataset* pioDataset, int t, int number, int value, PIODatatype pioDatatype)
+{
+    int d;
+
+    for (d=0; d<number*DIMENSION; d++) expectedData[t][d] = value + d;
+    expectedNumber[t] = number;
+    return pioWrite(pioDataset, t, expectedData[t], number, pioDatatype);
+}
+
+static void check(PIODataset* pioDataset, PIODatatype pioDatatype, const char* name)
+{
+    int numbers[NTIMERANGES];
+    void* buffer = NULL;
+    int64_t total = 0;
+    int t;
+
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        expect(pioRead(pioDataset, t, pioDatatype, &buffer), expectedNumber[t], name);
+        expect(memcmp(buffer, expectedData[t], expectedNumber[t]*DIMENSION*sizeof(int)), 0, name);
+        total += expectedNumber[t];
+    }
+
+    // all time ranges at once
+    expect(pioReadRange(pioDataset, 0, NTIMERANGES, pioDatatype, &buffer, numbers), total, name);
+    total = 0;
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        expect(numbers[t], expectedNumber[t], name);
+        expect(memcmp((int*)buffer + total*DIMENSION, expectedData[t],
+                      expectedNumber[t]*DIMENSION*sizeof(int)), 0, name);
+        total += expectedNumber[t];
+    }
+}
+
+// replace link dataset by a pre-0.4 one, with 32-bit positions and numbers
+static void convertLinksTo32(const char* path)
+{
+    hid_t file = H5Fopen(path, H5F_ACC_RDWR, H5P_DEFAULT);
+    hid_t dataset = H5Dopen2(file, LINK_PATH, H5P_DEFAULT);
+    hid_t dataspace = H5Dget_space(dataset);
+    hid_t creationProperty = H5Dget_create_plist(dataset);
+    hid_t memoryDatatype = H5Tcreate(H5T_COMPOUND, sizeof(link64_t));
+    hid_t fileDatatype = H5Tcreate(H5T_COMPOUND, 2*sizeof(int32_t));
+    link64_t links[NTIMERANGES];
+
+    H5Tinsert(memoryDatatype, "position", HOFFSET(link64_t, position), H5T_NATIVE_INT64);
+    H5Tinsert(memoryDatatype, "number", HOFFSET(link64_t, number), H5T_NATIVE_INT64);
+    H5Tinsert(fileDatatype, "position", 0, H5T_STD_I32LE);
+    H5Tinsert(fileDatatype, "number", sizeof(int32_t), H5T_STD_I32LE);
+
+    expect(H5Dread(dataset, memoryDatatype, H5S_ALL, H5S_ALL, H5P_DEFAULT, links) >= 0, 1, "read links");
+    H5Dclose(dataset);
+    H5Ldelete(file, LINK_PATH, H5P_DEFAULT);
+
+    dataset = H5Dcreate2(file, LINK_PATH, fileDatatype, dataspace, H5P_DEFAULT, creationProperty, H5P_DEFAULT);
+    expect(dataset >= 0, 1, "create 32-bit links");
+    expect(H5Dwrite(dataset, memoryDatatype, H5S_ALL, H5S_ALL, H5P_DEFAULT, links) >= 0, 1, "write 32-bit links");
+
+    H5Dclose(dataset);
+    H5Tclose(fileDatatype);
+    H5Tclose(memoryDatatype);
+    H5Pclose(creationProperty);
+    H5Sclose(dataspace);
+    H5Fclose(file);
+}
+
+// extend data dataset (without writing anything) so that it holds extent entries
+static void extendData(const char* path, hsize_t extent)
+{
+    hid_t file = H5Fopen(path, H5F_ACC_RDWR, H5P_DEFAULT);
+    hid_t dataset = H5Dopen2(file, DATA_PATH, H5P_DEFAULT);
+
+    expect(H5Dset_extent(dataset, &extent) >= 0, 1, "extend data");
+    H5Dclose(dataset);
+    H5Fclose(file);
+}
+
+int main (int argc, char *const  argv[])
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, DIMENSION);
+    PIODataset pioDataset = PIODatasetInvalid;
+    int64_t stored;
+    int t;
+
+    pioFile = newFramesFile(TEST_FILE, NTIMERANGES, &pioTimeline);
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    for (t=0; t<NTIMERANGES; t++) write(&pioDataset, t, t%4, 100*t, pioDatatype);
+    pioCloseDataset(&pioDataset);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+
+    convertLinksTo32(TEST_FILE);
+
+    // read
+    pioFile = pioOpenFile(TEST_FILE, PINOCCHIO_READNWRITE);
+    pioDataset = pioOpenDataset(PIOMakeObject(pioFile), "features");
+    expect(PIODatasetIsValid(pioDataset), 1, "pioOpenDataset");
+    check(&pioDataset, pioDatatype, "32-bit links");
+
+    // append directly...
+    for (t=0; t<NTIMERANGES; t+=7)
+        expect(write(&pioDataset, t, 1+t%3, -100*t, pioDatatype), 1+t%3, "direct write");
+    check(&pioDataset, pioDatatype, "32-bit links after direct writes");
+
+    // ... and through a writer
+    pioNewDatasetWriter(&pioDataset, 0);
+    for (t=1; t<NTIMERANGES; t+=5)
+        expect(write(&pioDataset, t, t%4, 1000*t, pioDatatype), t%4, "buffered write");
+    expect(pioCloseDatasetWriter(&pioDataset), 1, "pioCloseDatasetWriter");
+    check(&pioDataset, pioDatatype, "32-bit links after buffered writes");
+    pioCloseDataset(&pioDataset);
+
+    // same after reopening
+    pioDataset = pioOpenDataset(PIOMakeObject(pioFile), "features");
+    check(&pioDataset, pioDatatype, "32-bit links (reopened)");
+    pioCloseDataset(&pioDataset);
+    pioCloseFile(&pioFile);
+
+    // 32-bit links cannot address more than 2^31 entries
+    extendData(TEST_FILE, (hsize_t)INT32_MAX-1);
+    pioFile = pioOpenFile(TEST_FILE, PINOCCHIO_READNWRITE);
+    pioDataset = pioOpenDataset(PIOMakeObject(pioFile), "features");
+    stored = pioDataset.stored;
+    expect(stored, INT32_MAX-1, "extended data");
+    expect(write(&pioDataset, 2, 1, 7, pioDatatype), 1, "write up to 2^31 entries");
+    expect(pioWrite(&pioDataset, 3, expectedData[0], 2, pioDatatype), -1, "write past 2^31 entries");
+    expect(pioDataset.stored, stored+1, "stored entries after failed write");
+    check(&pioDataset, pioDatatype, "32-bit links after failed write");
+    pioCloseDataset(&pioDataset);
+
+    pioCloseFile(&pioFile);
+    pioCloseDatatype(&pioDatatype);
+    remove(TEST_FILE);
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
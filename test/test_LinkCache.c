@@ -0,0 +1,104 @@
+/*
+ *  test_LinkCache.c
+ *  pinocchIO
+ *
+ *  Checks that datasets opened with PINOCCHIO_DATASET_CACHE_LINKS and
+ *  PINOCCHIO_DATASET_PRELOAD_LINKS load their link table when expected, read
+ *  the same data as datasets opened the default way, and that the in-memory
+ *  link table follows direct and buffered writes.
+ *
+ *  usage: test_LinkCache
+ *
+ */
+
+#include <string.h>
+#include "test_utils.h"
+
+#define TEST_FILE "/tmp/test_LinkCache.pio"
+#define NTIMERANGES 300
+
+// read every time range of dataset and reference, and compare them
+static void check(PIODataset* pioDataset, PIODataset* reference, PIODatatype pioDatatype, const char* name)
+{
+    int numbers[NTIMERANGES], referenceNumbers[NTIMERANGES];
+    void* buffer = NULL;
+    int* expected = (int*) malloc(8*sizeof(int));
+    int number, t;
+
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        number = pioRead(reference, t, pioDatatype, &buffer);
+        memcpy(expected, buffer, number*sizeof(int));
+        expect(pioRead(pioDataset, t, pioDatatype, &buffer), number, name);
+        expect(memcmp(buffer, expected, number*sizeof(int)), 0, name);
+        expect(pioReadNumber(*pioDataset, t), number, name);
+    }
+    expect(pioReadAllNumbers(*pioDataset, numbers), pioReadAllNumbers(*reference, referenceNumbers), name);
+    expect(memcmp(numbers, referenceNumbers, NTIMERANGES*sizeof(int)), 0, name);
+
+    free(expected);
+}
+
+int main (int argc, char *const  argv[])
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    PIODataset reference = PIODatasetInvalid;
+    PIODataset cached = PIODatasetInvalid;
+    PIODataset preloaded = PIODatasetInvalid;
+    int data[8];
+    void* buffer = NULL;
+    int t, d;
+
+    pioFile = newFramesFile(TEST_FILE, NTIMERANGES, &pioTimeline);
+    reference = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        for (d=0; d<8; d++) data[d] = t+d;
+        pioWrite(&reference, t, data, t%3, pioDatatype);
+    }
+    pioCloseDataset(&reference);
+
+    reference = pioOpenDataset(PIOMakeObject(pioFile), "features");
+    cached = pioOpenDatasetWithFlags(PIOMakeObject(pioFile), "features", PINOCCHIO_DATASET_CACHE_LINKS);
+    preloaded = pioOpenDatasetWithFlags(PIOMakeObject(pioFile), "features", PINOCCHIO_DATASET_PRELOAD_LINKS);
+    expect(reference.links == NULL, 1, "default dataset has no link table");
+    expect(cached.links == NULL, 1, "link table is loaded at first read");
+    expect(preloaded.links != NULL, 1, "link table is loaded when opening");
+
+    pioRead(&cached, 0, pioDatatype, &buffer);
+    expect(cached.links != NULL, 1, "link table is loaded after first read");
+    check(&cached, &reference, pioDatatype, "cached links");
+    check(&preloaded, &reference, pioDatatype, "preloaded links");
+
+    // direct writes through cached dataset update its link table...
+    for (t=0; t<NTIMERANGES; t+=5)
+    {
+        for (d=0; d<8; d++) data[d] = -t-d;
+        expect(pioWrite(&preloaded, t, data, 1+t%7, pioDatatype), 1+t%7, "direct write");
+    }
+    // ... and so do buffered ones
+    pioNewDatasetWriter(&preloaded, 0);
+    for (t=1; t<NTIMERANGES; t+=5)
+    {
+        for (d=0; d<8; d++) data[d] = 1000+t+d;
+        expect(pioWrite(&preloaded, t, data, t%4, pioDatatype), t%4, "buffered write");
+    }
+    pioCloseDatasetWriter(&preloaded);
+    pioCloseDataset(&reference);
+    reference = pioOpenDataset(PIOMakeObject(pioFile), "features");
+    check(&preloaded, &reference, pioDatatype, "preloaded links after writes");
+    expect(pioReadNumber(preloaded, 5), 6, "number of entries after write");
+
+    pioCloseDataset(&preloaded);
+    pioCloseDataset(&cached);
+    pioCloseDataset(&reference);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+    pioCloseDatatype(&pioDatatype);
+    remove(TEST_FILE);
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
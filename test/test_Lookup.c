@@ -0,0 +1,199 @@
+/*
+ *  test_Lookup.c
+ *  pinocchIO
+ *
+ *  Checks pioFindTimeRangeInTimeLine(), pioFindTimeRangesContainingTime() and
+ *  pioFindTimeRangesIntersectingTimeRange() against a linear scan of timelines
+ *  with and without overlapping time ranges, at the bounds of each time range,
+ *  with too small arrays of indices and on tiny timelines.
+ *
+ *  usage: test_Lookup
+ *
+ */
+
+#include <string.h>
+#include "test_utils.h"
+
+#define NTIMERANGES 5000
+#define NQUERIES 500
+
+static int compare(const void* tr1, const void* tr2)
+{
+    return pioCompareTimeRanges(*(PIOTimeRange*)tr1, *(PIOTimeRange*)tr2);
+}
+
+// segments (in milliseconds) of 10 to 100 ms, some of them much longer
+// and overlapping many others (or identical to previous one) when overlap is set
+static PIOTimeRange* segments(int n, int overlap)
+{
+    PIOTimeRange* timeranges = (PIOTimeRange*) malloc(n*sizeof(PIOTimeRange));
+    int64_t time = 0;
+    int t;
+
+    for (t=0; t<n; t++)
+    {
+        timeranges[t].time = time;
+        timeranges[t].duration = 10 + rand()%90;
+        timeranges[t].scale = 1000;
+        if (overlap)
+        {
+            if (rand()%100 == 0) timeranges[t].duration = rand()%10000;
+            if ((t > 0) && (rand()%20 == 0)) timeranges[t] = timeranges[t-1];
+            time += rand()%50;
+        }
+        else
+            time += timeranges[t].duration + rand()%10;
+    }
+    qsort(timeranges, n, sizeof(PIOTimeRange), compare);
+    return timeranges;
+}
+
+static int linearContaining(PIOTimeRange* tl, int n, PIOTime time, int* indices)
+{
+    int t, number = 0;
+    for (t=0; t<n; t++)
+        if (pioTimeInTimeRange(time, tl[t])) indices[number++] = t;
+    return number;
+}
+
+static int linearIntersecting(PIOTimeRange* tl, int n, PIOTimeRange tr, int* indices)
+{
+    int t, number = 0;
+    for (t=0; t<n; t++)
+        if (pioTimeRangeIntersectsTimeRange(tl[t], tr)) indices[number++] = t;
+    return number;
+}
+
+static void compareIndices(int number, int* indices, int expectedNumber, int* expected, const char* name)
+{
+    int i;
+
+    expect(number, expectedNumber, name);
+    for (i=0; i<number; i++) expect(indices[i], expected[i], name);
+}
+
+static void checkContaining(PIOTimeRange* tl, PIOTime* stops, int n, PIOTime time,
+                            int* indices, int* expected, const char* name)
+{
+    int number = linearContaining(tl, n, time, expected);
+
+    compareIndices(pioFindTimeRangesContainingTime(tl, stops, n, time, indices, n), indices,
+                   number, expected, name);
+    expect(pioFindTimeRangesContainingTime(tl, stops, n, time, NULL, 0), number, name);
+
+    // only first indices are stored, all of them are counted
+    if (number > 1)
+    {
+        memset(indices, -1, n*sizeof(int));
+        expect(pioFindTimeRangesContainingTime(tl, stops, n, time, indices, 1), number, name);
+        expect(indices[0], expected[0], name);
+        expect(indices[1], -1, name);
+    }
+}
+
+static void checkIntersecting(PIOTimeRange* tl, PIOTime* stops, int n, PIOTimeRange tr,
+                              int* indices, int* expected, const char* name)
+{
+    int number = linearIntersecting(tl, n, tr, expected);
+
+    compareIndices(pioFindTimeRangesIntersectingTimeRange(tl, stops, n, tr, indices, n), indices,
+                   number, expected, name);
+    expect(pioFindTimeRangesIntersectingTimeRange(tl, stops, n, tr, NULL, 0), number, name);
+
+    if (number > 1)
+    {
+        memset(indices, -1, n*sizeof(int));
+        expect(pioFindTimeRangesIntersectingTimeRange(tl, stops, n, tr, indices, 1), number, name);
+        expect(indices[0], expected[0], name);
+        expect(indices[1], -1, name);
+    }
+}
+
+static void check(int n, int overlap)
+{
+    PIOTimeRange* tl = segments(n, overlap);
+    PIOTime* maxStops = (PIOTime*) malloc(n*sizeof(PIOTime));
+    int* indices = (int*) malloc(n*sizeof(int));
+    int* expected = (int*) malloc(n*sizeof(int));
+    PIOTime* stops = overlap ? maxStops : NULL;
+    int64_t extent = tl[n-1].time;
+    PIOTime time;
+    PIOTimeRange period;
+    int found, q, t;
+
+    expect(pioGetTimeLineMaximumStops(tl, n, maxStops), 1, "pioGetTimeLineMaximumStops");
+
+    // timestamps and periods of up to one second at 90 kHz, before, within and after timeline
+    for (q=0; q<NQUERIES; q++)
+    {
+        time = (PIOTime){(rand() % (extent+2000) - 1000)*90 + rand()%90, 90000};
+        checkContaining(tl, stops, n, time, indices, expected, "containing timestamp");
+        period = (PIOTimeRange){time.time, rand()%90000, 90000};
+        checkIntersecting(tl, stops, n, period, indices, expected, "intersecting period");
+    }
+
+    // bounds of each time range, time range itself
+    for (t=0; t<n; t++)
+    {
+        time = (PIOTime){tl[t].time, tl[t].scale};
+        checkContaining(tl, stops, n, time, indices, expected, "start of time range");
+        time.time += tl[t].duration;
+        checkContaining(tl, stops, n, time, indices, expected, "stop of time range");
+        checkIntersecting(tl, stops, n, tl[t], indices, expected, "time range itself");
+
+        // first one of identical time ranges
+        found = pioFindTimeRangeInTimeLine(tl[t], tl, n);
+        expect(found >= 0 && found <= t, 1, "pioFindTimeRangeInTimeLine");
+        expect(pioCompareTimeRanges(tl[found], tl[t]), PINOCCHIO_TIMERANGE_COMPARISON_SAME, "pioFindTimeRangeInTimeLine");
+        if (found > 0)
+            expect(pioCompareTimeRanges(tl[found-1], tl[t]) == PINOCCHIO_TIMERANGE_COMPARISON_SAME, 0,
+                   "pioFindTimeRangeInTimeLine (first one)");
+    }
+
+    // time ranges not in timeline
+    period = (PIOTimeRange){tl[0].time-1, 1, tl[0].scale};
+    expect(pioFindTimeRangeInTimeLine(period, tl, n) < 0, 1, "time range before timeline");
+    period = (PIOTimeRange){extent+1000000, 1, tl[0].scale};
+    expect(pioFindTimeRangeInTimeLine(period, tl, n) < 0, 1, "time range after timeline");
+    period = tl[n/2];
+    period.duration += 100000;
+    expect(pioFindTimeRangeInTimeLine(period, tl, n) < 0, 1, "longer time range");
+
+    free(expected);
+    free(indices);
+    free(maxStops);
+    free(tl);
+}
+
+int main (int argc, char *const  argv[])
+{
+    PIOTimeRange tr = {0, 1, 25};
+    PIOTimeRange after = {1, 1, 25};
+    PIOTimeRange within = {1, 1, 50};
+    PIOTime time = {0, 25};
+    PIOTime maxStop;
+    int index = -1;
+
+    // empty timeline
+    expect(pioFindTimeRangeInTimeLine(tr, NULL, 0) < 0, 1, "empty timeline");
+    expect(pioFindTimeRangesContainingTime(NULL, NULL, 0, time, NULL, 0), 0, "empty timeline (containing)");
+    expect(pioFindTimeRangesIntersectingTimeRange(NULL, NULL, 0, tr, NULL, 0), 0, "empty timeline (intersecting)");
+
+    // single time range
+    expect(pioFindTimeRangeInTimeLine(tr, &tr, 1), 0, "single time range");
+    expect(pioFindTimeRangeInTimeLine(after, &tr, 1) < 0, 1, "time range after last one");
+    expect(pioFindTimeRangesContainingTime(&tr, NULL, 1, time, &index, 1), 1, "single time range (containing)");
+    expect(index, 0, "single time range (containing)");
+    expect(pioGetTimeLineMaximumStops(&tr, 1, &maxStop), 1, "single time range (maximum stops)");
+    expect(pioFindTimeRangesIntersectingTimeRange(&tr, &maxStop, 1, within, NULL, 0), 1,
+           "single time range (intersecting)");
+    expect(pioFindTimeRangesIntersectingTimeRange(&tr, &maxStop, 1, after, NULL, 0), 0,
+           "single time range (next one)");
+
+    srand(42);
+    check(NTIMERANGES, 0);
+    check(NTIMERANGES, 1);
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
@@ -0,0 +1,160 @@
+/*
+ *  test_Pool.c
+ *  pinocchIO
+ *
+ *  Checks that a pool of pinocchIO handles (pioNewPool()) returns the right
+ *  datasets, never keeps more unreferenced files open than allowed (even when
+ *  opening a dataset fails), never closes referenced ones, and always returns
+ *  datasets with the requested flags.
+ *
+ *  usage: test_Pool
+ *
+ */
+
+#include <string.h>
+#include "test_utils.h"
+
+#define TEST_FILE "/tmp/test_Pool_%d.pio"
+#define NFILES 12
+#define NTIMERANGES 100
+#define POOLSIZE 3
+
+static void create(int f)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 2);
+    PIODataset pioDataset = PIODatasetInvalid;
+    char path[256];
+    int data[2];
+    int t;
+
+    sprintf(path, TEST_FILE, f);
+    pioFile = newFramesFile(path, NTIMERANGES, &pioTimeline);
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        data[0] = f;
+        data[1] = t;
+        pioWrite(&pioDataset, t, data, 1, pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+    pioCloseDatatype(&pioDatatype);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+}
+
+// number of HDF5 files currently open
+static int openFiles(void)
+{
+    return (int)H5Fget_obj_count(H5F_OBJ_ALL, H5F_OBJ_FILE);
+}
+
+static void check(PIODataset* pioDataset, PIODatatype pioDatatype, int f, int t, const char* name)
+{
+    void* buffer = NULL;
+
+    expect(pioDataset != NULL, 1, name);
+    expect(pioRead(pioDataset, t, pioDatatype, &buffer), 1, name);
+    expect(((int*)buffer)[0], f, name);
+    expect(((int*)buffer)[1], t, name);
+}
+
+int main (int argc, char *const  argv[])
+{
+    char* paths[NFILES];
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 2);
+    PIOPool* pool = NULL;
+    PIOFile* files[NFILES];
+    PIODataset* pooled = NULL;
+    PIODataset* preloaded = NULL;
+    int i, f;
+
+    for (f=0; f<NFILES; f++)
+    {
+        create(f);
+        paths[f] = (char*) malloc(256);
+        sprintf(paths[f], TEST_FILE, f);
+    }
+
+    expect(pioNewPool(0) == NULL, 1, "empty pool");
+    pool = pioNewPool(POOLSIZE);
+
+    // random reads: released files are closed once the pool is full
+    srand(42);
+    for (i=0; i<1000; i++)
+    {
+        f = (rand()%10 < 8) ? rand()%POOLSIZE : rand()%NFILES;
+        pooled = pioPoolOpenDataset(pool, paths[f], "features", PINOCCHIO_DATASET_PRELOAD_LINKS);
+        check(pooled, pioDatatype, f, i%NTIMERANGES, "pooled read");
+        pioPoolReleaseDataset(pool, pooled);
+        expect(openFiles() <= POOLSIZE, 1, "number of open files");
+    }
+
+    // referenced files are never closed...
+    for (f=0; f<NFILES; f++)
+    {
+        files[f] = pioPoolOpenFile(pool, paths[f]);
+        expect(files[f] != NULL, 1, "pioPoolOpenFile");
+    }
+    expect(openFiles(), NFILES, "referenced files");
+    pooled = pioPoolOpenDataset(pool, paths[0], "features", PINOCCHIO_DATASET_DEFAULT);
+    check(pooled, pioDatatype, 0, 0, "dataset of referenced file");
+    expect(pioPoolReleaseDataset(pool, pooled), 1, "pioPoolReleaseDataset");
+    expect(pioPoolReleaseDataset(pool, pooled), 0, "dataset released twice");
+
+    // ... until they are released
+    for (f=0; f<NFILES; f++)
+        expect(pioPoolReleaseFile(pool, files[f]), 1, "pioPoolReleaseFile");
+    expect(pioPoolReleaseFile(pool, files[0]), 0, "file released twice");
+    expect(openFiles() <= POOLSIZE, 1, "number of open files after release");
+
+    // files opened for missing datasets do not stay open beyond pool size
+    for (f=0; f<NFILES; f++)
+    {
+        expect(pioPoolOpenDataset(pool, paths[f], "nothing", PINOCCHIO_DATASET_DEFAULT) == NULL, 1, "missing dataset");
+        expect(openFiles() <= POOLSIZE, 1, "number of open files after missing dataset");
+    }
+
+    // dataset referenced with fewer flags than requested: opened once more...
+    pooled = pioPoolOpenDataset(pool, paths[1], "features", PINOCCHIO_DATASET_DEFAULT);
+    check(pooled, pioDatatype, 1, 2, "default flags");
+    preloaded = pioPoolOpenDataset(pool, paths[1], "features", PINOCCHIO_DATASET_PRELOAD_LINKS);
+    expect(preloaded != pooled, 1, "dataset opened once more");
+    expect((preloaded->flags & PINOCCHIO_DATASET_PRELOAD_LINKS) != 0, 1, "requested flags");
+    expect(preloaded->links != NULL, 1, "preloaded links");
+    check(preloaded, pioDatatype, 1, 3, "preloaded links");
+    check(pooled, pioDatatype, 1, 4, "default flags (still referenced)");
+
+    // ... and the one with more flags is shared by later requests
+    expect(pioPoolOpenDataset(pool, paths[1], "features", PINOCCHIO_DATASET_PRELOAD_LINKS) == preloaded, 1,
+           "dataset with requested flags is shared");
+    pioPoolReleaseDataset(pool, preloaded);
+    pioPoolReleaseDataset(pool, preloaded);
+    pioPoolReleaseDataset(pool, pooled);
+
+    // unreferenced dataset with fewer flags is reopened
+    pioClosePool(&pool);
+    pool = pioNewPool(POOLSIZE);
+    pooled = pioPoolOpenDataset(pool, paths[2], "features", PINOCCHIO_DATASET_DEFAULT);
+    pioPoolReleaseDataset(pool, pooled);
+    preloaded = pioPoolOpenDataset(pool, paths[2], "features", PINOCCHIO_DATASET_PRELOAD_LINKS);
+    expect(preloaded == pooled, 1, "unreferenced dataset is reopened");
+    expect(preloaded->links != NULL, 1, "reopened with requested flags");
+    check(preloaded, pioDatatype, 2, 5, "reopened dataset");
+    pioPoolReleaseDataset(pool, preloaded);
+
+    expect(pioClosePool(&pool), 1, "pioClosePool");
+    expect(pool == NULL, 1, "pool set to NULL");
+    expect(openFiles(), 0, "files closed with pool");
+
+    pioCloseDatatype(&pioDatatype);
+    for (f=0; f<NFILES; f++)
+    {
+        remove(paths[f]);
+        free(paths[f]);
+    }
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
@@ -0,0 +1,203 @@
+/*
+ *  test_Prefetch.c
+ *  pinocchIO
+ *
+ *  Checks that gptReadNext() with read-ahead (prefetchDepth) returns the same
+ *  entries and labels as without, pass after pass, whatever the read-ahead
+ *  depth and memory, when the datatype changes in the middle of a pass,
+ *  after switching iteration modes, and that the server can be closed
+ *  while reading ahead.
+ *
+ *  usage: test_Prefetch
+ *
+ */
+
+#include <string.h>
+#include "gepetto/gepetto.h"
+#include "test_utils.h"
+
+#define TEST_FILE "/tmp/test_Prefetch_%d.pio"
+#define NFILES 4
+#define NTIMERANGES 600
+#define DIMENSION 4
+
+static void create(int f)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, DIMENSION);
+    PIODatatype labelDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    PIODataset pioDataset = PIODatasetInvalid;
+    char path[256];
+    float data[2*DIMENSION];
+    int label;
+    int t, d;
+
+    sprintf(path, TEST_FILE, f);
+    pioFile = newFramesFile(path, NTIMERANGES, &pioTimeline);
+
+    // up to 2 entries per timerange
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        for (d=0; d<2*DIMENSION; d++) data[d] = (float)(1000*f+t) + d/10.f;
+        pioWrite(&pioDataset, t, data, t%5 == 4 ? 0 : 1+t%2, pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    pioDataset = pioNewDataset(pioFile, "labels", "labels", pioTimeline, labelDatatype);
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        label = (f+t)%3;
+        pioWrite(&pioDataset, t, &label, 1, labelDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    pioCloseDatatype(&labelDatatype);
+    pioCloseDatatype(&pioDatatype);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+}
+
+static GPTServer newServer(char** paths, int prefetchDepth, size_t prefetchMemory)
+{
+    GPTServerOptions options = GPTServerOptionsDefault;
+
+    options.prefetchDepth = prefetchDepth;
+    options.prefetchMemory = prefetchMemory;
+    return gptNewServerWithOptions(NFILES, paths, "features",
+                                   GEPETTO_LABEL_FILTER_TYPE_DIFFERS_FROM, 1, -1,
+                                   NFILES, paths, "labels", options);
+}
+
+// entries served by reference server (one pass, without read-ahead)
+typedef struct {
+    int numberOfReads;
+    int numbers[NFILES*NTIMERANGES];
+    int labels[NFILES*NTIMERANGES];
+    float data[2*NFILES*NTIMERANGES*DIMENSION];
+} reference_t;
+
+static void readReference(char** paths, reference_t* reference)
+{
+    GPTServer server = newServer(paths, 0, 0);
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, DIMENSION);
+    void* buffer = NULL;
+    int* labels = NULL;
+    int nLabels, number;
+    int v = 0;
+
+    expect(GPTServerIsInvalid(server), 0, "reference server");
+    reference->numberOfReads = 0;
+    while ((number = gptReadNext(&server, pioDatatype, &buffer, &nLabels, &labels)) >= 0)
+    {
+        expect(nLabels, 1, "reference server");
+        reference->numbers[reference->numberOfReads] = number;
+        reference->labels[reference->numberOfReads] = labels[0];
+        memcpy(reference->data+v, buffer, number*DIMENSION*sizeof(float));
+        v += number*DIMENSION;
+        reference->numberOfReads++;
+    }
+    expect(reference->numberOfReads > 0, 1, "reference server");
+
+    pioCloseDatatype(&pioDatatype);
+    gptCloseServer(&server);
+}
+
+// one pass through server, switching to double precision after given number of reads
+static void checkPass(GPTServer* server, reference_t* reference, int switchAfter, const char* name)
+{
+    PIODatatype floatDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, DIMENSION);
+    PIODatatype doubleDatatype = pioNewDatatype(PINOCCHIO_TYPE_DOUBLE, DIMENSION);
+    void* buffer = NULL;
+    int* labels = NULL;
+    int nLabels, number, r, n;
+    int v = 0;
+
+    for (r=0; r<reference->numberOfReads; r++)
+    {
+        if (r < switchAfter)
+            number = gptReadNext(server, floatDatatype, &buffer, &nLabels, &labels);
+        else
+            number = gptReadNext(server, doubleDatatype, &buffer, &nLabels, &labels);
+        expect(number, reference->numbers[r], name);
+        expect(nLabels, 1, name);
+        expect(labels[0], reference->labels[r], name);
+        for (n=0; n<number*DIMENSION; n++)
+        {
+            if (r < switchAfter)
+                expect(((float*)buffer)[n] == reference->data[v+n], 1, name);
+            else
+                expect(((double*)buffer)[n] == (double)reference->data[v+n], 1, name);
+        }
+        v += number*DIMENSION;
+    }
+    expect(gptReadNext(server, floatDatatype, &buffer, &nLabels, &labels), -1, name);
+
+    pioCloseDatatype(&doubleDatatype);
+    pioCloseDatatype(&floatDatatype);
+}
+
+static void check(char** paths, reference_t* reference, int prefetchDepth, size_t prefetchMemory, const char* name)
+{
+    GPTServer server = newServer(paths, prefetchDepth, prefetchMemory);
+
+    expect(GPTServerIsInvalid(server), 0, name);
+    checkPass(&server, reference, reference->numberOfReads, name);
+    // server starts over
+    checkPass(&server, reference, reference->numberOfReads/3, name);
+    checkPass(&server, reference, 0, name);
+    gptCloseServer(&server);
+}
+
+int main (int argc, char *const  argv[])
+{
+    char* paths[NFILES];
+    reference_t* reference = (reference_t*) malloc(sizeof(reference_t));
+    GPTServer server = GPTServerInvalid;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, DIMENSION);
+    void* buffer = NULL;
+    int64_t total = 0;
+    int number, f, r;
+
+    for (f=0; f<NFILES; f++)
+    {
+        create(f);
+        paths[f] = (char*) malloc(256);
+        sprintf(paths[f], TEST_FILE, f);
+    }
+    readReference(paths, reference);
+
+    check(paths, reference, 256, 16*1048576, "read-ahead");
+    check(paths, reference, 1, 16*1048576, "read-ahead of one timerange");
+    check(paths, reference, 3*NFILES*NTIMERANGES, 16*1048576, "read-ahead of the whole server");
+    check(paths, reference, 256, 1, "read-ahead with little memory");
+
+    // read-ahead stops while iterating in another mode, and resumes afterwards
+    server = newServer(paths, 64, 1048576);
+    for (r=0; r<10; r++) gptReadNext(&server, pioDatatype, &buffer, NULL, NULL);
+    gptSetIterationMode(&server, GEPETTO_ITERATION_MODE_SHUFFLE, 1, 4);
+    while ((number = gptReadNext(&server, pioDatatype, &buffer, NULL, NULL)) >= 0) total += number;
+    for (r=0; r<reference->numberOfReads; r++) total -= reference->numbers[r];
+    expect(total, 0, "shuffled entries");
+    gptSetIterationMode(&server, GEPETTO_ITERATION_MODE_SEQUENTIAL, 0, 1);
+    checkPass(&server, reference, reference->numberOfReads, "read-ahead after shuffle");
+    gptCloseServer(&server);
+
+    // closing the server while reading ahead
+    server = newServer(paths, 64, 1048576);
+    for (r=0; r<10; r++)
+        expect(gptReadNext(&server, pioDatatype, &buffer, NULL, NULL), reference->numbers[r], "first reads");
+    gptCloseServer(&server);
+
+    pioCloseDatatype(&pioDatatype);
+    for (f=0; f<NFILES; f++)
+    {
+        remove(paths[f]);
+        free(paths[f]);
+    }
+    free(reference);
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
@@ -0,0 +1,211 @@
+/*
+ *  test_ReadBatch.c
+ *  pinocchIO
+ *
+ *  Checks that gptReadBatch() returns the same entries and labels as gptReadNext(),
+ *  with the file and timerange each entry comes from, and tells the end of the
+ *  server, a batch too small for the next timerange and a read failure apart,
+ *  leaving the server position where expected.
+ *
+ *  usage: test_ReadBatch
+ *
+ */
+
+#include <string.h>
+#include "gepetto/gepetto.h"
+#include "test_utils.h"
+
+#define TEST_FILE "/tmp/test_ReadBatch_%d.pio"
+#define NFILES 3
+#define NTIMERANGES 200
+#define MAX_NUMBER 12
+
+static int number(int f, int t) { return (t%50 == 7) ? MAX_NUMBER : (t+f)%3; }
+
+// runs of label 0 (filtered out) between runs of labels 1 and 2
+static int labelOf(int f, int t) { return (t/20+f)%3; }
+
+static void create(int f)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    PIODataset pioDataset = PIODatasetInvalid;
+    char path[256];
+    int data[MAX_NUMBER];
+    int label;
+    int t, n;
+
+    sprintf(path, TEST_FILE, f);
+    pioFile = newFramesFile(path, NTIMERANGES, &pioTimeline);
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        for (n=0; n<MAX_NUMBER; n++) data[n] = 100000*f+100*t+n;
+        pioWrite(&pioDataset, t, data, number(f, t), pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+    pioDataset = pioNewDataset(pioFile, "labels", "labels", pioTimeline, pioDatatype);
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        label = labelOf(f, t);
+        pioWrite(&pioDataset, t, &label, 1, pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+    pioCloseDatatype(&pioDatatype);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+}
+
+// entries, labels, files and timeranges of a filtered server, by batches and one timerange at a time
+static void checkLabelled(char** paths, PIODatatype pioDatatype)
+{
+    GPTServer server = gptNewServer(NFILES, paths, "features",
+                                    GEPETTO_LABEL_FILTER_TYPE_DIFFERS_FROM, 0, -1,
+                                    NFILES, paths, "labels");
+    int* expected = (int*) malloc(NFILES*NTIMERANGES*MAX_NUMBER*sizeof(int));
+    int* expectedLabels = (int*) malloc(NFILES*NTIMERANGES*MAX_NUMBER*sizeof(int));
+    int batch[4*MAX_NUMBER], labels[4*MAX_NUMBER], fileIndices[4*MAX_NUMBER], timeranges[4*MAX_NUMBER];
+    void* buffer = NULL;
+    int* entryLabels = NULL;
+    int64_t total = 0;
+    int64_t v = 0;
+    int nLabels, read, n, f, t;
+    int lastFile = 0, lastTimerange = -1;
+
+    expect(GPTServerIsInvalid(server), 0, "gptNewServer (labels)");
+    while ((read = gptReadNext(&server, pioDatatype, &buffer, &nLabels, &entryLabels)) >= 0)
+    {
+        expect(nLabels, 1, "gptReadNext (labels)");
+        memcpy(expected+total, buffer, read*sizeof(int));
+        for (n=0; n<read; n++) expectedLabels[total+n] = entryLabels[0];
+        total += read;
+    }
+    expect(total > 0, 1, "gptReadNext (labels)");
+
+    while ((read = gptReadBatch(&server, pioDatatype, 4*MAX_NUMBER, batch, labels, fileIndices, timeranges)) >= 0)
+        for (n=0; n<read; n++, v++)
+        {
+            expect(batch[n], expected[v], "batch data (labels)");
+            expect(labels[n], expectedLabels[v], "batch labels");
+            // entries tell where they come from
+            f = batch[n]/100000;
+            t = (batch[n]%100000)/100;
+            expect(fileIndices[n], f, "batch file indices");
+            expect(timeranges[n], t, "batch timeranges");
+            expect(labels[n], labelOf(f, t), "batch labels");
+            expect((f > lastFile) || ((f == lastFile) && (t >= lastTimerange)), 1, "batch entries are sorted");
+            lastFile = f;
+            lastTimerange = t;
+        }
+    expect(read, GEPETTO_END_OF_SERVER, "end of server (labels)");
+    expect(v, total, "number of entries read by batches (labels)");
+
+    gptCloseServer(&server);
+    free(expectedLabels);
+    free(expected);
+}
+
+int main (int argc, char *const  argv[])
+{
+    char* paths[NFILES];
+    GPTServer server = GPTServerInvalid;
+    GPTServerOptions options = GPTServerOptionsDefault;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    int* expected = NULL;
+    int batch[4*MAX_NUMBER];
+    void* buffer = NULL;
+    int64_t total = 0;
+    int64_t v = 0;
+    int read, f, t;
+
+    for (f=0; f<NFILES; f++)
+    {
+        create(f);
+        paths[f] = (char*) malloc(256);
+        sprintf(paths[f], TEST_FILE, f);
+        for (t=0; t<NTIMERANGES; t++) total += number(f, t);
+    }
+
+    // only the last scanned file is kept open
+    options.maximumNumberOfOpenFiles = 1;
+    server = gptNewServerWithOptions(NFILES, paths, "features",
+                                     GEPETTO_LABEL_FILTER_TYPE_NONE, 0, -1,
+                                     0, NULL, NULL, options);
+    expect(GPTServerIsInvalid(server), 0, "gptNewServerWithOptions");
+
+    expected = (int*) malloc(total*sizeof(int));
+    while ((read = gptReadNext(&server, pioDatatype, &buffer, NULL, NULL)) >= 0)
+    {
+        memcpy(expected+v, buffer, read*sizeof(int));
+        v += read;
+    }
+    expect(v, total, "gptReadNext");
+    checkLabelled(paths, pioDatatype);
+    // start over (and clear end of server flag)
+    gptSetIterationMode(&server, GEPETTO_ITERATION_MODE_SEQUENTIAL, 0, 1);
+
+    // small batches: too small for timeranges with MAX_NUMBER entries
+    v = 0;
+    for (;;)
+    {
+        read = gptReadBatch(&server, pioDatatype, MAX_NUMBER-1, batch, NULL, NULL, NULL);
+        if (read == GEPETTO_END_OF_SERVER) break;
+        if (read == GEPETTO_BATCH_TOO_SMALL)
+        {
+            expect(server.eof, 0, "end of server is not reached");
+            // position did not move
+            read = gptReadBatch(&server, pioDatatype, MAX_NUMBER, batch, NULL, NULL, NULL);
+            expect(read, MAX_NUMBER, "larger batch");
+        }
+        expect(read > 0, 1, "gptReadBatch");
+        expect(memcmp(batch, expected+v, read*sizeof(int)), 0, "batch data");
+        v += read;
+    }
+    expect(v, total, "number of entries read by batches");
+    expect(server.eof, 1, "end of server");
+
+    // server starts over
+    expect(gptReadBatch(&server, pioDatatype, 4*MAX_NUMBER, batch, NULL, NULL, NULL) > 0, 1, "read after end of server");
+    expect(memcmp(batch, expected, sizeof(int)), 0, "read after end of server");
+    gptSetIterationMode(&server, GEPETTO_ITERATION_MODE_SEQUENTIAL, 0, 1);
+
+    // same in shuffled order
+    gptSetIterationMode(&server, GEPETTO_ITERATION_MODE_SHUFFLE, 1, 4);
+    v = 0;
+    while ((read = gptReadBatch(&server, pioDatatype, MAX_NUMBER-1, batch, NULL, NULL, NULL)) != GEPETTO_END_OF_SERVER)
+    {
+        if (read == GEPETTO_BATCH_TOO_SMALL)
+            read = gptReadBatch(&server, pioDatatype, MAX_NUMBER, batch, NULL, NULL, NULL);
+        expect(read > 0, 1, "shuffled gptReadBatch");
+        v += read;
+    }
+    expect(v, total, "number of entries read by shuffled batches");
+    gptSetIterationMode(&server, GEPETTO_ITERATION_MODE_SEQUENTIAL, 0, 1);
+
+    // second file can no longer be opened: entries of the first one are returned...
+    remove(paths[1]);
+    v = 0;
+    while ((read = gptReadBatch(&server, pioDatatype, 4*MAX_NUMBER, batch, NULL, NULL, NULL)) > 0)
+    {
+        expect(memcmp(batch, expected+v, read*sizeof(int)), 0, "batch data before failure");
+        v += read;
+    }
+    expect(v*NFILES < total, 1, "entries read before failure");
+    // ... then failure is reported, again and again
+    expect(read, GEPETTO_READ_FAILURE, "read failure");
+    expect(gptReadBatch(&server, pioDatatype, 4*MAX_NUMBER, batch, NULL, NULL, NULL), GEPETTO_READ_FAILURE, "read failure");
+    expect(server.eof, 0, "end of server is not reached after failure");
+
+    gptCloseServer(&server);
+    pioCloseDatatype(&pioDatatype);
+    for (f=0; f<NFILES; f++)
+    {
+        remove(paths[f]);
+        free(paths[f]);
+    }
+    free(expected);
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
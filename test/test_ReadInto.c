@@ -0,0 +1,99 @@
+/*
+ *  test_ReadInto.c
+ *  pinocchIO
+ *
+ *  Checks that pioReadInto() and pioReadRangeInto() read the same entries as
+ *  pioRead() and pioReadRange(), straight into the caller buffer, and that
+ *  they fail without touching the buffer when data do not fit.
+ *
+ *  usage: test_ReadInto
+ *
+ */
+
+#include <string.h>
+#include "test_utils.h"
+
+#define TEST_FILE "/tmp/test_ReadInto.pio"
+#define NTIMERANGES 300
+#define DIMENSION 2
+#define CAPACITY (64*DIMENSION*sizeof(double))
+
+static void check(PIODataset* pioDataset, PIODatatype pioDatatype, const char* name)
+{
+    size_t entry = pioGetSize(pioDatatype);
+    char into[CAPACITY];
+    char untouched[CAPACITY];
+    int number[8], expectedNumber[8];
+    void* buffer = NULL;
+    int64_t total;
+    int n, t, count;
+
+    memset(untouched, 0x5a, CAPACITY);
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        n = pioRead(pioDataset, t, pioDatatype, &buffer);
+        expect(pioReadInto(pioDataset, t, pioDatatype, into, n*entry), n, name);
+        expect(memcmp(into, buffer, n*entry), 0, name);
+        if (n == 0) continue;
+        // one byte short
+        memcpy(into, untouched, CAPACITY);
+        expect(pioReadInto(pioDataset, t, pioDatatype, into, n*entry-1), -1, name);
+        expect(memcmp(into, untouched, CAPACITY), 0, name);
+    }
+
+    for (t=0; t+8<=NTIMERANGES; t+=3)
+        for (count=0; count<=8; count++)
+        {
+            total = pioReadRange(pioDataset, t, count, pioDatatype, &buffer, expectedNumber);
+            expect(pioReadRangeInto(pioDataset, t, count, pioDatatype, into, CAPACITY, number), total, name);
+            expect(memcmp(into, buffer, total*entry), 0, name);
+            expect(memcmp(number, expectedNumber, count*sizeof(int)), 0, name);
+            expect(pioReadRangeInto(pioDataset, t, count, pioDatatype, into, total*entry, NULL), total, name);
+            if (total == 0) continue;
+            memcpy(into, untouched, CAPACITY);
+            expect(pioReadRangeInto(pioDataset, t, count, pioDatatype, into, total*entry-1, NULL), -1, name);
+            expect(memcmp(into, untouched, CAPACITY), 0, name);
+        }
+
+    expect(pioReadRangeInto(pioDataset, NTIMERANGES-1, 2, pioDatatype, into, CAPACITY, NULL) < 0, 1, "range after timeline");
+}
+
+int main (int argc, char *const  argv[])
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype intDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, DIMENSION);
+    PIODatatype doubleDatatype = pioNewDatatype(PINOCCHIO_TYPE_DOUBLE, DIMENSION);
+    PIODataset pioDataset = PIODatasetInvalid;
+    int data[8*DIMENSION];
+    int t, d;
+
+    pioFile = newFramesFile(TEST_FILE, NTIMERANGES, &pioTimeline);
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, intDatatype);
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        for (d=0; d<8*DIMENSION; d++) data[d] = 10*t+d;
+        pioWrite(&pioDataset, t, data, t%8, intDatatype);
+    }
+    check(&pioDataset, intDatatype, "contiguous data");
+    check(&pioDataset, doubleDatatype, "contiguous data (double)");
+
+    // overwritten time ranges are appended at the end: data are scattered
+    for (t=1; t<NTIMERANGES; t+=4)
+    {
+        for (d=0; d<8*DIMENSION; d++) data[d] = -10*t-d;
+        pioWrite(&pioDataset, t, data, 1+t%5, intDatatype);
+    }
+    check(&pioDataset, intDatatype, "scattered data");
+    check(&pioDataset, doubleDatatype, "scattered data (double)");
+    pioCloseDataset(&pioDataset);
+
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+    pioCloseDatatype(&doubleDatatype);
+    pioCloseDatatype(&intDatatype);
+    remove(TEST_FILE);
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
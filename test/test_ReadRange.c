@@ -0,0 +1,105 @@
+/*
+ *  test_ReadRange.c
+ *  pinocchIO
+ *
+ *  Checks that pioReadRange() returns the same entries as pioReadData()
+ *  called time range after time range, whether data are stored contiguously
+ *  (chronological writes) or scattered (overwritten time ranges), with empty
+ *  time ranges, datatype conversion and ranges out of the timeline.
+ *
+ *  usage: test_ReadRange
+ *
+ */
+
+#include <string.h>
+#include "test_utils.h"
+
+#define TEST_FILE "/tmp/test_ReadRange.pio"
+#define NTIMERANGES 500
+#define DIMENSION 3
+
+// compare pioReadRange() with pioReadData() for every range of up to maxCount time ranges
+static void check(PIODataset* pioDataset, PIODatatype pioDatatype, int maxCount, const char* name)
+{
+    size_t entry = pioGetSize(pioDatatype);
+    char* expected = (char*) malloc(NTIMERANGES*4*entry);
+    int number[NTIMERANGES];
+    void* buffer = NULL;
+    int64_t total, n;
+    int first, count, t;
+
+    for (first=0; first<NTIMERANGES; first+=7)
+        for (count=0; (count<=maxCount) && (first+count<=NTIMERANGES); count+=(count<5 ? 1 : 13))
+        {
+            total = 0;
+            for (t=first; t<first+count; t++)
+            {
+                n = pioRead(pioDataset, t, pioDatatype, &buffer);
+                memcpy(expected + total*entry, buffer, n*entry);
+                total += n;
+            }
+            expect(pioReadRange(pioDataset, first, count, pioDatatype, &buffer, number), total, name);
+            expect(memcmp(buffer, expected, total*entry), 0, name);
+            for (t=first; t<first+count; t++)
+                expect(number[t-first], pioReadNumber(*pioDataset, t), name);
+            // number of entries per time range is optional
+            expect(pioReadRange(pioDataset, first, count, pioDatatype, &buffer, NULL), total, name);
+        }
+
+    free(expected);
+}
+
+int main (int argc, char *const  argv[])
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype intDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, DIMENSION);
+    PIODatatype doubleDatatype = pioNewDatatype(PINOCCHIO_TYPE_DOUBLE, DIMENSION);
+    PIODataset pioDataset = PIODatasetInvalid;
+    int data[4*DIMENSION];
+    void* buffer = NULL;
+    int t, d;
+
+    pioFile = newFramesFile(TEST_FILE, NTIMERANGES, &pioTimeline);
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, intDatatype);
+
+    // chronological writes: 0 to 3 entries per time range, stored contiguously
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        for (d=0; d<4*DIMENSION; d++) data[d] = 100*t+d;
+        pioWrite(&pioDataset, t, data, t%4, intDatatype);
+    }
+    check(&pioDataset, intDatatype, 60, "contiguous data");
+    check(&pioDataset, doubleDatatype, 20, "contiguous data (double)");
+
+    // whole dataset at once
+    expect(pioReadRange(&pioDataset, 0, NTIMERANGES, intDatatype, &buffer, NULL), pioDataset.stored, "whole dataset");
+
+    // overwritten time ranges are appended at the end: data are scattered
+    for (t=3; t<NTIMERANGES; t+=10)
+    {
+        for (d=0; d<4*DIMENSION; d++) data[d] = -100*t-d;
+        pioWrite(&pioDataset, t, data, 1+t%3, intDatatype);
+    }
+    check(&pioDataset, intDatatype, 60, "scattered data");
+    check(&pioDataset, doubleDatatype, 20, "scattered data (double)");
+
+    // out of timeline
+    expect(pioReadRange(&pioDataset, NTIMERANGES-2, 3, intDatatype, &buffer, NULL) < 0, 1, "range after timeline");
+    expect(pioReadRange(&pioDataset, -1, 2, intDatatype, &buffer, NULL) < 0, 1, "range before timeline");
+    pioCloseDataset(&pioDataset);
+
+    // same after reopening
+    pioDataset = pioOpenDataset(PIOMakeObject(pioFile), "features");
+    check(&pioDataset, intDatatype, 60, "scattered data (reopened)");
+    pioCloseDataset(&pioDataset);
+
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+    pioCloseDatatype(&doubleDatatype);
+    pioCloseDatatype(&intDatatype);
+    remove(TEST_FILE);
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
@@ -0,0 +1,262 @@
+/*
+ *  test_Readers.c
+ *  pinocchIO
+ *
+ *  Checks that the shards of a Gepetto server (gptNewReaderWithSharding()),
+ *  read concurrently by several threads with gptReaderReadNext() or
+ *  gptReaderReadBatch(), serve each filtered timerange exactly once with its
+ *  data and labels, keep whole files together when sharded by file, are
+ *  balanced when sharded by entries, and start over once exhausted.
+ *  Also checks that invalid shards are rejected.
+ *
+ *  usage: test_Readers
+ *
+ */
+
+#include <string.h>
+#include <pthread.h>
+#include "gepetto/gepetto.h"
+#include "test_utils.h"
+
+#define TEST_FILE "/tmp/test_Readers_%d.pio"
+#define NFILES 6
+#define NTIMERANGES 300
+#define MAX_THREADS 8
+
+// files do not have the same size, timeranges do not have the same number of entries
+#define SIZE_OF(f) (NTIMERANGES*(1+(f)%3))
+#define ENTRIES_OF(t) (1+(t)%3)
+#define TOTAL (NFILES*3*NTIMERANGES)
+
+typedef struct {
+    GPTServer* server;
+    GPTShardingMode mode;
+    int shard;
+    int numberOfShards;
+    int batch;
+    int served[TOTAL];  // position (f*3*NTIMERANGES+t) of each served timerange
+    int numberOfServed;
+    int64_t entries;
+} consumer_t;
+
+static void create(int f)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = PIODatatypeInvalid;
+    PIODataset pioDataset = PIODatasetInvalid;
+    char path[256];
+    int data[6];
+    int label;
+    int t, e;
+
+    sprintf(path, TEST_FILE, f);
+    pioFile = newFramesFile(path, SIZE_OF(f), &pioTimeline);
+
+    // each entry tells where it comes from
+    pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 2);
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    for (t=0; t<SIZE_OF(f); t++)
+    {
+        for (e=0; e<ENTRIES_OF(t); e++)
+        {
+            data[2*e] = f;
+            data[2*e+1] = t;
+        }
+        pioWrite(&pioDataset, t, data, ENTRIES_OF(t), pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+    pioCloseDatatype(&pioDatatype);
+
+    pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    pioDataset = pioNewDataset(pioFile, "labels", "labels", pioTimeline, pioDatatype);
+    for (t=0; t<SIZE_OF(f); t++)
+    {
+        label = t%4;
+        pioWrite(&pioDataset, t, &label, 1, pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+    pioCloseDatatype(&pioDatatype);
+
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+}
+
+static void* consume(void* arg)
+{
+    consumer_t* consumer = (consumer_t*) arg;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 2);
+    GPTReader* reader = NULL;
+    void* buffer = NULL;
+    int* data = NULL;
+    int* labels = NULL;
+    int nLabels;
+    int number, i, e;
+
+    reader = gptNewReaderWithSharding(consumer->server, consumer->shard,
+                                      consumer->numberOfShards, consumer->mode);
+    expect(reader != NULL, 1, "gptNewReaderWithSharding");
+
+    consumer->numberOfServed = 0;
+    consumer->entries = 0;
+
+    if (consumer->batch)
+    {
+        // one vector per entry, timeranges are not split between batches
+        data = (int*) malloc(consumer->batch*2*sizeof(int));
+        labels = (int*) malloc(consumer->batch*sizeof(int));
+        while ((number = gptReaderReadBatch(reader, pioDatatype, consumer->batch, data, labels, NULL, NULL)) > 0)
+        {
+            for (i=0; i<number; i+=ENTRIES_OF(data[2*i+1]))
+            {
+                expect(i+ENTRIES_OF(data[2*i+1]) <= number, 1, "timerange split between batches");
+                for (e=0; e<ENTRIES_OF(data[2*i+1]); e++)
+                {
+                    expect(data[2*(i+e)], data[2*i], "gptReaderReadBatch (data)");
+                    expect(data[2*(i+e)+1], data[2*i+1], "gptReaderReadBatch (data)");
+                    expect(labels[i+e], data[2*i+1]%4, "gptReaderReadBatch (labels)");
+                }
+                consumer->served[consumer->numberOfServed++] = data[2*i]*3*NTIMERANGES + data[2*i+1];
+            }
+            consumer->entries += number;
+        }
+        expect(number, GEPETTO_END_OF_SERVER, "end of shard");
+        free(labels);
+        free(data);
+    }
+    else
+    {
+        while ((number = gptReaderReadNext(reader, pioDatatype, &buffer, &nLabels, &labels)) >= 0)
+        {
+            data = (int*) buffer;
+            expect(number, ENTRIES_OF(data[1]), "gptReaderReadNext (data)");
+            for (e=1; e<number; e++)
+            {
+                expect(data[2*e], data[0], "gptReaderReadNext (data)");
+                expect(data[2*e+1], data[1], "gptReaderReadNext (data)");
+            }
+            expect(nLabels, 1, "gptReaderReadNext (labels)");
+            expect(labels[0], data[1]%4, "gptReaderReadNext (labels)");
+            consumer->served[consumer->numberOfServed++] = data[0]*3*NTIMERANGES + data[1];
+            consumer->entries += number;
+        }
+    }
+
+    gptCloseReader(&reader);
+    pioCloseDatatype(&pioDatatype);
+    return NULL;
+}
+
+// one epoch with n threads, each of them consuming its own shard
+// (returns largest shard compared to a perfectly balanced one)
+static double epoch(GPTServer* server, GPTShardingMode mode, int n, int batch, const char* name)
+{
+    pthread_t threads[MAX_THREADS];
+    consumer_t* consumers = (consumer_t*) malloc(MAX_THREADS*sizeof(consumer_t));
+    int shardOfFile[NFILES];
+    char seen[TOTAL];
+    int64_t maximum = 0, sum = 0;
+    int i, s, f, t;
+
+    for (s=0; s<n; s++)
+    {
+        consumers[s].server = server;
+        consumers[s].mode = mode;
+        consumers[s].shard = s;
+        consumers[s].numberOfShards = n;
+        consumers[s].batch = batch;
+        pthread_create(&(threads[s]), NULL, consume, &(consumers[s]));
+    }
+    for (s=0; s<n; s++) pthread_join(threads[s], NULL);
+
+    // shards are disjoint and cover every filtered timerange
+    memset(seen, 0, TOTAL);
+    for (f=0; f<NFILES; f++) shardOfFile[f] = -1;
+    for (s=0; s<n; s++)
+    {
+        for (i=0; i<consumers[s].numberOfServed; i++)
+        {
+            expect(seen[consumers[s].served[i]], 0, name);
+            seen[consumers[s].served[i]] = 1;
+
+            // files are not split between shards
+            if (mode == GEPETTO_SHARDING_BY_FILE)
+            {
+                f = consumers[s].served[i]/(3*NTIMERANGES);
+                if (shardOfFile[f] < 0) shardOfFile[f] = s;
+                expect(shardOfFile[f], s, name);
+            }
+        }
+        if (consumers[s].entries > maximum) maximum = consumers[s].entries;
+        sum += consumers[s].entries;
+    }
+    for (f=0; f<DAT_NFILES(*server); f++)
+        for (t=0; t<DAT_NTIMERANGES(*server, f); t++)
+            expect(seen[f*3*NTIMERANGES+t], DAT_FILTERED(*server, f, t) ? 1 : 0, name);
+
+    free(consumers);
+    return sum ? ((double)maximum*n)/sum : 1.;
+}
+
+int main (int argc, char *const  argv[])
+{
+    char* paths[NFILES];
+    GPTServer server = GPTServerInvalid;
+    GPTReader* reader = NULL;
+    PIODatatype pioDatatype = PIODatatypeInvalid;
+    void* buffer = NULL;
+    int counts[2];
+    int f, i, n;
+
+    for (f=0; f<NFILES; f++)
+    {
+        create(f);
+        paths[f] = (char*) malloc(256);
+        sprintf(paths[f], TEST_FILE, f);
+    }
+
+    server = gptNewServer(NFILES, paths, "features",
+                          GEPETTO_LABEL_FILTER_TYPE_DIFFERS_FROM, 3, -1,
+                          NFILES, paths, "labels");
+    expect(GPTServerIsInvalid(server), 0, "gptNewServer");
+
+    // invalid shards are rejected
+    expect(gptNewReader(&server, 2, 2) == NULL, 1, "shard after last one");
+    expect(gptNewReader(&server, -1, 2) == NULL, 1, "negative shard");
+    expect(gptNewReader(&server, 0, 0) == NULL, 1, "no shard");
+
+    // more shards than files: some of them are empty
+    for (n=1; n<=MAX_THREADS; n++)
+    {
+        epoch(&server, GEPETTO_SHARDING_BY_FILE, n, 0, "shards by file");
+        epoch(&server, GEPETTO_SHARDING_BY_ENTRIES, n, 0, "shards by entries");
+        epoch(&server, GEPETTO_SHARDING_BY_ENTRIES, n, 50, "shards by entries (batches)");
+        epoch(&server, GEPETTO_SHARDING_BY_FILE, n, 7, "shards by file (batches)");
+    }
+
+    // shards by entries are balanced (within a few timeranges)
+    expect(epoch(&server, GEPETTO_SHARDING_BY_ENTRIES, 4, 0, "balanced shards") <= 1.01, 1, "balanced shards");
+
+    // readers start over once their shard is exhausted
+    pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 2);
+    reader = gptNewReader(&server, 0, 1);
+    for (i=0; i<2; i++)
+    {
+        counts[i] = 0;
+        while (gptReaderReadNext(reader, pioDatatype, &buffer, NULL, NULL) >= 0) counts[i]++;
+    }
+    gptCloseReader(&reader);
+    pioCloseDatatype(&pioDatatype);
+    expect(counts[0] > 0, 1, "reader");
+    expect(counts[1], counts[0], "reader starts over");
+
+    gptCloseServer(&server);
+    for (f=0; f<NFILES; f++)
+    {
+        remove(paths[f]);
+        free(paths[f]);
+    }
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
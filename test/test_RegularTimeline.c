@@ -0,0 +1,283 @@
+/*
+ *  test_RegularTimeline.c
+ *  pinocchIO
+ *
+ *  Checks that regular timelines (pioNewRegularTimeline()) do not store their
+ *  time ranges, cannot be read as timelines by pinocchIO versions older than
+ *  0.5, and return the expected time ranges (computed from first time range
+ *  and step), whether opened lazily or not.
+ *  Also checks which first time ranges and steps are accepted, constant-time
+ *  lookups against lookups in the explicit timeline (overlapping time ranges,
+ *  queries at other scales), pioIsRegularTimeLine(), and that pioCopyTimeline()
+ *  keeps regular timelines regular and compares them with other timelines.
+ *
+ *  usage: test_RegularTimeline
+ *
+ */
+
+#include <stdint.h>
+#include <hdf5.h>
+#include "test_utils.h"
+
+#define TEST_FILE "/tmp/test_RegularTimeline.pio"
+#define COPY_FILE "/tmp/test_RegularTimeline_copy.pio"
+#define NTIMERANGES 10000
+#define NQUERIES 1000
+
+// explicit time ranges of regular timeline
+static PIOTimeRange* explicitTimeRanges(PIOTimeRange first, int64_t step, int n)
+{
+    PIOTimeRange* tl = (PIOTimeRange*) malloc(n*sizeof(PIOTimeRange));
+    int t;
+
+    for (t=0; t<n; t++)
+    {
+        tl[t] = first;
+        tl[t].time += t*step;
+    }
+    return tl;
+}
+
+static int64_t random64(int64_t n)
+{
+    return (((int64_t)rand()*RAND_MAX + rand()) % n);
+}
+
+// consecutive indices [firstIndex, firstIndex+number) are the ones found in explicit timeline
+static void checkIndices(int number, int firstIndex, int expectedNumber, int* expected, const char* name)
+{
+    int i;
+
+    expect(number, expectedNumber, name);
+    for (i=0; i<number; i++) expect(firstIndex+i, expected[i], name);
+}
+
+// queries (at 90 kHz) in regular timeline, checked against explicit one
+static void checkLookups(PIOTimeRange first, int64_t step, int n, const char* name)
+{
+    PIOTimeRange* tl = explicitTimeRanges(first, step, n);
+    PIOTime* maxStops = (PIOTime*) malloc(n*sizeof(PIOTime));
+    int* indices = (int*) malloc(n*sizeof(int));
+    int64_t extent = ((first.time + n*step)/first.scale + 1)*90000;
+    PIOTime time;
+    PIOTimeRange period;
+    int firstIndex = -1;
+    int number, q, t;
+
+    pioGetTimeLineMaximumStops(tl, n, maxStops);
+
+    // random queries, a few of them at the bounds of time ranges
+    for (q=0; q<NQUERIES; q++)
+    {
+        time = (PIOTime){random64(extent) - 90000, 90000};
+        period = (PIOTimeRange){time.time, random64(9000), 90000};
+        if (q%10 == 0)
+        {
+            t = (int)random64(n);
+            time = (PIOTime){tl[t].time + (q%20 ? tl[t].duration : 0), tl[t].scale};
+            period = (PIOTimeRange){time.time, random64(first.duration+1), tl[t].scale};
+        }
+
+        number = pioFindTimeRangesContainingTimeInRegularTimeLine(first, step, n, time, &firstIndex);
+        checkIndices(number, firstIndex, pioFindTimeRangesContainingTime(tl, maxStops, n, time, indices, n),
+                     indices, name);
+        number = pioFindTimeRangesIntersectingTimeRangeInRegularTimeLine(first, step, n, period, &firstIndex);
+        checkIndices(number, firstIndex, pioFindTimeRangesIntersectingTimeRange(tl, maxStops, n, period, indices, n),
+                     indices, name);
+        expect(pioFindTimeRangeInRegularTimeLine(period, first, step, n) < 0,
+               pioFindTimeRangeInTimeLine(period, tl, n) < 0, name);
+    }
+
+    // time ranges themselves
+    for (t=0; t<n; t+=n/NQUERIES+1)
+        expect(pioFindTimeRangeInRegularTimeLine(tl[t], first, step, n), t, name);
+    expect(pioFindTimeRangeInRegularTimeLine(tl[n-1], first, step, n), n-1, name);
+
+    free(indices);
+    free(maxStops);
+    free(tl);
+}
+
+// compare time range t of timeline with the expected regular one
+static void check(PIOTimeline* pioTimeline, PIOTimeRange first, int64_t step, const char* name)
+{
+    PIOTimeRange timerange;
+    int t;
+
+    expect(pioTimeline->ntimeranges, NTIMERANGES, name);
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        timerange = pioGetTimeRange(pioTimeline, t);
+        expect(timerange.time, first.time + t*step, name);
+        expect(timerange.duration, first.duration, name);
+        expect(timerange.scale, first.scale, name);
+    }
+}
+
+// read timeline with raw HDF5, as pinocchIO versions older than 0.5 do
+static void checkStorage(PIOFile pioFile, const char* path)
+{
+    PIOTimeRange timeranges[1];
+    hid_t dataset = H5Dopen2(pioFile.identifier, path, H5P_DEFAULT);
+    hid_t dataspace = H5Dget_space(dataset);
+    hid_t datatype = H5Tcreate(H5T_COMPOUND, sizeof(PIOTimeRange));
+    herr_t read_err;
+
+    H5Tinsert(datatype, "time", HOFFSET(PIOTimeRange, time), H5T_NATIVE_INT64);
+    H5Tinsert(datatype, "duration", HOFFSET(PIOTimeRange, duration), H5T_NATIVE_INT64);
+    H5Tinsert(datatype, "scale", HOFFSET(PIOTimeRange, scale), H5T_NATIVE_INT32);
+
+    expect(H5Sget_simple_extent_npoints(dataspace), 0, "no time range stored");
+    expect(H5Dget_storage_size(dataset), 0, "no storage");
+    H5E_BEGIN_TRY {
+        read_err = H5Dread(dataset, datatype, H5S_ALL, H5S_ALL, H5P_DEFAULT, timeranges);
+    } H5E_END_TRY;
+    expect(read_err < 0, 1, "read by older versions");
+
+    H5Tclose(datatype);
+    H5Sclose(dataspace);
+    H5Dclose(dataset);
+}
+
+int main (int argc, char *const  argv[])
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIOTimeRange first = {-1000, 2, 25};
+    PIOTimeRange timerange = {0, 0, 1};
+    PIOTimeRange* timeranges = NULL;
+    PIOTimeRange found;
+    PIOFile pioCopyFile = PIOFileInvalid;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    PIODataset pioDataset = PIODatasetInvalid;
+    void* buffer = NULL;
+    int64_t step = 3;
+    int64_t foundStep;
+    int t;
+
+    // explicit time ranges can be checked for regularity
+    timeranges = explicitTimeRanges(first, step, NTIMERANGES);
+    expect(pioIsRegularTimeLine(timeranges, NTIMERANGES, &found, &foundStep), 1, "pioIsRegularTimeLine");
+    expect(pioCompareTimeRanges(found, first), PINOCCHIO_TIMERANGE_COMPARISON_SAME, "pioIsRegularTimeLine (first)");
+    expect(foundStep, step, "pioIsRegularTimeLine (step)");
+    timeranges[NTIMERANGES/2].duration++;
+    expect(pioIsRegularTimeLine(timeranges, NTIMERANGES, NULL, NULL), 0, "different duration");
+    timeranges[NTIMERANGES/2].duration--;
+    timeranges[NTIMERANGES/2].time++;
+    expect(pioIsRegularTimeLine(timeranges, NTIMERANGES, NULL, NULL), 0, "different step");
+    timeranges[NTIMERANGES/2].time--;
+
+    remove(TEST_FILE);
+    pioFile = pioNewFile(TEST_FILE, "/path/to/medium");
+    pioTimeline = pioNewRegularTimeline(pioFile, "frames", "frames", NTIMERANGES, first, step);
+    expect(PIOTimelineIsValid(pioTimeline), 1, "pioNewRegularTimeline");
+    expect(pioTimeline.step, step, "pioNewRegularTimeline");
+    pioCloseTimeline(&pioTimeline);
+    pioTimeline = pioNewTimeline(pioFile, "explicit", "explicit", NTIMERANGES, timeranges);
+    pioCloseTimeline(&pioTimeline);
+    pioTimeline = pioNewRegularTimeline(pioFile, "zero", "zero", NTIMERANGES, first, 0);
+    expect(PIOTimelineIsValid(pioTimeline), 0, "zero step");
+
+    // end of last time range must fit in 64 bits, whatever the sign of first one
+    timerange.time = -1;
+    pioTimeline = pioNewRegularTimeline(pioFile, "negative", "negative", 3, timerange, INT64_MAX/2);
+    expect(PIOTimelineIsValid(pioTimeline), 1, "negative start");
+    pioCloseTimeline(&pioTimeline);
+    timerange.time = INT64_MIN;
+    pioTimeline = pioNewRegularTimeline(pioFile, "minimum", "minimum", 2, timerange, INT64_MAX);
+    expect(PIOTimelineIsValid(pioTimeline), 1, "minimum start");
+    pioCloseTimeline(&pioTimeline);
+    timerange.time = 1;
+    timerange.duration = 1;
+    pioTimeline = pioNewRegularTimeline(pioFile, "overflow", "overflow", 3, timerange, INT64_MAX/2);
+    expect(PIOTimelineIsValid(pioTimeline), 0, "end after INT64_MAX");
+    timerange.time = 0;
+    pioTimeline = pioNewRegularTimeline(pioFile, "overflow", "overflow", 3, timerange, INT64_MAX/2+1);
+    expect(PIOTimelineIsValid(pioTimeline), 0, "step too large");
+    pioCloseFile(&pioFile);
+
+    pioFile = pioOpenFile(TEST_FILE, PINOCCHIO_READNWRITE);
+    checkStorage(pioFile, "/timeline/frames");
+
+    // time ranges computed from first time range and step...
+    pioTimeline = pioOpenTimelineWithFlags(PIOMakeObject(pioFile), "frames", PINOCCHIO_TIMELINE_LAZY);
+    expect(pioTimeline.step, step, "regular timeline");
+    expect(pioTimeline.timeranges == NULL, 1, "lazy regular timeline");
+    check(&pioTimeline, first, step, "computed time ranges (lazy)");
+    expect(pioTimeline.window == NULL, 1, "regular timeline is not read");
+    expect(pioLoadTimeline(&pioTimeline), 1, "pioLoadTimeline");
+    check(&pioTimeline, first, step, "loaded time ranges");
+    pioCloseTimeline(&pioTimeline);
+
+    // ... or loaded when opened
+    pioTimeline = pioOpenTimeline(PIOMakeObject(pioFile), "frames");
+    expect(pioTimeline.timeranges != NULL, 1, "time ranges loaded");
+    check(&pioTimeline, first, step, "computed time ranges");
+
+    // datasets use regular timelines as any other
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    expect(PIODatasetIsValid(pioDataset), 1, "pioNewDataset");
+    expect(pioDataset.ntimeranges, NTIMERANGES, "number of time ranges of dataset");
+    for (t=0; t<NTIMERANGES; t+=100) pioWrite(&pioDataset, t, &t, 1, pioDatatype);
+    pioCloseDataset(&pioDataset);
+    pioCloseTimeline(&pioTimeline);
+    pioDataset = pioOpenDataset(PIOMakeObject(pioFile), "features");
+    for (t=0; t<NTIMERANGES; t+=50)
+    {
+        expect(pioRead(&pioDataset, t, pioDatatype, &buffer), (t%100) ? 0 : 1, "pioRead");
+        if (t%100 == 0) expect(*((int*)buffer), t, "pioRead");
+    }
+    pioCloseDataset(&pioDataset);
+
+    pioTimeline = pioOpenTimeline(PIOMakeObject(pioFile), "minimum");
+    expect(pioGetTimeRange(&pioTimeline, 1).time, -1, "minimum start");
+    pioCloseTimeline(&pioTimeline);
+
+    // explicit timeline with the same time ranges
+    pioTimeline = pioOpenTimeline(PIOMakeObject(pioFile), "explicit");
+    expect(pioTimeline.step, 0, "explicit timeline");
+    check(&pioTimeline, first, step, "explicit time ranges");
+    pioCloseTimeline(&pioTimeline);
+
+    // copies of regular timelines stay regular, and can be compared to explicit ones
+    remove(COPY_FILE);
+    pioCopyFile = pioNewFile(COPY_FILE, "/path/to/medium");
+    expect(pioCopyTimeline("frames", pioFile, pioCopyFile), 1, "pioCopyTimeline (regular)");
+    pioTimeline = pioOpenTimelineWithFlags(PIOMakeObject(pioCopyFile), "frames", PINOCCHIO_TIMELINE_LAZY);
+    expect(pioTimeline.step, step, "copy of regular timeline");
+    check(&pioTimeline, first, step, "copy of regular timeline");
+    pioCloseTimeline(&pioTimeline);
+    pioTimeline = pioNewRegularTimeline(pioCopyFile, "explicit", "explicit", NTIMERANGES, first, step);
+    pioCloseTimeline(&pioTimeline);
+    expect(pioCopyTimeline("explicit", pioFile, pioCopyFile), 1, "pioCopyTimeline (explicit onto regular)");
+
+    // every other time range (at 50 Hz) is a subset of timeline, shifted time ranges are not
+    pioTimeline = pioNewRegularTimeline(pioCopyFile, "half", "half", NTIMERANGES/2,
+                                        (PIOTimeRange){2*first.time, 2*first.duration, 50}, 4*step);
+    pioCloseTimeline(&pioTimeline);
+    pioTimeline = pioNewRegularTimeline(pioCopyFile, "shifted", "shifted", NTIMERANGES,
+                                        (PIOTimeRange){first.time+1, first.duration, first.scale}, step);
+    pioCloseTimeline(&pioTimeline);
+    pioTimeline = pioNewRegularTimeline(pioFile, "half", "half", NTIMERANGES, first, step);
+    pioCloseTimeline(&pioTimeline);
+    pioTimeline = pioNewRegularTimeline(pioFile, "shifted", "shifted", NTIMERANGES, first, step);
+    pioCloseTimeline(&pioTimeline);
+    expect(pioCopyTimeline("half", pioCopyFile, pioFile), 1, "pioCopyTimeline (subset)");
+    expect(pioCopyTimeline("shifted", pioCopyFile, pioFile), 0, "pioCopyTimeline (shifted)");
+    pioCloseFile(&pioCopyFile);
+
+    pioCloseFile(&pioFile);
+    pioCloseDatatype(&pioDatatype);
+    remove(COPY_FILE);
+    remove(TEST_FILE);
+    free(timeranges);
+
+    // lookups, with overlapping time ranges and queries at other scales
+    srand(42);
+    checkLookups(first, step, NTIMERANGES, "lookups (frames)");
+    checkLookups((PIOTimeRange){-5, 25, 1000}, 10, NTIMERANGES, "lookups (25 ms windows every 10 ms)");
+    checkLookups((PIOTimeRange){0, 90000, 30000}, 10000, NTIMERANGES/100, "lookups (3 s windows every 1/3 s)");
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
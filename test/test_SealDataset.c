@@ -0,0 +1,150 @@
+/*
+ *  test_SealDataset.c
+ *  pinocchIO
+ *
+ *  Checks that sealed datasets read the same data, memory-mapped or not, in
+ *  chronological and random order, in files with and without an HDF5 user
+ *  block, that they can no longer be written, and that a failed
+ *  pioSealDataset() leaves the original dataset in place.
+ *
+ *  usage: test_SealDataset
+ *
+ */
+
+#include <string.h>
+#include "test_utils.h"
+#include "pIOVersion.h"
+#include <hdf5_hl.h>
+
+#define TEST_FILE "/tmp/test_SealDataset.pio"
+#define NTIMERANGES 400
+#define DIMENSION 5
+
+// new pinocchIO file at path (overwritten), with a user block of given size
+static PIOFile newFileWithUserblock(const char* path, hsize_t userblock)
+{
+    hid_t creationProperty = H5Pcreate(H5P_FILE_CREATE);
+    hid_t file = -1;
+    hid_t group = -1;
+
+    remove(path);
+    if (userblock > 0) H5Pset_userblock(creationProperty, userblock);
+    file = H5Fcreate(path, H5F_ACC_EXCL, creationProperty, H5P_DEFAULT);
+    H5Pclose(creationProperty);
+    H5LTset_attribute_string(file, "/", PIOAttribute_File_Medium, "/path/to/medium");
+    H5LTset_attribute_string(file, "/", PIOAttribute_Version, PINOCCHIO_VERSION);
+    group = H5Gcreate2(file, PIOFile_Structure_Group_Timelines, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    H5Gclose(group);
+    group = H5Gcreate2(file, PIOFile_Structure_Group_Datasets, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    H5Gclose(group);
+    H5Fclose(file);
+
+    return pioOpenFile(path, PINOCCHIO_READNWRITE);
+}
+
+static int value(int t, int n, int d)
+{
+    return (t%3 == 0) ? -1000*t-10*n-d : 1000*t+10*n+d;
+}
+
+// read every time range of dataset at path (in chronological or random order)
+// and compare with expected values
+static void check(PIOFile pioFile, int flags, int mapped, const char* name)
+{
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, DIMENSION);
+    PIODataset pioDataset = pioOpenDatasetWithFlags(PIOMakeObject(pioFile), "features", flags);
+    void* buffer = NULL;
+    int order[2*NTIMERANGES];
+    int i, t, n, d;
+
+    for (i=0; i<NTIMERANGES; i++) order[i] = i;
+    for (i=NTIMERANGES; i<2*NTIMERANGES; i++) order[i] = rand()%NTIMERANGES;
+
+    expect(PIODatasetIsInvalid(pioDataset), 0, name);
+    expect(pioDataset.mapping != NULL, mapped, name);
+    for (i=0; i<2*NTIMERANGES; i++)
+    {
+        t = order[i];
+        expect(pioRead(&pioDataset, t, pioDatatype, &buffer), t%4, name);
+        for (n=0; n<t%4; n++)
+            for (d=0; d<DIMENSION; d++)
+                expect(((int*)buffer)[n*DIMENSION+d], value(t, n, d), name);
+    }
+    pioCloseDataset(&pioDataset);
+    pioCloseDatatype(&pioDatatype);
+}
+
+static void test(hsize_t userblock)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, DIMENSION);
+    PIODataset pioDataset = PIODatasetInvalid;
+    PIOTimeRange* timeranges = newFrames(NTIMERANGES);
+    int data[4*DIMENSION];
+    char unsealed[256];
+    hid_t group = -1;
+    int t, n, d;
+
+    pioFile = newFileWithUserblock(TEST_FILE, userblock);
+    expect(PIOFileIsInvalid(pioFile), 0, "file with user block");
+    pioTimeline = pioNewTimeline(pioFile, "frames", "frames", NTIMERANGES, timeranges);
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    // time ranges multiple of 3 are written twice: data are scattered
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        for (n=0; n<4; n++) for (d=0; d<DIMENSION; d++) data[n*DIMENSION+d] = (t%3 == 0) ? -value(t, n, d) : value(t, n, d);
+        pioWrite(&pioDataset, t, data, t%4, pioDatatype);
+    }
+    for (t=0; t<NTIMERANGES; t+=3)
+    {
+        for (n=0; n<4; n++) for (d=0; d<DIMENSION; d++) data[n*DIMENSION+d] = value(t, n, d);
+        pioWrite(&pioDataset, t, data, t%4, pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+    check(pioFile, PINOCCHIO_DATASET_MMAP, 0, "unsealed dataset is not mapped");
+
+    // sealing fails when its temporary link cannot be created...
+    sprintf(unsealed, "/%s/features/%s_unsealed", PIOFile_Structure_Group_Datasets, PIOFile_Structure_Datasets_Data);
+    group = H5Gcreate2(pioFile.identifier, unsealed, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    expect(pioSealDataset(PIOMakeObject(pioFile), "features"), 0, "failed pioSealDataset");
+    H5Gclose(group);
+    H5Ldelete(pioFile.identifier, unsealed, H5P_DEFAULT);
+    // ... and leaves original dataset untouched
+    check(pioFile, PINOCCHIO_DATASET_DEFAULT, 0, "dataset after failed pioSealDataset");
+    check(pioFile, PINOCCHIO_DATASET_MMAP, 0, "dataset after failed pioSealDataset");
+
+    expect(pioSealDataset(PIOMakeObject(pioFile), "features"), 1, "pioSealDataset");
+    expect(pioSealDataset(PIOMakeObject(pioFile), "features"), 1, "second pioSealDataset");
+    check(pioFile, PINOCCHIO_DATASET_DEFAULT, 0, "sealed dataset");
+    check(pioFile, PINOCCHIO_DATASET_MMAP, 1, "mapped dataset");
+
+    // sealed datasets are read-only
+    pioDataset = pioOpenDataset(PIOMakeObject(pioFile), "features");
+    expect(pioWrite(&pioDataset, 1, data, 1, pioDatatype) < 0, 1, "sealed dataset is not writable");
+    pioCloseDataset(&pioDataset);
+    check(pioFile, PINOCCHIO_DATASET_MMAP, 1, "mapped dataset after write attempt");
+
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+
+    // same once file is reopened read-only
+    pioFile = pioOpenFile(TEST_FILE, PINOCCHIO_READONLY);
+    check(pioFile, PINOCCHIO_DATASET_MMAP, 1, "mapped dataset (read-only)");
+    pioCloseFile(&pioFile);
+
+    pioCloseDatatype(&pioDatatype);
+    remove(TEST_FILE);
+    free(timeranges);
+}
+
+int main (int argc, char *const  argv[])
+{
+    srand(42);
+    test(0);
+    test(512);
+    test(4096);
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
@@ -0,0 +1,246 @@
+/*
+ *  test_ServerCache.c
+ *  pinocchIO
+ *
+ *  Checks that a Gepetto server created from an index cache file (cold or
+ *  warm) serves the same data and labels as one created without cache, that
+ *  the cache is not used once a file, the label filter or the sampling
+ *  changes, and that unreadable or unwritable cache files are not fatal.
+ *
+ *  usage: test_ServerCache
+ *
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "gepetto/gepetto.h"
+#include "test_utils.h"
+
+#define TEST_FILE "/tmp/test_ServerCache_%d.pio"
+#define CACHE_FILE "/tmp/test_ServerCache.cache"
+#define NFILES 5
+#define NTIMERANGES 400
+
+static void create(int f, int ntimeranges, int offset)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIOTimeline labelTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, 4);
+    PIODatatype labelDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    PIODataset pioDataset = PIODatasetInvalid;
+    PIOTimeRange* timeranges = NULL;
+    char path[256];
+    float data[4];
+    int label;
+    int t, d;
+
+    sprintf(path, TEST_FILE, f);
+    pioFile = newFramesFile(path, ntimeranges, &pioTimeline);
+
+    // no entry every 5 frames
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    for (t=0; t<ntimeranges; t++)
+    {
+        for (d=0; d<4; d++) data[d] = (float)(f+t+d+offset);
+        pioWrite(&pioDataset, t, data, t%5 == 4 ? 0 : 1, pioDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    // one label every 10 frames
+    timeranges = newFrames(ntimeranges/10);
+    for (t=0; t<ntimeranges/10; t++)
+    {
+        timeranges[t].time = 10*t;
+        timeranges[t].duration = 10;
+    }
+    labelTimeline = pioNewTimeline(pioFile, "shots", "shots", ntimeranges/10, timeranges);
+    pioDataset = pioNewDataset(pioFile, "labels", "labels", labelTimeline, labelDatatype);
+    for (t=0; t<ntimeranges/10; t++)
+    {
+        label = (f+t+offset)%3;
+        pioWrite(&pioDataset, t, &label, 1, labelDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    pioCloseDatatype(&labelDatatype);
+    pioCloseDatatype(&pioDatatype);
+    pioCloseTimeline(&labelTimeline);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+    free(timeranges);
+}
+
+static GPTServer newServer(char** paths, int filterValue, int maximumNumberOfSamplesPerLabel,
+                           const char* cacheFile)
+{
+    GPTServerOptions options = GPTServerOptionsDefault;
+
+    options.cacheFile = cacheFile;
+    return gptNewServerWithOptions(NFILES, paths, "features",
+                                   GEPETTO_LABEL_FILTER_TYPE_DIFFERS_FROM, filterValue,
+                                   maximumNumberOfSamplesPerLabel,
+                                   NFILES, paths, "labels", options);
+}
+
+// server serves the same entries and labels, and has the same label index, as reference
+static void compare(GPTServer* server, GPTServer* reference, PIODatatype pioDatatype, const char* name)
+{
+    int64_t size = gptDumpServer(reference, pioDatatype, NULL);
+    void* dumped = malloc(size > 0 ? size : 1);
+    void* referenceDumped = malloc(size > 0 ? size : 1);
+    int labels[16], referenceLabels[16];
+    const GPTTimeRange* timeranges = NULL;
+    const GPTTimeRange* referenceTimeranges = NULL;
+    void* buffer = NULL;
+    int* served = NULL;
+    int* referenceServed = NULL;
+    int nLabels, referenceNLabels, entries, n, l, t;
+
+    expect(GPTServerIsInvalid(*server), 0, name);
+    expect(gptDumpServer(server, pioDatatype, NULL), size, name);
+    gptDumpServer(server, pioDatatype, dumped);
+    gptDumpServer(reference, pioDatatype, referenceDumped);
+    expect(memcmp(dumped, referenceDumped, size), 0, name);
+
+    referenceServed = (int*) malloc(16*sizeof(int));
+    while ((entries = gptReadNext(reference, pioDatatype, &buffer, &referenceNLabels, &served)) >= 0)
+    {
+        expect(referenceNLabels <= 16, 1, name);
+        memcpy(referenceServed, served, referenceNLabels*sizeof(int));
+        expect(gptReadNext(server, pioDatatype, &buffer, &nLabels, &served), entries, name);
+        expect(nLabels, referenceNLabels, name);
+        for (l=0; l<nLabels; l++) expect(served[l], referenceServed[l], name);
+    }
+    expect(gptReadNext(server, pioDatatype, &buffer, NULL, NULL), -1, name);
+
+    n = gptGetListOfDistinctLabels(*reference, NULL);
+    expect(n <= 16, 1, name);
+    expect(gptGetListOfDistinctLabels(*server, NULL), n, name);
+    gptGetListOfDistinctLabels(*server, labels);
+    gptGetListOfDistinctLabels(*reference, referenceLabels);
+    expect(memcmp(labels, referenceLabels, n*sizeof(int)), 0, name);
+    for (l=0; l<n; l++)
+    {
+        entries = gptGetTimerangesForLabelNoCopy(*reference, labels[l], &referenceTimeranges);
+        expect(gptGetTimerangesForLabelNoCopy(*server, labels[l], &timeranges), entries, name);
+        for (t=0; t<entries; t++)
+        {
+            expect(timeranges[t].fileIndex, referenceTimeranges[t].fileIndex, name);
+            expect(timeranges[t].timerange.time, referenceTimeranges[t].timerange.time, name);
+            expect(timeranges[t].timerange.duration, referenceTimeranges[t].timerange.duration, name);
+        }
+    }
+
+    free(referenceServed);
+    free(referenceDumped);
+    free(dumped);
+}
+
+// compare server created with given cache file with one created without cache
+static void check(char** paths, int filterValue, const char* cacheFile, PIODatatype pioDatatype, const char* name)
+{
+    GPTServer reference = newServer(paths, filterValue, -1, NULL);
+    GPTServer server = newServer(paths, filterValue, -1, cacheFile);
+
+    expect(GPTServerIsInvalid(reference), 0, name);
+    compare(&server, &reference, pioDatatype, name);
+    gptCloseServer(&server);
+    gptCloseServer(&reference);
+}
+
+// modification time of file, in nanoseconds (-1 if it does not exist)
+static int64_t modified(const char* path)
+{
+    struct stat st;
+
+    if (stat(path, &st) < 0) return -1;
+#ifdef __APPLE__
+    return (int64_t)st.st_mtimespec.tv_sec*1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    return (int64_t)st.st_mtim.tv_sec*1000000000 + st.st_mtim.tv_nsec;
+#endif
+}
+
+int main (int argc, char *const  argv[])
+{
+    char* paths[NFILES];
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, 4);
+    GPTServer server = GPTServerInvalid;
+    GPTServer sampled = GPTServerInvalid;
+    GPTServerOptions options = GPTServerOptionsDefault;
+    FILE* file = NULL;
+    int64_t written;
+    int f;
+
+    for (f=0; f<NFILES; f++)
+    {
+        create(f, NTIMERANGES, 0);
+        paths[f] = (char*) malloc(256);
+        sprintf(paths[f], TEST_FILE, f);
+    }
+    remove(CACHE_FILE);
+
+    // cold cache, then warm cache (loaded, not written again)
+    check(paths, 1, CACHE_FILE, pioDatatype, "cold cache");
+    written = modified(CACHE_FILE);
+    expect(written >= 0, 1, "cache file written");
+    check(paths, 1, CACHE_FILE, pioDatatype, "warm cache");
+    expect(modified(CACHE_FILE), written, "warm cache is not written");
+
+    // label filter is part of the cache key
+    check(paths, 2, CACHE_FILE, pioDatatype, "other label filter");
+    check(paths, 1, CACHE_FILE, pioDatatype, "label filter back");
+
+    // sampled filter is cached: warm cache serves the very same samples
+    remove(CACHE_FILE);
+    sampled = newServer(paths, 1, 5, CACHE_FILE);
+    server = newServer(paths, 1, 5, CACHE_FILE);
+    compare(&server, &sampled, pioDatatype, "sampled labels");
+    gptCloseServer(&server);
+    gptCloseServer(&sampled);
+    check(paths, 1, CACHE_FILE, pioDatatype, "sampling is part of the cache key");
+
+    // changed file: stale cache is not used
+    create(NFILES/2, NTIMERANGES/2, 1);
+    written = modified(CACHE_FILE);
+    check(paths, 1, CACHE_FILE, pioDatatype, "changed file");
+    expect(modified(CACHE_FILE) != written, 1, "cache rebuilt");
+    check(paths, 1, CACHE_FILE, pioDatatype, "cache of changed file");
+
+    // changed list of files
+    options.cacheFile = CACHE_FILE;
+    server = gptNewServerWithOptions(NFILES-1, paths+1, "features",
+                                     GEPETTO_LABEL_FILTER_TYPE_DIFFERS_FROM, 1, -1,
+                                     NFILES-1, paths+1, "labels", GPTServerOptionsDefault);
+    sampled = gptNewServerWithOptions(NFILES-1, paths+1, "features",
+                                      GEPETTO_LABEL_FILTER_TYPE_DIFFERS_FROM, 1, -1,
+                                      NFILES-1, paths+1, "labels", options);
+    compare(&sampled, &server, pioDatatype, "other list of files");
+    gptCloseServer(&sampled);
+    gptCloseServer(&server);
+
+    // corrupted cache files are ignored
+    check(paths, 1, CACHE_FILE, pioDatatype, "cache before truncation");
+    truncate(CACHE_FILE, 100);
+    check(paths, 1, CACHE_FILE, pioDatatype, "truncated cache");
+    file = fopen(CACHE_FILE, "w");
+    fprintf(file, "not a Gepetto cache file");
+    fclose(file);
+    check(paths, 1, CACHE_FILE, pioDatatype, "garbage cache");
+
+    // failing to write cache file is not fatal
+    check(paths, 1, "/nonexistent/directory/cache", pioDatatype, "unwritable cache");
+
+    pioCloseDatatype(&pioDatatype);
+    for (f=0; f<NFILES; f++)
+    {
+        remove(paths[f]);
+        free(paths[f]);
+    }
+    remove(CACHE_FILE);
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
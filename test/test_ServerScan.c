@@ -0,0 +1,185 @@
+/*
+ *  test_ServerScan.c
+ *  pinocchIO
+ *
+ *  Checks that a Gepetto server serves every entry of every data file whose
+ *  labels pass the filter, whatever the number of processes scanning files,
+ *  and that missing files, missing datasets and mismatching datatypes are
+ *  reported by an invalid server.
+ *
+ *  usage: test_ServerScan
+ *
+ */
+
+#include <string.h>
+#include "gepetto/gepetto.h"
+#include "test_utils.h"
+
+#define TEST_FILE "/tmp/test_ServerScan_%d.pio"
+#define NFILES 4
+#define NTIMERANGES 300
+
+static int number(int f, int t) { return (t+f)%3; }
+static int label(int f, int t) { return ((t+2*f)/20)%3; }
+
+// file f, with features of given dimension
+static void create(int f, int dimension)
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, dimension);
+    PIODatatype labelDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    PIODataset pioDataset = PIODatasetInvalid;
+    char path[256];
+    float data[2*3] = {0, 1, 2, 3, 4, 5};
+    int value;
+    int t;
+
+    sprintf(path, TEST_FILE, f);
+    pioFile = newFramesFile(path, NTIMERANGES, &pioTimeline);
+
+    pioDataset = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    for (t=0; t<NTIMERANGES; t++) pioWrite(&pioDataset, t, data, number(f, t), pioDatatype);
+    pioCloseDataset(&pioDataset);
+
+    pioDataset = pioNewDataset(pioFile, "labels", "labels", pioTimeline, labelDatatype);
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        value = label(f, t);
+        pioWrite(&pioDataset, t, &value, 1, labelDatatype);
+    }
+    pioCloseDataset(&pioDataset);
+
+    pioCloseDatatype(&labelDatatype);
+    pioCloseDatatype(&pioDatatype);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+}
+
+static GPTServer newServer(char** paths, const char* dataset, int numberOfProcesses)
+{
+    GPTServerOptions options = GPTServerOptionsDefault;
+
+    options.numberOfProcesses = numberOfProcesses;
+    return gptNewServerWithOptions(NFILES, paths, dataset,
+                                   GEPETTO_LABEL_FILTER_TYPE_GREATER_THAN, 0, -1,
+                                   NFILES, paths, "labels", options);
+}
+
+// server serves the same entries and labels, and has the same label index, as reference
+static void compare(GPTServer* server, GPTServer* reference, PIODatatype pioDatatype, const char* name)
+{
+    int64_t size = gptDumpServer(reference, pioDatatype, NULL);
+    void* dumped = malloc(size);
+    void* referenceDumped = malloc(size);
+    int labels[16], referenceLabels[16];
+    const GPTTimeRange* timeranges = NULL;
+    const GPTTimeRange* referenceTimeranges = NULL;
+    void* buffer = NULL;
+    int* served = NULL;
+    int nLabels, referenceNLabels, firstLabel, entries, n, l, t;
+
+    expect(GPTServerIsInvalid(*server), 0, name);
+    expect(gptDumpServer(server, pioDatatype, NULL), size, name);
+    gptDumpServer(server, pioDatatype, dumped);
+    gptDumpServer(reference, pioDatatype, referenceDumped);
+    expect(memcmp(dumped, referenceDumped, size), 0, name);
+
+    for (n=0; (entries = gptReadNext(reference, pioDatatype, &buffer, &referenceNLabels, &served)) >= 0; n++)
+    {
+        firstLabel = served[0];
+        expect(gptReadNext(server, pioDatatype, &buffer, &nLabels, &served), entries, name);
+        expect(nLabels, referenceNLabels, name);
+        expect(served[0], firstLabel, name);
+    }
+    expect(gptReadNext(server, pioDatatype, &buffer, NULL, NULL), -1, name);
+
+    n = gptGetListOfDistinctLabels(*reference, NULL);
+    expect(n <= 16, 1, name);
+    expect(gptGetListOfDistinctLabels(*server, NULL), n, name);
+    gptGetListOfDistinctLabels(*server, labels);
+    gptGetListOfDistinctLabels(*reference, referenceLabels);
+    expect(memcmp(labels, referenceLabels, n*sizeof(int)), 0, name);
+    for (l=0; l<n; l++)
+    {
+        entries = gptGetTimerangesForLabelNoCopy(*reference, labels[l], &referenceTimeranges);
+        expect(gptGetTimerangesForLabelNoCopy(*server, labels[l], &timeranges), entries, name);
+        for (t=0; t<entries; t++)
+        {
+            expect(timeranges[t].fileIndex, referenceTimeranges[t].fileIndex, name);
+            expect(timeranges[t].timerange.time, referenceTimeranges[t].timerange.time, name);
+            expect(timeranges[t].timerange.duration, referenceTimeranges[t].timerange.duration, name);
+        }
+    }
+
+    free(referenceDumped);
+    free(dumped);
+}
+
+int main (int argc, char *const  argv[])
+{
+    char* paths[NFILES];
+    GPTServer server = GPTServerInvalid;
+    GPTServer sequential = GPTServerInvalid;
+    int numberOfProcesses[4] = {2, 3, NFILES, 16};
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_FLOAT, 2);
+    void* buffer = NULL;
+    int64_t expected = 0;
+    int64_t served = 0;
+    int entries, f, t, p;
+
+    for (f=0; f<NFILES; f++)
+    {
+        create(f, 2);
+        paths[f] = (char*) malloc(256);
+        sprintf(paths[f], TEST_FILE, f);
+        for (t=0; t<NTIMERANGES; t++)
+            if (label(f, t) > 0) expected += number(f, t);
+    }
+
+    sequential = newServer(paths, "features", 1);
+    expect(GPTServerIsInvalid(sequential), 0, "gptNewServer");
+    expect(gptDumpServer(&sequential, pioDatatype, NULL), expected*pioGetSize(pioDatatype), "size of server");
+    while ((entries = gptReadNext(&sequential, pioDatatype, &buffer, NULL, NULL)) >= 0) served += entries;
+    expect(served, expected, "number of served entries");
+
+    // files scanned by several processes
+    for (p=0; p<4; p++)
+    {
+        server = newServer(paths, "features", numberOfProcesses[p]);
+        compare(&server, &sequential, pioDatatype, "server scanned by several processes");
+        gptCloseServer(&server);
+    }
+    gptCloseServer(&sequential);
+
+    for (p=1; p<=3; p+=2)
+    {
+        server = newServer(paths, "missing", p);
+        expect(GPTServerIsInvalid(server), 1, "missing dataset");
+    }
+
+    // features of last file have another dimension
+    create(NFILES-1, 3);
+    for (p=1; p<=3; p+=2)
+    {
+        server = newServer(paths, "features", p);
+        expect(GPTServerIsInvalid(server), 1, "datatype mismatch");
+    }
+
+    remove(paths[NFILES-1]);
+    for (p=1; p<=3; p+=2)
+    {
+        server = newServer(paths, "features", p);
+        expect(GPTServerIsInvalid(server), 1, "missing file");
+    }
+
+    pioCloseDatatype(&pioDatatype);
+    for (f=0; f<NFILES; f++)
+    {
+        remove(paths[f]);
+        free(paths[f]);
+    }
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
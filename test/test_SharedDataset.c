@@ -0,0 +1,88 @@
+/*
+ *  test_SharedDataset.c
+ *  pinocchIO
+ *
+ *  Checks that a dataset handle keeps reading correct data while another
+ *  handle on the same dataset extends it, and that by-value copies of a
+ *  handle read the same data as the original.
+ *
+ *  usage: test_SharedDataset
+ *
+ */
+
+#include <string.h>
+#include "test_utils.h"
+
+#define TEST_FILE "/tmp/test_SharedDataset.pio"
+#define NTIMERANGES 200
+
+// check time range t of dataset contains number entries, starting at value
+static void check(PIODataset* pioDataset, int t, int number, int value, PIODatatype pioDatatype, const char* name)
+{
+    void* buffer = NULL;
+    int i;
+
+    expect(pioRead(pioDataset, t, pioDatatype, &buffer), number, name);
+    for (i=0; i<number; i++) expect(((int*)buffer)[i], value+i, name);
+}
+
+int main (int argc, char *const  argv[])
+{
+    PIOFile pioFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    PIODataset writer = PIODatasetInvalid;
+    PIODataset reader = PIODatasetInvalid;
+    PIODataset copy = PIODatasetInvalid;
+    int data[NTIMERANGES];
+    int t, d;
+
+    pioFile = newFramesFile(TEST_FILE, NTIMERANGES, &pioTimeline);
+    writer = pioNewDataset(pioFile, "features", "features", pioTimeline, pioDatatype);
+    for (t=0; t<NTIMERANGES/2; t++)
+    {
+        for (d=0; d<t%5; d++) data[d] = 10*t+d;
+        pioWrite(&writer, t, data, t%5, pioDatatype);
+    }
+
+    // reader is opened before writer extends the dataset any further
+    reader = pioOpenDataset(PIOMakeObject(pioFile), "features");
+    check(&reader, NTIMERANGES/2-1, (NTIMERANGES/2-1)%5, 10*(NTIMERANGES/2-1), pioDatatype, "read before extension");
+
+    for (t=NTIMERANGES/2; t<NTIMERANGES; t++)
+    {
+        for (d=0; d<t; d++) data[d] = 10*t+d;
+        pioWrite(&writer, t, data, t, pioDatatype);
+        // new data are readable right away...
+        check(&reader, t, t, 10*t, pioDatatype, "read after extension");
+    }
+    // ... and so are data appended when time ranges are overwritten
+    for (t=0; t<NTIMERANGES; t+=9)
+    {
+        for (d=0; d<20; d++) data[d] = -100*t+d;
+        pioWrite(&writer, t, data, 20, pioDatatype);
+        check(&reader, t, 20, -100*t, pioDatatype, "read after overwrite");
+    }
+
+    // by-value copies share HDF5 identifiers but no selection state
+    copy = reader;
+    copy.buffer = NULL;
+    copy.buffer_size = 0;
+    for (t=0; t<NTIMERANGES; t++)
+    {
+        expect(pioReadNumber(copy, t), pioReadNumber(reader, t), "copy");
+        check(&copy, t, pioReadNumber(reader, t), (t%9 == 0) ? -100*t : 10*t, pioDatatype, "copy");
+        check(&reader, t, pioReadNumber(copy, t), (t%9 == 0) ? -100*t : 10*t, pioDatatype, "original");
+    }
+    free(copy.buffer);
+
+    pioCloseDataset(&reader);
+    pioCloseDataset(&writer);
+    pioCloseTimeline(&pioTimeline);
+    pioCloseFile(&pioFile);
+    pioCloseDatatype(&pioDatatype);
+    remove(TEST_FILE);
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
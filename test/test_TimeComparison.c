@@ -0,0 +1,201 @@
+/*
+ *  test_TimeComparison.c
+ *  pinocchIO
+ *
+ *  Checks time and time range comparisons close to the limits of 64-bit products:
+ *  fine scales (90 kHz) over long periods compared with other scales,
+ *  times close to INT64_MAX at a single scale, and times close to INT64_MIN
+ *  and INT64_MAX at different scales.
+ *
+ *  usage: test_TimeComparison
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "pinocchIO.h"
+
+// 100 years at 90 kHz
+#define CENTURY_90KHZ (90000LL*86400*365*100)
+#define THREE_YEARS (3LL*365*86400)
+#define NFRAMES 1000
+
+static int failures = 0;
+
+static void expect(int result, int expected, const char* name)
+{
+    if (result != expected)
+    {
+        fprintf(stderr, "%s: got %d instead of %d.\n", name, result, expected);
+        failures++;
+    }
+}
+
+// one frame every step/25 second starting at offset seconds, in 1/scale units
+static void frames(PIOTimeRange* timeranges, int n, int32_t scale, int step, int64_t offset)
+{
+    int t;
+
+    for (t=0; t<n; t++)
+    {
+        timeranges[t].time = offset*scale + ((int64_t)t*step*scale)/25;
+        timeranges[t].duration = scale/25;
+        timeranges[t].scale = scale;
+    }
+}
+
+int main (int argc, char *const  argv[])
+{
+    // same instant, at 90 kHz and at the largest 32-bit scale
+    // (cross products are about 6e23, way beyond INT64_MAX)
+    PIOTime t90k = {CENTURY_90KHZ, 90000};
+    PIOTime tmax = {(CENTURY_90KHZ/90000)*INT32_MAX, INT32_MAX};
+    PIOTime tmaxNext = {(CENTURY_90KHZ/90000)*INT32_MAX+1, INT32_MAX};
+    PIOTime tmaxPrevious = {(CENTURY_90KHZ/90000)*INT32_MAX-1, INT32_MAX};
+    PIOTime negative90k = {-CENTURY_90KHZ, 90000};
+    PIOTime negativeMax = {-(CENTURY_90KHZ/90000)*INT32_MAX, INT32_MAX};
+
+    PIOTimeRange frame90k = {CENTURY_90KHZ, 3600, 90000};
+    PIOTimeRange frame25 = {(CENTURY_90KHZ/3600), 1, 25};
+    PIOTimeRange frameMax = {(CENTURY_90KHZ/90000)*INT32_MAX, INT32_MAX/25, INT32_MAX};
+
+    // single scale, close to INT64_MAX (no product at all)
+    PIOTime huge = {INT64_MAX-1, 1000};
+    PIOTime hugeNext = {INT64_MAX, 1000};
+    PIOTimeRange hugeRange = {INT64_MAX-10, 5, 1000};
+    PIOTimeRange hugeLater = {INT64_MAX-5, 5, 1000};
+
+    // INT64_MAX = INT32_MAX*(2^32+2)+1 and INT64_MIN = -INT32_MAX*(2^32+2)-2:
+    // exact comparisons at these extremes need 128-bit cross products
+    PIOTime maxAtMaxScale = {INT64_MAX, INT32_MAX};
+    PIOTime maxMinusOne = {INT64_MAX-1, INT32_MAX};
+    PIOTime minAtMaxScale = {INT64_MIN, INT32_MAX};
+    PIOTime minPlusTwo = {INT64_MIN+2, INT32_MAX};
+    PIOTime seconds = {(1LL<<32)+2, 1};
+    PIOTime negativeSeconds = {-(1LL<<32)-2, 1};
+    PIOTime maxAtScale2 = {INT64_MAX, 2};
+    PIOTime maxAtScale3 = {INT64_MAX, 3};
+    PIOTime minAtScale2 = {INT64_MIN, 2};
+    PIOTime minAtScale3 = {INT64_MIN, 3};
+    PIOTimeRange lastSecond = {INT64_MAX-1-INT32_MAX, INT32_MAX, INT32_MAX};
+    PIOTimeRange lastSecondAt1 = {(1LL<<32)+1, 1, 1};
+    PIOTimeRange firstSecond = {INT64_MIN+2, INT32_MAX, INT32_MAX};
+    PIOTimeRange firstSecondAt1 = {-(1LL<<32)-2, 1, 1};
+    PIOTimeRange tlExtreme[3] = {{INT64_MIN+2, INT32_MAX, INT32_MAX},
+                                 {INT64_MAX-1-2*(int64_t)INT32_MAX, INT32_MAX, INT32_MAX},
+                                 {INT64_MAX-1-INT32_MAX, INT32_MAX, INT32_MAX}};
+    PIOTimeRange tlExtremeAt1[3] = {{-(1LL<<32)-2, 1, 1}, {1LL<<32, 1, 1}, {(1LL<<32)+1, 1, 1}};
+
+    PIOTime start48k = {48000LL*3600*24*365, 48000};
+    PIOTime stop90k = {90000LL*3600*24*365 + 90, 90000};
+    PIOTimeRange between;
+
+    PIOTimeRange tl90k[3] = {{0, 3600, 90000}, {3600, 3600, 90000}, {CENTURY_90KHZ, 3600, 90000}};
+    PIOTimeRange tl25[3] = {{0, 1, 25}, {1, 1, 25}, {CENTURY_90KHZ/3600, 1, 25}};
+    PIOTimeRange tl25bis[3] = {{0, 1, 25}, {1, 1, 25}, {CENTURY_90KHZ/3600, 2, 25}};
+    PIOTimeRange twice[4] = {{1, 1, 25}, {1, 1, 25}, {CENTURY_90KHZ/3600, 1, 25}, {CENTURY_90KHZ/3600, 1, 25}};
+    int mapping[4];
+
+    // 90 kHz and nanoseconds, 3 years in: cross products do not fit in 64 bits
+    PIOTimeRange late90k[NFRAMES], late1G[NFRAMES], lateEvery10[NFRAMES/10];
+    int lateMapping[NFRAMES/10];
+    int t;
+
+    // timestamps at different scales
+    expect(pioCompareTimes(t90k, tmax), PINOCCHIO_TIME_COMPARISON_SAME, "90 kHz == INT32_MAX scale");
+    expect(pioCompareTimes(t90k, tmaxNext), PINOCCHIO_TIME_COMPARISON_ASCENDING, "90 kHz < INT32_MAX scale");
+    expect(pioCompareTimes(tmaxNext, t90k), PINOCCHIO_TIME_COMPARISON_DESCENDING, "INT32_MAX scale > 90 kHz");
+    expect(pioCompareTimes(tmaxPrevious, t90k), PINOCCHIO_TIME_COMPARISON_ASCENDING, "INT32_MAX scale < 90 kHz");
+    expect(pioCompareTimes(negative90k, negativeMax), PINOCCHIO_TIME_COMPARISON_SAME, "negative times");
+    expect(pioCompareTimes(negativeMax, t90k), PINOCCHIO_TIME_COMPARISON_ASCENDING, "negative < positive");
+    expect(pioGetTimeMax(t90k, tmaxNext).scale, INT32_MAX, "pioGetTimeMax");
+    expect(pioGetTimeMin(t90k, tmaxNext).scale, 90000, "pioGetTimeMin");
+
+    // time ranges at different scales
+    expect(pioCompareTimeRanges(frame90k, frame25), PINOCCHIO_TIMERANGE_COMPARISON_SAME, "90 kHz frame == 25 Hz frame");
+    expect(pioCompareTimeRanges(frame90k, frameMax), PINOCCHIO_TIMERANGE_COMPARISON_DESCENDING, "90 kHz frame ends after");
+    expect(pioTimeInTimeRange(t90k, frame25), 1, "start of 25 Hz frame");
+    expect(pioTimeInTimeRange(tmaxPrevious, frame25), 0, "just before 25 Hz frame");
+    expect(pioTimeRangeInTimeRange(frameMax, frame90k), 1, "frame included in frame");
+    expect(pioTimeRangeInTimeRange(frame90k, frameMax), 0, "frame not included in frame");
+    expect(pioTimeRangeIntersectsTimeRange(frame90k, frameMax), 1, "frames intersect");
+    expect(pioCompareTimeAndTimeRange(tmaxPrevious, frame90k), PINOCCHIO_TIMERANGE_COMPARISON_ASCENDING, "time before time range");
+    expect(pioCompareTimeAndTimeRange(tmaxNext, frame90k), PINOCCHIO_TIMERANGE_COMPARISON_SAME, "time during time range");
+
+    // single scale close to INT64_MAX
+    expect(pioCompareTimes(huge, hugeNext), PINOCCHIO_TIME_COMPARISON_ASCENDING, "INT64_MAX-1 < INT64_MAX");
+    expect(pioCompareTimeRanges(hugeRange, hugeLater), PINOCCHIO_TIMERANGE_COMPARISON_ASCENDING, "time ranges close to INT64_MAX");
+    expect(pioTimeRangeIntersectsTimeRange(hugeRange, hugeLater), 0, "adjacent time ranges close to INT64_MAX");
+
+    // different scales at the limits of 64-bit times
+    expect(pioCompareTimes(maxMinusOne, seconds), PINOCCHIO_TIME_COMPARISON_SAME, "INT64_MAX-1 at INT32_MAX scale");
+    expect(pioCompareTimes(maxAtMaxScale, seconds), PINOCCHIO_TIME_COMPARISON_DESCENDING, "INT64_MAX at INT32_MAX scale");
+    expect(pioCompareTimes(seconds, maxAtMaxScale), PINOCCHIO_TIME_COMPARISON_ASCENDING, "seconds before INT64_MAX");
+    expect(pioCompareTimes(minPlusTwo, negativeSeconds), PINOCCHIO_TIME_COMPARISON_SAME, "INT64_MIN+2 at INT32_MAX scale");
+    expect(pioCompareTimes(minAtMaxScale, negativeSeconds), PINOCCHIO_TIME_COMPARISON_ASCENDING, "INT64_MIN at INT32_MAX scale");
+    expect(pioCompareTimes(maxAtScale3, maxAtScale2), PINOCCHIO_TIME_COMPARISON_ASCENDING, "INT64_MAX/3 < INT64_MAX/2");
+    expect(pioCompareTimes(minAtScale3, minAtScale2), PINOCCHIO_TIME_COMPARISON_DESCENDING, "INT64_MIN/3 > INT64_MIN/2");
+    expect(pioCompareTimes(minAtMaxScale, maxAtMaxScale), PINOCCHIO_TIME_COMPARISON_ASCENDING, "INT64_MIN < INT64_MAX");
+    expect(pioCompareTimes(minAtScale2, maxAtScale3), PINOCCHIO_TIME_COMPARISON_ASCENDING, "INT64_MIN/2 < INT64_MAX/3");
+    expect(pioCompareTimeRanges(lastSecond, lastSecondAt1), PINOCCHIO_TIMERANGE_COMPARISON_SAME, "last second before INT64_MAX");
+    expect(pioCompareTimeRanges(firstSecond, firstSecondAt1), PINOCCHIO_TIMERANGE_COMPARISON_SAME, "first second after INT64_MIN");
+    expect(pioCompareTimeRanges(firstSecond, lastSecondAt1), PINOCCHIO_TIMERANGE_COMPARISON_ASCENDING, "first and last seconds");
+    expect(pioTimeInTimeRange(maxAtMaxScale, lastSecondAt1), 0, "INT64_MAX after last second");
+    expect(pioTimeInTimeRange(maxMinusOne, lastSecondAt1), 1, "end of last second (included)");
+    expect(pioTimeInTimeRange(maxMinusOne, firstSecondAt1), 0, "INT64_MAX-1 not in first second");
+    expect(pioTimeInTimeRange(minPlusTwo, firstSecondAt1), 1, "start of first second");
+    expect(pioTimeInTimeRange(minAtMaxScale, firstSecondAt1), 0, "INT64_MIN before first second");
+    expect(pioTimeRangeIntersectsTimeRange(lastSecond, lastSecondAt1), 1, "last seconds intersect");
+    expect(pioTimeRangeIntersectsTimeRange(firstSecond, lastSecondAt1), 0, "first and last seconds do not intersect");
+    expect(pioCompareTimeLines(tlExtreme, 3, tlExtremeAt1, 3), PINOCCHIO_TIMELINE_COMPARISON_SAME, "extreme timelines");
+    expect(pioCompareTimeLinesWithMapping(tlExtreme+1, 2, tlExtremeAt1, 3, mapping), PINOCCHIO_TIMELINE_COMPARISON_SUBSET, "extreme subset");
+    expect(mapping[0]*10 + mapping[1], 12, "mapping of extreme subset");
+    expect(pioCompareTimeLines(tlExtremeAt1, 3, tlExtreme, 2), PINOCCHIO_TIMELINE_COMPARISON_SUPERSET, "extreme superset");
+
+    // time range between 48 kHz and 90 kHz timestamps (48000*90000 does not fit in 32 bits)
+    between = pioGetTimeRangeBetweenTimes(start48k, stop90k);
+    expect(between.scale, 720000, "common scale of 48 kHz and 90 kHz");
+    expect(between.duration == 720000/1000, 1, "duration of 1 ms");
+    expect(pioTimeInTimeRange(start48k, between) && pioTimeInTimeRange(stop90k, between), 1, "time range between times");
+
+    // timelines
+    expect(pioCompareTimeLines(tl90k, 3, tl25, 3), PINOCCHIO_TIMELINE_COMPARISON_SAME, "same timeline at 90 kHz and 25 Hz");
+    expect(pioCompareTimeLines(tl90k, 3, tl90k, 3), PINOCCHIO_TIMELINE_COMPARISON_SAME, "same timeline");
+    expect(pioCompareTimeLines(tl25, 3, tl25bis, 3), PINOCCHIO_TIMELINE_COMPARISON_OTHER, "different last time range");
+    expect(pioCompareTimeLines(tl90k+2, 1, tl25, 3), PINOCCHIO_TIMELINE_COMPARISON_SUBSET, "last time range at 90 kHz");
+    expect(pioCompareTimeLines(tl25, 3, tl90k, 2), PINOCCHIO_TIMELINE_COMPARISON_SUPERSET, "first two time ranges at 90 kHz");
+    expect(pioCompareTimeLinesWithMapping(tl90k+1, 2, tl25, 3, mapping), PINOCCHIO_TIMELINE_COMPARISON_SUBSET, "last two time ranges");
+    expect(mapping[0]*10 + mapping[1], 12, "mapping of last two time ranges");
+    expect(pioCompareTimeLinesWithMapping(tl25, 3, tl90k+1, 1, mapping), PINOCCHIO_TIMELINE_COMPARISON_SUPERSET, "second time range");
+    expect(mapping[0], 1, "mapping of second time range");
+    expect(pioCompareTimeLines(tl90k, 2, tl25bis+1, 2), PINOCCHIO_TIMELINE_COMPARISON_OTHER, "shifted timeline");
+    expect(pioCompareTimeLines(tl25bis, 3, tl90k, 2), PINOCCHIO_TIMELINE_COMPARISON_SUPERSET, "first two time ranges of other timeline");
+    expect(pioCompareTimeLines(tl25bis+1, 2, tl90k, 3), PINOCCHIO_TIMELINE_COMPARISON_OTHER, "longer last time range");
+    
+    // long timelines at mixed scales
+    frames(late90k, NFRAMES, 90000, 1, THREE_YEARS);
+    frames(late1G, NFRAMES, 1000000000, 1, THREE_YEARS);
+    frames(lateEvery10, NFRAMES/10, 90000, 10, THREE_YEARS);
+    expect(pioCompareTimeLines(late90k, NFRAMES, late1G, NFRAMES), PINOCCHIO_TIMELINE_COMPARISON_SAME, "90 kHz vs 1 GHz, 3 years in");
+    expect(pioCompareTimeLinesWithMapping(lateEvery10, NFRAMES/10, late1G, NFRAMES, lateMapping),
+           PINOCCHIO_TIMELINE_COMPARISON_SUBSET, "subset at 90 kHz vs 1 GHz, 3 years in");
+    for (t=0; t<NFRAMES/10; t++) expect(lateMapping[t], 10*t, "mapping of subset at 90 kHz vs 1 GHz");
+    expect(pioCompareTimeLines(late1G, NFRAMES, lateEvery10, NFRAMES/10), PINOCCHIO_TIMELINE_COMPARISON_SUPERSET,
+           "superset at 1 GHz vs 90 kHz, 3 years in");
+    late1G[NFRAMES/2].time++;
+    expect(pioCompareTimeLines(late90k, NFRAMES, late1G, NFRAMES), PINOCCHIO_TIMELINE_COMPARISON_OTHER, "one nanosecond off");
+
+    // identical time ranges
+    expect(pioCompareTimeLinesWithMapping(twice, 2, tl25, 3, mapping), PINOCCHIO_TIMELINE_COMPARISON_SUBSET, "identical time ranges");
+    expect(mapping[0]*10 + mapping[1], 11, "mapping of identical time ranges");
+    expect(pioCompareTimeLinesWithMapping(twice+1, 3, twice, 4, mapping), PINOCCHIO_TIMELINE_COMPARISON_SUBSET, "some identical time ranges");
+    expect(mapping[0]*100 + mapping[1]*10 + mapping[2], 23, "mapping of some identical time ranges");
+
+    if (failures)
+    {
+        fprintf(stderr, "%d failure(s).\n", failures);
+        exit(-1);
+    }
+    fprintf(stdout, "OK\n");
+    return 0;
+}
@@ -0,0 +1,172 @@
+/*
+ *  test_TimelineMapping.c
+ *  pinocchIO
+ *
+ *  Checks the mapping returned by pioCompareTimeLinesWithMapping() against a
+ *  search of each time range with pioFindTimeRangeInTimeLine() (subsets and
+ *  supersets, at mixed scales, with identical time ranges), and that a dataset
+ *  copied onto a timeline containing more time ranges than its own keeps its
+ *  data in the matching time ranges only.
+ *
+ *  usage: test_TimelineMapping
+ *
+ */
+
+#include <string.h>
+#include "test_utils.h"
+
+#define TEST_FILE "/tmp/test_TimelineMapping_%s.pio"
+#define NFRAMES 20000
+
+// one frame every step/25 second starting at offset seconds, in 1/scale units
+static PIOTimeRange* frames(int n, int32_t scale, int step, int64_t offset)
+{
+    PIOTimeRange* timeranges = (PIOTimeRange*) malloc(n*sizeof(PIOTimeRange));
+    int t;
+
+    for (t=0; t<n; t++)
+    {
+        timeranges[t].time = offset*scale + ((int64_t)t*step*scale)/25;
+        timeranges[t].duration = scale/25;
+        timeranges[t].scale = scale;
+    }
+    return timeranges;
+}
+
+// subset tr1 of superset tr2, both ways
+static void checkMapping(PIOTimeRange* tr1, int n1, PIOTimeRange* tr2, int n2, const char* name)
+{
+    int* mapping = (int*) malloc(n1*sizeof(int));
+    int* expected = (int*) malloc(n1*sizeof(int));
+    int t;
+
+    for (t=0; t<n1; t++) expected[t] = pioFindTimeRangeInTimeLine(tr1[t], tr2, n2);
+
+    expect(pioCompareTimeLinesWithMapping(tr1, n1, tr2, n2, mapping), PINOCCHIO_TIMELINE_COMPARISON_SUBSET, name);
+    for (t=0; t<n1; t++) expect(mapping[t], expected[t], name);
+
+    memset(mapping, 0, n1*sizeof(int));
+    expect(pioCompareTimeLinesWithMapping(tr2, n2, tr1, n1, mapping), PINOCCHIO_TIMELINE_COMPARISON_SUPERSET, name);
+    for (t=0; t<n1; t++) expect(mapping[t], expected[t], name);
+
+    expect(pioCompareTimeLinesWithMapping(tr1, n1, tr2, n2, NULL), PINOCCHIO_TIMELINE_COMPARISON_SUBSET, name);
+
+    free(expected);
+    free(mapping);
+}
+
+// copy a dataset whose timeline is tr1 into a file whose timeline is tr2
+static void checkCopy(PIOTimeRange* tr1, int n1, PIOTimeRange* tr2, int n2)
+{
+    PIOFile pioInputFile = PIOFileInvalid;
+    PIOFile pioOutputFile = PIOFileInvalid;
+    PIOTimeline pioTimeline = PIOTimelineInvalid;
+    PIODatatype pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_INT, 1);
+    PIODataset pioDataset = PIODatasetInvalid;
+    char input[256], output[256];
+    void* buffer = NULL;
+    int t, u, number;
+
+    sprintf(input, TEST_FILE, "input");
+    sprintf(output, TEST_FILE, "output");
+    remove(input);
+    remove(output);
+
+    pioInputFile = pioNewFile(input, "/path/to/medium");
+    pioTimeline = pioNewTimeline(pioInputFile, "frames", "frames", n1, tr1);
+    pioDataset = pioNewDataset(pioInputFile, "index", "index", pioTimeline, pioDatatype);
+    pioNewDatasetWriter(&pioDataset, 0);
+    for (t=0; t<n1; t++) pioWrite(&pioDataset, t, &t, 1, pioDatatype);
+    pioCloseDataset(&pioDataset);
+    pioCloseTimeline(&pioTimeline);
+
+    pioOutputFile = pioNewFile(output, "/path/to/medium");
+    pioTimeline = pioNewTimeline(pioOutputFile, "frames", "frames", n2, tr2);
+    pioCloseTimeline(&pioTimeline);
+
+    expect(pioCopyDataset("index", pioInputFile, pioOutputFile), 1, "pioCopyDataset (subset)");
+
+    // each time range holds its own index in input timeline, others are empty
+    pioDataset = pioOpenDataset(PIOMakeObject(pioOutputFile), "index");
+    expect(PIODatasetIsInvalid(pioDataset), 0, "copied dataset");
+    for (t=0, u=0; u<n2; u++)
+    {
+        number = pioRead(&pioDataset, u, pioDatatype, &buffer);
+        if ((t < n1) && (pioCompareTimeRanges(tr1[t], tr2[u]) == PINOCCHIO_TIMERANGE_COMPARISON_SAME))
+        {
+            expect(number, 1, "matching time range");
+            expect(((int*)buffer)[0], t, "matching time range");
+            t++;
+        }
+        else
+            expect(number, 0, "other time range");
+    }
+    expect(t, n1, "every time range copied");
+    pioCloseDataset(&pioDataset);
+
+    // copying the other way round is not possible
+    expect(pioCopyDataset("index", pioOutputFile, pioInputFile), 0, "pioCopyDataset (superset)");
+
+    pioCloseDatatype(&pioDatatype);
+    pioCloseFile(&pioOutputFile);
+    pioCloseFile(&pioInputFile);
+    remove(input);
+    remove(output);
+}
+
+int main (int argc, char *const  argv[])
+{
+    int64_t years = 3LL*365*86400;
+    PIOTimeRange* frames90k = frames(NFRAMES, 90000, 1, 0);
+    PIOTimeRange* frames25 = frames(NFRAMES, 25, 1, 0);
+    PIOTimeRange* every10 = frames(NFRAMES/10, 90000, 10, 0);
+    // 90 kHz and nanoseconds, 3 years in: cross products do not fit in 64 bits
+    PIOTimeRange* late1G = frames(NFRAMES, 1000000000, 1, years);
+    PIOTimeRange* lateEvery10 = frames(NFRAMES/10, 90000, 10, years);
+    PIOTimeRange repeated[6] = {{0, 1, 25}, {0, 1, 25}, {0, 1, 25}, {1, 1, 25}, {1, 1, 25}, {2, 1, 25}};
+    PIOTimeRange missing[2] = {{0, 1, 25}, {3, 1, 25}};
+    int mapping[NFRAMES];
+    int t;
+
+    checkMapping(every10, NFRAMES/10, frames90k, NFRAMES, "subset (90 kHz)");
+    checkMapping(every10, NFRAMES/10, frames25, NFRAMES, "subset (90 kHz vs 25 Hz)");
+    checkMapping(lateEvery10, NFRAMES/10, late1G, NFRAMES, "subset (90 kHz vs 1 GHz, 3 years in)");
+    checkMapping(frames90k, 1, frames25, NFRAMES, "first time range only");
+    checkMapping(frames90k+NFRAMES-1, 1, frames25, NFRAMES, "last time range only");
+
+    // same timelines map time ranges onto themselves
+    expect(pioCompareTimeLinesWithMapping(frames90k, NFRAMES, frames25, NFRAMES, mapping),
+           PINOCCHIO_TIMELINE_COMPARISON_SAME, "same timelines");
+    for (t=0; t<NFRAMES; t++) expect(mapping[t], t, "same timelines");
+
+    // identical time ranges are matched one to one
+    expect(pioCompareTimeLinesWithMapping(repeated, 2, repeated, 6, mapping),
+           PINOCCHIO_TIMELINE_COMPARISON_SUBSET, "identical time ranges");
+    expect(mapping[0], 0, "identical time ranges");
+    expect(mapping[1], 1, "identical time ranges");
+    expect(pioCompareTimeLinesWithMapping(repeated+1, 4, repeated, 6, mapping),
+           PINOCCHIO_TIMELINE_COMPARISON_SUBSET, "identical time ranges");
+    expect(mapping[0], 0, "identical time ranges");
+    expect(mapping[1], 1, "identical time ranges");
+    expect(mapping[2], 3, "identical time ranges");
+    expect(mapping[3], 4, "identical time ranges");
+    expect(pioCompareTimeLinesWithMapping(repeated, 3, repeated+1, 5, mapping),
+           PINOCCHIO_TIMELINE_COMPARISON_SUBSET, "more identical time ranges");
+    expect(mapping[0], 0, "more identical time ranges");
+    expect(mapping[1], 1, "more identical time ranges");
+    expect(mapping[2], 1, "more identical time ranges (last one shared)");
+    expect(pioCompareTimeLinesWithMapping(missing, 2, repeated, 6, mapping),
+           PINOCCHIO_TIMELINE_COMPARISON_OTHER, "missing time range");
+
+    // dataset copied onto a larger timeline
+    checkCopy(every10, NFRAMES/100, frames25, NFRAMES/10);
+
+    free(lateEvery10);
+    free(late1G);
+    free(every10);
+    free(frames25);
+    free(frames90k);
+
+    fprintf(stdout, "OK\n");
+    return 0;
+}
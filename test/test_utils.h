@@ -0,0 +1,62 @@
+/*
+ *  test_utils.h
+ *  pinocchIO
+ *
+ *  Helpers shared by tests (test_*.c, run by ctest) and benchmarks
+ *  (bench_*.c, built along with them but run by hand).
+ *
+ */
+
+#ifndef _TEST_UTILS_H
+#define _TEST_UTILS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "pinocchIO.h"
+
+// wall-clock time, in seconds
+static inline double now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + 1e-6*tv.tv_usec;
+}
+
+// n consecutive frames at 25 Hz, to be freed by caller
+static inline PIOTimeRange* newFrames(int n)
+{
+    PIOTimeRange* timeranges = (PIOTimeRange*) malloc(n*sizeof(PIOTimeRange));
+    int t;
+
+    for (t=0; t<n; t++)
+    {
+        timeranges[t].time = t;
+        timeranges[t].duration = 1;
+        timeranges[t].scale = 25;
+    }
+    return timeranges;
+}
+
+// new file at path (overwritten) with a timeline "frames" of n frames at 25 Hz
+static inline PIOFile newFramesFile(const char* path, int n, PIOTimeline* pioTimeline)
+{
+    PIOTimeRange* timeranges = newFrames(n);
+    PIOFile pioFile = PIOFileInvalid;
+
+    remove(path);
+    pioFile = pioNewFile(path, "/path/to/medium");
+    *pioTimeline = pioNewTimeline(pioFile, "frames", "frames", n, timeranges);
+    free(timeranges);
+    return pioFile;
+}
+
+// exit with an error message unless result is the expected one
+static inline void expect(int64_t result, int64_t expected, const char* name)
+{
+    if (result == expected) return;
+    fprintf(stderr, "%s: got %lld instead of %lld.\n", name, (long long)result, (long long)expected);
+    exit(-1);
+}
+
+#endif
@@ -49,6 +49,9 @@
                     If it exists:                                   
                         Timeline in OUTPUT pinocchIO file at PATH is
                         used as timeline for new dataset.           
+                    Regular timelines (time ranges with the same    
+                    duration, starting at a constant interval) are  
+                    stored as such.                                 
                                                                     
     -p, --precision=SCALE                                           
                     Set precision used for new timeline.           
@@ -340,6 +343,9 @@ int usage(int argc, char *const argv[])
 			"					If it exists:                                   \n" \
 			"						Timeline in OUTPUT pinocchIO file at PATH is\n" \
 			"                       used as timeline for new dataset.           \n" \
+			"                   Regular timelines (time ranges with the same    \n" \
+			"                   duration, starting at a constant interval) are  \n" \
+			"                   stored as such.                                 \n" \
 			"                                                                   \n" \
 			"   -p, --precision=SCALE                                           \n" \
 			"                   Set precision used for new timeline.            \n" \
@@ -390,6 +396,8 @@ int main (int argc, char *const  argv[])
 	
 	PIOFile pioFile = PIOFileInvalid;
 	PIOTimeRange* timeline = NULL;
+	PIOTimeRange first;
+	int64_t step;
 	int ntimeranges = -1;
 	int lineId = -1;
 	PIOTimeline pioTimeline = PIOTimelineInvalid;
@@ -528,14 +536,18 @@ int main (int argc, char *const  argv[])
 		exit(-1);
 	}
 	
-	// tries to load timeline
-	pioTimeline = pioOpenTimeline(PIOMakeObject(pioFile), path2timeline);
+	// tries to open timeline (only its length is needed)
+	pioTimeline = pioOpenTimelineWithFlags(PIOMakeObject(pioFile), path2timeline, PINOCCHIO_TIMELINE_LAZY);
 	if (PIOTimelineIsInvalid(pioTimeline))
 	{
 		// timeline probably does not exist --> create it
 		timeline = (PIOTimeRange*) malloc(ntimeranges*sizeof(PIOTimeRange));
 		readTimeline( in_ascii, ntimeranges, timeline, precision, unit);
-		pioTimeline = pioNewTimeline(pioFile, path2timeline, timeline_description, ntimeranges, timeline);
+		// regular timelines (frames, for instance) do not need to store every time range
+		if (pioIsRegularTimeLine(timeline, ntimeranges, &first, &step))
+			pioTimeline = pioNewRegularTimeline(pioFile, path2timeline, timeline_description, ntimeranges, first, step);
+		else
+			pioTimeline = pioNewTimeline(pioFile, path2timeline, timeline_description, ntimeranges, timeline);
 		free(timeline);
 		if (PIOTimelineIsInvalid(pioTimeline))
 		{
@@ -615,6 +627,9 @@ int main (int argc, char *const  argv[])
 		else 
 			pioDatatype = pioNewDatatype(PINOCCHIO_TYPE_DOUBLE, dimension);
 
+		// write by batches
+		pioNewDatasetWriter(&pioDataset, 0);
+		
 		if (string_flag)
 			for (lineId=0; lineId<ntimeranges; lineId++)
 				pioWrite(&pioDataset, lineId, strings[lineId], strlen(strings[lineId]), pioDatatype);
@@ -64,11 +64,11 @@ void prepareBufferForMaximum( void* buffer, PIODatatype pioDatatype)
     }
 }
 
-void updateBufferForMaximum( void* aggregated_buffer, void* buffer, int number, PIODatatype pioDatatype)
+void updateBufferForMaximum( void* aggregated_buffer, void* buffer, int64_t number, PIODatatype pioDatatype)
 {
     int dimension = pioDatatype.dimension;
     int d;
-    int n;
+    int64_t n;
 
     char* aggregated_buffer_char = aggregated_buffer;
     int*  aggregated_buffer_int  = aggregated_buffer;
@@ -136,11 +136,11 @@ void prepareBufferForMinimum( void* buffer, PIODatatype pioDatatype)
     }
 }
 
-void updateBufferForMinimum( void* aggregated_buffer, void* buffer, int number, PIODatatype pioDatatype)
+void updateBufferForMinimum( void* aggregated_buffer, void* buffer, int64_t number, PIODatatype pioDatatype)
 {
     int dimension = pioDatatype.dimension;
     int d;
-    int n;
+    int64_t n;
     
     char* aggregated_buffer_char = aggregated_buffer;
     int*  aggregated_buffer_int  = aggregated_buffer;
@@ -247,7 +247,8 @@ int main (int argc, char *const  argv[])
     PIODatatype pioDatatype = PIODatatypeInvalid;
     
     void* buffer = NULL; // data buffer
-    int number; // data number
+    int64_t number; // data number
+    int count; // number of consecutive timeranges
     
 	int c;
 	while (1)
@@ -349,7 +350,8 @@ int main (int argc, char *const  argv[])
     }
     
     // load original dataset
-    pioInputDataset = pioOpenDataset(PIOMakeObject(pioInputFile), dataset_path);
+    pioInputDataset = pioOpenDatasetWithFlags(PIOMakeObject(pioInputFile), dataset_path,
+                                              PINOCCHIO_DATASET_PRELOAD_LINKS);
     if (PIODatasetIsInvalid(pioInputDataset))
     {
         fprintf(stderr, "Cannot open original dataset %s in file %s.\n", dataset_path, input_file);
@@ -372,36 +374,23 @@ int main (int argc, char *const  argv[])
     }
     
     // mapping between original and target timeline
+    // (first target timerange intersecting each original timerange)
     
-    int target_t = 0;
+    int target_t;
     int original_t;
     int* mapping = (int*) malloc(pioOriginalTimeline.ntimeranges*sizeof(int));
-    for (original_t=0; original_t<pioOriginalTimeline.ntimeranges; original_t++) 
+    if (pioJoinTimeLines(pioOriginalTimeline.timeranges, pioOriginalTimeline.ntimeranges,
+                         pioTargetTimeline.timeranges, pioTargetTimeline.ntimeranges,
+                         mapping, NULL) < 0)
     {
-        // look for first target timerange intersecting original timerange
-        while (
-               // not yet reached the end of target timeline
-               (target_t < pioTargetTimeline.ntimeranges)
-               &&
-               // target timerange is before original timerange
-               (pioCompareTimeRanges(pioTargetTimeline.timeranges[target_t], 
-                                     pioOriginalTimeline.timeranges[original_t]) != PINOCCHIO_TIMERANGE_COMPARISON_DESCENDING) 
-               &&
-               // target timerange do not intersect original timerange
-               (!pioTimeRangeIntersectsTimeRange(pioTargetTimeline.timeranges[target_t], 
-                                                 pioOriginalTimeline.timeranges[original_t]))
-               )
-        {
-            // try next target timerange
-            target_t++;
-        }
-        
-        // if found, update mask based on 
-        if (pioTimeRangeIntersectsTimeRange(pioTargetTimeline.timeranges[target_t], 
-                                            pioOriginalTimeline.timeranges[original_t]))
-            mapping[original_t] = target_t;
-        else 
-            mapping[original_t] = -1;
+        fprintf(stderr, "Cannot map original timeline onto target timeline.\n");
+        fflush(stderr);
+        free(mapping);
+        pioCloseTimeline(&pioOriginalTimeline);
+        pioCloseDataset(&pioInputDataset);
+        pioCloseTimeline(&pioTargetTimeline);
+        pioCloseFile(&pioInputFile);
+        exit(-1);
     }
     
     // get datatype
@@ -459,6 +448,9 @@ int main (int argc, char *const  argv[])
         exit(-1);
     }
 
+    // write by batches
+    pioNewDatasetWriter(&pioOutputDataset, 0);
+    
     void* aggregated_buffer = malloc(pioGetSize(pioDatatype));   
     int previous_original_t = 0;
     
@@ -487,7 +479,14 @@ int main (int argc, char *const  argv[])
             
             if (mapping[original_t] == target_t)
             {
-                number = pioReadData(&pioInputDataset, original_t, pioDatatype, &buffer);
+                // read all consecutive original timeranges mapped to target timerange at once
+                count = 1;
+                while ((original_t+count < pioOriginalTimeline.ntimeranges) && 
+                       (mapping[original_t+count] == target_t)) 
+                    count++;
+                
+                number = pioReadRange(&pioInputDataset, original_t, count, pioDatatype, &buffer, NULL);
+                original_t = original_t + count - 1;
                 
                 if (maximum_flag)
                     updateBufferForMaximum(aggregated_buffer, buffer, number, pioDatatype);
@@ -507,9 +506,11 @@ int main (int argc, char *const  argv[])
     free(aggregated_dataset_path);
     free(aggregated_dataset_description);
     free(mapping);
+    free(aggregated_buffer);
     pioCloseDatatype(&pioDatatype);
     pioCloseTimeline(&pioOriginalTimeline);
     pioCloseDataset(&pioInputDataset);
+    pioCloseDataset(&pioOutputDataset);
     pioCloseTimeline(&pioTargetTimeline);
     pioCloseFile(&pioInputFile);
     
@@ -34,6 +34,7 @@
 
 static int verbose_flag = 0;
 static int all_flag = 0;
+static int shuffle_flag = 0;
 
 void usage(const char * path2tool)
 {
@@ -45,7 +46,11 @@ void usage(const char * path2tool)
 			"       -t PATH, --timeline=PATH\n"
 			"                Copy timeline at PATH\n"
 			"       -d PATH, --dataset=PATH\n"
-			"                Copy dataset at PATH\n");
+			"                Copy dataset at PATH\n"
+			"       -z LEVEL, --compress=LEVEL\n"
+			"                Compress copied datasets with deflate LEVEL (1-9)\n"
+			"       --shuffle\n"
+			"                Byte-shuffle copied datasets before compression\n");
 	fflush(stdout);
 }
 
@@ -55,6 +60,7 @@ int main (int argc, char *const  argv[])
 	char* output_file = NULL;
 	char* timeline_path = NULL;
 	char* dataset_path = NULL;
+    PIODatasetOptions pioOptions = PIODatasetOptionsDefault;
     
     PIOFile pioInputFile = PIOFileInvalid;
     PIOFile pioOutputFile = PIOFileInvalid;
@@ -77,14 +83,16 @@ int main (int argc, char *const  argv[])
 			/* These options don't set a flag.
 			 We distinguish them by their indices. */
             {"all",      no_argument, &all_flag, 1},
+            {"shuffle",  no_argument, &shuffle_flag, 1},
 			{"timeline", required_argument, 0, 't'},
 			{"dataset",  required_argument, 0, 'd'},
+			{"compress", required_argument, 0, 'z'},
 			{0, 0, 0, 0}
 		};
 		/* getopt_long stores the option index here. */
 		int option_index = 0;
 		
-		c = getopt_long (argc, argv, "ht:d:",
+		c = getopt_long (argc, argv, "ht:d:z:",
 						 long_options, &option_index);
 		
 		/* Detect the end of the options. */
@@ -110,6 +118,16 @@ int main (int argc, char *const  argv[])
 			case 'd':
 				dataset_path = optarg;
 				break;
+				
+			case 'z':
+				pioOptions.compression = atoi(optarg);
+				if ((pioOptions.compression < 1) || (pioOptions.compression > 9))
+				{
+					fprintf(stderr, "Compression level must be between 1 and 9.\n");
+					fflush(stderr);
+					exit(-1);
+				}
+				break;
                 
 			case 'h':
 				usage(argv[0]);
@@ -139,6 +157,14 @@ int main (int argc, char *const  argv[])
         exit(-1);
     }
     
+    if (shuffle_flag && pioOptions.compression == 0)
+    {
+        fprintf(stderr, "--shuffle option requires --compress.\n");
+        fflush(stderr);
+        exit(-1);
+    }
+    pioOptions.shuffle = shuffle_flag;
+    
 	input_file = argv[optind];
     optind++;
     output_file = argv[optind];
@@ -176,7 +202,7 @@ int main (int argc, char *const  argv[])
     // copy dataset
     if (dataset_path)
     {
-        if (!pioCopyDataset(dataset_path, pioInputFile, pioOutputFile))
+        if (!pioCopyDatasetWithOptions(dataset_path, pioInputFile, pioOutputFile, pioOptions))
         {
             fprintf(stderr, "Cannot copy dataset %s.\n", dataset_path);
             fflush(stderr);
@@ -197,7 +223,7 @@ int main (int argc, char *const  argv[])
 
         numberOfDatasets = pioGetListOfDatasets(pioInputFile, &pathsToDatasets);
         for (i=0; i<numberOfDatasets; i++)
-            pioCopyDataset(pathsToDatasets[i], pioInputFile, pioOutputFile);
+            pioCopyDatasetWithOptions(pathsToDatasets[i], pioInputFile, pioOutputFile, pioOptions);
         for (i=0; i<numberOfDatasets; i++)
             free(pathsToDatasets[i]);
         free(pathsToDatasets);
@@ -272,7 +272,7 @@ int main (int argc, char *const  argv[])
         if (ascii)
         {
             size_t size;
-            int nVectors;
+            int64_t nVectors;
             int tr, n, d, N;
             double* buffer;
             PIODatatype outDatatype = PIODatatypeInvalid;
@@ -354,7 +354,7 @@ int main (int argc, char *const  argv[])
             }
 
             size_t size;
-            int nVectors;
+            int64_t nVectors;
             int tr, n, N;
             char* buffer;
             PIODatatype outDatatype = PIODatatypeInvalid;
@@ -400,7 +400,7 @@ int main (int argc, char *const  argv[])
         if (libsvm)
         {
             size_t size;
-            int nVectors;
+            int64_t nVectors;
             int tr, n, d, N;
             double* buffer;
             int* number;
@@ -452,7 +452,7 @@ int main (int argc, char *const  argv[])
         {
             size_t size;
             size_t itemSize;
-            int nVectors;
+            int64_t nVectors;
             void* buffer;
             PIODatatype outDatatype = PIODatatypeInvalid;
             
@@ -488,8 +488,8 @@ int main (int argc, char *const  argv[])
             size_t size;
             size_t itemSize;
             size_t dimensionSize;
-            int nVectors;
-            int n;
+            int64_t nVectors;
+            int64_t n;
             float* buffer;
             PIODatatype outDatatype = PIODatatypeInvalid;
             
@@ -514,8 +514,8 @@ int main (int argc, char *const  argv[])
             size_t size;
             size_t itemSize;
             size_t dimensionSize;
-            int nVectors;
-            int n;
+            int64_t nVectors;
+            int64_t n;
             int* buffer;
             PIODatatype outDatatype = PIODatatypeInvalid;
             
@@ -540,8 +540,8 @@ int main (int argc, char *const  argv[])
             size_t size;
             size_t itemSize;
             size_t dimensionSize;
-            int nVectors;
-            int n;
+            int64_t nVectors;
+            int64_t n;
             char* buffer;
             PIODatatype outDatatype = PIODatatypeInvalid;
             
@@ -569,6 +569,7 @@ int main (int argc, char *const  argv[])
 	if (timeline_path)
 	{
         int tr;
+        PIOTimeRange timerange;
         
         // Prepare output file
         
@@ -594,7 +595,8 @@ int main (int argc, char *const  argv[])
             exit(-1);
         }
         
-		pioTimeline = pioOpenTimeline(PIOMakeObject(pioFile), timeline_path);
+		// time ranges are read window after window
+		pioTimeline = pioOpenTimelineWithFlags(PIOMakeObject(pioFile), timeline_path, PINOCCHIO_TIMELINE_LAZY);
 		if (PIOTimelineIsInvalid(pioTimeline))
 		{
 			fprintf(stderr, "Cannot open timeline %s in file %s.\n", timeline_path, pinocchio_path);
@@ -606,10 +608,11 @@ int main (int argc, char *const  argv[])
 		
 		for (tr=0; tr<pioTimeline.ntimeranges; tr++)
         {
+            timerange = pioGetTimeRange(&pioTimeline, tr);
             fprintf(output, 
                     "%f %f\n", 
-                    1.0 *  pioTimeline.timeranges[tr].time                                        / pioTimeline.timeranges[tr].scale,
-                    1.0 * (pioTimeline.timeranges[tr].time + pioTimeline.timeranges[tr].duration) / pioTimeline.timeranges[tr].scale);
+                    1.0 *  timerange.time                      / timerange.scale,
+                    1.0 * (timerange.time + timerange.duration) / timerange.scale);
 		}
 		
         fclose(output);
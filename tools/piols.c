@@ -278,7 +278,7 @@ int main (int argc, char *const  argv[])
             fflush(stdout);
         }
         
-        PIOTimeline pioTimeline = pioGetTimeline(pioDataset);
+        PIOTimeline pioTimeline = pioGetTimelineWithFlags(pioDataset, PINOCCHIO_TIMELINE_LAZY);
         if (PIOTimelineIsInvalid(pioTimeline))
         {
             fprintf(stderr, "Cannot open timeline of dataset %s.\n", dataset);
@@ -355,7 +355,8 @@ int main (int argc, char *const  argv[])
     
     if (timeline)
     {
-        PIOTimeline pioTimeline = pioOpenTimeline(PIOMakeObject(pioFile), timeline);
+        PIOTimeline pioTimeline = pioOpenTimelineWithFlags(PIOMakeObject(pioFile), timeline, 
+                                                           PINOCCHIO_TIMELINE_LAZY);
         if (PIOTimelineIsInvalid(pioTimeline))
         {
             fprintf(stderr, "Cannot open timeline %s.\n", timeline);
@@ -402,7 +403,8 @@ int main (int argc, char *const  argv[])
 		fprintf(stdout, "== %d timeline(s) ==\n", numberOfTimelines);
 		for (tl = 0; tl<numberOfTimelines; tl++) 
 		{
-			PIOTimeline pioTimeline = pioOpenTimeline(PIOMakeObject(pioFile), timelines[tl]);
+			PIOTimeline pioTimeline = pioOpenTimelineWithFlags(PIOMakeObject(pioFile), timelines[tl], 
+															   PINOCCHIO_TIMELINE_LAZY);
 			if (PIOTimelineIsInvalid(pioTimeline))
 			{
 				pretty_print(timelines[tl], "ERROR - CANNOT OPEN TIMELINE");